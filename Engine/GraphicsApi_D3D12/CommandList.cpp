@@ -51,6 +51,7 @@ CopyCommandList::CopyCommandList(ComPtr<ID3D12GraphicsCommandList>& native)
 {
 
 	assert(native->GetType() == D3D12_COMMAND_LIST_TYPE_DIRECT ||
+		   native->GetType() == D3D12_COMMAND_LIST_TYPE_BUNDLE ||
 		   native->GetType() == D3D12_COMMAND_LIST_TYPE_COMPUTE ||
 		   native->GetType() == D3D12_COMMAND_LIST_TYPE_COPY);
 }
@@ -201,6 +202,7 @@ ComputeCommandList::ComputeCommandList(ComPtr<ID3D12GraphicsCommandList>& native
 	: CopyCommandList(native)
 {
 	assert(native->GetType() == D3D12_COMMAND_LIST_TYPE_DIRECT ||
+		   native->GetType() == D3D12_COMMAND_LIST_TYPE_BUNDLE ||
 		   native->GetType() == D3D12_COMMAND_LIST_TYPE_COMPUTE);
 }
 
@@ -284,7 +286,7 @@ void ComputeCommandList::SetDescriptorHeaps(gxapi::IDescriptorHeap*const * heaps
 GraphicsCommandList::GraphicsCommandList(ComPtr<ID3D12GraphicsCommandList>& native)
 	: ComputeCommandList(native)
 {
-	assert(native->GetType() == D3D12_COMMAND_LIST_TYPE_DIRECT);
+	assert(native->GetType() == D3D12_COMMAND_LIST_TYPE_DIRECT || native->GetType() == D3D12_COMMAND_LIST_TYPE_BUNDLE);
 }
 
 
@@ -350,6 +352,22 @@ void GraphicsCommandList::ExecuteBundle(IGraphicsCommandList* bundle) {
 }
 
 
+void GraphicsCommandList::ExecuteIndirect(gxapi::ICommandSignature* commandSignature,
+										  unsigned maxCommandCount,
+										  gxapi::IResource* argumentBuffer,
+										  size_t argumentBufferOffset,
+										  gxapi::IResource* countBuffer,
+										  size_t countBufferOffset)
+{
+	m_native->ExecuteIndirect(native_cast(commandSignature),
+							  maxCommandCount,
+							  native_cast(argumentBuffer),
+							  argumentBufferOffset,
+							  native_cast(countBuffer),
+							  countBufferOffset);
+}
+
+
 // Input assembler
 void GraphicsCommandList::SetIndexBuffer(void * gpuVirtualAddress, size_t sizeInBytes, gxapi::eFormat format) {
 	D3D12_INDEX_BUFFER_VIEW ibv;
@@ -155,6 +155,13 @@ public:
 
 	void ExecuteBundle(IGraphicsCommandList* bundle) override;
 
+	void ExecuteIndirect(gxapi::ICommandSignature* commandSignature,
+						 unsigned maxCommandCount,
+						 gxapi::IResource* argumentBuffer,
+						 size_t argumentBufferOffset,
+						 gxapi::IResource* countBuffer = nullptr,
+						 size_t countBufferOffset = 0) override;
+
 	// input assembler
 	void SetIndexBuffer(void* gpuVirtualAddress, size_t sizeInBytes, gxapi::eFormat format) override;
 
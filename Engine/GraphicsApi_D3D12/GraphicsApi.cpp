@@ -4,6 +4,7 @@
 #include "CommandAllocator.hpp"
 #include "CommandList.hpp"
 #include "DescriptorHeap.hpp"
+#include "CommandSignature.hpp"
 #include "NativeCast.hpp"
 #include "ExceptionExpansions.hpp"
 
@@ -61,7 +62,9 @@ gxapi::ICommandAllocator* GraphicsApi::CreateCommandAllocator(gxapi::eCommandLis
 gxapi::IGraphicsCommandList* GraphicsApi::CreateGraphicsCommandList(gxapi::CommandListDesc desc) {
 	ComPtr<ID3D12GraphicsCommandList> native;
 
-	ThrowIfFailed(m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, native_cast(desc.allocator), native_cast(desc.initialState), IID_PPV_ARGS(&native)));
+	// Bundles are graphics command lists recorded with a bundle allocator
+	D3D12_COMMAND_LIST_TYPE type = desc.allocator->GetType() == gxapi::eCommandListType::BUNDLE ? D3D12_COMMAND_LIST_TYPE_BUNDLE : D3D12_COMMAND_LIST_TYPE_DIRECT;
+	ThrowIfFailed(m_device->CreateCommandList(0, type, native_cast(desc.allocator), native_cast(desc.initialState), IID_PPV_ARGS(&native)));
 
 	return new GraphicsCommandList{ native };
 }
@@ -247,12 +250,19 @@ gxapi::IPipelineState* GraphicsApi::CreateGraphicsPipelineState(const gxapi::Gra
 	nativeDesc.SampleDesc.Count = desc.multisampleCount;
 	nativeDesc.SampleDesc.Quality = desc.multisampleQuality;
 	nativeDesc.NodeMask = 0;
-	nativeDesc.CachedPSO.CachedBlobSizeInBytes = 0;
-	nativeDesc.CachedPSO.pCachedBlob = nullptr;
+	nativeDesc.CachedPSO.CachedBlobSizeInBytes = desc.cachedState.sizeOfCachedBlob;
+	nativeDesc.CachedPSO.pCachedBlob = desc.cachedState.cachedBlob;
 	nativeDesc.Flags = desc.addDebugInfo ? D3D12_PIPELINE_STATE_FLAG_TOOL_DEBUG : D3D12_PIPELINE_STATE_FLAG_NONE;
 
 
-	ThrowIfFailed(m_device->CreateGraphicsPipelineState(&nativeDesc, IID_PPV_ARGS(&native)), "While creating graphics PSO");
+	HRESULT hr = m_device->CreateGraphicsPipelineState(&nativeDesc, IID_PPV_ARGS(&native));
+	if (FAILED(hr) && nativeDesc.CachedPSO.pCachedBlob != nullptr) {
+		// Stale blob (driver or adapter changed), compile from scratch.
+		nativeDesc.CachedPSO.CachedBlobSizeInBytes = 0;
+		nativeDesc.CachedPSO.pCachedBlob = nullptr;
+		hr = m_device->CreateGraphicsPipelineState(&nativeDesc, IID_PPV_ARGS(&native));
+	}
+	ThrowIfFailed(hr, "While creating graphics PSO");
 
 	return new PipelineState{ native };
 }
@@ -260,8 +270,8 @@ gxapi::IPipelineState* GraphicsApi::CreateGraphicsPipelineState(const gxapi::Gra
 
 gxapi::IPipelineState* GraphicsApi::CreateComputePipelineState(const gxapi::ComputePipelineStateDesc& desc) {
 	D3D12_COMPUTE_PIPELINE_STATE_DESC nativeDesc;
-	nativeDesc.CachedPSO.CachedBlobSizeInBytes = 0;
-	nativeDesc.CachedPSO.pCachedBlob = nullptr;
+	nativeDesc.CachedPSO.CachedBlobSizeInBytes = desc.cachedState.sizeOfCachedBlob;
+	nativeDesc.CachedPSO.pCachedBlob = desc.cachedState.cachedBlob;
 	nativeDesc.CS.pShaderBytecode = desc.cs.shaderByteCode;
 	nativeDesc.CS.BytecodeLength = desc.cs.sizeOfByteCode;
 	nativeDesc.Flags = desc.addDebugInfo ? D3D12_PIPELINE_STATE_FLAG_TOOL_DEBUG : D3D12_PIPELINE_STATE_FLAG_NONE;
@@ -269,7 +279,13 @@ gxapi::IPipelineState* GraphicsApi::CreateComputePipelineState(const gxapi::Comp
 	nativeDesc.pRootSignature = native_cast(desc.rootSignature);
 
 	ComPtr<ID3D12PipelineState> native;
-	ThrowIfFailed(m_device->CreateComputePipelineState(&nativeDesc, IID_PPV_ARGS(&native)), "While creating compute PSO");
+	HRESULT hr = m_device->CreateComputePipelineState(&nativeDesc, IID_PPV_ARGS(&native));
+	if (FAILED(hr) && nativeDesc.CachedPSO.pCachedBlob != nullptr) {
+		nativeDesc.CachedPSO.CachedBlobSizeInBytes = 0;
+		nativeDesc.CachedPSO.pCachedBlob = nullptr;
+		hr = m_device->CreateComputePipelineState(&nativeDesc, IID_PPV_ARGS(&native));
+	}
+	ThrowIfFailed(hr, "While creating compute PSO");
 
 	return new PipelineState{ native };
 }
@@ -285,6 +301,28 @@ gxapi::IDescriptorHeap* GraphicsApi::CreateDescriptorHeap(gxapi::DescriptorHeapD
 }
 
 
+gxapi::ICommandSignature* GraphicsApi::CreateCommandSignature(const gxapi::CommandSignatureDesc& desc, gxapi::IRootSignature* rootSignature) {
+	ComPtr<ID3D12CommandSignature> native;
+
+	std::vector<D3D12_INDIRECT_ARGUMENT_DESC> nativeArguments;
+	nativeArguments.reserve(desc.arguments.size());
+	for (const auto& argument : desc.arguments) {
+		nativeArguments.push_back(native_cast(argument));
+	}
+
+	D3D12_COMMAND_SIGNATURE_DESC nativeDesc;
+	nativeDesc.ByteStride = desc.byteStride;
+	nativeDesc.NumArgumentDescs = (UINT)nativeArguments.size();
+	nativeDesc.pArgumentDescs = nativeArguments.data();
+	nativeDesc.NodeMask = 0;
+
+	// The root signature must be null if the arguments only draw or dispatch
+	ThrowIfFailed(m_device->CreateCommandSignature(&nativeDesc, native_cast(rootSignature), IID_PPV_ARGS(&native)));
+
+	return new CommandSignature{ native };
+}
+
+
 void GraphicsApi::CreateConstantBufferView(gxapi::ConstantBufferViewDesc desc,
 										   gxapi::DescriptorHandle destination)
 {
@@ -42,6 +42,8 @@ public:
 
 	gxapi::IDescriptorHeap* CreateDescriptorHeap(gxapi::DescriptorHeapDesc desc) override;
 
+	gxapi::ICommandSignature* CreateCommandSignature(const gxapi::CommandSignatureDesc& desc, gxapi::IRootSignature* rootSignature = nullptr) override;
+
 
 	void CreateConstantBufferView(gxapi::ConstantBufferViewDesc desc,
 								  gxapi::DescriptorHandle destination) override;
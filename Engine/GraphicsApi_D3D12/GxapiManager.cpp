@@ -203,7 +203,7 @@ static std::vector<Macro> ParseMacros(const char* macros) {
 	Macro m;
 	std::vector<Macro> collection;
 
-	while ((c = macros[i]) != '\0') {
+	for (; (c = macros[i]) != '\0'; ++i) {
 		// escaped characters are just inserted, not processed further
 		if (escape) {
 			if (state == NAME)
@@ -230,7 +230,7 @@ static std::vector<Macro> ParseMacros(const char* macros) {
 		}
 		else if (isspace(c) && !quote) {
 			// finish off current record on space
-			if (state == VALUE) {
+			if (!m.name.empty()) {
 				state = NAME;
 				collection.push_back(m);
 				m.name = m.definition = "";
@@ -243,6 +243,9 @@ static std::vector<Macro> ParseMacros(const char* macros) {
 				m.definition += c;
 		}
 	}
+	if (!m.name.empty()) {
+		collection.push_back(m);
+	}
 
 	return collection;
 }
@@ -314,6 +317,10 @@ gxapi::ShaderProgramBinary GxapiManager::CompileShader(
 	ComPtr<ID3DBlob> binaryCode;
 	ComPtr<ID3DBlob> errorMessage;
 	std::vector<D3D_SHADER_MACRO> d3dMacrosDefines;
+	for (const auto& macro : parsedMacroDefinitions) {
+		d3dMacrosDefines.push_back({ macro.name.c_str(), macro.definition.c_str() });
+	}
+	d3dMacrosDefines.push_back({ nullptr, nullptr });
 	D3dIncludeProvider d3dIncludeProvider(includeProvider);
 
 	HRESULT hr = D3DCompile(
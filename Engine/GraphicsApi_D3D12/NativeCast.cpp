@@ -102,6 +102,15 @@ ID3D12RootSignature* native_cast(gxapi::IRootSignature* source) {
 }
 
 
+ID3D12CommandSignature* native_cast(gxapi::ICommandSignature* source) {
+	if (source == nullptr) {
+		return nullptr;
+	}
+
+	return static_cast<CommandSignature*>(source)->GetNative();
+}
+
+
 ID3D12DescriptorHeap* native_cast(gxapi::IDescriptorHeap* source) {
 	if (source == nullptr) {
 		return nullptr;
@@ -186,6 +195,8 @@ D3D12_COMMAND_LIST_TYPE native_cast(gxapi::eCommandListType source) {
 		return D3D12_COMMAND_LIST_TYPE_COMPUTE;
 	case gxapi::eCommandListType::GRAPHICS:
 		return D3D12_COMMAND_LIST_TYPE_DIRECT;
+	case gxapi::eCommandListType::BUNDLE:
+		return D3D12_COMMAND_LIST_TYPE_BUNDLE;
 	default:
 		assert(false);
 		break;
@@ -235,6 +246,31 @@ D3D12_ROOT_PARAMETER_TYPE native_cast(gxapi::RootParameterDesc::eType source) {
 	return D3D12_ROOT_PARAMETER_TYPE{};
 }
 
+
+D3D12_INDIRECT_ARGUMENT_TYPE native_cast(gxapi::eIndirectArgumentType source) {
+	switch (source) {
+	case gxapi::eIndirectArgumentType::DRAW:
+		return D3D12_INDIRECT_ARGUMENT_TYPE_DRAW;
+	case gxapi::eIndirectArgumentType::DRAW_INDEXED:
+		return D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+	case gxapi::eIndirectArgumentType::DISPATCH:
+		return D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH;
+	case gxapi::eIndirectArgumentType::CONSTANT:
+		return D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+	case gxapi::eIndirectArgumentType::CONSTANT_BUFFER_VIEW:
+		return D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT_BUFFER_VIEW;
+	case gxapi::eIndirectArgumentType::SHADER_RESOURCE_VIEW:
+		return D3D12_INDIRECT_ARGUMENT_TYPE_SHADER_RESOURCE_VIEW;
+	case gxapi::eIndirectArgumentType::UNORDERED_ACCESS_VIEW:
+		return D3D12_INDIRECT_ARGUMENT_TYPE_UNORDERED_ACCESS_VIEW;
+	default:
+		assert(false);
+		break;
+	}
+
+	return D3D12_INDIRECT_ARGUMENT_TYPE{};
+}
+
 D3D12_DESCRIPTOR_RANGE_TYPE native_cast(gxapi::DescriptorRange::eType source) {
 	switch (source) {
 	case gxapi::DescriptorRange::CBV:
@@ -1954,6 +1990,33 @@ D3D12_ROOT_CONSTANTS native_cast(gxapi::RootConstant source) {
 }
 
 
+D3D12_INDIRECT_ARGUMENT_DESC native_cast(gxapi::IndirectArgumentDesc source) {
+	D3D12_INDIRECT_ARGUMENT_DESC result = {};
+
+	result.Type = native_cast(source.type);
+	switch (source.type) {
+	case gxapi::eIndirectArgumentType::CONSTANT:
+		result.Constant.RootParameterIndex = source.rootParameterIndex;
+		result.Constant.DestOffsetIn32BitValues = source.destOffset;
+		result.Constant.Num32BitValuesToSet = source.numValues;
+		break;
+	case gxapi::eIndirectArgumentType::CONSTANT_BUFFER_VIEW:
+		result.ConstantBufferView.RootParameterIndex = source.rootParameterIndex;
+		break;
+	case gxapi::eIndirectArgumentType::SHADER_RESOURCE_VIEW:
+		result.ShaderResourceView.RootParameterIndex = source.rootParameterIndex;
+		break;
+	case gxapi::eIndirectArgumentType::UNORDERED_ACCESS_VIEW:
+		result.UnorderedAccessView.RootParameterIndex = source.rootParameterIndex;
+		break;
+	default:
+		break;
+	}
+
+	return result;
+}
+
+
 D3D12_SHADER_BYTECODE native_cast(gxapi::ShaderByteCodeDesc source) {
 	D3D12_SHADER_BYTECODE result;
 
@@ -2211,6 +2274,7 @@ gxapi::eResourceFlags native_cast(D3D12_RESOURCE_FLAGS source) {
 gxapi::eCommandListType native_cast(D3D12_COMMAND_LIST_TYPE source) {
 	switch (source) {
 	case D3D12_COMMAND_LIST_TYPE_BUNDLE:
+		return gxapi::eCommandListType::BUNDLE;
 	case D3D12_COMMAND_LIST_TYPE_DIRECT:
 		return gxapi::eCommandListType::GRAPHICS;
 	case D3D12_COMMAND_LIST_TYPE_COMPUTE:
@@ -5,6 +5,7 @@
 #include "CommandAllocator.hpp"
 #include "CommandQueue.hpp"
 #include "RootSignature.hpp"
+#include "CommandSignature.hpp"
 #include "DescriptorHeap.hpp"
 #include "CommandList.hpp"
 #include "Fence.hpp"
@@ -48,6 +49,8 @@ ID3D12GraphicsCommandList* native_cast(gxapi::IGraphicsCommandList* source);
 
 ID3D12RootSignature* native_cast(gxapi::IRootSignature* source);
 
+ID3D12CommandSignature* native_cast(gxapi::ICommandSignature* source);
+
 ID3D12DescriptorHeap* native_cast(gxapi::IDescriptorHeap* source);
 
 ID3D12Fence* native_cast(gxapi::IFence* source);
@@ -66,6 +69,8 @@ D3D12_DESCRIPTOR_HEAP_TYPE native_cast(gxapi::eDescriptorHeapType source);
 
 D3D12_ROOT_PARAMETER_TYPE native_cast(gxapi::RootParameterDesc::eType source);
 
+D3D12_INDIRECT_ARGUMENT_TYPE native_cast(gxapi::eIndirectArgumentType source);
+
 D3D12_DESCRIPTOR_RANGE_TYPE native_cast(gxapi::DescriptorRange::eType source);
 
 D3D12_TEXTURE_ADDRESS_MODE native_cast(gxapi::eTextureAddressMode source);
@@ -255,6 +260,8 @@ D3D12_DESCRIPTOR_RANGE native_cast(gxapi::DescriptorRange source);
 
 D3D12_ROOT_CONSTANTS native_cast(gxapi::RootConstant source);
 
+D3D12_INDIRECT_ARGUMENT_DESC native_cast(gxapi::IndirectArgumentDesc source);
+
 D3D12_SHADER_BYTECODE native_cast(gxapi::ShaderByteCodeDesc source);
 
 
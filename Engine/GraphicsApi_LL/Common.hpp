@@ -507,6 +507,16 @@ enum class eResourceBarrierType {
 	UAV,
 };
 
+enum class eIndirectArgumentType {
+	DRAW,
+	DRAW_INDEXED,
+	DISPATCH,
+	CONSTANT,
+	CONSTANT_BUFFER_VIEW,
+	SHADER_RESOURCE_VIEW,
+	UNORDERED_ACCESS_VIEW,
+};
+
 //------------------------------------------------------------------------------
 // Bitflag enumerations
 //------------------------------------------------------------------------------
@@ -859,6 +869,17 @@ struct ShaderByteCodeDesc {
 };
 
 
+/// <summary> A driver-specific blob previously retrieved by IPipelineState::GetCachedBlob.
+/// Implementations ignore the blob if it does not match the current driver or device. </summary>
+struct CachedPipelineStateDesc {
+	CachedPipelineStateDesc() = default;
+	CachedPipelineStateDesc(const void* cachedBlob, size_t sizeOfCachedBlob)
+		: cachedBlob(cachedBlob), sizeOfCachedBlob(sizeOfCachedBlob) {}
+	const void* cachedBlob = nullptr;
+	size_t sizeOfCachedBlob = 0;
+};
+
+
 struct StreamOutputState {
 private:
 };
@@ -1086,6 +1107,8 @@ struct GraphicsPipelineStateDesc {
 	unsigned multisampleCount;
 	unsigned multisampleQuality;
 
+	CachedPipelineStateDesc cachedState;
+
 	bool addDebugInfo;
 };
 
@@ -1098,6 +1121,7 @@ struct ComputePipelineStateDesc {
 		: rootSignature(rootSignature), cs(cs), addDebugInfo(addDebugInfo) {};
 	IRootSignature* rootSignature;
 	ShaderByteCodeDesc cs;
+	CachedPipelineStateDesc cachedState;
 	bool addDebugInfo;
 };
 
@@ -1325,6 +1349,63 @@ struct RootSignatureDesc {
 
 
 
+// indirect commands
+
+/// <summary> One argument of an indirect command, as it follows the previous one in the argument buffer. </summary>
+struct IndirectArgumentDesc {
+	static IndirectArgumentDesc Draw() { return IndirectArgumentDesc{ eIndirectArgumentType::DRAW }; }
+	static IndirectArgumentDesc DrawIndexed() { return IndirectArgumentDesc{ eIndirectArgumentType::DRAW_INDEXED }; }
+	static IndirectArgumentDesc Dispatch() { return IndirectArgumentDesc{ eIndirectArgumentType::DISPATCH }; }
+	static IndirectArgumentDesc Constant(unsigned rootParameterIndex, unsigned destOffset, unsigned numValues) {
+		return IndirectArgumentDesc{ eIndirectArgumentType::CONSTANT, rootParameterIndex, destOffset, numValues };
+	}
+	/// <summary> A root CBV, SRV or UAV, given by its GPU virtual address. </summary>
+	static IndirectArgumentDesc View(eIndirectArgumentType type, unsigned rootParameterIndex) {
+		return IndirectArgumentDesc{ type, rootParameterIndex };
+	}
+
+	/// <summary> Size of the argument in the argument buffer. </summary>
+	unsigned Size() const;
+
+	eIndirectArgumentType type = eIndirectArgumentType::DRAW_INDEXED;
+	unsigned rootParameterIndex = 0; // CONSTANT and views only
+	unsigned destOffset = 0; // CONSTANT only, in 32-bit values
+	unsigned numValues = 0; // CONSTANT only, 32-bit values
+};
+
+
+/// <summary> The layout of the commands in an argument buffer. Commands end with a draw or a dispatch. </summary>
+struct CommandSignatureDesc {
+	unsigned byteStride = 0;
+	std::vector<IndirectArgumentDesc> arguments;
+};
+
+
+struct DrawArguments {
+	uint32_t numVertices;
+	uint32_t numInstances;
+	uint32_t startVertex;
+	uint32_t startInstance;
+};
+
+
+struct DrawIndexedArguments {
+	uint32_t numIndices;
+	uint32_t numInstances;
+	uint32_t startIndex;
+	int32_t vertexOffset;
+	uint32_t startInstance;
+};
+
+
+struct DispatchArguments {
+	uint32_t dimx;
+	uint32_t dimy;
+	uint32_t dimz;
+};
+
+
+
 // buffer views
 
 struct ConstantBufferViewDesc {
@@ -1894,6 +1975,26 @@ inline RootDescriptorTable& RootParameterDesc::As<RootParameterDesc::eType::DESC
 }
 
 
+inline unsigned IndirectArgumentDesc::Size() const {
+	switch (type) {
+		case eIndirectArgumentType::DRAW:
+			return sizeof(DrawArguments);
+		case eIndirectArgumentType::DRAW_INDEXED:
+			return sizeof(DrawIndexedArguments);
+		case eIndirectArgumentType::DISPATCH:
+			return sizeof(DispatchArguments);
+		case eIndirectArgumentType::CONSTANT:
+			return numValues * sizeof(uint32_t);
+		case eIndirectArgumentType::CONSTANT_BUFFER_VIEW:
+		case eIndirectArgumentType::SHADER_RESOURCE_VIEW:
+		case eIndirectArgumentType::UNORDERED_ACCESS_VIEW:
+			return sizeof(uint64_t);
+		default:
+			return 0;
+	}
+}
+
+
 
 //------------------------------------------------------------------------------
 // Internal helper function
@@ -8,6 +8,7 @@ namespace inl {
 namespace gxapi {
 
 class IDescriptorHeap;
+class ICommandSignature;
 
 class ICommandList {
 public:
@@ -137,6 +138,15 @@ public:
 
 	virtual void ExecuteBundle(IGraphicsCommandList* bundle) = 0;
 
+	/// <summary> Executes the commands laid out in the argument buffer. </summary>
+	/// <param name="countBuffer"> Holds the number of commands as a 32-bit value, null to execute maxCommandCount commands. </param>
+	virtual void ExecuteIndirect(ICommandSignature* commandSignature,
+								 unsigned maxCommandCount,
+								 IResource* argumentBuffer,
+								 size_t argumentBufferOffset,
+								 IResource* countBuffer = nullptr,
+								 size_t countBufferOffset = 0) = 0;
+
 	// input assembler
 	virtual void SetIndexBuffer(void* gpuVirtualAddress, size_t sizeInBytes, eFormat format) = 0;
 
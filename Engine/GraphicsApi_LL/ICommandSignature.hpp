@@ -0,0 +1,16 @@
+#pragma once
+
+namespace inl {
+namespace gxapi {
+
+
+/// <summary> The layout of the commands in an indirect argument buffer, see IGraphicsCommandList::ExecuteIndirect. </summary>
+class ICommandSignature {
+public:
+	virtual ~ICommandSignature() = default;
+
+};
+
+
+}
+}
@@ -16,6 +16,7 @@ class IFence;
 class IResource;
 
 class IRootSignature;
+class ICommandSignature;
 class IPipelineState;
 class IDescriptorHeap;
 
@@ -44,6 +45,8 @@ public:
 	virtual IPipelineState* CreateGraphicsPipelineState(const GraphicsPipelineStateDesc& desc) = 0;
 	virtual gxapi::IPipelineState* CreateComputePipelineState(const gxapi::ComputePipelineStateDesc& desc) = 0;
 	virtual IDescriptorHeap* CreateDescriptorHeap(DescriptorHeapDesc) = 0;
+	/// <param name="rootSignature"> The root signature that the arguments set parameters of, null if they set none. </param>
+	virtual ICommandSignature* CreateCommandSignature(const CommandSignatureDesc& desc, IRootSignature* rootSignature = nullptr) = 0;
 
 	// Views
 	virtual void CreateConstantBufferView(ConstantBufferViewDesc desc,
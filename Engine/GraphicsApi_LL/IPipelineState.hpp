@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstdint>
+#include <vector>
+
 namespace inl {
 namespace gxapi {
 
@@ -7,6 +10,10 @@ class IPipelineState {
 public:
 	virtual ~IPipelineState() = default;
 
+	/// <summary> Returns a driver-specific blob that can be passed back on creation
+	/// through CachedPipelineStateDesc to speed up compilation. </summary>
+	virtual std::vector<uint8_t> GetCachedBlob() const = 0;
+
 };
 
 }
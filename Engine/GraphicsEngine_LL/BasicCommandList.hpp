@@ -67,6 +67,9 @@ namespace inl {
 namespace gxeng {
 
 
+class GraphicsBundle;
+
+
 class BasicCommandList {
 public:
 
@@ -75,6 +78,7 @@ public:
 		std::unique_ptr<gxapi::ICopyCommandList> commandList;
 		std::vector<ScratchSpacePtr> scratchSpaces;
 		std::vector<ResourceUsage> usedResources;
+		std::vector<std::shared_ptr<const GraphicsBundle>> executedBundles;
 	};
 public:
 	BasicCommandList(const BasicCommandList& rhs) = delete; // could be, but big perf hit, better not allow user
@@ -1,9 +1,9 @@
-#pragma once
-
 #include <GraphicsApi_LL/IGraphicsApi.hpp>
 
 #include "Binder.hpp"
+#include "RootSignatureCache.hpp"
 #include <algorithm>
+#include <stdexcept>
 
 
 namespace inl {
@@ -14,7 +14,7 @@ namespace gxeng {
 Binder::Binder(inl::gxapi::IGraphicsApi* gxApi, const std::vector<BindParameterDesc>& parameters, const std::vector<gxapi::StaticSamplerDesc>& staticSamplers) {
 	CalculateLayout(parameters);
 	m_rootSignatureDesc.staticSamplers = staticSamplers;
-	m_rootSignature.reset(gxApi->CreateRootSignature(m_rootSignatureDesc));
+	m_rootSignature = RootSignatureCache::Get(gxApi, m_rootSignatureDesc);
 }
 
 void Binder::Translate(BindParameter parameter, int & rootParamIndex, int & rootTableIndex) const {
@@ -31,91 +31,88 @@ void Binder::CalculateLayout(const std::vector<BindParameterDesc>& parameters) {
 	// copy input parameters to mapping
 	m_parameters.reserve(parameters.size());
 
-	std::vector<std::vector<BindParameterDesc>> tableParams; // goes into descriptor heap (scratch space)
-	std::vector<BindParameterDesc> samplerParams; // samplers are treated separately
-	std::vector<BindParameterDesc> constantParams; // inline constants and inline CBVs
-
 	// put parameters to the right slot/table in the root signature
-	DistributeParameters(parameters, tableParams, samplerParams, constantParams);
+	std::vector<RootSlotLayout> slots = DistributeParameters(parameters);
 
 	// declare root signature desc
 	gxapi::RootSignatureDesc desc;
 
 	// copy parameters to m_parameters and fill root signature desc
 	int rootParamIndex = 0;
-	int rootTableIndex = 0;
-	// constants
-	for (const auto& param : constantParams) {
-		// copy mapping
-		RootParameterMapping mapping;
-		mapping.bindParam = param.parameter;
-		mapping.rootParamIndex = rootParamIndex++;
-		mapping.constantCount = (param.constantSize + 3) / 4;
-		m_parameters.push_back(mapping);
-
-		// fill desc
-		if (mapping.constantCount > 0) {
-			desc.rootParameters.push_back(gxapi::RootParameterDesc::Constant(
-				mapping.constantCount,
-				mapping.bindParam.reg,
-				mapping.bindParam.space,
-				param.shaderVisibility));
-		}
-		else {
-			desc.rootParameters.push_back(gxapi::RootParameterDesc::Cbv(
-				mapping.bindParam.reg,
-				mapping.bindParam.space,
-				param.shaderVisibility));
-		}
-	}
-	// descriptor tables
-	for (auto& table : tableParams) {
-		rootTableIndex = 0;
-
-		// sort table by type (CBV/SRV/UAV) by register by space [radix sort]
-		std::stable_sort(table.begin(), table.end(), [](const BindParameterDesc& lhs, const BindParameterDesc& rhs)
-		{
-			return lhs.parameter.reg < rhs.parameter.reg;
-		});
-		std::stable_sort(table.begin(), table.end(), [](const BindParameterDesc& lhs, const BindParameterDesc& rhs)
-		{
-			return lhs.parameter.space < rhs.parameter.space;
-		});
-		std::stable_sort(table.begin(), table.end(), [](const BindParameterDesc& lhs, const BindParameterDesc& rhs)
-		{
-			return lhs.parameter.type < rhs.parameter.type;
-		});
+	for (auto& slot : slots) {
+		// constants
+		if (slot.type == gxapi::RootParameterDesc::CONSTANT || slot.type == gxapi::RootParameterDesc::CBV) {
+			const BindParameterDesc& param = slot.parameters[0];
 
-		// fill desc
-		desc.rootParameters.push_back(gxapi::RootParameterDesc::DescriptorTable());
-		auto& rootTable = desc.rootParameters[rootParamIndex].As<gxapi::RootParameterDesc::DESCRIPTOR_TABLE>();
-
-		int typeStreakLength = 0; // how many of the same type (cbv/srv/uav) do we encounter in a row
-		eBindParameterType typeOfStreak = eBindParameterType::CONSTANT;
-		int spaceOfStreak = 0;
-		int regOfStreak = 0;
-		for (const auto& param : table) {
 			// copy mapping
 			RootParameterMapping mapping;
 			mapping.bindParam = param.parameter;
 			mapping.rootParamIndex = rootParamIndex;
-			mapping.rootTableIndex = rootTableIndex++;
-			mapping.constantCount = 0;
+			mapping.constantCount = slot.type == gxapi::RootParameterDesc::CONSTANT ? (param.constantSize + 3) / 4 : 0;
 			m_parameters.push_back(mapping);
 
 			// fill desc
-			// start new streak if needed
-			if (param.parameter.type != typeOfStreak
-				|| param.parameter.space != spaceOfStreak
-				|| param.parameter.reg != regOfStreak + 1
-				|| typeStreakLength == 0)
+			if (mapping.constantCount > 0) {
+				desc.rootParameters.push_back(gxapi::RootParameterDesc::Constant(
+					mapping.constantCount,
+					mapping.bindParam.reg,
+					mapping.bindParam.space,
+					param.shaderVisibility));
+			}
+			else {
+				desc.rootParameters.push_back(gxapi::RootParameterDesc::Cbv(
+					mapping.bindParam.reg,
+					mapping.bindParam.space,
+					param.shaderVisibility));
+			}
+		}
+		// descriptor tables
+		else {
+			auto& table = slot.parameters;
+			int rootTableIndex = 0;
+
+			// sort table by type (CBV/SRV/UAV) by space by register
+			std::sort(table.begin(), table.end(), [](const BindParameterDesc& lhs, const BindParameterDesc& rhs)
 			{
-				rootTable.ranges.push_back(gxapi::DescriptorRange{ CastRangeType(param.parameter.type), 0, param.parameter.reg, param.parameter.space });
+				return RadixLess(lhs.parameter, rhs.parameter);
+			});
+
+			// table is visible to a single stage only if all its parameters are
+			gxapi::eShaderVisiblity visibility = table[0].shaderVisibility;
+			for (const auto& param : table) {
+				if (param.shaderVisibility != visibility) {
+					visibility = gxapi::eShaderVisiblity::ALL;
+				}
 			}
 
-			typeOfStreak = param.parameter.type;
-			regOfStreak = param.parameter.reg;
-			rootTable.ranges.back().numDescriptors++;
+			// fill desc
+			desc.rootParameters.push_back(gxapi::RootParameterDesc::DescriptorTable(visibility));
+			auto& rootTable = desc.rootParameters[rootParamIndex].As<gxapi::RootParameterDesc::DESCRIPTOR_TABLE>();
+
+			const BindParameterDesc* prev = nullptr;
+			for (const auto& param : table) {
+				// copy mapping
+				RootParameterMapping mapping;
+				mapping.bindParam = param.parameter;
+				mapping.rootParamIndex = rootParamIndex;
+				mapping.rootTableIndex = rootTableIndex;
+				mapping.constantCount = 0;
+				rootTableIndex += param.numDescriptors;
+				m_parameters.push_back(mapping);
+
+				// fill desc
+				// start new range if registers are not consecutive
+				if (prev == nullptr
+					|| param.parameter.type != prev->parameter.type
+					|| param.parameter.space != prev->parameter.space
+					|| param.parameter.reg != prev->parameter.reg + prev->numDescriptors)
+				{
+					rootTable.ranges.push_back(gxapi::DescriptorRange{ CastRangeType(param.parameter.type), 0, param.parameter.reg, param.parameter.space });
+				}
+				rootTable.ranges.back().numDescriptors += param.numDescriptors;
+
+				prev = &param;
+			}
 		}
 
 		++rootParamIndex;
@@ -131,90 +128,111 @@ void Binder::CalculateLayout(const std::vector<BindParameterDesc>& parameters) {
 }
 
 
-// Note that this function is optimized for nvidia, without taking much care for nvidia either.
-void Binder::DistributeParameters(const std::vector<BindParameterDesc>& parameters,
-								  std::vector<std::vector<BindParameterDesc>> & tableParams,
-								  std::vector<BindParameterDesc> & samplerParams,
-								  std::vector<BindParameterDesc> & constantParams)
-{
-	// put SRV's and UAV's into descriptor table: they have so many limitation that inlining them is basically worthless
-	// put samplers into separate list
+auto Binder::DistributeParameters(const std::vector<BindParameterDesc>& parameters) -> std::vector<RootSlotLayout> {
+	std::vector<RootSlotLayout> slots;
+
+	// Put SRV's and UAV's into descriptor tables: they have so many limitation that inlining them is basically worthless.
+	// Each change frequency gets its own table, so that frequently changed descriptors
+	// don't force the rarely changed ones to be copied over and over again.
+	// Arrays get a table of their own, so that the table can point to a range filled up front, like the texture table.
+	// Samplers are static, they don't appear in the layout.
+	auto addToTable = [&slots](const BindParameterDesc& param) {
+		auto tableIt = std::find_if(slots.begin(), slots.end(), [&param](const RootSlotLayout& slot) {
+			return slot.type == gxapi::RootParameterDesc::DESCRIPTOR_TABLE && slot.changeFrequency == param.relativeChangeFrequency
+				&& slot.parameters[0].numDescriptors == 1;
+		});
+		if (tableIt == slots.end() || param.numDescriptors > 1) {
+			slots.push_back({ gxapi::RootParameterDesc::DESCRIPTOR_TABLE, param.relativeChangeFrequency, {} });
+			tableIt = slots.end() - 1;
+		}
+		tableIt->parameters.push_back(param);
+	};
+
 	for (const auto& param : parameters) {
 		if (param.parameter.type == eBindParameterType::TEXTURE || param.parameter.type == eBindParameterType::UNORDERED) {
-			if (tableParams.size() == 0) {
-				tableParams.resize(1);
-			}
-			tableParams[0].push_back(param);
-		}
-		else if (param.parameter.type == eBindParameterType::SAMPLER) {
-			samplerParams.push_back(param);
+			addToTable(param);
 		}
-		else {
-			constantParams.push_back(param);
+		else if (param.parameter.type == eBindParameterType::CONSTANT) {
+			auto type = param.constantSize > 0 ? gxapi::RootParameterDesc::CONSTANT : gxapi::RootParameterDesc::CBV;
+			slots.push_back({ type, param.relativeChangeFrequency, { param } });
 		}
 	}
 
-	// how to compute required number of bytes in root signature
-	auto usedSpace = [&] {
+	auto usedSpace = [&slots] {
 		int size = 0;
-		//for (const auto& param : parameters) {
-		//	size += ((param.constantSize + 3) / 4 > 0 ? param.constantSize : 8); break; // inline constant size OR 64 bit virtual address
-		//}
-		//size += tableParams.empty() ? 0 : 4; // 32 bits for each descriptor table
-
-		for (const auto& table : tableParams) {
-			size += 4;
-		}
-		for (const auto& constant : constantParams) {
-			size += constant.constantSize > 0 ? ((constant.constantSize + 3) / 4 * 4) : 8;
+		for (const auto& slot : slots) {
+			size += SlotSize(slot);
 		}
-
 		return size;
 	};
 
-
-	// sort constant parametes by size, ascending, 0 is considered biggest
-	std::sort(constantParams.begin(), constantParams.end(), [](const BindParameterDesc& lhs, const BindParameterDesc& rhs)
-	{
-		auto lhscmp = lhs.constantSize <= 0 ? std::numeric_limits<decltype(lhs.constantSize)>::max() : lhs.constantSize;
-		auto rhscmp = rhs.constantSize <= 0 ? std::numeric_limits<decltype(rhs.constantSize)>::max() : rhs.constantSize;
-		return lhscmp < rhscmp;
-	});
-
-	// sort constant parametes by change frequency
-	auto largeBegin = constantParams.begin();
-	while (largeBegin != constantParams.end() && largeBegin->constantSize <= 8) {
-		largeBegin++;
-	}
-
-	std::sort(largeBegin, constantParams.end(), [](const BindParameterDesc& lhs, const BindParameterDesc& rhs)
-	{
-		return lhs.relativeChangeFrequency < rhs.relativeChangeFrequency;
-	});
+	// Parameters that are rarely changed and rarely read are the cheapest to move out of the root signature.
+	auto demoteOrder = [](const RootSlotLayout& lhs, const RootSlotLayout& rhs) {
+		const BindParameterDesc& l = lhs.parameters[0];
+		const BindParameterDesc& r = rhs.parameters[0];
+		float lhsScore = l.relativeChangeFrequency * l.relativeAccessFrequency;
+		float rhsScore = r.relativeChangeFrequency * r.relativeAccessFrequency;
+		if (lhsScore != rhsScore) {
+			return lhsScore < rhsScore;
+		}
+		return l.constantSize > r.constantSize; // prefer moving the bigger one
+	};
 
 	// convert inline constants to CBVs to save space
-	{
-		auto convertIt = constantParams.rbegin();
-		auto endIt = constantParams.rend();
-		while (maxSize < usedSpace() && convertIt != endIt) {
-			convertIt->constantSize = 0;
-			++convertIt;
+	constexpr int cbvSize = 8;
+	while (maxSize < usedSpace()) {
+		auto candidateIt = slots.end();
+		for (auto it = slots.begin(); it != slots.end(); ++it) {
+			if (it->type == gxapi::RootParameterDesc::CONSTANT && SlotSize(*it) > cbvSize) {
+				if (candidateIt == slots.end() || demoteOrder(*it, *candidateIt)) {
+					candidateIt = it;
+				}
+			}
 		}
+		if (candidateIt == slots.end()) {
+			break;
+		}
+		candidateIt->type = gxapi::RootParameterDesc::CBV;
+		candidateIt->parameters[0].constantSize = 0;
 	}
 
-	// throw CBVs into descriptor table until there's enough space
-	{
-		while (maxSize < usedSpace()) {
-			auto constantIt = constantParams.rbegin();
-			auto endIt = constantParams.rend();
-			if (constantIt != endIt) {
-				if (tableParams.size() == 0) {
-					tableParams.resize(1);
+	// throw CBVs into descriptor tables until there's enough space
+	while (maxSize < usedSpace()) {
+		auto candidateIt = slots.end();
+		for (auto it = slots.begin(); it != slots.end(); ++it) {
+			if (it->type == gxapi::RootParameterDesc::CBV) {
+				if (candidateIt == slots.end() || demoteOrder(*it, *candidateIt)) {
+					candidateIt = it;
 				}
-				tableParams[0].push_back(*constantIt);
-				constantParams.erase(--constantIt.base());
 			}
 		}
+		if (candidateIt == slots.end()) {
+			throw std::invalid_argument("Parameters don't fit into a root signature.");
+		}
+		BindParameterDesc param = candidateIt->parameters[0];
+		slots.erase(candidateIt);
+		addToTable(param);
+	}
+
+	// Most frequently changed parameters go first.
+	// On equal frequency, inline constants come first, then CBVs, then tables.
+	std::stable_sort(slots.begin(), slots.end(), [](const RootSlotLayout& lhs, const RootSlotLayout& rhs)
+	{
+		if (lhs.changeFrequency != rhs.changeFrequency) {
+			return lhs.changeFrequency > rhs.changeFrequency;
+		}
+		return lhs.type < rhs.type;
+	});
+
+	return slots;
+}
+
+
+int Binder::SlotSize(const RootSlotLayout& slot) {
+	switch (slot.type) {
+		case gxapi::RootParameterDesc::CONSTANT: return (slot.parameters[0].constantSize + 3) / 4 * 4;
+		case gxapi::RootParameterDesc::DESCRIPTOR_TABLE: return 4; // 32 bits for each descriptor table
+		default: return 8; // 64 bit virtual address
 	}
 }
 
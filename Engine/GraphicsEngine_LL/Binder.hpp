@@ -5,6 +5,8 @@
 
 #include <cstdint>
 #include <cassert>
+#include <memory>
+#include <vector>
 #include <iostream>
 #include <initializer_list>
 
@@ -62,9 +64,10 @@ struct BindParameter {
 struct BindParameterDesc {
 	BindParameter parameter; /// <summary> Target register. </summary>
 	unsigned constantSize = 0; /// <summary> Size of constant in bytes. Set to zero if unknown. </summary>
-	float relativeAccessFrequency = 1; /// <summary> Not used currently. TODO: Read more about this aspect. </summary>
+	float relativeAccessFrequency = 1; /// <summary> How often shaders read this binding relative to others. Frequently read constants are kept inline. </summary>
 	float relativeChangeFrequency = 1; /// <summary> How often will you change this binding relative to others. Absolute value does not matter. </summary>
 	gxapi::eShaderVisiblity shaderVisibility = gxapi::eShaderVisiblity::ALL;
+	unsigned numDescriptors = 1; /// <summary> Size of the array for arrays of SRVs or UAVs, starting at the target register. Arrays get a table of their own. </summary>
 };
 
 
@@ -74,6 +77,7 @@ struct BindParameterDesc {
 /// <remarks>
 /// The binder is a flat structure, that is, a mapping between shader registers and resources.
 /// Hides the complexity of Root Signatures, and optimizes parameter layout for preformance and space.
+/// Binders with identical layouts share the same root signature object, see <see cref="RootSignatureCache"/>.
 /// </remarks>
 class Binder {
 	friend std::ostream& ::operator<<(std::ostream& os, const Binder& binder);
@@ -86,6 +90,13 @@ private:
 		int rootTableIndex = -1; // if the root parameter is a descriptor table, specifies the index within the table, -1 if not a table
 	};
 
+	// A root signature parameter being laid out.
+	struct RootSlotLayout {
+		gxapi::RootParameterDesc::eType type; // CONSTANT, CBV or DESCRIPTOR_TABLE
+		float changeFrequency; // highest change frequency of contained parameters
+		std::vector<BindParameterDesc> parameters; // exactly one unless it's a table
+	};
+
 	// Radix sort for BindParameters
 	static bool RadixLess(const BindParameter& lhs, const BindParameter& rhs);
 public:
@@ -106,16 +117,14 @@ public:
 	const gxapi::RootSignatureDesc& GetRootSignatureDesc() const { return m_rootSignatureDesc; }
 private:
 	void CalculateLayout(const std::vector<BindParameterDesc>& parameters);
-	void DistributeParameters(const std::vector<BindParameterDesc>& parameters,
-		std::vector<std::vector<BindParameterDesc>> & tableParams,
-		std::vector<BindParameterDesc> & samplerParams,
-		std::vector<BindParameterDesc> & constantParams);
+	std::vector<RootSlotLayout> DistributeParameters(const std::vector<BindParameterDesc>& parameters);
+	static int SlotSize(const RootSlotLayout& slot);
 	gxapi::DescriptorRange::eType CastRangeType(eBindParameterType source);
 
 	std::pair<std::vector<RootParameterMapping>::const_iterator, bool> FindMapping(BindParameter param) const;
 private:
 	std::vector<RootParameterMapping> m_parameters;
-	std::unique_ptr<gxapi::IRootSignature> m_rootSignature;
+	std::shared_ptr<gxapi::IRootSignature> m_rootSignature;
 	gxapi::RootSignatureDesc m_rootSignatureDesc;
 
 	// Maximum root signature size = 64 DWORDs.
@@ -2,7 +2,9 @@
 
 #include "RootTableManager.hpp"
 #include "ResourceView.hpp"
+#include "TextureTable.hpp"
 #include <stdexcept>
+#include <vector>
 
 
 namespace inl::gxeng {
@@ -14,9 +16,19 @@ public:
 	BindingManager();
 	BindingManager(gxapi::IGraphicsApi* graphicsApi, CommandListT* commandList);
 
-	using RootTableManager::SetBinder;
 	using RootTableManager::SetDescriptorHeap;
 	using RootTableManager::CommitDrawCall;
+	using RootTableManager::GetNumSubmittedCalls;
+	using RootTableManager::GetNumFilteredCalls;
+
+	/// <summary> Sets the binder, root constants and constant buffers are forgotten if the root signature changes. </summary>
+	void SetBinder(Binder* binder);
+
+	/// <summary> Forgets the root constants and constant buffers, the next binds set them again.
+	///		Used after bundles, which may change them. </summary>
+	void InvalidateRootArguments();
+	/// <summary> Forgets the root signature and all arguments. Used after the state of the command list was cleared. </summary>
+	void InvalidateRootSignature();
 
 	void Bind(BindParameter parameter, const TextureView1D& shaderResource);
 	void Bind(BindParameter parameter, const TextureView2D& shaderResource);
@@ -28,6 +40,12 @@ public:
 	void Bind(BindParameter parameter, const RWTextureView2D& rwResource);
 	void Bind(BindParameter parameter, const RWTextureView3D& rwResource);
 	void Bind(BindParameter parameter, const RWBufferView& rwResource);
+
+	/// <summary> Binds the texture table to an array of textures, shaders pick textures by index.
+	///		The table is synced to the current scratch space first, so that textures created since it was requested are included. </summary>
+	/// <exception cref="std::invalid_argument"> If the parameter is not an array of textures with a table of its own, or its size is not the capacity of the table. </exception>
+	/// <exception cref="std::logic_error"> If the scratch space does not reserve room for the table. </exception>
+	void Bind(BindParameter parameter, TextureTable& textureTable);
 protected:
 	void SetRootConstants(gxapi::IGraphicsCommandList* list, unsigned parameterIndex, unsigned destOffset, unsigned numValues, const uint32_t* value);
 	void SetRootConstants(gxapi::IComputeCommandList* list, unsigned parameterIndex, unsigned destOffset, unsigned numValues, const uint32_t* value);
@@ -35,8 +53,18 @@ protected:
 	void SetRootConstantBuffer(gxapi::IComputeCommandList* list, unsigned parameterIndex, void* gpuVirtualAddress);
 
 private:
+	/// <summary> Root constants and constant buffers last set on the command list, redundant binds are dropped. </summary>
+	struct RootArgumentState {
+		void* constantBuffer = nullptr; // nullptr if not known
+		std::vector<uint32_t> constants;
+		std::vector<bool> constantsKnown;
+	};
+
 	void BindTexture(BindParameter parameter, gxapi::DescriptorHandle handle);
 	void BindUav(BindParameter parameter, gxapi::DescriptorHandle handle);
+	RootArgumentState& GetRootArgument(int slot);
+private:
+	std::vector<RootArgumentState> m_rootArguments; // indexed by root parameter
 };
 
 
@@ -51,6 +79,27 @@ BindingManager<Type>::BindingManager(gxapi::IGraphicsApi* graphicsApi, CommandLi
 {}
 
 
+template <gxapi::eCommandListType Type>
+void BindingManager<Type>::SetBinder(Binder* binder) {
+	if (RootTableManager::SetBinder(binder)) {
+		InvalidateRootArguments();
+	}
+}
+
+
+template <gxapi::eCommandListType Type>
+void BindingManager<Type>::InvalidateRootArguments() {
+	m_rootArguments.clear();
+}
+
+
+template <gxapi::eCommandListType Type>
+void BindingManager<Type>::InvalidateRootSignature() {
+	RootTableManager::InvalidateRootSignature();
+	InvalidateRootArguments();
+}
+
+
 template <gxapi::eCommandListType Type>
 void BindingManager<Type>::Bind(BindParameter parameter, const TextureView1D& shaderResource) {
 	return BindTexture(parameter, shaderResource.GetHandle());
@@ -97,7 +146,15 @@ void BindingManager<Type>::Bind(BindParameter parameter, const ConstBufferView&
 	const auto& rootParam = desc.rootParameters[slot];
 
 	if (rootParam.type == gxapi::RootParameterDesc::CBV) {
-		SetRootConstantBuffer(m_commandList, slot, shaderConstant.GetResource().GetVirtualAddress());
+		void* address = shaderConstant.GetResource().GetVirtualAddress();
+		RootArgumentState& argument = GetRootArgument(slot);
+		if (argument.constantBuffer == address) {
+			++m_numFilteredCalls;
+			return;
+		}
+		argument.constantBuffer = address;
+		SetRootConstantBuffer(m_commandList, slot, address);
+		++m_numSubmittedCalls;
 	}
 	else if (rootParam.type == gxapi::RootParameterDesc::DESCRIPTOR_TABLE) {
 		UpdateBinding(shaderConstant.GetHandle(), slot, tableIndex);
@@ -122,7 +179,29 @@ void BindingManager<Type>::Bind(BindParameter parameter, const void* shaderConst
 
 	if (desc.rootParameters[slot].type == gxapi::RootParameterDesc::CONSTANT) {
 		assert(desc.rootParameters[slot].As<gxapi::RootParameterDesc::CONSTANT>().numConstants >= unsigned(size + offset) / 4);
-		SetRootConstants(m_commandList, slot, offset, size / 4, reinterpret_cast<const uint32_t*>(shaderConstant));
+		const uint32_t* values = reinterpret_cast<const uint32_t*>(shaderConstant);
+		size_t numValues = size / 4;
+
+		// values are compared to the ones last set at the same offset, unknown ones always differ
+		RootArgumentState& argument = GetRootArgument(slot);
+		if (argument.constants.size() < offset + numValues) {
+			argument.constants.resize(offset + numValues);
+			argument.constantsKnown.resize(offset + numValues, false);
+		}
+		bool same = true;
+		for (size_t i = 0; i < numValues && same; ++i) {
+			same = argument.constantsKnown[offset + i] && argument.constants[offset + i] == values[i];
+		}
+		if (same) {
+			++m_numFilteredCalls;
+			return;
+		}
+		for (size_t i = 0; i < numValues; ++i) {
+			argument.constants[offset + i] = values[i];
+			argument.constantsKnown[offset + i] = true;
+		}
+		SetRootConstants(m_commandList, slot, offset, (unsigned)numValues, values);
+		++m_numSubmittedCalls;
 	}
 	else {
 		throw std::invalid_argument("Parameter is not an inline constant.");
@@ -169,6 +248,40 @@ void BindingManager<Type>::Bind(BindParameter parameter, const RWBufferView& rwR
 }
 
 
+template <gxapi::eCommandListType Type>
+void BindingManager<Type>::Bind(BindParameter parameter, TextureTable& textureTable) {
+	assert(m_binder != nullptr);
+
+	int slot, tableIndex;
+	const gxapi::RootSignatureDesc& desc = m_binder->GetRootSignatureDesc();
+	m_binder->Translate(parameter, slot, tableIndex);
+	const auto& rootParam = desc.rootParameters[slot];
+
+	if (rootParam.type != gxapi::RootParameterDesc::DESCRIPTOR_TABLE || tableIndex != 0) {
+		throw std::invalid_argument("Parameter is not a texture array with a table of its own.");
+	}
+	const auto& ranges = rootParam.As<gxapi::RootParameterDesc::DESCRIPTOR_TABLE>().ranges;
+	if (ranges.size() != 1 || ranges[0].type != gxapi::DescriptorRange::SRV || ranges[0].numDescriptors != textureTable.GetCapacity()) {
+		throw std::invalid_argument("Parameter is not a texture array the size of the texture table.");
+	}
+	if (m_heap->GetReservedSize() < textureTable.GetCapacity()) {
+		throw std::logic_error("Scratch space does not reserve room for the texture table.");
+	}
+
+	textureTable.Sync(*m_heap);
+	UpdateReservedTable(slot);
+}
+
+
+template <gxapi::eCommandListType Type>
+auto BindingManager<Type>::GetRootArgument(int slot) -> RootArgumentState& {
+	if (m_rootArguments.size() <= (size_t)slot) {
+		m_rootArguments.resize(slot + 1);
+	}
+	return m_rootArguments[slot];
+}
+
+
 template <gxapi::eCommandListType Type>
 void BindingManager<Type>::SetRootConstants(gxapi::IGraphicsCommandList* list, unsigned parameterIndex, unsigned destOffset, unsigned numValues, const uint32_t* value) {
 	list->SetGraphicsRootConstants(parameterIndex, destOffset, numValues, value);
@@ -0,0 +1,100 @@
+#include "BoundingVolume.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace inl {
+namespace gxeng {
+
+
+Aabb ComputeAabb(const mathfu::Vector<float, 3>* points, size_t count) {
+	Aabb aabb;
+	if (count == 0) {
+		return aabb;
+	}
+
+	aabb.min = aabb.max = points[0];
+	for (size_t i = 1; i < count; ++i) {
+		aabb.min = mathfu::Vector<float, 3>::Min(aabb.min, points[i]);
+		aabb.max = mathfu::Vector<float, 3>::Max(aabb.max, points[i]);
+	}
+	return aabb;
+}
+
+
+BoundingSphere ComputeBoundingSphere(const mathfu::Vector<float, 3>* points, size_t count) {
+	Aabb aabb = ComputeAabb(points, count);
+
+	BoundingSphere sphere;
+	sphere.center = (aabb.min + aabb.max) * 0.5f;
+	float radiusSq = 0;
+	for (size_t i = 0; i < count; ++i) {
+		radiusSq = std::max(radiusSq, (points[i] - sphere.center).LengthSquared());
+	}
+	sphere.radius = std::sqrt(radiusSq);
+	return sphere;
+}
+
+
+Aabb Merge(const Aabb& lhs, const Aabb& rhs) {
+	Aabb aabb;
+	aabb.min = mathfu::Vector<float, 3>::Min(lhs.min, rhs.min);
+	aabb.max = mathfu::Vector<float, 3>::Max(lhs.max, rhs.max);
+	return aabb;
+}
+
+
+BoundingSphere Merge(const BoundingSphere& lhs, const BoundingSphere& rhs) {
+	mathfu::Vector<float, 3> offset = rhs.center - lhs.center;
+	float distance = offset.Length();
+
+	// one contains the other
+	if (distance + rhs.radius <= lhs.radius) {
+		return lhs;
+	}
+	if (distance + lhs.radius <= rhs.radius) {
+		return rhs;
+	}
+
+	BoundingSphere sphere;
+	sphere.radius = (distance + lhs.radius + rhs.radius) * 0.5f;
+	sphere.center = lhs.center + offset * ((sphere.radius - lhs.radius) / distance);
+	return sphere;
+}
+
+
+Aabb TransformAabb(const Aabb& aabb, const mathfu::Matrix<float, 4, 4>& transform) {
+	mathfu::Vector<float, 3> center = transform * ((aabb.min + aabb.max) * 0.5f);
+	mathfu::Vector<float, 3> halfSize = (aabb.max - aabb.min) * 0.5f;
+
+	// extent along each world axis is the sum of the transformed half size's absolute components
+	mathfu::Vector<float, 3> extent;
+	for (int row = 0; row < 3; ++row) {
+		extent[row] = std::abs(transform(row, 0)) * halfSize[0]
+			+ std::abs(transform(row, 1)) * halfSize[1]
+			+ std::abs(transform(row, 2)) * halfSize[2];
+	}
+
+	Aabb result;
+	result.min = center - extent;
+	result.max = center + extent;
+	return result;
+}
+
+
+BoundingSphere TransformSphere(const BoundingSphere& sphere, const mathfu::Matrix<float, 4, 4>& transform) {
+	float scaleSq = std::max({
+		transform.GetColumn(0).xyz().LengthSquared(),
+		transform.GetColumn(1).xyz().LengthSquared(),
+		transform.GetColumn(2).xyz().LengthSquared() });
+
+	BoundingSphere result;
+	result.center = transform * sphere.center;
+	result.radius = sphere.radius * std::sqrt(scaleSq);
+	return result;
+}
+
+
+} // namespace gxeng
+} // namespace inl
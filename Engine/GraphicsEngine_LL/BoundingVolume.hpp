@@ -0,0 +1,50 @@
+#pragma once
+
+#include <mathfu/vector.h>
+#include <mathfu/vector_3.h>
+#include <mathfu/matrix_4x4.h>
+
+#include <cstddef>
+
+
+namespace inl {
+namespace gxeng {
+
+
+/// <summary> Axis aligned bounding box. Empty boxes have min greater than max. </summary>
+struct Aabb {
+	mathfu::Vector<float, 3> min = { 0, 0, 0 };
+	mathfu::Vector<float, 3> max = { 0, 0, 0 };
+};
+
+
+/// <summary> Sphere that contains an object. </summary>
+struct BoundingSphere {
+	mathfu::Vector<float, 3> center = { 0, 0, 0 };
+	float radius = 0;
+};
+
+
+/// <summary> Smallest axis aligned box containing the points. A single point at the origin if there are no points. </summary>
+Aabb ComputeAabb(const mathfu::Vector<float, 3>* points, size_t count);
+
+/// <summary> Sphere around the center of the bounding box of the points, just large enough to contain them. </summary>
+BoundingSphere ComputeBoundingSphere(const mathfu::Vector<float, 3>* points, size_t count);
+
+/// <summary> Smallest axis aligned box containing both boxes. </summary>
+Aabb Merge(const Aabb& lhs, const Aabb& rhs);
+
+/// <summary> Smallest sphere containing both spheres. </summary>
+BoundingSphere Merge(const BoundingSphere& lhs, const BoundingSphere& rhs);
+
+/// <summary> Smallest axis aligned box containing the box transformed by the matrix. </summary>
+Aabb TransformAabb(const Aabb& aabb, const mathfu::Matrix<float, 4, 4>& transform);
+
+/// <summary> Sphere that contains the sphere transformed by the matrix. </summary>
+/// <remarks> The radius is scaled by the largest scale of the matrix, so the result stays conservative
+///		for non-uniform scaling. </remarks>
+BoundingSphere TransformSphere(const BoundingSphere& sphere, const mathfu::Matrix<float, 4, 4>& transform);
+
+
+} // namespace gxeng
+} // namespace inl
@@ -0,0 +1,462 @@
+#include "BoundingVolumeHierarchy.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <functional>
+#include <cmath>
+
+
+namespace inl {
+namespace gxeng {
+
+
+namespace {
+
+enum class eOverlap {
+	NONE,
+	PARTIAL,
+	FULL,
+};
+
+
+float SurfaceArea(const Aabb& aabb) {
+	mathfu::Vector<float, 3> size = mathfu::Vector<float, 3>::Max(aabb.max - aabb.min, { 0, 0, 0 });
+	return 2 * (size.x() * size.y() + size.y() * size.z() + size.z() * size.x());
+}
+
+
+Aabb EmptyAabb() {
+	Aabb aabb;
+	aabb.min = mathfu::Vector<float, 3>(std::numeric_limits<float>::infinity());
+	aabb.max = mathfu::Vector<float, 3>(-std::numeric_limits<float>::infinity());
+	return aabb;
+}
+
+
+bool operator!=(const Aabb& lhs, const Aabb& rhs) {
+	return lhs.min != rhs.min || lhs.max != rhs.max;
+}
+
+} // namespace
+
+
+
+//------------------------------------------------------------------------------
+// Builder
+//------------------------------------------------------------------------------
+
+class BoundingVolumeHierarchy::Builder {
+public:
+	static constexpr int NumBins = 16;
+	static constexpr uint32_t ParallelThreshold = 4096;
+	static constexpr int MaxParallelDepth = 4;
+public:
+	Builder(const Aabb* bounds, Node* nodes, uint32_t* items, uint32_t count);
+
+	/// <summary> Builds the subtree of items [first, first + count) into the node. </summary>
+	void Build(uint32_t nodeIndex, uint32_t first, uint32_t count, int depth);
+
+	uint32_t GetNumNodes() const { return m_numNodes; }
+private:
+	struct Split {
+		int axis = -1;
+		int bin = 0;
+		float cost = std::numeric_limits<float>::infinity();
+	};
+
+	Split FindSplit(uint32_t first, uint32_t count, const Aabb& centroidBounds) const;
+	int BinOf(uint32_t item, int axis, const Aabb& centroidBounds) const;
+private:
+	const Aabb* m_bounds;
+	Node* m_nodes;
+	uint32_t* m_items;
+	std::vector<mathfu::Vector<float, 3>> m_centroids;
+	std::atomic<uint32_t> m_numNodes;
+};
+
+
+BoundingVolumeHierarchy::Builder::Builder(const Aabb* bounds, Node* nodes, uint32_t* items, uint32_t count)
+	: m_bounds(bounds), m_nodes(nodes), m_items(items), m_centroids(count), m_numNodes(1)
+{
+	for (uint32_t i = 0; i < count; ++i) {
+		m_centroids[i] = (bounds[i].min + bounds[i].max) * 0.5f;
+	}
+}
+
+
+void BoundingVolumeHierarchy::Builder::Build(uint32_t nodeIndex, uint32_t first, uint32_t count, int depth) {
+	Aabb bounds = EmptyAabb();
+	Aabb centroidBounds = EmptyAabb();
+	for (uint32_t i = first; i < first + count; ++i) {
+		bounds = Merge(bounds, m_bounds[m_items[i]]);
+		centroidBounds.min = mathfu::Vector<float, 3>::Min(centroidBounds.min, m_centroids[m_items[i]]);
+		centroidBounds.max = mathfu::Vector<float, 3>::Max(centroidBounds.max, m_centroids[m_items[i]]);
+	}
+
+	Node& node = m_nodes[nodeIndex];
+	node.bounds = bounds;
+	node.first = first;
+	node.count = count;
+
+	if (count <= 1) {
+		return;
+	}
+
+	// Splitting costs one box test on top of the children, a leaf tests all its items.
+	Split split = FindSplit(first, count, centroidBounds);
+	float leafCost = float(count);
+	uint32_t leftCount;
+	if (split.axis < 0) {
+		// all centroids are the same, split in half if too many for a leaf
+		if (count <= MaxLeafSize) {
+			return;
+		}
+		leftCount = count / 2;
+	}
+	else {
+		float area = SurfaceArea(bounds);
+		float splitCost = 1.0f + (area > 0 ? split.cost / area : 0.0f);
+		if (splitCost >= leafCost && count <= MaxLeafSize) {
+			return;
+		}
+		auto middle = std::partition(m_items + first, m_items + first + count, [&](uint32_t item) {
+			return BinOf(item, split.axis, centroidBounds) <= split.bin;
+		});
+		leftCount = uint32_t(middle - (m_items + first));
+		if (leftCount == 0 || leftCount == count) {
+			leftCount = count / 2;
+		}
+	}
+
+	uint32_t left = m_numNodes.fetch_add(2);
+	node.first = left;
+	node.count = 0;
+
+	if (count >= ParallelThreshold && depth < MaxParallelDepth) {
+		auto leftBuild = std::async(std::launch::async, [=] { Build(left, first, leftCount, depth + 1); });
+		Build(left + 1, first + leftCount, count - leftCount, depth + 1);
+		leftBuild.get();
+	}
+	else {
+		Build(left, first, leftCount, depth + 1);
+		Build(left + 1, first + leftCount, count - leftCount, depth + 1);
+	}
+}
+
+
+auto BoundingVolumeHierarchy::Builder::FindSplit(uint32_t first, uint32_t count, const Aabb& centroidBounds) const -> Split {
+	Split best;
+
+	for (int axis = 0; axis < 3; ++axis) {
+		if (!(centroidBounds.max[axis] > centroidBounds.min[axis])) {
+			continue;
+		}
+
+		Aabb binBounds[NumBins];
+		uint32_t binCounts[NumBins] = {};
+		std::fill(std::begin(binBounds), std::end(binBounds), EmptyAabb());
+		for (uint32_t i = first; i < first + count; ++i) {
+			int bin = BinOf(m_items[i], axis, centroidBounds);
+			binBounds[bin] = Merge(binBounds[bin], m_bounds[m_items[i]]);
+			++binCounts[bin];
+		}
+
+		// cost of the right side for splitting after each bin, sweeping from the right
+		float rightCosts[NumBins];
+		Aabb accumulated = EmptyAabb();
+		uint32_t accumulatedCount = 0;
+		for (int bin = NumBins - 1; bin > 0; --bin) {
+			accumulated = Merge(accumulated, binBounds[bin]);
+			accumulatedCount += binCounts[bin];
+			rightCosts[bin - 1] = accumulatedCount > 0 ? SurfaceArea(accumulated) * accumulatedCount : 0.0f;
+		}
+
+		accumulated = EmptyAabb();
+		accumulatedCount = 0;
+		for (int bin = 0; bin < NumBins - 1; ++bin) {
+			accumulated = Merge(accumulated, binBounds[bin]);
+			accumulatedCount += binCounts[bin];
+			if (accumulatedCount == 0 || accumulatedCount == count) {
+				continue;
+			}
+			float cost = SurfaceArea(accumulated) * accumulatedCount + rightCosts[bin];
+			if (cost < best.cost) {
+				best.axis = axis;
+				best.bin = bin;
+				best.cost = cost;
+			}
+		}
+	}
+
+	return best;
+}
+
+
+int BoundingVolumeHierarchy::Builder::BinOf(uint32_t item, int axis, const Aabb& centroidBounds) const {
+	float extent = centroidBounds.max[axis] - centroidBounds.min[axis];
+	int bin = int(NumBins * (m_centroids[item][axis] - centroidBounds.min[axis]) / extent);
+	return std::min(std::max(bin, 0), NumBins - 1);
+}
+
+
+
+//------------------------------------------------------------------------------
+// Building and refitting
+//------------------------------------------------------------------------------
+
+void BoundingVolumeHierarchy::Build(const Aabb* bounds, size_t count) {
+	Clear();
+	if (count == 0) {
+		return;
+	}
+
+	m_items.resize(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		m_items[i] = i;
+	}
+
+	// a binary tree with at least one item per leaf has at most 2 * count - 1 nodes
+	m_nodes.resize(2 * count - 1);
+	Builder builder(bounds, m_nodes.data(), m_items.data(), uint32_t(count));
+	builder.Build(0, 0, uint32_t(count), 0);
+	m_nodes.resize(builder.GetNumNodes());
+
+	LinkNodes();
+	m_weightedArea = ComputeWeightedArea();
+	m_cost = m_builtCost = NormalizeCost(m_weightedArea);
+}
+
+
+bool BoundingVolumeHierarchy::Refit(const Aabb* bounds) {
+	// children always come after their parent, so going backwards visits children first
+	bool changed = false;
+	for (size_t i = m_nodes.size(); i-- > 0; ) {
+		Node& node = m_nodes[i];
+		Aabb nodeBounds = FitNode(node, bounds);
+		if (nodeBounds != node.bounds) {
+			node.bounds = nodeBounds;
+			changed = true;
+		}
+	}
+
+	if (changed) {
+		m_weightedArea = ComputeWeightedArea();
+		m_cost = NormalizeCost(m_weightedArea);
+	}
+	return changed;
+}
+
+
+bool BoundingVolumeHierarchy::Refit(const Aabb* bounds, const std::vector<uint32_t>& movedItems) {
+	// Only the leaves of the moved items and their ancestors change. Walking up stops at nodes
+	// already marked, their ancestors are marked too.
+	m_refitNodes.clear();
+	for (uint32_t item : movedItems) {
+		for (uint32_t nodeIndex = m_leafOfItems[item]; nodeIndex != InvalidNode && !m_refitMarks[nodeIndex]; nodeIndex = m_parents[nodeIndex]) {
+			m_refitMarks[nodeIndex] = 1;
+			m_refitNodes.push_back(nodeIndex);
+		}
+	}
+
+	// children always come after their parent, so going backwards visits children first
+	std::sort(m_refitNodes.begin(), m_refitNodes.end(), std::greater<uint32_t>());
+	bool changed = false;
+	for (uint32_t nodeIndex : m_refitNodes) {
+		m_refitMarks[nodeIndex] = 0;
+		Node& node = m_nodes[nodeIndex];
+		Aabb nodeBounds = FitNode(node, bounds);
+		if (nodeBounds != node.bounds) {
+			float weight = node.count > 0 ? float(node.count) : 1.0f;
+			m_weightedArea += (SurfaceArea(nodeBounds) - SurfaceArea(node.bounds)) * weight;
+			node.bounds = nodeBounds;
+			changed = true;
+		}
+	}
+
+	if (changed) {
+		m_cost = NormalizeCost(m_weightedArea);
+	}
+	return changed;
+}
+
+
+void BoundingVolumeHierarchy::Clear() {
+	m_nodes.clear();
+	m_items.clear();
+	m_parents.clear();
+	m_leafOfItems.clear();
+	m_refitMarks.clear();
+	m_weightedArea = m_cost = m_builtCost = 0;
+}
+
+
+bool BoundingVolumeHierarchy::NeedsRebuild() const {
+	return m_cost > m_builtCost * RebuildThreshold;
+}
+
+
+void BoundingVolumeHierarchy::LinkNodes() {
+	m_parents.assign(m_nodes.size(), InvalidNode);
+	m_leafOfItems.resize(m_items.size());
+	m_refitMarks.assign(m_nodes.size(), 0);
+	for (uint32_t i = 0; i < m_nodes.size(); ++i) {
+		const Node& node = m_nodes[i];
+		if (node.count > 0) {
+			for (uint32_t j = node.first; j < node.first + node.count; ++j) {
+				m_leafOfItems[m_items[j]] = i;
+			}
+		}
+		else {
+			m_parents[node.first] = i;
+			m_parents[node.first + 1] = i;
+		}
+	}
+}
+
+
+Aabb BoundingVolumeHierarchy::FitNode(const Node& node, const Aabb* bounds) const {
+	if (node.count == 0) {
+		return Merge(m_nodes[node.first].bounds, m_nodes[node.first + 1].bounds);
+	}
+
+	Aabb nodeBounds = bounds[m_items[node.first]];
+	for (uint32_t j = node.first + 1; j < node.first + node.count; ++j) {
+		nodeBounds = Merge(nodeBounds, bounds[m_items[j]]);
+	}
+	return nodeBounds;
+}
+
+
+float BoundingVolumeHierarchy::ComputeWeightedArea() const {
+	float weightedArea = 0;
+	for (auto& node : m_nodes) {
+		weightedArea += SurfaceArea(node.bounds) * (node.count > 0 ? node.count : 1);
+	}
+	return weightedArea;
+}
+
+
+float BoundingVolumeHierarchy::NormalizeCost(float weightedArea) const {
+	if (m_nodes.empty()) {
+		return 0;
+	}
+
+	float rootArea = SurfaceArea(m_nodes[0].bounds);
+	if (rootArea <= 0) {
+		return float(m_items.size());
+	}
+	return weightedArea / rootArea;
+}
+
+
+
+//------------------------------------------------------------------------------
+// Queries
+//------------------------------------------------------------------------------
+
+template <class Test>
+void BoundingVolumeHierarchy::Query(Test&& test, std::vector<uint32_t>& items) const {
+	if (m_nodes.empty()) {
+		return;
+	}
+
+	uint32_t stack[64];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0) {
+		uint32_t nodeIndex = stack[--stackSize];
+		const Node& node = m_nodes[nodeIndex];
+
+		eOverlap overlap = test(node.bounds);
+		if (overlap == eOverlap::NONE) {
+			continue;
+		}
+		if (overlap == eOverlap::FULL) {
+			AppendSubtree(nodeIndex, items);
+			continue;
+		}
+
+		if (node.count > 0) {
+			items.insert(items.end(), m_items.begin() + node.first, m_items.begin() + node.first + node.count);
+		}
+		else if (stackSize + 2 <= 64) {
+			stack[stackSize++] = node.first + 1;
+			stack[stackSize++] = node.first;
+		}
+		else {
+			// pathologically deep tree, avoid overflowing the stack
+			AppendSubtree(nodeIndex, items);
+		}
+	}
+}
+
+
+void BoundingVolumeHierarchy::AppendSubtree(uint32_t nodeIndex, std::vector<uint32_t>& items) const {
+	const Node& node = m_nodes[nodeIndex];
+	if (node.count > 0) {
+		items.insert(items.end(), m_items.begin() + node.first, m_items.begin() + node.first + node.count);
+	}
+	else {
+		AppendSubtree(node.first, items);
+		AppendSubtree(node.first + 1, items);
+	}
+}
+
+
+void BoundingVolumeHierarchy::QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& items) const {
+	Query([&frustum](const Aabb& bounds) {
+		if (!frustum.IsVisible(bounds)) {
+			return eOverlap::NONE;
+		}
+		return frustum.Contains(bounds) ? eOverlap::FULL : eOverlap::PARTIAL;
+	}, items);
+}
+
+
+void BoundingVolumeHierarchy::QueryAabb(const Aabb& aabb, std::vector<uint32_t>& items) const {
+	Query([&aabb](const Aabb& bounds) {
+		for (int axis = 0; axis < 3; ++axis) {
+			if (bounds.max[axis] < aabb.min[axis] || aabb.max[axis] < bounds.min[axis]) {
+				return eOverlap::NONE;
+			}
+		}
+		return eOverlap::PARTIAL;
+	}, items);
+}
+
+
+void BoundingVolumeHierarchy::QuerySphere(const BoundingSphere& sphere, std::vector<uint32_t>& items) const {
+	float radiusSq = sphere.radius * sphere.radius;
+	Query([&sphere, radiusSq](const Aabb& bounds) {
+		mathfu::Vector<float, 3> closest = mathfu::Vector<float, 3>::Min(mathfu::Vector<float, 3>::Max(sphere.center, bounds.min), bounds.max);
+		return (closest - sphere.center).LengthSquared() <= radiusSq ? eOverlap::PARTIAL : eOverlap::NONE;
+	}, items);
+}
+
+
+void BoundingVolumeHierarchy::QueryRay(const Ray& ray, std::vector<uint32_t>& items, float maxDistance) const {
+	mathfu::Vector<float, 3> inverseDirection(1.0f / ray.direction.x(), 1.0f / ray.direction.y(), 1.0f / ray.direction.z());
+
+	Query([&ray, &inverseDirection, maxDistance](const Aabb& bounds) {
+		// slab test, distances are in units of the direction's length
+		float enter = 0;
+		float exit = maxDistance;
+		for (int axis = 0; axis < 3; ++axis) {
+			float t1 = (bounds.min[axis] - ray.origin[axis]) * inverseDirection[axis];
+			float t2 = (bounds.max[axis] - ray.origin[axis]) * inverseDirection[axis];
+			if (std::isnan(t1) || std::isnan(t2)) {
+				// ray is parallel to the slab and starts on its boundary
+				continue;
+			}
+			enter = std::max(enter, std::min(t1, t2));
+			exit = std::min(exit, std::max(t1, t2));
+		}
+		return enter <= exit ? eOverlap::PARTIAL : eOverlap::NONE;
+	}, items);
+}
+
+
+} // namespace gxeng
+} // namespace inl
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "BoundingVolume.hpp"
+#include "FrustumCulling.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <limits>
+
+
+namespace inl {
+namespace gxeng {
+
+
+/// <summary> A half line, direction need not be unit length. </summary>
+struct Ray {
+	mathfu::Vector<float, 3> origin = { 0, 0, 0 };
+	mathfu::Vector<float, 3> direction = { 0, 0, 1 };
+};
+
+
+/// <summary>
+/// Bounding volume hierarchy over a set of items given by their bounding boxes.
+/// Items are identified by their index in the array of boxes passed to Build.
+/// <para />
+/// The tree is built top-down with binned surface area heuristic. Large subtrees
+/// are built in parallel.
+/// When items move but the set of items stays the same, Refit updates the boxes of the
+/// nodes without changing the tree, either all of them or just the ones above the moved items.
+/// Refitting makes the tree worse over time, so NeedsRebuild tells when it's worth building it again.
+/// </summary>
+/// <remarks> Queries are thread-safe with each other, but not with Build and Refit. </remarks>
+class BoundingVolumeHierarchy {
+public:
+	/// <summary> Nodes with at most this many items may become leaves. </summary>
+	static constexpr size_t MaxLeafSize = 4;
+
+	/// <summary> Ratio of the refitted and the freshly built tree's cost at which rebuilding is suggested. </summary>
+	static constexpr float RebuildThreshold = 1.5f;
+public:
+	/// <summary> Builds the tree for items [0, count). </summary>
+	void Build(const Aabb* bounds, size_t count);
+
+	/// <summary> Updates the boxes of the nodes after items moved. </summary>
+	/// <param name="bounds"> New boxes of the same items that were passed to Build. </param>
+	/// <returns> Whether any box changed. </returns>
+	bool Refit(const Aabb* bounds);
+
+	/// <summary> Updates the boxes of the nodes above the moved items only. </summary>
+	/// <param name="bounds"> New boxes of the same items that were passed to Build. </param>
+	/// <param name="movedItems"> The items whose box may have changed, the rest must be the same as before. </param>
+	/// <returns> Whether any box changed. </returns>
+	bool Refit(const Aabb* bounds, const std::vector<uint32_t>& movedItems);
+
+	/// <summary> Removes all items. </summary>
+	void Clear();
+
+	/// <summary> Whether refitting degraded the tree enough to make rebuilding worth it. </summary>
+	bool NeedsRebuild() const;
+
+	size_t GetNumItems() const { return m_items.size(); }
+	size_t GetNumNodes() const { return m_nodes.size(); }
+
+	/// <summary> Box containing all items. Only valid if there are items. </summary>
+	const Aabb& GetBounds() const { return m_nodes[0].bounds; }
+
+	/// <summary> Expected cost of a query, relative to testing the root's box only. </summary>
+	float GetCost() const { return m_cost; }
+
+	/// <summary> Appends the items whose box is at least partly inside the frustum. </summary>
+	void QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& items) const;
+
+	/// <summary> Appends the items whose box overlaps the box. </summary>
+	void QueryAabb(const Aabb& aabb, std::vector<uint32_t>& items) const;
+
+	/// <summary> Appends the items whose box overlaps the sphere. </summary>
+	void QuerySphere(const BoundingSphere& sphere, std::vector<uint32_t>& items) const;
+
+	/// <summary> Appends the items whose box the ray hits, within maxDistance times the direction's length. </summary>
+	/// <remarks> Boxes are only an estimate of the items' shapes, the caller should test the items themselves. </remarks>
+	void QueryRay(const Ray& ray, std::vector<uint32_t>& items, float maxDistance = std::numeric_limits<float>::infinity()) const;
+private:
+	struct Node {
+		Aabb bounds;
+		uint32_t first; // leaves: first item in m_items, others: left child, right child is next to it
+		uint32_t count; // leaves: number of items, others: 0
+	};
+
+	static constexpr uint32_t InvalidNode = ~uint32_t(0);
+
+	class Builder;
+
+	template <class Test>
+	void Query(Test&& test, std::vector<uint32_t>& items) const;
+	void AppendSubtree(uint32_t nodeIndex, std::vector<uint32_t>& items) const;
+	void LinkNodes();
+	Aabb FitNode(const Node& node, const Aabb* bounds) const;
+	float ComputeWeightedArea() const;
+	float NormalizeCost(float weightedArea) const;
+private:
+	std::vector<Node> m_nodes;
+	std::vector<uint32_t> m_items;
+	std::vector<uint32_t> m_parents; // parent of each node, InvalidNode for the root
+	std::vector<uint32_t> m_leafOfItems; // leaf node holding each item
+	float m_weightedArea = 0; // sum of the nodes' areas times the boxes tested at them, kept up to date by refitting
+	float m_cost = 0;
+	float m_builtCost = 0;
+
+	// reused between partial refits to avoid allocations
+	std::vector<uint32_t> m_refitNodes;
+	std::vector<uint8_t> m_refitMarks;
+};
+
+
+} // namespace gxeng
+} // namespace inl
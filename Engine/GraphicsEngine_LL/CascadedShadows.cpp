@@ -0,0 +1,118 @@
+#include "CascadedShadows.hpp"
+#include "FrustumCulling.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace inl {
+namespace gxeng {
+
+
+std::vector<float> ComputeCascadeSplits(float nearPlane, float farPlane, unsigned numCascades, float logWeight) {
+	numCascades = std::max(numCascades, 1u);
+
+	std::vector<float> splits(numCascades + 1);
+	for (unsigned i = 0; i <= numCascades; ++i) {
+		float fraction = float(i) / numCascades;
+		float logSplit = nearPlane * std::pow(farPlane / nearPlane, fraction);
+		float uniformSplit = nearPlane + (farPlane - nearPlane) * fraction;
+		splits[i] = logWeight * logSplit + (1.0f - logWeight) * uniformSplit;
+	}
+
+	// exact ends, the formula may be off by rounding
+	splits.front() = nearPlane;
+	splits.back() = farPlane;
+
+	return splits;
+}
+
+
+mathfu::Matrix<float, 4, 4> LightViewTransform(const mathfu::Vector<float, 3>& lightDirection) {
+	mathfu::Vector<float, 3> z = -lightDirection.Normalized();
+	mathfu::Vector<float, 3> x = mathfu::Vector<float, 3>::CrossProduct({ 0, 1, 0 }, z);
+	if (x.LengthSquared() < 0.0001f) {
+		x = mathfu::Vector<float, 3>(1, 0, 0);
+	}
+	else {
+		x.Normalize();
+	}
+	mathfu::Vector<float, 3> y = mathfu::Vector<float, 3>::CrossProduct(z, x);
+
+	// rows are the light's axes, so this is the inverse of the light's rotation
+	mathfu::Matrix<float, 4, 4> view = mathfu::Matrix<float, 4, 4>::Identity();
+	for (int column = 0; column < 3; ++column) {
+		view(0, column) = x[column];
+		view(1, column) = y[column];
+		view(2, column) = z[column];
+	}
+	return view;
+}
+
+
+ShadowCascade FitShadowCascade(const Camera& camera,
+							   const mathfu::Matrix<float, 4, 4>& lightView,
+							   float nearDistance,
+							   float farDistance,
+							   unsigned resolution,
+							   float casterDistance)
+{
+	// Bounding sphere of the frustum slice, only depends on the camera's lens, not its orientation.
+	// Its center is on the view axis at distance d, equally far from the near and far corners.
+	mathfu::Matrix<float, 4, 4> projection = camera.GetPerspectiveMatrixRH();
+	float tanX = 1.0f / projection(0, 0);
+	float tanY = 1.0f / projection(1, 1);
+	float cornerSlopeSq = 1.0f + tanX * tanX + tanY * tanY;
+	float centerDistance = std::min(0.5f * (nearDistance + farDistance) * cornerSlopeSq, farDistance);
+	float nearOffset = centerDistance - nearDistance;
+	float farOffset = farDistance - centerDistance;
+	float radius = std::sqrt(std::max(nearOffset * nearOffset + nearDistance * nearDistance * (cornerSlopeSq - 1.0f),
+									  farOffset * farOffset + farDistance * farDistance * (cornerSlopeSq - 1.0f)));
+	radius = std::ceil(radius * 16.0f) / 16.0f; // rounding errors would change the size slightly from frame to frame
+
+	mathfu::Vector<float, 3> center = camera.GetPosition() + camera.GetLookDirection().Normalized() * centerDistance;
+
+	// Snap the center to the texel grid in the light's space.
+	mathfu::Vector<float, 4> lightCenter = lightView * mathfu::Vector<float, 4>(center, 1.0f);
+	float texelSize = 2.0f * radius / std::max(resolution, 1u);
+	float centerX = std::floor(lightCenter.x() / texelSize) * texelSize;
+	float centerY = std::floor(lightCenter.y() / texelSize) * texelSize;
+	float nearZ = lightCenter.z() + radius + casterDistance;
+	float farZ = lightCenter.z() - radius;
+
+	// Orthographic projection of the box around the sphere, extended towards the light.
+	mathfu::Matrix<float, 4, 4> ortho = mathfu::Matrix<float, 4, 4>::Identity();
+	ortho(0, 0) = 1.0f / radius;
+	ortho(0, 3) = -centerX / radius;
+	ortho(1, 1) = 1.0f / radius;
+	ortho(1, 3) = -centerY / radius;
+	ortho(2, 2) = -1.0f / (nearZ - farZ);
+	ortho(2, 3) = nearZ / (nearZ - farZ);
+
+	ShadowCascade cascade;
+	cascade.nearDistance = nearDistance;
+	cascade.farDistance = farDistance;
+	cascade.viewProjection = ortho * lightView;
+	return cascade;
+}
+
+
+void CullShadowCasters(const std::vector<ShadowCascade>& cascades,
+					   const float* centersX,
+					   const float* centersY,
+					   const float* centersZ,
+					   const float* radii,
+					   size_t count,
+					   std::vector<std::vector<uint32_t>>& casters)
+{
+	casters.resize(cascades.size());
+	for (size_t i = 0; i < cascades.size(); ++i) {
+		casters[i].resize(count);
+		size_t numCasters = CullSpheres(Frustum(cascades[i].viewProjection), centersX, centersY, centersZ, radii, count, casters[i].data());
+		casters[i].resize(numCasters);
+	}
+}
+
+
+} // namespace gxeng
+} // namespace inl
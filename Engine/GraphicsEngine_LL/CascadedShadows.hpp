@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Camera.hpp"
+
+#include <mathfu/vector_3.h>
+#include <mathfu/matrix_4x4.h>
+
+#include <vector>
+#include <cstdint>
+
+
+namespace inl {
+namespace gxeng {
+
+
+/// <summary> Maximum number of cascades the shaders can sample. </summary>
+constexpr unsigned MaxShadowCascades = 4;
+
+
+/// <summary> One cascade of a directional light's cascaded shadow map. </summary>
+struct ShadowCascade {
+	/// <summary> View distances of the part of the camera's frustum the cascade covers. </summary>
+	float nearDistance = 0;
+	float farDistance = 0;
+
+	/// <summary> Transforms world space to the cascade's clip space. Depth is 0 nearest to the light and 1 farthest. </summary>
+	mathfu::Matrix<float, 4, 4> viewProjection = mathfu::Matrix<float, 4, 4>::Identity();
+};
+
+
+/// <summary> Distances that split the camera's view range into cascades. </summary>
+/// <param name="logWeight"> Blends logarithmic (1) and uniform (0) splitting.
+///		Logarithmic splits give each cascade the same shadow map resolution on screen. </param>
+/// <returns> numCascades + 1 increasing distances, the first is nearPlane, the last is farPlane. </returns>
+std::vector<float> ComputeCascadeSplits(float nearPlane, float farPlane, unsigned numCascades, float logWeight = 0.75f);
+
+
+/// <summary> Rotation from world space to the light's space, where the light shines along -z. </summary>
+mathfu::Matrix<float, 4, 4> LightViewTransform(const mathfu::Vector<float, 3>& lightDirection);
+
+
+/// <summary>
+/// Fits a cascade on the part of the camera's view frustum between the two view distances.
+/// <para />
+/// The cascade covers the bounding sphere of that part, so its size does not change as the camera
+/// turns, and its position is snapped to whole shadow map texels, so shadow edges stay still as
+/// the camera moves.
+/// </summary>
+/// <param name="lightView"> The light's LightViewTransform. </param>
+/// <param name="resolution"> Width and height of the cascade's shadow map in texels. </param>
+/// <param name="casterDistance"> How far towards the light from the covered part casters are still drawn. </param>
+ShadowCascade FitShadowCascade(const Camera& camera,
+							   const mathfu::Matrix<float, 4, 4>& lightView,
+							   float nearDistance,
+							   float farDistance,
+							   unsigned resolution,
+							   float casterDistance);
+
+
+/// <summary> Finds the spheres that may cast shadows into each cascade, given as separate arrays of center coordinates and radii. </summary>
+/// <param name="casters"> casters[i] receives the indices of the spheres that overlap the i-th cascade's volume, in increasing order. </param>
+void CullShadowCasters(const std::vector<ShadowCascade>& cascades,
+					   const float* centersX,
+					   const float* centersY,
+					   const float* centersZ,
+					   const float* radii,
+					   size_t count,
+					   std::vector<std::vector<uint32_t>>& casters);
+
+
+} // namespace gxeng
+} // namespace inl
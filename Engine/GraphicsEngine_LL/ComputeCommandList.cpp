@@ -35,7 +35,11 @@ ComputeCommandList::ComputeCommandList(
 
 ComputeCommandList::ComputeCommandList(ComputeCommandList&& rhs)
 	: CopyCommandList(std::move(rhs)),
-	m_commandList(rhs.m_commandList)
+	m_commandList(rhs.m_commandList),
+	m_pipelineState(rhs.m_pipelineState),
+	m_numSubmittedStateCalls(rhs.m_numSubmittedStateCalls),
+	m_numFilteredStateCalls(rhs.m_numFilteredStateCalls),
+	m_computeBindingManager(std::move(rhs.m_computeBindingManager))
 {
 	rhs.m_commandList = nullptr;
 }
@@ -44,6 +48,10 @@ ComputeCommandList::ComputeCommandList(ComputeCommandList&& rhs)
 ComputeCommandList& ComputeCommandList::operator=(ComputeCommandList&& rhs) {
 	CopyCommandList::operator=(std::move(rhs));
 	m_commandList = rhs.m_commandList;
+	m_pipelineState = rhs.m_pipelineState;
+	m_numSubmittedStateCalls = rhs.m_numSubmittedStateCalls;
+	m_numFilteredStateCalls = rhs.m_numFilteredStateCalls;
+	m_computeBindingManager = std::move(rhs.m_computeBindingManager);
 	rhs.m_commandList = nullptr;
 
 	return *this;
@@ -61,19 +69,58 @@ BasicCommandList::Decomposition ComputeCommandList::Decompose() {
 // Draw
 //------------------------------------------------------------------------------
 void ComputeCommandList::Dispatch(size_t numThreadGroupsX, size_t numThreadGroupsY, size_t numThreadGroupsZ) {
+	CommitComputeBindings();
 	m_commandList->Dispatch(numThreadGroupsX, numThreadGroupsY, numThreadGroupsZ);
 }
 
 
+void ComputeCommandList::CommitComputeBindings() {
+	try {
+		m_computeBindingManager.CommitDrawCall();
+	}
+	catch (std::bad_alloc&) {
+		NewScratchSpace(1000);
+		m_computeBindingManager.CommitDrawCall();
+	}
+}
+
+
 //------------------------------------------------------------------------------
 // Command list state
 //------------------------------------------------------------------------------
 void ComputeCommandList::ResetState(gxapi::IPipelineState* newState) {
 	m_commandList->ResetState(newState);
+	InvalidateState();
+	m_pipelineState = newState;
 }
 
 void ComputeCommandList::SetPipelineState(gxapi::IPipelineState* pipelineState) {
+	if (pipelineState == m_pipelineState) {
+		CountStateCall(false);
+		return;
+	}
 	m_commandList->SetPipelineState(pipelineState);
+	m_pipelineState = pipelineState;
+	CountStateCall(true);
+}
+
+
+size_t ComputeCommandList::GetNumSubmittedStateCalls() const {
+	return m_numSubmittedStateCalls + m_computeBindingManager.GetNumSubmittedCalls();
+}
+
+size_t ComputeCommandList::GetNumFilteredStateCalls() const {
+	return m_numFilteredStateCalls + m_computeBindingManager.GetNumFilteredCalls();
+}
+
+
+void ComputeCommandList::InvalidateState() {
+	m_pipelineState = nullptr;
+	m_computeBindingManager.InvalidateRootSignature();
+}
+
+void ComputeCommandList::CountStateCall(bool submitted) {
+	++(submitted ? m_numSubmittedStateCalls : m_numFilteredStateCalls);
 }
 
 
@@ -87,95 +134,39 @@ void ComputeCommandList::SetComputeBinder(Binder* binder) {
 
 
 void ComputeCommandList::BindCompute(BindParameter parameter, const TextureView1D& shaderResource) {
-	try {
-		m_computeBindingManager.Bind(parameter, shaderResource);
-	}
-	catch (std::bad_alloc&) {
-		NewScratchSpace(1000);
-		m_computeBindingManager.Bind(parameter, shaderResource);
-	}
+	m_computeBindingManager.Bind(parameter, shaderResource);
 }
 
 void ComputeCommandList::BindCompute(BindParameter parameter, const TextureView2D& shaderResource) {
-	try {
-		m_computeBindingManager.Bind(parameter, shaderResource);
-	}
-	catch (std::bad_alloc&) {
-		NewScratchSpace(1000);
-		m_computeBindingManager.Bind(parameter, shaderResource);
-	}
+	m_computeBindingManager.Bind(parameter, shaderResource);
 }
 
 void ComputeCommandList::BindCompute(BindParameter parameter, const TextureView3D& shaderResource) {
-	try {
-		m_computeBindingManager.Bind(parameter, shaderResource);
-	}
-	catch (std::bad_alloc&) {
-		NewScratchSpace(1000);
-		m_computeBindingManager.Bind(parameter, shaderResource);
-	}
+	m_computeBindingManager.Bind(parameter, shaderResource);
 }
 
 void ComputeCommandList::BindCompute(BindParameter parameter, const ConstBufferView& shaderConstant) {
-	try {
-		m_computeBindingManager.Bind(parameter, shaderConstant);
-	}
-	catch (std::bad_alloc&) {
-		NewScratchSpace(1000);
-		m_computeBindingManager.Bind(parameter, shaderConstant);
-	}
+	m_computeBindingManager.Bind(parameter, shaderConstant);
 }
 
 void ComputeCommandList::BindCompute(BindParameter parameter, const void* shaderConstant, int size, int offset) {
-	try {
-		m_computeBindingManager.Bind(parameter, shaderConstant, size, offset);
-	}
-	catch (std::bad_alloc&) {
-		NewScratchSpace(1000);
-		m_computeBindingManager.Bind(parameter, shaderConstant, size, offset);
-	}
+	m_computeBindingManager.Bind(parameter, shaderConstant, size, offset);
 }
 
 void ComputeCommandList::BindCompute(BindParameter parameter, const RWTextureView1D& rwResource) {
-	try {
-		m_computeBindingManager.Bind(parameter, rwResource);
-	}
-	catch (std::bad_alloc&) {
-		NewScratchSpace(1000);
-		m_computeBindingManager.Bind(parameter, rwResource);
-	}
+	m_computeBindingManager.Bind(parameter, rwResource);
 }
 
 void ComputeCommandList::BindCompute(BindParameter parameter, const RWTextureView2D& rwResource) {
-	try {
-		m_computeBindingManager.Bind(parameter, rwResource);
-	}
-	catch (std::bad_alloc&) {
-		NewScratchSpace(1000);
-		m_computeBindingManager.Bind(parameter, rwResource);
-	}
+	m_computeBindingManager.Bind(parameter, rwResource);
 }
 
 void ComputeCommandList::BindCompute(BindParameter parameter, const RWTextureView3D& rwResource) {
-	try {
-		m_computeBindingManager.Bind(parameter, rwResource);
-	}
-	catch (std::bad_alloc&) {
-		NewScratchSpace(1000);
-		m_computeBindingManager.Bind(parameter, rwResource);
-	}
+	m_computeBindingManager.Bind(parameter, rwResource);
 }
 
 void ComputeCommandList::BindCompute(BindParameter parameter, const RWBufferView& rwResource) {
-	{
-		try {
-			m_computeBindingManager.Bind(parameter, rwResource);
-		}
-		catch (std::bad_alloc&) {
-			NewScratchSpace(1000);
-			m_computeBindingManager.Bind(parameter, rwResource);
-		}
-	}
+	m_computeBindingManager.Bind(parameter, rwResource);
 }
 
 
@@ -33,6 +33,11 @@ public:
 	void ResetState(gxapi::IPipelineState* newState = nullptr);
 	void SetPipelineState(gxapi::IPipelineState* pipelineState);
 
+	/// <summary> Number of state setting calls passed on to the API command list. </summary>
+	virtual size_t GetNumSubmittedStateCalls() const;
+	/// <summary> Number of state setting calls dropped because they would have set what was already set. </summary>
+	virtual size_t GetNumFilteredStateCalls() const;
+
 	// set compute root signature stuff
 	void SetComputeBinder(Binder* binder);
 
@@ -49,8 +54,19 @@ public:
 protected:
 	virtual Decomposition Decompose() override;
 	virtual void NewScratchSpace(size_t hint) override;
+
+	/// <summary> Forgets all state set on the API command list, called after its state was cleared. </summary>
+	virtual void InvalidateState();
+	void CountStateCall(bool submitted);
+	/// <summary> Forgets the pipeline state, the next one is set even if it is the same. </summary>
+	void InvalidatePipelineState() { m_pipelineState = nullptr; }
+private:
+	void CommitComputeBindings();
 private:
 	gxapi::IComputeCommandList* m_commandList;
+	gxapi::IPipelineState* m_pipelineState = nullptr; // last set on the API command list, nullptr if not known
+	size_t m_numSubmittedStateCalls = 0;
+	size_t m_numFilteredStateCalls = 0;
 
 	// scratch space managment
 	BindingManager<gxapi::eCommandListType::COMPUTE> m_computeBindingManager;
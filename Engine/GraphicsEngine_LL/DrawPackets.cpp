@@ -0,0 +1,121 @@
+#include "DrawPackets.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+
+namespace inl {
+namespace gxeng {
+
+
+void SortDrawPackets(std::vector<DrawPacket>& packets, std::vector<DrawPacket>& scratch) {
+	constexpr int NumPasses = sizeof(uint64_t);
+	size_t count = packets.size();
+	if (count < 2) {
+		return;
+	}
+
+	// histograms of all bytes in one go
+	size_t histograms[NumPasses][256] = {};
+	for (const DrawPacket& packet : packets) {
+		for (int pass = 0; pass < NumPasses; ++pass) {
+			++histograms[pass][(packet.key >> (8 * pass)) & 0xFF];
+		}
+	}
+
+	scratch.resize(count);
+	DrawPacket* source = packets.data();
+	DrawPacket* target = scratch.data();
+	for (int pass = 0; pass < NumPasses; ++pass) {
+		size_t* histogram = histograms[pass];
+
+		// the byte is the same in all keys, order would not change
+		if (histogram[(source[0].key >> (8 * pass)) & 0xFF] == count) {
+			continue;
+		}
+
+		size_t offset = 0;
+		for (int digit = 0; digit < 256; ++digit) {
+			size_t digitCount = histogram[digit];
+			histogram[digit] = offset;
+			offset += digitCount;
+		}
+		for (size_t i = 0; i < count; ++i) {
+			target[histogram[(source[i].key >> (8 * pass)) & 0xFF]++] = source[i];
+		}
+		std::swap(source, target);
+	}
+
+	if (source != packets.data()) {
+		packets.swap(scratch);
+	}
+}
+
+
+void DrawPacketBuilder::Clear() {
+	m_packets.clear();
+	m_batches.clear();
+
+	// Ids of destroyed meshes and textures are never freed, start over before running out.
+	if (m_meshIds.size() >= (size_t(1) << MeshBits) / 2) {
+		m_meshIds.clear();
+	}
+	if (m_textureIds.size() >= (size_t(1) << TextureBits) / 2) {
+		m_textureIds.clear();
+	}
+}
+
+
+void DrawPacketBuilder::Add(uint32_t index, uint32_t pipeline, const void* mesh, const void* texture, float depth) {
+	uint32_t meshId = GetId(m_meshIds, mesh, MeshBits);
+	uint32_t textureId = GetId(m_textureIds, texture, TextureBits);
+	m_packets.push_back({ MakeKey(pipeline, meshId, textureId, depth), index });
+}
+
+
+void DrawPacketBuilder::Build(uint32_t maxInstances) {
+	SortDrawPackets(m_packets, m_scratch);
+
+	m_batches.clear();
+	uint32_t count = (uint32_t)m_packets.size();
+	for (uint32_t first = 0; first < count; ) {
+		uint64_t state = StateOf(m_packets[first].key);
+		uint32_t end = first + 1;
+		while (end < count && end - first < maxInstances && StateOf(m_packets[end].key) == state) {
+			++end;
+		}
+		m_batches.push_back({ first, end - first });
+		first = end;
+	}
+}
+
+
+uint64_t DrawPacketBuilder::MakeKey(uint32_t pipeline, uint32_t mesh, uint32_t texture, float depth) {
+	constexpr uint64_t MaxDepth = (uint64_t(1) << DepthBits) - 1;
+	depth = depth > 0.0f ? std::min(depth, 1.0f) : 0.0f; // NaNs go to the front too
+	uint64_t quantizedDepth = uint64_t(depth * MaxDepth + 0.5f);
+
+	uint64_t key = pipeline & ((uint64_t(1) << PipelineBits) - 1);
+	key = (key << MeshBits) | (mesh & ((uint64_t(1) << MeshBits) - 1));
+	key = (key << TextureBits) | (texture & ((uint64_t(1) << TextureBits) - 1));
+	key = (key << DepthBits) | quantizedDepth;
+	return key;
+}
+
+
+uint32_t DrawPacketBuilder::GetId(std::unordered_map<const void*, uint32_t>& ids, const void* object, int bits) {
+	auto it = ids.find(object);
+	if (it != ids.end()) {
+		return it->second;
+	}
+	if (ids.size() >= (size_t(1) << bits)) {
+		throw std::length_error("Too many distinct meshes or textures drawn in a frame.");
+	}
+	uint32_t id = (uint32_t)ids.size();
+	ids.insert({ object, id });
+	return id;
+}
+
+
+} // namespace gxeng
+} // namespace inl
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+
+namespace inl {
+namespace gxeng {
+
+
+/// <summary> A single draw, identified by an index that is up to the user, sorted by its key. </summary>
+struct DrawPacket {
+	uint64_t key;
+	uint32_t index;
+};
+
+
+/// <summary> Sorts the packets by key with an LSD radix sort. The sort is stable. </summary>
+/// <param name="scratch"> Temporary storage, kept by the caller to avoid allocating each frame. </param>
+void SortDrawPackets(std::vector<DrawPacket>& packets, std::vector<DrawPacket>& scratch);
+
+
+/// <summary>
+/// Collects the draws of a frame, orders them to minimize state changes, and groups the draws
+/// of the same pipeline, mesh and texture into instanced batches.
+/// <para />
+/// Keys are, from the most significant bit: pipeline, mesh, texture and depth. Meshes and textures
+/// are given small ids on first sight, which stay the same across frames.
+/// Within a batch, draws are ordered front to back.
+/// </summary>
+class DrawPacketBuilder {
+public:
+	static constexpr int PipelineBits = 8;
+	static constexpr int MeshBits = 20;
+	static constexpr int TextureBits = 20;
+	static constexpr int DepthBits = 16;
+
+	/// <summary> Consecutive packets to draw with a single instanced draw call. </summary>
+	struct Batch {
+		uint32_t first;
+		uint32_t count;
+	};
+public:
+	/// <summary> Removes the packets of the previous frame. </summary>
+	void Clear();
+
+	/// <summary> Adds a draw. </summary>
+	/// <param name="pipeline"> Small id of the pipeline state, less than 2^PipelineBits. </param>
+	/// <param name="depth"> Distance from the camera, normalized to [0, 1]. Clamped. </param>
+	void Add(uint32_t index, uint32_t pipeline, const void* mesh, const void* texture, float depth);
+
+	/// <summary> Sorts the packets and groups them into batches. </summary>
+	/// <param name="maxInstances"> Longer runs of the same state are split into several batches. </param>
+	void Build(uint32_t maxInstances);
+
+	const std::vector<DrawPacket>& GetPackets() const { return m_packets; }
+	const std::vector<Batch>& GetBatches() const { return m_batches; }
+
+	static uint64_t MakeKey(uint32_t pipeline, uint32_t mesh, uint32_t texture, float depth);
+
+	/// <summary> The part of the key that must match for draws to be batched. </summary>
+	static uint64_t StateOf(uint64_t key) { return key >> DepthBits; }
+private:
+	static uint32_t GetId(std::unordered_map<const void*, uint32_t>& ids, const void* object, int bits);
+private:
+	std::vector<DrawPacket> m_packets;
+	std::vector<DrawPacket> m_scratch;
+	std::vector<Batch> m_batches;
+	std::unordered_map<const void*, uint32_t> m_meshIds;
+	std::unordered_map<const void*, uint32_t> m_textureIds;
+};
+
+
+} // namespace gxeng
+} // namespace inl
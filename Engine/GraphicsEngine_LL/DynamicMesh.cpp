@@ -0,0 +1,163 @@
+#include "DynamicMesh.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cassert>
+
+
+namespace inl {
+namespace gxeng {
+
+
+DynamicMesh::DynamicMesh(MemoryManager* memoryManager, unsigned numVersions) :
+	Mesh(memoryManager),
+	m_memoryManager(memoryManager),
+	m_numVersions(numVersions),
+	m_vertexData(numVersions, 0),
+	m_indexData(numVersions, 0)
+{}
+
+
+void DynamicMesh::Set(const VertexBase* vertices, size_t numVertices, const unsigned* indices, size_t numIndices) {
+	if (numVertices == 0 || numIndices == 0) {
+		throw std::invalid_argument("Dynamic mesh must have vertices and indices.");
+	}
+	if (numIndices % 3 != 0) {
+		throw std::invalid_argument("Index count not divisible by 3. Must be triangles.");
+	}
+	if (std::any_of(indices, indices + numIndices, [numVertices](unsigned index) { return index >= numVertices; })) {
+		throw std::invalid_argument("Indices over-index the vertex buffers.");
+	}
+
+	uint32_t stride;
+	std::unique_ptr<uint8_t[]> compressedData = CompressVertices(vertices, numVertices, stride);
+	bool index32Bit = numVertices > 0xFFFFu;
+	size_t indexStride = index32Bit ? sizeof(uint32_t) : sizeof(uint16_t);
+
+	// Every version stays mapped, upload heap memory can be written while the GPU reads other versions
+	std::vector<Version> versions;
+	for (unsigned i = 0; i < m_numVersions; ++i) {
+		Version version{
+			m_memoryManager->CreateVertexBuffer(eResourceHeapType::UPLOAD, stride * numVertices),
+			m_memoryManager->CreateIndexBuffer(eResourceHeapType::UPLOAD, indexStride * numIndices, numIndices),
+			nullptr,
+			nullptr
+		};
+		gxapi::MemoryRange noReadRange{ 0, 0 };
+		version.vertexMemory = static_cast<uint8_t*>(version.vertexBuffer._GetResourcePtr()->Map(0, &noReadRange));
+		version.indexMemory = static_cast<uint8_t*>(version.indexBuffer._GetResourcePtr()->Map(0, &noReadRange));
+		versions.push_back(std::move(version));
+	}
+
+	m_versions = std::move(versions);
+	m_stride = stride;
+	m_numVertices = numVertices;
+	m_index32Bit = index32Bit;
+	m_vertexData.Reset(m_numVersions, stride * numVertices);
+	m_indexData.Reset(m_numVersions, indexStride * numIndices);
+	m_vertexData.Write(0, compressedData.get(), stride * numVertices);
+	UpdateIndices(indices, numIndices, 0);
+
+	m_streamElements.clear();
+	m_streamElements.push_back(vertices->GetElements());
+	m_positions = GatherPositions(vertices, numVertices);
+	m_boundsChanged = true;
+
+	// The new buffers are not read by the GPU yet, so the mesh can be drawn right away
+	Flip();
+}
+
+
+void DynamicMesh::Update(const VertexBase* vertices, size_t numVertices, size_t offsetInVertices) {
+	if (offsetInVertices > m_numVertices || numVertices > m_numVertices - offsetInVertices) {
+		throw std::out_of_range("Vertices do not fit in the mesh.");
+	}
+	if (numVertices == 0) {
+		return;
+	}
+
+	uint32_t stride;
+	std::unique_ptr<uint8_t[]> compressedData = CompressVertices(vertices, numVertices, stride);
+	if (stride != m_stride) {
+		throw std::invalid_argument("Vertices do not have the layout of the mesh.");
+	}
+	m_vertexData.Write(offsetInVertices * m_stride, compressedData.get(), numVertices * m_stride);
+
+	auto positions = GatherPositions(vertices, numVertices);
+	if (!positions.empty() && !m_positions.empty()) {
+		std::copy(positions.begin(), positions.end(), m_positions.begin() + offsetInVertices);
+		m_boundsChanged = true;
+	}
+}
+
+
+void DynamicMesh::UpdateIndices(const unsigned* indices, size_t numIndices, size_t offsetInIndices) {
+	size_t indexStride = m_index32Bit ? sizeof(uint32_t) : sizeof(uint16_t);
+	size_t capacity = m_indexData.GetSize() / indexStride;
+	if (offsetInIndices > capacity || numIndices > capacity - offsetInIndices) {
+		throw std::out_of_range("Indices do not fit in the mesh.");
+	}
+	if (std::any_of(indices, indices + numIndices, [this](unsigned index) { return index >= m_numVertices; })) {
+		throw std::out_of_range("Indices over-index the vertex buffers.");
+	}
+
+	uint8_t* target = m_indexData.Map(offsetInIndices * indexStride, numIndices * indexStride);
+	for (size_t i = 0; i < numIndices; ++i) {
+		if (m_index32Bit) {
+			reinterpret_cast<uint32_t*>(target)[i] = (uint32_t)indices[i];
+		}
+		else {
+			reinterpret_cast<uint16_t*>(target)[i] = (uint16_t)indices[i];
+		}
+	}
+}
+
+
+void* DynamicMesh::MapVertices(size_t offsetInVertices, size_t numVertices) {
+	if (offsetInVertices > m_numVertices || numVertices > m_numVertices - offsetInVertices) {
+		throw std::out_of_range("Vertices do not fit in the mesh.");
+	}
+	return m_vertexData.Map(offsetInVertices * m_stride, numVertices * m_stride);
+}
+
+
+void DynamicMesh::Clear() {
+	Mesh::Clear();
+	m_versions.clear();
+	m_vertexData.Reset(m_numVersions, 0);
+	m_indexData.Reset(m_numVersions, 0);
+	m_stride = 0;
+	m_numVertices = 0;
+	m_positions.clear();
+	m_boundsChanged = false;
+	m_lastFlipSize = 0;
+}
+
+
+void DynamicMesh::Flip() {
+	if (m_versions.empty()) {
+		return;
+	}
+
+	ByteRange vertexRange = m_vertexData.Flip();
+	ByteRange indexRange = m_indexData.Flip();
+	assert(m_vertexData.GetCurrentVersion() == m_indexData.GetCurrentVersion());
+	Version& version = m_versions[m_vertexData.GetCurrentVersion()];
+
+	std::memcpy(version.vertexMemory + vertexRange.begin, m_vertexData.GetData() + vertexRange.begin, vertexRange.GetSize());
+	std::memcpy(version.indexMemory + indexRange.begin, m_indexData.GetData() + indexRange.begin, indexRange.GetSize());
+	m_lastFlipSize = vertexRange.GetSize() + indexRange.GetSize();
+
+	SetBuffers({ version.vertexBuffer }, { m_stride }, version.indexBuffer, m_index32Bit);
+
+	// Bounds follow the vertices that are drawn
+	if (m_boundsChanged) {
+		SetBounds(ComputeAabb(m_positions.data(), m_positions.size()), ComputeBoundingSphere(m_positions.data(), m_positions.size()));
+		m_boundsChanged = false;
+	}
+}
+
+
+} // namespace gxeng
+} // namespace inl
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Mesh.hpp"
+#include "VersionedBuffer.hpp"
+
+
+namespace inl {
+namespace gxeng {
+
+
+/// <summary>
+/// A mesh whose vertices and indices change every frame, such as ropes, blurred rotor cards or debug lines.
+/// <para />
+/// The mesh keeps one version of its buffers in the upload heap for each frame in flight.
+/// Updates are written to a CPU copy, and once per frame the engine copies the updated range
+/// into the version that the GPU no longer reads, and draws that version.
+/// Nothing is allocated or queued for upload after Set.
+/// </summary>
+/// <remarks>
+/// The number of vertices and indices is fixed by Set. Unused indices can be set to degenerate triangles.
+/// Updates are drawn from the next frame on.
+/// </remarks>
+class DynamicMesh : public Mesh {
+public:
+	/// <param name="numVersions"> The number of frames that the GPU may read the mesh in at the same time. </param>
+	DynamicMesh(MemoryManager* memoryManager, unsigned numVersions);
+
+	/// <summary> Sets the vertex layout, the number of vertices and indices, and the initial contents. </summary>
+	/// <exception cref="std::invalid_argument"> If indices over-index the vertices or are not triangles. </exception>
+	void Set(const VertexBase* vertices, size_t numVertices, const unsigned* indices, size_t numIndices);
+	/// <summary> Overwrites vertices. They must have the layout given to Set. </summary>
+	/// <exception cref="std::out_of_range"> If the vertices do not fit in the mesh. </exception>
+	void Update(const VertexBase* vertices, size_t numVertices, size_t offsetInVertices);
+	/// <exception cref="std::out_of_range"> If the indices do not fit in the mesh or over-index the vertices. </exception>
+	void UpdateIndices(const unsigned* indices, size_t numIndices, size_t offsetInIndices);
+	/// <summary> Returns the vertices in the vertex buffer's layout, see GetVertexBufferStride, to be written in place. </summary>
+	/// <remarks> Bounds are not updated for vertices written this way. </remarks>
+	/// <exception cref="std::out_of_range"> If the vertices do not fit in the mesh. </exception>
+	void* MapVertices(size_t offsetInVertices, size_t numVertices);
+	void Clear();
+
+	/// <summary> Brings the next version up to date and makes it the one drawn.
+	///		Called by the engine once per frame, after the frame that last drew that version has completed. </summary>
+	void Flip();
+
+	unsigned GetNumVersions() const { return m_numVersions; }
+	/// <summary> Bytes copied into the current version by the last flip. </summary>
+	size_t GetLastFlipSize() const { return m_lastFlipSize; }
+private:
+	struct Version {
+		VertexBuffer vertexBuffer;
+		IndexBuffer indexBuffer;
+		uint8_t* vertexMemory;
+		uint8_t* indexMemory;
+	};
+private:
+	MemoryManager* m_memoryManager;
+	unsigned m_numVersions;
+	std::vector<Version> m_versions;
+	VersionedBuffer m_vertexData;
+	VersionedBuffer m_indexData;
+	uint32_t m_stride = 0;
+	size_t m_numVertices = 0;
+	bool m_index32Bit = false;
+	std::vector<mathfu::Vector<float, 3>> m_positions;
+	bool m_boundsChanged = false;
+	size_t m_lastFlipSize = 0;
+};
+
+
+} // namespace gxeng
+} // namespace inl
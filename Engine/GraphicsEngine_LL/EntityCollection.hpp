@@ -1,17 +1,26 @@
 #pragma once
 
-#include <set>
+#include <vector>
+#include <unordered_map>
+#include <stdexcept>
+#include <cstdint>
 
 
 namespace inl {
 namespace gxeng {
 
 
+/// <summary>
+/// A set of entities, e.g. the meshes of a scene.
+/// <para />
+/// Members are kept in a contiguous array for fast iteration. Removal moves the last member
+/// into the removed one's place, so the order of iteration is unspecified.
+/// </summary>
 template <class EntityType>
 class EntityCollection {
 public:
-	using iterator = typename std::set<EntityType*>::iterator;
-	using const_iterator = typename std::set<EntityType*>::const_iterator;
+	using iterator = typename std::vector<EntityType*>::const_iterator;
+	using const_iterator = typename std::vector<EntityType*>::const_iterator;
 public:
 	iterator begin();
 	iterator end();
@@ -21,14 +30,19 @@ public:
 	const_iterator cend() const;
 
 	bool IsEmpty() const;
-	bool Size() const;
+	size_t Size() const;
 
 	void Add(EntityType* entity);
 	void Remove(EntityType* entity);
 	bool Contains(EntityType* entity) const;
 	void Clear();
+
+	/// <summary> Changes whenever members are added or removed. </summary>
+	uint64_t GetVersion() const { return m_version; }
 private:
-	std::set<EntityType*> m_entites;
+	std::vector<EntityType*> m_entites;
+	std::unordered_map<EntityType*, size_t> m_indices; // entity -> index in m_entites
+	uint64_t m_version = 0;
 };
 
 
@@ -68,31 +82,48 @@ bool EntityCollection<EntityType>::IsEmpty() const {
 }
 
 template <class EntityType>
-bool EntityCollection<EntityType>::Size() const {
+size_t EntityCollection<EntityType>::Size() const {
 	return m_entites.size();
 }
 
 template <class EntityType>
 void EntityCollection<EntityType>::Add(EntityType* entity) {
-	auto result = m_entites.insert(entity);
+	auto result = m_indices.insert({ entity, m_entites.size() });
 	if (result.second == false) {
 		throw std::invalid_argument("Entity already member of this collection.");
 	}
+	m_entites.push_back(entity);
+	++m_version;
 }
 
 template <class EntityType>
 void EntityCollection<EntityType>::Remove(EntityType* entity) {
-	m_entites.erase(entity);
+	auto it = m_indices.find(entity);
+	if (it == m_indices.end()) {
+		return;
+	}
+	size_t index = it->second;
+	m_indices.erase(it);
+
+	// move the last entity into the hole
+	if (index != m_entites.size() - 1) {
+		m_entites[index] = m_entites.back();
+		m_indices[m_entites[index]] = index;
+	}
+	m_entites.pop_back();
+	++m_version;
 }
 
 template <class EntityType>
 bool EntityCollection<EntityType>::Contains(EntityType* entity) const {
-	return m_entites.count(entity) > 0;
+	return m_indices.count(entity) > 0;
 }
 
 template <class EntityType>
 void EntityCollection<EntityType>::Clear() {
 	m_entites.clear();
+	m_indices.clear();
+	++m_version;
 }
 
 
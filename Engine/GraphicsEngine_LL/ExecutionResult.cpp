@@ -34,7 +34,12 @@ void ExecutionResult::AddCommandList(CopyCommandList&& list) {
 
 
 void ExecutionResult::GiveVolatileViewHeap(VolatileViewHeap&& heap) {
-	m_volatileViewHeap = std::move(heap);
+	if (m_volatileViewHeap.has_value()) {
+		m_volatileViewHeap->Merge(std::move(heap));
+	}
+	else {
+		m_volatileViewHeap = std::move(heap);
+	}
 }
 
 
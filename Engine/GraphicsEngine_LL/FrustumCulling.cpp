@@ -0,0 +1,141 @@
+#include "FrustumCulling.hpp"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define INL_FRUSTUM_CULLING_SSE
+#endif
+
+
+namespace inl {
+namespace gxeng {
+
+
+Frustum::Frustum() {
+	for (auto& plane : m_planes) {
+		plane = { 0, 0, 0, 1 };
+	}
+}
+
+
+Frustum::Frustum(const mathfu::Matrix<float, 4, 4>& viewProjection) {
+	auto row = [&viewProjection](int i) {
+		return mathfu::Vector<float, 4>(viewProjection(i, 0), viewProjection(i, 1), viewProjection(i, 2), viewProjection(i, 3));
+	};
+	mathfu::Vector<float, 4> x = row(0), y = row(1), z = row(2), w = row(3);
+
+	// Gribb-Hartmann: -w <= x <= w, -w <= y <= w, 0 <= z <= w
+	m_planes[0] = w + x;
+	m_planes[1] = w - x;
+	m_planes[2] = w + y;
+	m_planes[3] = w - y;
+	m_planes[4] = z;
+	m_planes[5] = w - z;
+
+	for (auto& plane : m_planes) {
+		plane /= plane.xyz().Length();
+	}
+}
+
+
+bool Frustum::IsVisible(const BoundingSphere& sphere) const {
+	for (auto& plane : m_planes) {
+		// same order of operations as CullSpheres, so both agree on the boundary
+		float distance = plane.x() * sphere.center.x() + plane.w();
+		distance += plane.y() * sphere.center.y();
+		distance += plane.z() * sphere.center.z();
+		if (distance < -sphere.radius) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool Frustum::IsVisible(const Aabb& aabb) const {
+	for (auto& plane : m_planes) {
+		// the corner furthest along the plane's normal
+		mathfu::Vector<float, 3> corner(plane.x() >= 0 ? aabb.max.x() : aabb.min.x(),
+										plane.y() >= 0 ? aabb.max.y() : aabb.min.y(),
+										plane.z() >= 0 ? aabb.max.z() : aabb.min.z());
+		if (mathfu::Vector<float, 3>::DotProduct(plane.xyz(), corner) + plane.w() < 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool Frustum::Contains(const Aabb& aabb) const {
+	for (auto& plane : m_planes) {
+		// the corner furthest against the plane's normal
+		mathfu::Vector<float, 3> corner(plane.x() >= 0 ? aabb.min.x() : aabb.max.x(),
+										plane.y() >= 0 ? aabb.min.y() : aabb.max.y(),
+										plane.z() >= 0 ? aabb.min.z() : aabb.max.z());
+		if (mathfu::Vector<float, 3>::DotProduct(plane.xyz(), corner) + plane.w() < 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+size_t CullSpheres(const Frustum& frustum,
+				   const float* centersX,
+				   const float* centersY,
+				   const float* centersZ,
+				   const float* radii,
+				   size_t count,
+				   uint32_t* visibleIndices)
+{
+	const auto& planes = frustum.GetPlanes();
+	size_t numVisible = 0;
+	size_t i = 0;
+
+#ifdef INL_FRUSTUM_CULLING_SSE
+	// Four spheres per iteration, each plane component is broadcast to all lanes.
+	__m128 planeA[Frustum::NumPlanes], planeB[Frustum::NumPlanes], planeC[Frustum::NumPlanes], planeD[Frustum::NumPlanes];
+	for (size_t p = 0; p < Frustum::NumPlanes; ++p) {
+		planeA[p] = _mm_set1_ps(planes[p].x());
+		planeB[p] = _mm_set1_ps(planes[p].y());
+		planeC[p] = _mm_set1_ps(planes[p].z());
+		planeD[p] = _mm_set1_ps(planes[p].w());
+	}
+
+	for (; i + 4 <= count; i += 4) {
+		const __m128 x = _mm_loadu_ps(centersX + i);
+		const __m128 y = _mm_loadu_ps(centersY + i);
+		const __m128 z = _mm_loadu_ps(centersZ + i);
+		const __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radii + i));
+
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (size_t p = 0; p < Frustum::NumPlanes; ++p) {
+			__m128 distance = _mm_add_ps(_mm_mul_ps(planeA[p], x), planeD[p]);
+			distance = _mm_add_ps(distance, _mm_mul_ps(planeB[p], y));
+			distance = _mm_add_ps(distance, _mm_mul_ps(planeC[p], z));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negRadius));
+		}
+
+		int mask = _mm_movemask_ps(inside);
+		for (int lane = 0; lane < 4; ++lane) {
+			if (mask & (1 << lane)) {
+				visibleIndices[numVisible++] = uint32_t(i + lane);
+			}
+		}
+	}
+#endif
+
+	for (; i < count; ++i) {
+		BoundingSphere sphere;
+		sphere.center = { centersX[i], centersY[i], centersZ[i] };
+		sphere.radius = radii[i];
+		if (frustum.IsVisible(sphere)) {
+			visibleIndices[numVisible++] = uint32_t(i);
+		}
+	}
+
+	return numVisible;
+}
+
+
+} // namespace gxeng
+} // namespace inl
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "BoundingVolume.hpp"
+
+#include <mathfu/vector_4.h>
+#include <mathfu/matrix_4x4.h>
+
+#include <array>
+#include <cstdint>
+
+
+namespace inl {
+namespace gxeng {
+
+
+/// <summary>
+/// The six planes of a view frustum, normals pointing inwards.
+/// </summary>
+class Frustum {
+public:
+	static constexpr size_t NumPlanes = 6;
+public:
+	/// <summary> A frustum that contains everything. </summary>
+	Frustum();
+
+	/// <summary> Extracts the planes of a view-projection matrix with D3D clip space (depth in [0, 1]). </summary>
+	explicit Frustum(const mathfu::Matrix<float, 4, 4>& viewProjection);
+
+	/// <summary> Planes as (a, b, c, d), where a point p is inside if dot(abc, p) + d >= 0. Normals are unit length. </summary>
+	const std::array<mathfu::Vector<float, 4>, NumPlanes>& GetPlanes() const { return m_planes; }
+
+	/// <summary> Whether the sphere is at least partly inside the frustum. </summary>
+	/// <remarks> Conservative: spheres near the frustum's corners may be reported visible. </remarks>
+	bool IsVisible(const BoundingSphere& sphere) const;
+
+	/// <summary> Whether the box is at least partly inside the frustum. </summary>
+	/// <remarks> Conservative: boxes near the frustum's corners may be reported visible. </remarks>
+	bool IsVisible(const Aabb& aabb) const;
+
+	/// <summary> Whether the box is entirely inside the frustum. </summary>
+	bool Contains(const Aabb& aabb) const;
+private:
+	std::array<mathfu::Vector<float, 4>, NumPlanes> m_planes;
+};
+
+
+/// <summary>
+/// Tests many spheres against the frustum, given as separate arrays of center coordinates and radii.
+/// Gives the same result as Frustum::IsVisible.
+/// </summary>
+/// <param name="visibleIndices"> Receives the indices of visible spheres in increasing order. Must have room for count elements. </param>
+/// <returns> The number of visible spheres. </returns>
+/// <remarks> Tests 4 spheres at a time with SSE where available. </remarks>
+size_t CullSpheres(const Frustum& frustum,
+				   const float* centersX,
+				   const float* centersY,
+				   const float* centersZ,
+				   const float* radii,
+				   size_t count,
+				   uint32_t* visibleIndices);
+
+
+} // namespace gxeng
+} // namespace inl
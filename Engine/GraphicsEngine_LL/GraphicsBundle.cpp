@@ -0,0 +1,174 @@
+#include "GraphicsBundle.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <cassert>
+
+
+namespace inl {
+namespace gxeng {
+
+
+GraphicsBundle::GraphicsBundle(gxapi::IGraphicsApi* graphicsApi) {
+	// Bundles record once, so each has an allocator of its own that is never reset
+	m_commandAllocator.reset(graphicsApi->CreateCommandAllocator(gxapi::eCommandListType::BUNDLE));
+	m_commandList.reset(graphicsApi->CreateGraphicsCommandList({ m_commandAllocator.get() }));
+}
+
+
+void GraphicsBundle::SetPipelineState(gxapi::IPipelineState* pipelineState) {
+	CheckRecording();
+	if (pipelineState == m_pipelineState) {
+		++m_numSkippedCommands;
+		return;
+	}
+	m_commandList->SetPipelineState(pipelineState);
+	m_pipelineState = pipelineState;
+	++m_numCommands;
+}
+
+
+void GraphicsBundle::SetGraphicsBinder(const Binder* binder) {
+	assert(binder != nullptr);
+	CheckRecording();
+	if (binder == m_binder) {
+		++m_numSkippedCommands;
+		return;
+	}
+	m_commandList->SetGraphicsRootSignature(binder->GetRootSignature());
+	m_binder = binder;
+	m_rootConstantBuffers.assign(binder->GetRootSignatureDesc().rootParameters.size(), nullptr);
+	++m_numCommands;
+}
+
+
+void GraphicsBundle::SetPrimitiveTopology(gxapi::ePrimitiveTopology topology) {
+	CheckRecording();
+	if (m_topology == topology) {
+		++m_numSkippedCommands;
+		return;
+	}
+	m_commandList->SetPrimitiveTopology(topology);
+	m_topology = topology;
+	++m_numCommands;
+}
+
+
+void GraphicsBundle::SetVertexBuffers(unsigned startSlot,
+	unsigned count,
+	const VertexBuffer* const * resources,
+	unsigned* sizeInBytes,
+	unsigned* strideInBytes)
+{
+	CheckRecording();
+	std::vector<VertexBufferBinding> bindings(count);
+	for (unsigned i = 0; i < count; ++i) {
+		bindings[i] = { resources[i]->GetVirtualAddress(), sizeInBytes[i], strideInBytes[i] };
+	}
+	if (m_vertexBuffers.size() >= startSlot + count && std::equal(bindings.begin(), bindings.end(), m_vertexBuffers.begin() + startSlot)) {
+		++m_numSkippedCommands;
+		return;
+	}
+
+	std::vector<void*> virtualAddresses(count);
+	for (unsigned i = 0; i < count; ++i) {
+		virtualAddresses[i] = bindings[i].address;
+	}
+	m_commandList->SetVertexBuffers(startSlot, count, virtualAddresses.data(), sizeInBytes, strideInBytes);
+
+	m_vertexBuffers.resize(std::max<size_t>(m_vertexBuffers.size(), startSlot + count), VertexBufferBinding{ nullptr, 0, 0 });
+	std::copy(bindings.begin(), bindings.end(), m_vertexBuffers.begin() + startSlot);
+	++m_numCommands;
+}
+
+
+void GraphicsBundle::SetIndexBuffer(const IndexBuffer* resource, bool is32Bit) {
+	CheckRecording();
+	void* address = resource->GetVirtualAddress();
+	if (address == m_indexBuffer && is32Bit == m_indexBuffer32Bit) {
+		++m_numSkippedCommands;
+		return;
+	}
+	m_commandList->SetIndexBuffer(address, resource->GetSize(), is32Bit ? gxapi::eFormat::R32_UINT : gxapi::eFormat::R16_UINT);
+	m_indexBuffer = address;
+	m_indexBuffer32Bit = is32Bit;
+	++m_numCommands;
+}
+
+
+void GraphicsBundle::BindGraphics(BindParameter parameter, const PersistentConstBuffer& buffer, size_t offset) {
+	CheckRecording();
+	int rootParamIndex;
+	if (TranslateRootParameter(parameter, rootParamIndex).type != gxapi::RootParameterDesc::CBV) {
+		throw std::invalid_argument("Bundles can only bind constant buffers kept in the root signature.");
+	}
+
+	void* address = static_cast<uint8_t*>(buffer.GetVirtualAddress()) + offset;
+	if (m_rootConstantBuffers[rootParamIndex] == address) {
+		++m_numSkippedCommands;
+		return;
+	}
+	m_commandList->SetGraphicsRootConstantBuffer(rootParamIndex, address);
+	m_rootConstantBuffers[rootParamIndex] = address;
+	++m_numCommands;
+
+	// The GPU reads the buffer whenever the bundle is executed
+	if (std::none_of(m_boundBuffers.begin(), m_boundBuffers.end(), [&buffer](const PersistentConstBuffer& bound) { return bound == buffer; })) {
+		m_boundBuffers.push_back(buffer);
+	}
+}
+
+
+void GraphicsBundle::BindGraphics(BindParameter parameter, const void* shaderConstant, int size, int offset) {
+	if (size % 4 != 0) {
+		throw std::invalid_argument("Size must be a multiple of 4.");
+	}
+	CheckRecording();
+	int rootParamIndex;
+	if (TranslateRootParameter(parameter, rootParamIndex).type != gxapi::RootParameterDesc::CONSTANT) {
+		throw std::invalid_argument("Parameter is not an inline constant.");
+	}
+
+	m_commandList->SetGraphicsRootConstants(rootParamIndex, offset, size / 4, reinterpret_cast<const uint32_t*>(shaderConstant));
+	++m_numCommands;
+}
+
+
+void GraphicsBundle::DrawIndexedInstanced(unsigned numIndices,
+	unsigned startIndex,
+	int vertexOffset,
+	unsigned numInstances,
+	unsigned startInstance)
+{
+	CheckRecording();
+	m_commandList->DrawIndexedInstanced(numIndices, startIndex, vertexOffset, numInstances, startInstance);
+	++m_numCommands;
+}
+
+
+void GraphicsBundle::Close() {
+	CheckRecording();
+	m_commandList->Close();
+	m_closed = true;
+}
+
+
+void GraphicsBundle::CheckRecording() const {
+	if (m_closed) {
+		throw std::logic_error("Bundle is closed, it cannot record more commands.");
+	}
+}
+
+
+const gxapi::RootParameterDesc& GraphicsBundle::TranslateRootParameter(BindParameter parameter, int& rootParamIndex) const {
+	if (m_binder == nullptr) {
+		throw std::logic_error("Set a binder before binding parameters.");
+	}
+	int rootTableIndex;
+	m_binder->Translate(parameter, rootParamIndex, rootTableIndex); // may throw out of range
+	return m_binder->GetRootSignatureDesc().rootParameters[rootParamIndex];
+}
+
+
+} // namespace gxeng
+} // namespace inl
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "MemoryObject.hpp"
+#include "Binder.hpp"
+
+#include "../GraphicsApi_LL/IGraphicsApi.hpp"
+#include "../GraphicsApi_LL/ICommandList.hpp"
+#include "../GraphicsApi_LL/ICommandAllocator.hpp"
+
+#include <optional>
+#include <memory>
+#include <vector>
+
+
+namespace inl {
+namespace gxeng {
+
+
+/// <summary>
+/// Draw commands that are recorded once and executed by graphics command lists any number of times,
+/// see GraphicsCommandList::ExecuteBundle.
+/// <para />
+/// A bundle sets its own pipeline state, topology, vertex and index buffers and root constants,
+/// and skips setting what it has already set. Descriptor tables are inherited from the command list
+/// that executes the bundle, which must have the same binder set.
+/// </summary>
+/// <remarks>
+/// Buffers bound to the bundle live as long as the bundle, and command lists that execute the bundle
+/// keep it alive until the GPU has finished them.
+/// </remarks>
+class GraphicsBundle {
+public:
+	GraphicsBundle(gxapi::IGraphicsApi* graphicsApi);
+	GraphicsBundle(const GraphicsBundle&) = delete;
+	GraphicsBundle& operator=(const GraphicsBundle&) = delete;
+
+	void SetPipelineState(gxapi::IPipelineState* pipelineState);
+	void SetGraphicsBinder(const Binder* binder);
+	void SetPrimitiveTopology(gxapi::ePrimitiveTopology topology);
+
+	void SetVertexBuffers(unsigned startSlot,
+						  unsigned count,
+						  const VertexBuffer* const * resources,
+						  unsigned* sizeInBytes,
+						  unsigned* strideInBytes);
+	void SetIndexBuffer(const IndexBuffer* resource, bool is32Bit);
+
+	/// <summary> Binds the buffer from the offset on to a constant buffer in the root signature. </summary>
+	/// <exception cref="std::invalid_argument"> If the binder does not keep the parameter as a root constant buffer. </exception>
+	void BindGraphics(BindParameter parameter, const PersistentConstBuffer& buffer, size_t offset = 0);
+	/// <exception cref="std::invalid_argument"> If the binder does not keep the parameter inline. </exception>
+	void BindGraphics(BindParameter parameter, const void* shaderConstant, int size, int offset);
+
+	void DrawIndexedInstanced(unsigned numIndices,
+							  unsigned startIndex = 0,
+							  int vertexOffset = 0,
+							  unsigned numInstances = 1,
+							  unsigned startInstance = 0);
+
+	/// <summary> Ends recording, the bundle can be executed from then on. </summary>
+	void Close();
+	bool IsClosed() const { return m_closed; }
+
+	/// <summary> Number of commands recorded into the bundle. </summary>
+	size_t GetNumCommands() const { return m_numCommands; }
+	/// <summary> Number of commands not recorded because they would have set what was already set. </summary>
+	size_t GetNumSkippedCommands() const { return m_numSkippedCommands; }
+
+	gxapi::IGraphicsCommandList* _GetCommandList() const { return m_commandList.get(); }
+private:
+	struct VertexBufferBinding {
+		void* address;
+		unsigned size;
+		unsigned stride;
+
+		bool operator==(const VertexBufferBinding& rhs) const { return address == rhs.address && size == rhs.size && stride == rhs.stride; }
+	};
+
+	void CheckRecording() const;
+	const gxapi::RootParameterDesc& TranslateRootParameter(BindParameter parameter, int& rootParamIndex) const;
+private:
+	std::unique_ptr<gxapi::ICommandAllocator> m_commandAllocator;
+	std::unique_ptr<gxapi::IGraphicsCommandList> m_commandList;
+	std::vector<PersistentConstBuffer> m_boundBuffers;
+	bool m_closed = false;
+	size_t m_numCommands = 0;
+	size_t m_numSkippedCommands = 0;
+
+	// State set by the recorded commands
+	gxapi::IPipelineState* m_pipelineState = nullptr;
+	const Binder* m_binder = nullptr;
+	std::optional<gxapi::ePrimitiveTopology> m_topology;
+	std::vector<VertexBufferBinding> m_vertexBuffers; // indexed by slot
+	void* m_indexBuffer = nullptr;
+	bool m_indexBuffer32Bit = false;
+	std::vector<void*> m_rootConstantBuffers; // indexed by root parameter
+};
+
+
+} // namespace gxeng
+} // namespace inl
@@ -22,7 +22,14 @@ GraphicsCommandList::GraphicsCommandList(
 
 GraphicsCommandList::GraphicsCommandList(GraphicsCommandList&& rhs)
 	: ComputeCommandList(std::move(rhs)),
-	m_commandList(rhs.m_commandList)
+	m_commandList(rhs.m_commandList),
+	m_executedBundles(std::move(rhs.m_executedBundles)),
+	m_topology(rhs.m_topology),
+	m_vertexBuffers(std::move(rhs.m_vertexBuffers)),
+	m_indexBuffer(rhs.m_indexBuffer),
+	m_indexBufferSize(rhs.m_indexBufferSize),
+	m_indexBuffer32Bit(rhs.m_indexBuffer32Bit),
+	m_graphicsBindingManager(std::move(rhs.m_graphicsBindingManager))
 {
 	rhs.m_commandList = nullptr;
 }
@@ -31,6 +38,13 @@ GraphicsCommandList::GraphicsCommandList(GraphicsCommandList&& rhs)
 GraphicsCommandList& GraphicsCommandList::operator=(GraphicsCommandList&& rhs) {
 	ComputeCommandList::operator=(std::move(rhs));
 	m_commandList = rhs.m_commandList;
+	m_executedBundles = std::move(rhs.m_executedBundles);
+	m_topology = rhs.m_topology;
+	m_vertexBuffers = std::move(rhs.m_vertexBuffers);
+	m_indexBuffer = rhs.m_indexBuffer;
+	m_indexBufferSize = rhs.m_indexBufferSize;
+	m_indexBuffer32Bit = rhs.m_indexBuffer32Bit;
+	m_graphicsBindingManager = std::move(rhs.m_graphicsBindingManager);
 	rhs.m_commandList = nullptr;
 
 	return *this;
@@ -40,7 +54,9 @@ GraphicsCommandList& GraphicsCommandList::operator=(GraphicsCommandList&& rhs) {
 BasicCommandList::Decomposition GraphicsCommandList::Decompose() {
 	m_commandList = nullptr;
 
-	return ComputeCommandList::Decompose();
+	Decomposition decomposition = ComputeCommandList::Decompose();
+	decomposition.executedBundles = std::move(m_executedBundles);
+	return decomposition;
 }
 
 
@@ -77,8 +93,8 @@ void GraphicsCommandList::DrawIndexedInstanced(unsigned numIndices,
 	unsigned numInstances,
 	unsigned startInstance)
 {
+	CommitGraphicsBindings();
 	m_commandList->DrawIndexedInstanced(numIndices, startIndex, vertexOffset, numInstances, startInstance);
-	m_graphicsBindingManager.CommitDrawCall();
 }
 
 void GraphicsCommandList::DrawInstanced(unsigned numVertices,
@@ -86,8 +102,40 @@ void GraphicsCommandList::DrawInstanced(unsigned numVertices,
 	unsigned numInstances,
 	unsigned startInstance)
 {
+	CommitGraphicsBindings();
 	m_commandList->DrawInstanced(numVertices, startVertex, numInstances, startInstance);
-	m_graphicsBindingManager.CommitDrawCall();
+}
+
+
+void GraphicsCommandList::ExecuteBundle(std::shared_ptr<const GraphicsBundle> bundle) {
+	if (!bundle->IsClosed()) {
+		throw std::logic_error("Bundle must be closed before it is executed.");
+	}
+	CommitGraphicsBindings();
+	m_commandList->ExecuteBundle(bundle->_GetCommandList());
+	m_executedBundles.push_back(std::move(bundle));
+	InvalidateBundleState();
+}
+
+
+void GraphicsCommandList::ExecuteIndirect(gxapi::ICommandSignature* commandSignature, unsigned numCommands, const ConstBuffer& arguments) {
+	CommitGraphicsBindings();
+
+	// Volatile buffers are placed in a larger resource
+	gxapi::IResource* resource = const_cast<gxapi::IResource*>(arguments._GetResourcePtr());
+	size_t offset = (uint8_t*)arguments.GetVirtualAddress() - (uint8_t*)resource->GetGPUAddress();
+	m_commandList->ExecuteIndirect(commandSignature, numCommands, resource, offset);
+}
+
+
+void GraphicsCommandList::CommitGraphicsBindings() {
+	try {
+		m_graphicsBindingManager.CommitDrawCall();
+	}
+	catch (std::bad_alloc&) {
+		NewScratchSpace(1000);
+		m_graphicsBindingManager.CommitDrawCall();
+	}
 }
 
 
@@ -96,14 +144,32 @@ void GraphicsCommandList::DrawInstanced(unsigned numVertices,
 //------------------------------------------------------------------------------
 
 void GraphicsCommandList::SetIndexBuffer(const IndexBuffer* resource, bool is32Bit) {
-	m_commandList->SetIndexBuffer(resource->GetVirtualAddress(),
-		resource->GetSize(),
+	void* address = resource->GetVirtualAddress();
+	uint64_t size = resource->GetSize();
+	if (address == m_indexBuffer && size == m_indexBufferSize && is32Bit == m_indexBuffer32Bit) {
+		CountStateCall(false);
+		return;
+	}
+
+	m_commandList->SetIndexBuffer(address,
+		size,
 		is32Bit ? gxapi::eFormat::R32_UINT : gxapi::eFormat::R16_UINT);
+	m_indexBuffer = address;
+	m_indexBufferSize = size;
+	m_indexBuffer32Bit = is32Bit;
+	CountStateCall(true);
 }
 
 
 void GraphicsCommandList::SetPrimitiveTopology(gxapi::ePrimitiveTopology topology) {
+	if (m_topology == topology) {
+		CountStateCall(false);
+		return;
+	}
+
 	m_commandList->SetPrimitiveTopology(topology);
+	m_topology = topology;
+	CountStateCall(true);
 }
 
 
@@ -119,11 +185,32 @@ void GraphicsCommandList::SetVertexBuffers(unsigned startSlot,
 		virtualAddresses[i] = resources[i]->GetVirtualAddress();
 	}
 
-	m_commandList->SetVertexBuffers(startSlot,
-		count,
-		virtualAddresses.get(),
-		sizeInBytes,
-		strideInBytes);
+	// Only the range of slots that changed is set
+	if (m_vertexBuffers.size() < startSlot + count) {
+		m_vertexBuffers.resize(startSlot + count, VertexBufferBinding{ nullptr, 0, 0 });
+	}
+	unsigned first = 0;
+	unsigned last = count;
+	while (first < last && m_vertexBuffers[startSlot + first] == VertexBufferBinding{ virtualAddresses[first], sizeInBytes[first], strideInBytes[first] }) {
+		++first;
+	}
+	while (last > first && m_vertexBuffers[startSlot + last - 1] == VertexBufferBinding{ virtualAddresses[last - 1], sizeInBytes[last - 1], strideInBytes[last - 1] }) {
+		--last;
+	}
+	if (first == last) {
+		CountStateCall(false);
+		return;
+	}
+
+	m_commandList->SetVertexBuffers(startSlot + first,
+		last - first,
+		virtualAddresses.get() + first,
+		sizeInBytes + first,
+		strideInBytes + first);
+	for (unsigned i = first; i < last; ++i) {
+		m_vertexBuffers[startSlot + i] = { virtualAddresses[i], sizeInBytes[i], strideInBytes[i] };
+	}
+	CountStateCall(true);
 }
 
 
@@ -189,53 +276,27 @@ void GraphicsCommandList::SetGraphicsBinder(Binder* binder) {
 
 
 void GraphicsCommandList::BindGraphics(BindParameter parameter, const TextureView1D& shaderResource) {
-	try {
-		m_graphicsBindingManager.Bind(parameter, shaderResource);
-	}
-	catch (std::bad_alloc&) {
-		NewScratchSpace(1000);
-		m_graphicsBindingManager.Bind(parameter, shaderResource);
-	}
+	m_graphicsBindingManager.Bind(parameter, shaderResource);
 }
 
 void GraphicsCommandList::BindGraphics(BindParameter parameter, const TextureView2D& shaderResource) {
-	try {
-		m_graphicsBindingManager.Bind(parameter, shaderResource);
-	}
-	catch (std::bad_alloc&) {
-		NewScratchSpace(1000);
-		m_graphicsBindingManager.Bind(parameter, shaderResource);
-	}
+	m_graphicsBindingManager.Bind(parameter, shaderResource);
 }
 
 void GraphicsCommandList::BindGraphics(BindParameter parameter, const TextureView3D& shaderResource) {
-	try {
-		m_graphicsBindingManager.Bind(parameter, shaderResource);
-	}
-	catch (std::bad_alloc&) {
-		NewScratchSpace(1000);
-		m_graphicsBindingManager.Bind(parameter, shaderResource);
-	}
+	m_graphicsBindingManager.Bind(parameter, shaderResource);
 }
 
 void GraphicsCommandList::BindGraphics(BindParameter parameter, const ConstBufferView& shaderConstant) {
-	try {
-		m_graphicsBindingManager.Bind(parameter, shaderConstant);
-	}
-	catch (std::bad_alloc&) {
-		NewScratchSpace(1000);
-		m_graphicsBindingManager.Bind(parameter, shaderConstant);
-	}
+	m_graphicsBindingManager.Bind(parameter, shaderConstant);
 }
 
 void GraphicsCommandList::BindGraphics(BindParameter parameter, const void* shaderConstant, int size, int offset) {
-	try {
-		m_graphicsBindingManager.Bind(parameter, shaderConstant, size, offset);
-	}
-	catch (std::bad_alloc&) {
-		NewScratchSpace(1000);
-		m_graphicsBindingManager.Bind(parameter, shaderConstant, size, offset);
-	}
+	m_graphicsBindingManager.Bind(parameter, shaderConstant, size, offset);
+}
+
+void GraphicsCommandList::BindGraphics(BindParameter parameter, TextureTable& textureTable) {
+	m_graphicsBindingManager.Bind(parameter, textureTable);
 }
 
 
@@ -245,46 +306,51 @@ void GraphicsCommandList::NewScratchSpace(size_t hint) {
 }
 
 
+//------------------------------------------------------------------------------
+// Redundant state filtering
+//------------------------------------------------------------------------------
+
+size_t GraphicsCommandList::GetNumSubmittedStateCalls() const {
+	return ComputeCommandList::GetNumSubmittedStateCalls() + m_graphicsBindingManager.GetNumSubmittedCalls();
+}
+
+size_t GraphicsCommandList::GetNumFilteredStateCalls() const {
+	return ComputeCommandList::GetNumFilteredStateCalls() + m_graphicsBindingManager.GetNumFilteredCalls();
+}
+
+
+void GraphicsCommandList::InvalidateState() {
+	ComputeCommandList::InvalidateState();
+	InvalidateBundleState();
+	m_graphicsBindingManager.InvalidateRootSignature();
+}
+
+
+void GraphicsCommandList::InvalidateBundleState() {
+	// Bundles leave their pipeline state, input assembler state and root arguments set on the list,
+	// the root signature and the descriptor tables are inherited and can't be changed by bundles
+	InvalidatePipelineState();
+	m_topology.reset();
+	m_vertexBuffers.clear();
+	m_indexBuffer = nullptr;
+	m_graphicsBindingManager.InvalidateRootArguments();
+}
+
+
 void GraphicsCommandList::BindGraphics(BindParameter parameter, const RWTextureView1D& rwResource) {
-	try {
-		m_graphicsBindingManager.Bind(parameter, rwResource);
-	}
-	catch (std::bad_alloc&) {
-		NewScratchSpace(1000);
-		m_graphicsBindingManager.Bind(parameter, rwResource);
-	}
+	m_graphicsBindingManager.Bind(parameter, rwResource);
 }
 
 void GraphicsCommandList::BindGraphics(BindParameter parameter, const RWTextureView2D& rwResource) {
-	try {
-		m_graphicsBindingManager.Bind(parameter, rwResource);
-	}
-	catch (std::bad_alloc&) {
-		NewScratchSpace(1000);
-		m_graphicsBindingManager.Bind(parameter, rwResource);
-	}
+	m_graphicsBindingManager.Bind(parameter, rwResource);
 }
 
 void GraphicsCommandList::BindGraphics(BindParameter parameter, const RWTextureView3D& rwResource) {
-	try {
-		m_graphicsBindingManager.Bind(parameter, rwResource);
-	}
-	catch (std::bad_alloc&) {
-		NewScratchSpace(1000);
-		m_graphicsBindingManager.Bind(parameter, rwResource);
-	}
+	m_graphicsBindingManager.Bind(parameter, rwResource);
 }
 
 void GraphicsCommandList::BindGraphics(BindParameter parameter, const RWBufferView& rwResource) {
-	{
-		try {
-			m_graphicsBindingManager.Bind(parameter, rwResource);
-		}
-		catch (std::bad_alloc&) {
-			NewScratchSpace(1000);
-			m_graphicsBindingManager.Bind(parameter, rwResource);
-		}
-	}
+	m_graphicsBindingManager.Bind(parameter, rwResource);
 }
 
 
@@ -5,12 +5,19 @@
 #include "PipelineEventListener.hpp"
 #include "StackDescHeap.hpp"
 #include "BindingManager.hpp"
+#include "GraphicsBundle.hpp"
+
+#include <optional>
 
 namespace inl {
 namespace gxeng {
 
 
 
+/// <remarks>
+/// The pipeline state, binder, topology, vertex and index buffers and root arguments last set are remembered,
+/// and calls that would set them again are dropped, see GetNumFilteredStateCalls.
+/// </remarks>
 class GraphicsCommandList : public ComputeCommandList {
 public:
 	GraphicsCommandList(
@@ -50,7 +57,13 @@ public:
 					   unsigned numInstances = 1,
 					   unsigned startInstance = 0);
 
-	//!!! void ExecuteBundle(IGraphicsCommandList* bundle);
+	/// <summary> Executes the commands of the bundle, which inherits the bindings of this list.
+	///		The bundle is kept alive until the GPU has finished this list. </summary>
+	void ExecuteBundle(std::shared_ptr<const GraphicsBundle> bundle);
+
+	/// <summary> Executes the commands laid out in the argument buffer, such as the draws of an IndirectDrawList. </summary>
+	/// <param name="arguments"> Upload heap memory, which is readable as indirect arguments. </param>
+	void ExecuteIndirect(gxapi::ICommandSignature* commandSignature, unsigned numCommands, const ConstBuffer& arguments);
 
 	// input assembler
 	void SetIndexBuffer(const IndexBuffer* resource, bool is32Bit);
@@ -88,11 +101,38 @@ public:
 	void BindGraphics(BindParameter parameter, const RWTextureView2D& rwResource);
 	void BindGraphics(BindParameter parameter, const RWTextureView3D& rwResource);
 	void BindGraphics(BindParameter parameter, const RWBufferView& rwResource);
+	/// <summary> Binds all textures, draws then pass the index of their texture in root constants. </summary>
+	void BindGraphics(BindParameter parameter, TextureTable& textureTable);
+
+	virtual size_t GetNumSubmittedStateCalls() const override;
+	virtual size_t GetNumFilteredStateCalls() const override;
 protected:
 	virtual Decomposition Decompose() override;
 	virtual void NewScratchSpace(size_t hint) override;
+	virtual void InvalidateState() override;
+private:
+	struct VertexBufferBinding {
+		void* address;
+		unsigned size;
+		unsigned stride;
+
+		bool operator==(const VertexBufferBinding& rhs) const { return address == rhs.address && size == rhs.size && stride == rhs.stride; }
+		bool operator!=(const VertexBufferBinding& rhs) const { return !(*this == rhs); }
+	};
+
+	void CommitGraphicsBindings();
+	/// <summary> Forgets the state that executed bundles may have changed. </summary>
+	void InvalidateBundleState();
 private:
 	gxapi::IGraphicsCommandList* m_commandList;
+	std::vector<std::shared_ptr<const GraphicsBundle>> m_executedBundles;
+
+	// State set on the API command list
+	std::optional<gxapi::ePrimitiveTopology> m_topology;
+	std::vector<VertexBufferBinding> m_vertexBuffers; // indexed by slot, address is nullptr if not known
+	void* m_indexBuffer = nullptr; // nullptr if not known
+	uint64_t m_indexBufferSize = 0;
+	bool m_indexBuffer32Bit = false;
 
 	// scratch space managment
 	BindingManager<gxapi::eCommandListType::GRAPHICS> m_graphicsBindingManager;
@@ -1,5 +1,8 @@
 #include "GraphicsContext.hpp"
 #include "MemoryManager.hpp"
+#include "PipelineStateCache.hpp"
+#include "TextureTable.hpp"
+#include "ShaderPermutationManager.hpp"
 
 
 namespace inl {
@@ -13,7 +16,10 @@ GraphicsContext::GraphicsContext(MemoryManager* memoryManager,
 	int processorCount,
 	int deviceCount,
 	ShaderManager* shaderManager,
-	gxapi::IGraphicsApi* graphicsApi)
+	gxapi::IGraphicsApi* graphicsApi,
+	PipelineStateCache* pipelineStateCache,
+	TextureTable* textureTable,
+	ShaderPermutationManager* shaderPermutations)
 
 	: m_memoryManager(memoryManager),
 	m_srvHeap(srvHeap),
@@ -22,7 +28,10 @@ GraphicsContext::GraphicsContext(MemoryManager* memoryManager,
 	m_processorCount(processorCount),
 	m_deviceCount(deviceCount),
 	m_shaderManager(shaderManager),
-	m_graphicsApi(graphicsApi)
+	m_shaderPermutations(shaderPermutations),
+	m_graphicsApi(graphicsApi),
+	m_pipelineStateCache(pipelineStateCache),
+	m_textureTable(textureTable)
 {}
 
 
@@ -108,6 +117,11 @@ VolatileConstBuffer GraphicsContext::CreateVolatileConstBuffer(const void * data
 }
 
 
+PersistentConstBuffer GraphicsContext::CreatePersistentConstBuffer(const void* data, size_t size) {
+	return m_memoryManager->CreatePersistentConstBuffer(data, (uint32_t)size);
+}
+
+
 ConstBufferView GraphicsContext::CreateCbv(VolatileConstBuffer& buffer, size_t offset, size_t size, VolatileViewHeap& viewHeap) {
 	return ConstBufferView(
 		buffer,
@@ -117,16 +131,41 @@ ConstBufferView GraphicsContext::CreateCbv(VolatileConstBuffer& buffer, size_t o
 }
 
 
+std::shared_ptr<GraphicsBundle> GraphicsContext::CreateBundle() const {
+	return std::make_shared<GraphicsBundle>(m_graphicsApi);
+}
+
+
+void GraphicsContext::RequestShader(const std::string& name, ShaderParts stages, const std::string& macros) const {
+	if (m_shaderPermutations) {
+		m_shaderPermutations->Request(name, stages, m_shaderPermutations->GetMask(macros));
+	}
+}
+
 ShaderProgram GraphicsContext::CreateShader(const std::string& name, ShaderParts stages, const std::string& macros) {
+	if (m_shaderPermutations) {
+		return m_shaderPermutations->GetProgram(name, stages, m_shaderPermutations->GetMask(macros));
+	}
 	return m_shaderManager->CreateShader(name, stages, macros);
 }
 
-gxapi::IPipelineState* GraphicsContext::CreatePSO(const gxapi::GraphicsPipelineStateDesc& desc) {
-	return m_graphicsApi->CreateGraphicsPipelineState(desc);
+std::shared_ptr<gxapi::IPipelineState> GraphicsContext::CreatePSO(const gxapi::GraphicsPipelineStateDesc& desc) {
+	if (m_pipelineStateCache) {
+		return m_pipelineStateCache->Get(desc);
+	}
+	return std::shared_ptr<gxapi::IPipelineState>(m_graphicsApi->CreateGraphicsPipelineState(desc));
 }
 
-gxapi::IPipelineState* GraphicsContext::CreatePSO(const gxapi::ComputePipelineStateDesc& desc) {
-	return m_graphicsApi->CreateComputePipelineState(desc);
+std::shared_ptr<gxapi::IPipelineState> GraphicsContext::CreatePSO(const gxapi::ComputePipelineStateDesc& desc) {
+	if (m_pipelineStateCache) {
+		return m_pipelineStateCache->Get(desc);
+	}
+	return std::shared_ptr<gxapi::IPipelineState>(m_graphicsApi->CreateComputePipelineState(desc));
+}
+
+
+TextureTable* GraphicsContext::GetTextureTable() const {
+	return m_textureTable;
 }
 
 
@@ -4,7 +4,9 @@
 #include "ResourceView.hpp"
 #include "ShaderManager.hpp"
 #include "VolatileViewHeap.hpp"
+#include "GraphicsBundle.hpp"
 #include <cstdint>
+#include <memory>
 
 
 namespace inl {
@@ -14,6 +16,9 @@ class MemoryManager;
 class CbvSrvUavHeap;
 class RTVHeap;
 class DSVHeap;
+class PipelineStateCache;
+class TextureTable;
+class ShaderPermutationManager;
 
 class GraphicsContext {
 public:
@@ -24,7 +29,10 @@ public:
 					int processorCount = 0,
 					int deviceCount = 0,
 					ShaderManager* shaderManager = nullptr,
-					gxapi::IGraphicsApi* graphicsApi = nullptr);
+					gxapi::IGraphicsApi* graphicsApi = nullptr,
+					PipelineStateCache* pipelineStateCache = nullptr,
+					TextureTable* textureTable = nullptr,
+					ShaderPermutationManager* shaderPermutations = nullptr);
 	GraphicsContext(const GraphicsContext& rhs) = default;
 	GraphicsContext(GraphicsContext&& rhs) = default;
 	GraphicsContext& operator=(const GraphicsContext& rhs) = default;
@@ -48,12 +56,23 @@ public:
 
 	// Constant buffers
 	VolatileConstBuffer CreateVolatileConstBuffer(const void* data, size_t size);
+	/// <summary> A constant buffer that stays valid until destroyed, for data that outlives a frame. </summary>
+	PersistentConstBuffer CreatePersistentConstBuffer(const void* data, size_t size);
 	ConstBufferView CreateCbv(VolatileConstBuffer& buffer, size_t offset, size_t size, VolatileViewHeap& viewHeap);
 
+	// Bundles
+	std::shared_ptr<GraphicsBundle> CreateBundle() const;
+
 	// Shaders and PSOs
+	/// <summary> Marks a shader as used, it is compiled with the others before the nodes create it. </summary>
+	void RequestShader(const std::string& name, ShaderParts stages, const std::string& macros) const;
 	ShaderProgram CreateShader(const std::string& name, ShaderParts stages, const std::string& macros);
-	gxapi::IPipelineState* CreatePSO(const gxapi::GraphicsPipelineStateDesc& desc);
-	gxapi::IPipelineState* CreatePSO(const gxapi::ComputePipelineStateDesc& desc);
+	std::shared_ptr<gxapi::IPipelineState> CreatePSO(const gxapi::GraphicsPipelineStateDesc& desc);
+	std::shared_ptr<gxapi::IPipelineState> CreatePSO(const gxapi::ComputePipelineStateDesc& desc);
+
+	// Textures
+	/// <summary> Table of all images, bind it once and pass <see cref="Image::GetTableIndex"/> to draws. </summary>
+	TextureTable* GetTextureTable() const;
 
 private:
 	// Memory management stuff
@@ -66,7 +85,12 @@ private:
 
 	// Shaders and PSOs
 	ShaderManager* m_shaderManager;
+	ShaderPermutationManager* m_shaderPermutations;
 	gxapi::IGraphicsApi* m_graphicsApi;
+	PipelineStateCache* m_pipelineStateCache;
+
+	// Textures
+	TextureTable* m_textureTable;
 };
 
 
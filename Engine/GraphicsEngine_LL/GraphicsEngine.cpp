@@ -14,7 +14,11 @@
 
 //forward
 #include "Nodes/Node_ForwardRender.hpp"
+#include "Nodes/Node_ClusterLights.hpp"
 #include "Nodes/Node_DepthPrepass.hpp"
+#include "Nodes/Node_FrustumCull.hpp"
+#include "Nodes/Node_TerrainLod.hpp"
+#include "Nodes/Node_OcclusionCull.hpp"
 
 #include "Nodes/Node_GenCSM.hpp"
 #include "Nodes/Node_RenderToBackBuffer.hpp"
@@ -25,8 +29,10 @@
 #include "Scene.hpp"
 #include "Camera.hpp"
 #include "Mesh.hpp"
+#include "DynamicMesh.hpp"
 #include "Image.hpp"
 #include "MeshEntity.hpp"
+#include "TerrainEntity.hpp"
 
 
 namespace inl {
@@ -35,12 +41,16 @@ namespace gxeng {
 using namespace gxapi;
 
 
+static const char* PipelineCacheFile = "./PipelineCache.bin";
+
+
 
 GraphicsEngine::GraphicsEngine(GraphicsEngineDesc desc)
 	: m_gxapiManager(desc.gxapiManager),
 	m_graphicsApi(desc.graphicsApi),
 	m_commandAllocatorPool(desc.graphicsApi),
-	m_scratchSpacePool(desc.graphicsApi, gxapi::eDescriptorHeapType::CBV_SRV_UAV),
+	m_textureTable(desc.graphicsApi),
+	m_scratchSpacePool(desc.graphicsApi, gxapi::eDescriptorHeapType::CBV_SRV_UAV, &m_textureTable),
 	m_textureSpace(desc.graphicsApi),
 	m_masterCommandQueue(desc.graphicsApi->CreateCommandQueue(CommandQueueDesc{ eCommandListType::GRAPHICS }), desc.graphicsApi->CreateFence(0)),
 	m_residencyQueue(std::unique_ptr<gxapi::IFence>(desc.graphicsApi->CreateFence(0))),
@@ -49,7 +59,9 @@ GraphicsEngine::GraphicsEngine(GraphicsEngineDesc desc)
 	m_rtvHeap(desc.graphicsApi),
 	m_persResViewHeap(desc.graphicsApi),
 	m_logger(desc.logger),
-	m_shaderManager(desc.gxapiManager)
+	m_shaderManager(desc.gxapiManager),
+	m_shaderPermutations(&m_shaderManager),
+	m_pipelineStateCache(desc.graphicsApi)
 {
 	// Create swapchain
 	SwapChainDesc swapChainDesc;
@@ -78,7 +90,13 @@ GraphicsEngine::GraphicsEngine(GraphicsEngineDesc desc)
 	flags += gxapi::eShaderCompileFlags::DEBUG;
 	m_shaderManager.SetShaderCompileFlags(flags);
 #endif // NDEBUG
+	m_shaderManager.SetCacheDirectory("./ShaderCache");
+#ifndef NDEBUG
+	m_shaderManager.EnableHotReload(true);
+#endif
 
+	// Reuse pipelines compiled by previous runs, a missing or outdated file is not an error
+	m_pipelineStateCache.Load(PipelineCacheFile);
 
 	// Do more stuff...
 	CreatePipeline();
@@ -102,6 +120,13 @@ GraphicsEngine::GraphicsEngine(GraphicsEngineDesc desc)
 GraphicsEngine::~GraphicsEngine() {
 	SyncPoint lastSync = m_masterCommandQueue.Signal();
 	lastSync.Wait();
+
+	try {
+		m_pipelineStateCache.Save(PipelineCacheFile);
+	}
+	catch (std::exception& ex) {
+		m_logStreamGeneral.Event(exc::Event{ "Failed to save pipeline cache", exc::EventParameterString("reason", ex.what()) });
+	}
 }
 
 
@@ -115,6 +140,29 @@ void GraphicsEngine::Update(float elapsed) {
 		m_frameEndFenceValues[backBufferIndex].Wait();
 	}
 
+	// Swap in shaders that have been recompiled in the background
+	ApplyReloadedShaders();
+
+	// Dynamic meshes draw the version that the frame completed above was reading
+	for (DynamicMesh* mesh : m_dynamicMeshes) {
+		mesh->Flip();
+	}
+
+	// Upload terrain chunks generated since the last frame, their entities are placed below
+	for (Scene* scene : m_scenes) {
+		for (TerrainEntity* terrain : scene->GetTerrainEntities()) {
+			terrain->StreamChunks();
+		}
+	}
+
+	// Recompute world matrices of entities that moved since the last frame
+	m_meshEntityStore->UpdateWorldMatrices();
+
+	// Refit the scenes' spatial indices around the entities that moved, culling nodes query them
+	for (Scene* scene : m_scenes) {
+		scene->UpdateSpatialIndex(m_meshEntityStore->GetMovedEntities());
+	}
+
 	// Set up context
 	FrameContext context;
 	context.frameTime = frameTime;
@@ -191,8 +239,33 @@ Mesh* GraphicsEngine::CreateMesh() {
 	return new Mesh(&m_memoryManager);
 }
 
+DynamicMesh* GraphicsEngine::CreateDynamicMesh() {
+	class ObservedDynamicMesh : public DynamicMesh {
+	public:
+		ObservedDynamicMesh(std::function<void(DynamicMesh*)> deleteHandler, MemoryManager* memoryManager, unsigned numVersions) :
+			DynamicMesh(memoryManager, numVersions), m_deleteHandler(std::move(deleteHandler))
+		{}
+		~ObservedDynamicMesh() {
+			if (m_deleteHandler) { m_deleteHandler(static_cast<DynamicMesh*>(this)); }
+		}
+	protected:
+		std::function<void(DynamicMesh*)> m_deleteHandler;
+	};
+
+	// Functor to perform the unregistration.
+	auto unregisterMesh = [this](DynamicMesh* arg) {
+		m_dynamicMeshes.erase(arg);
+	};
+
+	// One version for each frame in flight, which is one per back buffer.
+	DynamicMesh* mesh = new ObservedDynamicMesh(unregisterMesh, &m_memoryManager, (unsigned)m_frameEndFenceValues.size());
+	m_dynamicMeshes.insert(mesh);
+
+	return mesh;
+}
+
 Image* GraphicsEngine::CreateImage() {
-	return new Image(&m_memoryManager, &m_textureSpace);
+	return new Image(&m_memoryManager, &m_textureSpace, &m_textureTable);
 }
 
 // Scene
@@ -250,7 +323,11 @@ Camera* GraphicsEngine::CreateCamera(std::string name) {
 }
 
 MeshEntity* GraphicsEngine::CreateMeshEntity() {
-	return new MeshEntity;
+	return new MeshEntity(m_meshEntityStore);
+}
+
+TerrainEntity* GraphicsEngine::CreateTerrainEntity() {
+	return new TerrainEntity(&m_memoryManager, m_meshEntityStore);
 }
 
 
@@ -260,40 +337,92 @@ void GraphicsEngine::CreatePipeline() {
 	std::unique_ptr<nodes::GetSceneByName> getWorldScene(new nodes::GetSceneByName());
 	std::unique_ptr<nodes::GetCameraByName> getCamera(new nodes::GetCameraByName());
 	std::unique_ptr<nodes::RenderToBackBuffer> renderToBackbuffer(new nodes::RenderToBackBuffer(m_graphicsApi));
+	std::unique_ptr<nodes::TerrainLod> terrainLod(new nodes::TerrainLod(swapChainDesc.width, swapChainDesc.height));
+	std::unique_ptr<nodes::FrustumCull> frustumCull(new nodes::FrustumCull());
+	std::unique_ptr<nodes::OcclusionCull> occlusionCull(new nodes::OcclusionCull());
+	std::unique_ptr<nodes::ClusterLights> clusterLights(new nodes::ClusterLights());
 
 	std::unique_ptr<nodes::ForwardRender> forwardRender(new nodes::ForwardRender(m_graphicsApi, swapChainDesc.width, swapChainDesc.height));
 	std::unique_ptr<nodes::DepthPrepass> depthPrePass(new nodes::DepthPrepass(m_graphicsApi, swapChainDesc.width, swapChainDesc.height));
+	std::unique_ptr<nodes::GenCSM> genCSM(new nodes::GenCSM(m_graphicsApi));
 
 	getWorldScene->GetInput<0>().Set("World");
 	getCamera->GetInput<0>().Set("WorldCam");
 
-	depthPrePass->GetInput<0>().Link(getWorldScene->GetOutput(0));
+	terrainLod->GetInput<0>().Link(getWorldScene->GetOutput(4));
+	terrainLod->GetInput<1>().Link(getCamera->GetOutput(0));
+
+	// the scene's entities are found through its spatial index, only the terrain chunks are given one by one
+	frustumCull->GetInput<0>().Link(terrainLod->GetOutput(0));
+	frustumCull->GetInput<1>().Link(getCamera->GetOutput(0));
+	frustumCull->GetInput<2>().Link(getWorldScene->GetOutput(5));
+
+	occlusionCull->GetInput<0>().Link(frustumCull->GetOutput(0));
+	occlusionCull->GetInput<1>().Link(getCamera->GetOutput(0));
+
+	depthPrePass->GetInput<0>().Link(occlusionCull->GetOutput(0));
 	depthPrePass->GetInput<1>().Link(getCamera->GetOutput(0));
 
+	// shadows are cast by entities outside the camera's view too, the node culls by cascade itself,
+	// terrain only casts them from the chunks selected for the camera
+	genCSM->GetInput<0>().Link(getCamera->GetOutput(0));
+	genCSM->GetInput<1>().Link(getWorldScene->GetOutput(1));
+	genCSM->GetInput<2>().Link(terrainLod->GetOutput(0));
+	genCSM->GetInput<3>().Link(getWorldScene->GetOutput(5));
+
+	clusterLights->GetInput<0>().Link(getCamera->GetOutput(0));
+	clusterLights->GetInput<1>().Link(getWorldScene->GetOutput(2));
+	clusterLights->GetInput<2>().Link(getWorldScene->GetOutput(3));
+
 	forwardRender->GetInput<0>().Link(depthPrePass->GetOutput(0));
-	forwardRender->GetInput<1>().Link(getWorldScene->GetOutput(0));
+	forwardRender->GetInput<1>().Link(occlusionCull->GetOutput(0));
 	forwardRender->GetInput<2>().Link(getCamera->GetOutput(0));
 	forwardRender->GetInput<3>().Link(getWorldScene->GetOutput(1));
+	forwardRender->GetInput<4>().Link(genCSM->GetOutput(0));
+	forwardRender->GetInput<5>().Link(clusterLights->GetOutput(0));
 
 	renderToBackbuffer->GetInput<0>().Link(forwardRender->GetOutput(0));
 
-	GraphicsContext graphicsContext(&m_memoryManager, &m_persResViewHeap, &m_rtvHeap, &m_dsvHeap, std::thread::hardware_concurrency(), 1, &m_shaderManager, m_graphicsApi);
+	GraphicsContext graphicsContext = CreateGraphicsContext();
+
+	// Compile the shaders of all nodes at once, in parallel, so that InitGraphics finds them compiled.
+	// Failed shaders are compiled again by InitGraphics, which reports the error.
+	std::vector<GraphicsNode*> graphicsNodes = {
+		getWorldScene.get(), getCamera.get(), terrainLod.get(), frustumCull.get(), occlusionCull.get(),
+		clusterLights.get(), depthPrePass.get(), genCSM.get(), forwardRender.get(), renderToBackbuffer.get()
+	};
+	for (GraphicsNode* node : graphicsNodes) {
+		node->RequestShaders(graphicsContext);
+	}
+	std::vector<std::string> shaderErrors;
+	m_shaderPermutations.Precompile(shaderErrors);
 
 	getWorldScene->InitGraphics(graphicsContext);
 	getCamera->InitGraphics(graphicsContext);
+	terrainLod->InitGraphics(graphicsContext);
+	frustumCull->InitGraphics(graphicsContext);
+	occlusionCull->InitGraphics(graphicsContext);
+	clusterLights->InitGraphics(graphicsContext);
 	depthPrePass->InitGraphics(graphicsContext);
+	genCSM->InitGraphics(graphicsContext);
 	forwardRender->InitGraphics(graphicsContext);
 	renderToBackbuffer->InitGraphics(graphicsContext);
 
 	m_windowResizeListeners.push_back(forwardRender.get());
 	m_windowResizeListeners.push_back(depthPrePass.get());
+	m_windowResizeListeners.push_back(terrainLod.get());
 
 	{
 		m_pipeline.CreateFromNodesList(
 			{
 				getWorldScene.get(),
 				getCamera.get(),
+				terrainLod.get(),
+				frustumCull.get(),
+				occlusionCull.get(),
+				clusterLights.get(),
 				depthPrePass.get(),
+				genCSM.get(),
 				forwardRender.get(),
 				renderToBackbuffer.get()
 			},
@@ -302,12 +431,49 @@ void GraphicsEngine::CreatePipeline() {
 
 		getWorldScene.release();
 		getCamera.release();
+		terrainLod.release();
+		frustumCull.release();
+		occlusionCull.release();
+		clusterLights.release();
 		depthPrePass.release();
+		genCSM.release();
 		forwardRender.release();
 		renderToBackbuffer.release();
 	}
 }
 
 
+GraphicsContext GraphicsEngine::CreateGraphicsContext() {
+	return GraphicsContext(&m_memoryManager, &m_persResViewHeap, &m_rtvHeap, &m_dsvHeap, std::thread::hardware_concurrency(), 1, &m_shaderManager, m_graphicsApi, &m_pipelineStateCache, &m_textureTable, &m_shaderPermutations);
+}
+
+
+void GraphicsEngine::ApplyReloadedShaders() {
+	std::vector<std::string> errors;
+	bool reloaded = m_shaderManager.ApplyReloadedShaders(errors);
+
+	for (const auto& error : errors) {
+		m_logStreamGeneral.Event(exc::Event{ "Shader hot reload failed", exc::eEventType::ERROR, exc::EventParameterString("message", error) });
+	}
+	if (!reloaded) {
+		return;
+	}
+
+	// Nodes rebuild their PSOs from the new binaries. The frames in flight may still use the old ones,
+	// they are released once the GPU is past the work submitted so far.
+	SyncPoint retirePoint = m_masterCommandQueue.Signal();
+	m_residencyQueue.EnqueueClean(retirePoint, {}, m_pipelineStateCache.GetLivePipelineStates());
+	m_shaderPermutations.InvalidatePrograms();
+
+	GraphicsContext graphicsContext = CreateGraphicsContext();
+	const Pipeline& pipeline = m_scheduler.GetPipeline();
+	for (lemon::ListDigraph::NodeIt it(pipeline.GetDependencyGraph()); it != lemon::INVALID; ++it) {
+		if (GraphicsNode* node = dynamic_cast<GraphicsNode*>(pipeline.GetNodeMap()[it])) {
+			node->InitGraphics(graphicsContext);
+		}
+	}
+}
+
+
 } // namespace gxeng
 } // namespace inl
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "Scheduler.hpp"
 #include "CommandAllocatorPool.hpp"
 #include "ScratchSpacePool.hpp"
+#include "TextureTable.hpp"
 #include "ResourceResidencyQueue.hpp"
 #include "PipelineEventDispatcher.hpp"
 #include "PipelineEventListener.hpp"
@@ -13,6 +14,10 @@
 #include "MemoryManager.hpp"
 #include "HostDescHeap.hpp"
 #include "ShaderManager.hpp"
+#include "ShaderPermutationManager.hpp"
+#include "PipelineStateCache.hpp"
+#include "GraphicsContext.hpp"
+#include "MeshEntityStore.hpp"
 
 #include <GraphicsApi_LL/IGxapiManager.hpp>
 #include <GraphicsApi_LL/IGraphicsApi.hpp>
@@ -27,10 +32,12 @@ namespace gxeng {
 
 
 class Mesh;
+class DynamicMesh;
 class Image;
 
 class Scene;
 class MeshEntity;
+class TerrainEntity;
 class Camera;
 
 class WindowResizeListener;
@@ -88,14 +95,19 @@ public:
 
 	// Resources
 	Mesh* CreateMesh();
+	/// <summary> Creates a mesh that is updated every frame, see DynamicMesh. </summary>
+	DynamicMesh* CreateDynamicMesh();
 	Image* CreateImage();
 
 	// Scene
 	Scene* CreateScene(std::string name);
 	MeshEntity* CreateMeshEntity();
+	TerrainEntity* CreateTerrainEntity();
 	Camera* CreateCamera(std::string name);
 private:
 	void CreatePipeline();
+	GraphicsContext CreateGraphicsContext();
+	void ApplyReloadedShaders();
 private:
 	// Graphics API things
 	gxapi::IGxapiManager* m_gxapiManager; // external resource, we should not delete it
@@ -115,11 +127,14 @@ private:
 
 	// Pipeline Facilities
 	CommandAllocatorPool m_commandAllocatorPool;
+	TextureTable m_textureTable; // Indices of images, copied to the start of each scratch space
 	ScratchSpacePool m_scratchSpacePool; // Creates CBV_SRV_UAV type scratch spaces
 	CbvSrvUavHeap m_textureSpace;
 	Pipeline m_pipeline;
 	Scheduler m_scheduler;
 	ShaderManager m_shaderManager;
+	ShaderPermutationManager m_shaderPermutations; // Nodes create their shaders through this
+	PipelineStateCache m_pipelineStateCache;
 	std::vector<SyncPoint> m_frameEndFenceValues;
 
 	// Pipeline elements
@@ -140,6 +155,8 @@ private:
 	// Scene
 	std::set<Scene*> m_scenes;
 	std::set<Camera*> m_cameras;
+	std::set<DynamicMesh*> m_dynamicMeshes;
+	std::shared_ptr<MeshEntityStore> m_meshEntityStore = std::make_shared<MeshEntityStore>(); // shared with entities, which may outlive the engine
 };
 
 
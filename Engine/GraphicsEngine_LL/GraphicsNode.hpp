@@ -14,6 +14,8 @@ class GraphicsContext;
 
 class GraphicsNode : virtual public exc::NodeBase {
 public:
+	/// <summary> Requests the shaders that InitGraphics creates, so that they are compiled up front, in parallel. </summary>
+	virtual void RequestShaders(const GraphicsContext& context) {}
 	virtual void InitGraphics(const GraphicsContext& context) = 0;
 	virtual Task GetTask() = 0;
 };
@@ -0,0 +1,294 @@
+#include "HlslTokenizer.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+#include <cctype>
+
+
+namespace inl::gxeng {
+
+
+static bool IsIdentifierStart(char c) {
+	return isalpha((unsigned char)c) || c == '_';
+}
+
+static bool IsIdentifierChar(char c) {
+	return isalnum((unsigned char)c) || c == '_';
+}
+
+static bool IsPunctuation(const HlslToken& token, char c) {
+	return token.type == eHlslToken::PUNCTUATION && token.text[0] == c;
+}
+
+
+//------------------------------------------------------------------------------
+// Tokenizer
+//------------------------------------------------------------------------------
+
+std::vector<HlslToken> TokenizeHlsl(std::string_view source) {
+	std::vector<HlslToken> tokens;
+	tokens.reserve(source.size() / 4);
+
+	const size_t size = source.size();
+	size_t i = 0;
+	bool lineStart = true;
+
+	while (i < size) {
+		char c = source[i];
+
+		// whitespace
+		if (isspace((unsigned char)c)) {
+			lineStart = lineStart || c == '\n';
+			++i;
+			continue;
+		}
+
+		// comments
+		if (c == '/' && i + 1 < size && source[i + 1] == '/') {
+			i = source.find('\n', i);
+			i = i == source.npos ? size : i;
+			continue;
+		}
+		if (c == '/' && i + 1 < size && source[i + 1] == '*') {
+			size_t end = source.find("*/", i + 2);
+			if (end == source.npos) {
+				throw std::invalid_argument("Unterminated block comment in shader code.");
+			}
+			i = end + 2;
+			continue;
+		}
+
+		size_t start = i;
+		eHlslToken type;
+
+		if (c == '#' && lineStart) {
+			// preprocessor directive, until the end of the line not preceded by a backslash
+			type = eHlslToken::PREPROCESSOR;
+			while (i < size && source[i] != '\n') {
+				i += (source[i] == '\\' && i + 1 < size) ? 2 : 1;
+			}
+		}
+		else if (IsIdentifierStart(c)) {
+			type = eHlslToken::IDENTIFIER;
+			while (i < size && IsIdentifierChar(source[i])) {
+				++i;
+			}
+		}
+		else if (isdigit((unsigned char)c) || (c == '.' && i + 1 < size && isdigit((unsigned char)source[i + 1]))) {
+			// digits, suffixes, the decimal point and signed exponents like 1.5e-3f
+			type = eHlslToken::NUMBER;
+			++i;
+			while (i < size) {
+				char n = source[i];
+				bool exponentSign = (n == '+' || n == '-') && (source[i - 1] == 'e' || source[i - 1] == 'E');
+				if (!IsIdentifierChar(n) && n != '.' && !exponentSign) {
+					break;
+				}
+				++i;
+			}
+		}
+		else if (c == '"') {
+			type = eHlslToken::STRING;
+			++i;
+			while (i < size && source[i] != '"') {
+				i += (source[i] == '\\') ? 2 : 1;
+			}
+			if (i >= size) {
+				throw std::invalid_argument("Unterminated string literal in shader code.");
+			}
+			++i;
+		}
+		else {
+			type = eHlslToken::PUNCTUATION;
+			++i;
+		}
+
+		tokens.push_back({ type, source.substr(start, i - start), start });
+		lineStart = false;
+	}
+
+	return tokens;
+}
+
+
+//------------------------------------------------------------------------------
+// Signatures
+//------------------------------------------------------------------------------
+
+static bool IsParameterModifier(std::string_view text) {
+	static constexpr std::string_view modifiers[] = {
+		"in", "out", "inout", "uniform", "const", "precise",
+		"linear", "centroid", "nointerpolation", "noperspective", "sample",
+		"row_major", "column_major",
+		"point", "line", "triangle", "lineadj", "triangleadj",
+	};
+	return std::find(std::begin(modifiers), std::end(modifiers), text) != std::end(modifiers);
+}
+
+
+// Concatenates tokens, keeping a space only where two words would otherwise merge.
+static std::string JoinTokens(const HlslToken* first, const HlslToken* last) {
+	std::string result;
+	for (auto it = first; it != last; ++it) {
+		if (it != first && it->type != eHlslToken::PUNCTUATION && (it - 1)->type != eHlslToken::PUNCTUATION) {
+			result += ' ';
+		}
+		result += it->text;
+	}
+	return result;
+}
+
+
+static std::pair<std::string, std::string> ParseParameter(const HlslToken* first, const HlslToken* last, std::string_view functionName) {
+	// cut off semantic and default value
+	int depth = 0;
+	for (auto it = first; it != last; ++it) {
+		if (IsPunctuation(*it, '<') || IsPunctuation(*it, '(') || IsPunctuation(*it, '{')) {
+			++depth;
+		}
+		else if (IsPunctuation(*it, '>') || IsPunctuation(*it, ')') || IsPunctuation(*it, '}')) {
+			--depth;
+		}
+		else if (depth == 0 && (IsPunctuation(*it, ':') || IsPunctuation(*it, '='))) {
+			last = it;
+			break;
+		}
+	}
+
+	// skip modifiers
+	while (first != last && first->type == eHlslToken::IDENTIFIER && IsParameterModifier(first->text)) {
+		++first;
+	}
+
+	// skip array dimensions after the name
+	while (last - first >= 3 && IsPunctuation(*(last - 1), ']')) {
+		do {
+			--last;
+		} while (last != first && !IsPunctuation(*last, '['));
+	}
+
+	if (last - first < 2 || (last - 1)->type != eHlslToken::IDENTIFIER) {
+		throw std::invalid_argument("Parameter of " + std::string(functionName) + " has no type specifier or declaration name.");
+	}
+
+	return { JoinTokens(first, last - 1), std::string((last - 1)->text) };
+}
+
+
+HlslFunctionSignature FindHlslFunctionSignature(const std::vector<HlslToken>& tokens, std::string_view functionName) {
+	int braceDepth = 0;
+	for (size_t i = 0; i < tokens.size(); ++i) {
+		const HlslToken& token = tokens[i];
+		if (IsPunctuation(token, '{')) {
+			++braceDepth;
+			continue;
+		}
+		if (IsPunctuation(token, '}')) {
+			--braceDepth;
+			continue;
+		}
+		if (braceDepth != 0
+			|| token.type != eHlslToken::IDENTIFIER
+			|| token.text != functionName
+			|| i + 1 >= tokens.size()
+			|| !IsPunctuation(tokens[i + 1], '('))
+		{
+			continue;
+		}
+
+		// find closing parenthesis
+		size_t closing = i + 1;
+		int parenDepth = 0;
+		for (; closing < tokens.size(); ++closing) {
+			parenDepth += IsPunctuation(tokens[closing], '(');
+			parenDepth -= IsPunctuation(tokens[closing], ')');
+			if (parenDepth == 0) {
+				break;
+			}
+		}
+		if (closing >= tokens.size()) {
+			throw std::invalid_argument("Unbalanced parentheses in signature of " + std::string(functionName) + ".");
+		}
+
+		// only accept definitions, optionally with a return semantic
+		size_t body = closing + 1;
+		if (body + 1 < tokens.size() && IsPunctuation(tokens[body], ':')) {
+			body += 2;
+		}
+		if (body >= tokens.size() || !IsPunctuation(tokens[body], '{')) {
+			continue;
+		}
+
+		HlslFunctionSignature signature;
+
+		// return type, possibly templated
+		size_t returnLast = i;
+		size_t returnFirst = i;
+		if (returnFirst > 0 && IsPunctuation(tokens[returnFirst - 1], '>')) {
+			int angleDepth = 0;
+			do {
+				--returnFirst;
+				angleDepth += IsPunctuation(tokens[returnFirst], '>');
+				angleDepth -= IsPunctuation(tokens[returnFirst], '<');
+			} while (returnFirst > 0 && angleDepth > 0);
+		}
+		if (returnFirst == 0 || tokens[returnFirst - 1].type != eHlslToken::IDENTIFIER) {
+			throw std::invalid_argument("Function " + std::string(functionName) + " has no return type.");
+		}
+		--returnFirst;
+		signature.returnType = JoinTokens(&tokens[returnFirst], &tokens[0] + returnLast);
+
+		// split parameters at top-level commas
+		const HlslToken* paramFirst = &tokens[i + 2];
+		const HlslToken* listEnd = &tokens[0] + closing;
+		bool isVoid = listEnd - paramFirst == 1 && paramFirst->type == eHlslToken::IDENTIFIER && paramFirst->text == "void";
+		if (paramFirst == listEnd || isVoid) {
+			return signature;
+		}
+		int depth = 0;
+		for (const HlslToken* it = paramFirst; it <= listEnd; ++it) {
+			if (it != listEnd) {
+				if (IsPunctuation(*it, '<') || IsPunctuation(*it, '(') || IsPunctuation(*it, '{')) {
+					++depth;
+				}
+				else if (IsPunctuation(*it, '>') || IsPunctuation(*it, ')') || IsPunctuation(*it, '}')) {
+					--depth;
+				}
+				if (depth != 0 || !IsPunctuation(*it, ',')) {
+					continue;
+				}
+			}
+			signature.parameters.push_back(ParseParameter(paramFirst, it, functionName));
+			paramFirst = it + 1;
+		}
+
+		return signature;
+	}
+
+	throw std::invalid_argument("No " + std::string(functionName) + " function found in material shader.");
+}
+
+
+//------------------------------------------------------------------------------
+// Renaming
+//------------------------------------------------------------------------------
+
+std::string RenameHlslIdentifier(std::string_view source, const std::vector<HlslToken>& tokens, std::string_view from, std::string_view to) {
+	std::string result;
+	result.reserve(source.size());
+
+	size_t copied = 0;
+	for (const auto& token : tokens) {
+		if (token.type == eHlslToken::IDENTIFIER && token.text == from) {
+			result.append(source.substr(copied, token.offset - copied));
+			result.append(to);
+			copied = token.offset + token.text.size();
+		}
+	}
+	result.append(source.substr(copied));
+
+	return result;
+}
+
+
+} // namespace inl::gxeng
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+
+
+namespace inl::gxeng {
+
+
+enum class eHlslToken {
+	IDENTIFIER,
+	NUMBER,
+	STRING,
+	PUNCTUATION,
+	PREPROCESSOR,
+};
+
+
+struct HlslToken {
+	eHlslToken type;
+	std::string_view text;
+	size_t offset; // position of the first character in the source
+};
+
+
+/// <summary>
+/// Splits HLSL source code into tokens in a single pass.
+/// <para />
+/// Comments and whitespace are dropped. Preprocessor directives become a single token
+/// spanning the whole (possibly continued) line. Multi-character operators are split
+/// into single characters, which is enough for finding declarations.
+/// The tokens reference the source, which must outlive them.
+/// </summary>
+/// <exception cref="std::invalid_argument"> If a block comment or a string is not terminated. </exception>
+std::vector<HlslToken> TokenizeHlsl(std::string_view source);
+
+
+struct HlslFunctionSignature {
+	std::string returnType;
+	std::vector<std::pair<std::string, std::string>> parameters; // (type, name)
+};
+
+
+/// <summary>
+/// Finds the definition of a function in the token stream and extracts its return type and parameters.
+/// <para />
+/// Input modifiers (in, out, const, etc.), semantics and default values of parameters
+/// are skipped, and template arguments are kept as part of the type.
+/// </summary>
+/// <exception cref="std::invalid_argument"> If there's no such function or the signature is malformed. </exception>
+HlslFunctionSignature FindHlslFunctionSignature(const std::vector<HlslToken>& tokens, std::string_view functionName);
+
+
+/// <summary> Replaces each occurrence of an identifier, leaving comments, strings and longer identifiers untouched. </summary>
+std::string RenameHlslIdentifier(std::string_view source, const std::vector<HlslToken>& tokens, std::string_view from, std::string_view to);
+
+
+} // namespace inl::gxeng
@@ -3,10 +3,13 @@
 #include "../GraphicsApi_LL/IGraphicsApi.hpp"
 #include "../GraphicsApi_LL/Exception.hpp"
 #include "../GraphicsApi_LL/IDescriptorHeap.hpp"
-#include "../BaseLibrary/Memory/SlabAllocatorEngine.hpp"
+#include "../BaseLibrary/BitOperations.hpp"
 
 #include <vector>
 #include <mutex>
+#include <atomic>
+#include <memory>
+#include <algorithm>
 #include <functional>
 #include <cassert>
 
@@ -27,7 +30,7 @@ public:
 /// This class was made for high level engine components
 /// that need a way of handling resource descriptors.
 /// <para />
-/// This class is thread safe.
+/// This class is thread safe. Lookups (<see cref="At"/>) are lock-free.
 /// <para />
 /// The heap automatically grows if current size is not
 /// sufficient for a new allocation.
@@ -38,10 +41,21 @@ public:
 /// </summary>
 template <gxapi::eDescriptorHeapType HeapType>
 class HostDescHeap : public IHostDescHeap {
+	// How it works:
+	// Descriptor heaps have a power of two size, and are organized into a two level
+	// directory: the directory holds chunks, each chunk holds chunkDim heaps.
+	// A global index is split into (chunk, heap, descriptor) by shifts and masks.
+	// Growing only ever appends new chunks/heaps, and publishes them through atomics
+	// before the new slots become allocatable, so readers never have to lock.
+	// Slot occupancy is tracked by a bitmap, one bit per descriptor.
 	static constexpr size_t chunkDim = 64;
-	struct ChunkListItem {
-		std::unique_ptr<gxapi::IDescriptorHeap> heaps[chunkDim];
-		std::unique_ptr<ChunkListItem> next;
+	static constexpr size_t chunkShift = 6;
+	static constexpr size_t directoryDim = 256;
+	static_assert(chunkDim == (size_t(1) << chunkShift), "chunkDim must be 2^chunkShift");
+
+	struct Chunk {
+		Chunk() { for (auto& heap : heaps) { heap.store(nullptr, std::memory_order_relaxed); } }
+		std::atomic<gxapi::IDescriptorHeap*> heaps[chunkDim];
 	};
 
 public:
@@ -52,100 +66,126 @@ public:
 	gxapi::DescriptorHandle At(size_t pos) override;
 private:
 	void Grow();
+	static size_t CeilLog2(size_t value);
 
 protected:
 	gxapi::IGraphicsApi* const m_graphicsApi;
 private:
-	std::mutex m_listMutex;
-	std::unique_ptr<ChunkListItem> m_first;
-	size_t m_descriptorCount;
+	const size_t m_heapShift;
+	const size_t m_heapDim;
 
-	std::mutex m_allocMutex;
-	exc::SlabAllocatorEngine m_allocEngine;
+	std::atomic<Chunk*> m_directory[directoryDim];
+	std::atomic<size_t> m_descriptorCount;
 
-	const size_t heapDim;
+	// Only touched while m_allocMutex is held.
+	std::mutex m_allocMutex;
+	std::vector<std::unique_ptr<Chunk>> m_chunks;
+	std::vector<std::unique_ptr<gxapi::IDescriptorHeap>> m_heaps;
+	std::vector<uint64_t> m_occupancy; // 1 bit per slot, 1 means occupied
+	size_t m_firstFreeWord; // no free slots before this word
 };
 
 
 template <gxapi::eDescriptorHeapType HeapType>
 HostDescHeap<HeapType>::HostDescHeap(gxapi::IGraphicsApi* graphicsApi, size_t heapSize)
 	: m_graphicsApi(graphicsApi),
-	heapDim(heapSize),
-	m_allocEngine(0),
-	m_descriptorCount(0)
-{}
+	m_heapShift(CeilLog2(heapSize)),
+	m_heapDim(size_t(1) << m_heapShift),
+	m_descriptorCount(0),
+	m_firstFreeWord(0)
+{
+	for (auto& chunk : m_directory) {
+		chunk.store(nullptr, std::memory_order_relaxed);
+	}
+}
 
 template <gxapi::eDescriptorHeapType HeapType>
 size_t HostDescHeap<HeapType>::Allocate() {
-	try {
-		std::lock_guard<std::mutex> lkg(m_allocMutex);
-		return m_allocEngine.Allocate();
+	std::lock_guard<std::mutex> lkg(m_allocMutex);
+
+	size_t wordIdx = m_firstFreeWord;
+	while (wordIdx < m_occupancy.size() && m_occupancy[wordIdx] == ~uint64_t(0)) {
+		++wordIdx;
 	}
-	catch (std::bad_alloc&) {
-		std::lock_guard<std::mutex> lkg(m_listMutex);
+	if (wordIdx == m_occupancy.size()) {
+		// new slots start at the old end, which may be in the middle of the last word
+		wordIdx = m_descriptorCount.load(std::memory_order_relaxed) / 64;
 		Grow();
-		return m_allocEngine.Allocate();
 	}
+
+	const int bit = exc::CountTrailingZeros(~m_occupancy[wordIdx]);
+	assert(bit >= 0);
+	m_occupancy[wordIdx] |= uint64_t(1) << bit;
+	m_firstFreeWord = wordIdx;
+
+	return wordIdx * 64 + bit;
 }
 
 template <gxapi::eDescriptorHeapType HeapType>
 void HostDescHeap<HeapType>::Deallocate(size_t pos) {
 	std::lock_guard<std::mutex> lkg(m_allocMutex);
-	m_allocEngine.Deallocate(pos);
+	assert(pos < m_descriptorCount.load(std::memory_order_relaxed));
+
+	const size_t wordIdx = pos / 64;
+	assert(m_occupancy[wordIdx] & (uint64_t(1) << (pos % 64)));
+	m_occupancy[wordIdx] &= ~(uint64_t(1) << (pos % 64));
+	m_firstFreeWord = std::min(m_firstFreeWord, wordIdx);
 }
 
 template <gxapi::eDescriptorHeapType HeapType>
 gxapi::DescriptorHandle HostDescHeap<HeapType>::At(size_t pos) {
-	assert(pos < m_descriptorCount);
+	assert(pos < m_descriptorCount.load(std::memory_order_acquire));
 
-	// structure is like a 3D texture
-	const size_t chunkIdx = pos / (chunkDim*chunkDim); // z = i / (width*height)
-	const size_t heapIdx = (pos - chunkIdx*heapDim*chunkDim) / heapDim; // y = (i - z*width*height) / width
-	const size_t descIdx = (pos - chunkIdx*heapDim*chunkDim - heapIdx*heapDim) / 1; // x = (i - z*width*height - y*width) / 1
+	const size_t heapIdx = pos >> m_heapShift;
+	const size_t descIdx = pos & (m_heapDim - 1);
+	const size_t chunkIdx = heapIdx >> chunkShift;
+	const size_t heapInChunkIdx = heapIdx & (chunkDim - 1);
 
-	ChunkListItem* chunk = m_first.get();
-	for (size_t i = chunkIdx; i != 0; --i) {
-		chunk = chunk->next.get();
-	}
-
-	gxapi::IDescriptorHeap* heap = chunk->heaps[heapIdx].get();
-	gxapi::DescriptorHandle desc = heap->At(descIdx);
+	Chunk* chunk = m_directory[chunkIdx].load(std::memory_order_acquire);
+	gxapi::IDescriptorHeap* heap = chunk->heaps[heapInChunkIdx].load(std::memory_order_acquire);
 
-	return desc;
+	return heap->At(descIdx);
 }
 
 template <gxapi::eDescriptorHeapType HeapType>
 void HostDescHeap<HeapType>::Grow() {
-	ChunkListItem* chunk = m_first.get();
+	const size_t heapIdx = m_heaps.size();
+	const size_t chunkIdx = heapIdx >> chunkShift;
+	const size_t heapInChunkIdx = heapIdx & (chunkDim - 1);
 
-	// if there aren't any chunks
-	if (chunk == nullptr) {
-		m_first = std::make_unique<ChunkListItem>();
-		chunk = m_first.get();
+	if (chunkIdx >= directoryDim) {
+		throw gxapi::OutOfMemory("Host descriptor heap reached its maximum size.", m_heapDim);
 	}
 
-	// find last chunk
-	while (chunk->next) {
-		chunk = chunk->next.get();
+	// add new chunk if needed
+	if (heapInChunkIdx == 0) {
+		m_chunks.push_back(std::make_unique<Chunk>());
+		m_directory[chunkIdx].store(m_chunks.back().get(), std::memory_order_release);
 	}
 
-	// find last heap
-	ptrdiff_t heapIdx = 0;
-	while (heapIdx < chunkDim && chunk->heaps[heapIdx]) {
-		++heapIdx;
+	// allocate new heap
+	m_heaps.emplace_back(m_graphicsApi->CreateDescriptorHeap({ HeapType, m_heapDim, false }));
+	Chunk* chunk = m_directory[chunkIdx].load(std::memory_order_relaxed);
+	chunk->heaps[heapInChunkIdx].store(m_heaps.back().get(), std::memory_order_release);
+
+	// extend occupancy bitmap, slots past the end are marked as occupied
+	const size_t oldCount = m_descriptorCount.load(std::memory_order_relaxed);
+	const size_t newCount = oldCount + m_heapDim;
+	m_occupancy.resize((newCount + 63) / 64, ~uint64_t(0));
+	for (size_t pos = oldCount; pos < newCount; ++pos) {
+		m_occupancy[pos / 64] &= ~(uint64_t(1) << (pos % 64));
 	}
 
-	// add new chunk if needed
-	if (heapIdx >= chunkDim) {
-		chunk->next = std::make_unique<ChunkListItem>();
-		chunk = chunk->next.get();
-		heapIdx = 0;
-	}
+	m_descriptorCount.store(newCount, std::memory_order_release);
+}
 
-	// allocate new heap
-	chunk->heaps[heapIdx].reset(m_graphicsApi->CreateDescriptorHeap({ HeapType, heapDim, false }));
-	m_descriptorCount += heapDim;
-	m_allocEngine.Resize(m_descriptorCount);
+template <gxapi::eDescriptorHeapType HeapType>
+size_t HostDescHeap<HeapType>::CeilLog2(size_t value) {
+	size_t shift = 0;
+	while ((size_t(1) << shift) < value) {
+		++shift;
+	}
+	return shift;
 }
 
 
@@ -4,17 +4,23 @@ namespace inl {
 namespace gxeng {
 
 
-Image::Image(MemoryManager* memoryManager, CbvSrvUavHeap* descriptorHeap) {
+Image::Image(MemoryManager* memoryManager, CbvSrvUavHeap* descriptorHeap, TextureTable* textureTable) {
 	assert(memoryManager != nullptr);
 	m_memoryManager = memoryManager;
 	m_descriptorHeap = descriptorHeap;
+	m_textureTable = textureTable;
 
 	m_channelCount = 0;
+
+	// the index is stable from now on, the texture is put there once the layout is set
+	m_tableIndex = m_textureTable != nullptr ? m_textureTable->Allocate() : TextureTable::InvalidIndex;
 }
 
 
 Image::~Image() {
-
+	if (m_textureTable != nullptr) {
+		m_textureTable->Free(m_tableIndex);
+	}
 }
 
 
@@ -35,6 +41,9 @@ void Image::SetLayout(size_t width, size_t height, ePixelChannelType channelType
 		desc.numMipLevels = -1;
 		desc.planeIndex = 0;
 		m_resource.reset(new TextureView2D(texture, *m_descriptorHeap, texture.GetFormat(), desc));
+		if (m_textureTable != nullptr) {
+			m_textureTable->Set(m_tableIndex, m_resource->GetHandle());
+		}
 
 		m_channelCount = channelCount;
 		m_channelType = channelType;
@@ -124,6 +133,11 @@ std::shared_ptr<const TextureView2D> Image::GetSrv() {
 }
 
 
+uint32_t Image::GetTableIndex() const {
+	return m_tableIndex;
+}
+
+
 bool Image::ConvertFormat(ePixelChannelType channelType, int channelCount, ePixelClass pixelClass, gxapi::eFormat& fmt, int& resultingChannelCount) {
 	using gxapi::eFormat;
 
@@ -5,6 +5,7 @@
 #include "Pixel.hpp"
 #include "MemoryManager.hpp"
 #include "ResourceView.hpp"
+#include "TextureTable.hpp"
 
 
 namespace inl {
@@ -14,7 +15,10 @@ namespace gxeng {
 
 class Image {
 public:
-	Image(MemoryManager* memoryManager, CbvSrvUavHeap* descriptorHeap);
+	/// <param name="textureTable"> If not null, the image takes an index in the table for its lifetime. </param>
+	Image(MemoryManager* memoryManager, CbvSrvUavHeap* descriptorHeap, TextureTable* textureTable = nullptr);
+	Image(const Image&) = delete;
+	Image& operator=(const Image&) = delete;
 	~Image();
 
 	void SetLayout(size_t width, size_t height, ePixelChannelType channelType, int channelCount, ePixelClass pixelClass);
@@ -27,6 +31,9 @@ public:
 	ePixelClass GetPixelClass() const;
 
 	std::shared_ptr<const TextureView2D> GetSrv();
+	/// <summary> Index of the image in the texture table, it does not change while the image exists.
+	///		TextureTable::InvalidIndex if the image is not in a table. </summary>
+	uint32_t GetTableIndex() const;
 protected:
 	static bool Image::ConvertFormat(ePixelChannelType channelType, int channelCount, ePixelClass pixelClass, gxapi::eFormat& fmt, int& resultingChannelCount);
 private:
@@ -36,6 +43,8 @@ private:
 	ePixelClass m_pixelClass;
 	MemoryManager* m_memoryManager;
 	CbvSrvUavHeap* m_descriptorHeap;
+	TextureTable* m_textureTable;
+	uint32_t m_tableIndex;
 
 };
 
@@ -0,0 +1,58 @@
+#include "IndirectDrawList.hpp"
+
+#include <stdexcept>
+#include <cstring>
+
+
+namespace inl {
+namespace gxeng {
+
+
+void IndirectDrawList::AddConstants(unsigned rootParameterIndex, unsigned numValues, unsigned destOffset) {
+	if (!m_data.empty()) {
+		throw std::logic_error("Constants must be added before the draws.");
+	}
+
+	m_constants.push_back(gxapi::IndirectArgumentDesc::Constant(rootParameterIndex, destOffset, numValues));
+	m_numConstants += numValues;
+}
+
+
+void IndirectDrawList::AddConstants(const Binder& binder, BindParameter parameter) {
+	int rootParamIndex, rootTableIndex;
+	binder.Translate(parameter, rootParamIndex, rootTableIndex);
+
+	const gxapi::RootParameterDesc& rootParameter = binder.GetRootSignatureDesc().rootParameters[rootParamIndex];
+	if (rootParameter.type != gxapi::RootParameterDesc::CONSTANT) {
+		throw std::invalid_argument("Only constants kept inline in the root signature can be set by draws.");
+	}
+	AddConstants((unsigned)rootParamIndex, rootParameter.As<gxapi::RootParameterDesc::CONSTANT>().numConstants);
+}
+
+
+void IndirectDrawList::AddDraw(const gxapi::DrawIndexedArguments& arguments, const uint32_t* constants) {
+	size_t offset = m_data.size();
+	m_data.resize(offset + GetStride());
+	if (m_numConstants > 0) {
+		std::memcpy(m_data.data() + offset, constants, m_numConstants * sizeof(uint32_t));
+	}
+	std::memcpy(m_data.data() + offset + m_numConstants * sizeof(uint32_t), &arguments, sizeof(arguments));
+}
+
+
+void IndirectDrawList::Clear() {
+	m_data.clear();
+}
+
+
+gxapi::CommandSignatureDesc IndirectDrawList::GetSignatureDesc() const {
+	gxapi::CommandSignatureDesc desc;
+	desc.byteStride = GetStride();
+	desc.arguments = m_constants;
+	desc.arguments.push_back(gxapi::IndirectArgumentDesc::DrawIndexed());
+	return desc;
+}
+
+
+} // namespace gxeng
+} // namespace inl
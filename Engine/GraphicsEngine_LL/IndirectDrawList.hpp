@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Binder.hpp"
+
+#include "../GraphicsApi_LL/Common.hpp"
+
+#include <vector>
+#include <cstdint>
+
+
+namespace inl {
+namespace gxeng {
+
+
+/// <summary>
+/// Packs indexed draws, and the root constants that change between them, into an indirect argument buffer,
+/// so that any number of draws is submitted with one call, see GraphicsCommandList::ExecuteIndirect.
+/// </summary>
+/// <remarks>
+/// Constants are laid out first, then the draw arguments. The command signature is created from
+/// GetSignatureDesc, with the binder's root signature if the draws set constants.
+/// </remarks>
+class IndirectDrawList {
+public:
+	/// <summary> Draws set the 32-bit values of a root constant before drawing. Constants are added before any draw. </summary>
+	/// <exception cref="std::logic_error"> If draws have already been added. </exception>
+	void AddConstants(unsigned rootParameterIndex, unsigned numValues, unsigned destOffset = 0);
+	/// <summary> Draws set all values of the binder's inline constant. </summary>
+	/// <exception cref="std::invalid_argument"> If the binder does not keep the parameter inline. </exception>
+	/// <exception cref="std::logic_error"> If draws have already been added. </exception>
+	void AddConstants(const Binder& binder, BindParameter parameter);
+
+	/// <param name="constants"> The values of every constant added, in the order they were added. </param>
+	void AddDraw(const gxapi::DrawIndexedArguments& arguments, const uint32_t* constants = nullptr);
+	/// <summary> Removes the draws, the constants stay. </summary>
+	void Clear();
+
+	gxapi::CommandSignatureDesc GetSignatureDesc() const;
+	/// <summary> Whether the draws set root parameters, so the signature needs the root signature. </summary>
+	bool HasConstants() const { return m_numConstants > 0; }
+
+	unsigned GetStride() const { return m_numConstants * sizeof(uint32_t) + sizeof(gxapi::DrawIndexedArguments); }
+	size_t GetDrawCount() const { return m_data.size() / GetStride(); }
+	bool IsEmpty() const { return m_data.empty(); }
+	const uint8_t* GetData() const { return m_data.data(); }
+	size_t GetSize() const { return m_data.size(); }
+private:
+	std::vector<gxapi::IndirectArgumentDesc> m_constants;
+	unsigned m_numConstants = 0;
+	std::vector<uint8_t> m_data;
+};
+
+
+} // namespace gxeng
+} // namespace inl
@@ -0,0 +1,303 @@
+#include "LightClusters.hpp"
+
+#include "Camera.hpp"
+#include "PointLight.hpp"
+#include "SpotLight.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <stdexcept>
+#include <thread>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define INL_LIGHT_CLUSTERS_SSE
+#endif
+
+
+namespace inl {
+namespace gxeng {
+
+
+// Slices are only split across threads if each thread gets at least this many light-cluster tests.
+static constexpr size_t MinTestsPerThread = 65536;
+
+
+// View space lights as separate components, see the members of LightClusters.
+struct LightArrays {
+	const float* centersX;
+	const float* centersY;
+	const float* centersZ;
+	const float* ranges;
+	const float* directionsX;
+	const float* directionsY;
+	const float* directionsZ;
+	const float* cosAngles;
+	const float* sinAngles;
+};
+
+
+// Whether the light's sphere overlaps the box, and its cone overlaps the box's bounding sphere.
+// The cone test is the closest distance of the sphere's center to the cone's side, in the plane of the cone's axis.
+static bool IntersectsCluster(const Aabb& box, const mathfu::Vector<float, 3>& boxCenter, float boxRadius, const LightArrays& lights, size_t i) {
+	float x = lights.centersX[i], y = lights.centersY[i], z = lights.centersZ[i], range = lights.ranges[i];
+
+	float ex = std::max(0.0f, std::max(box.min.x() - x, x - box.max.x()));
+	float ey = std::max(0.0f, std::max(box.min.y() - y, y - box.max.y()));
+	float ez = std::max(0.0f, std::max(box.min.z() - z, z - box.max.z()));
+	bool sphereHit = ex * ex + ey * ey + ez * ez <= range * range;
+
+	float vx = boxCenter.x() - x, vy = boxCenter.y() - y, vz = boxCenter.z() - z;
+	float lengthSq = vx * vx + vy * vy + vz * vz;
+	float alongAxis = vx * lights.directionsX[i] + vy * lights.directionsY[i] + vz * lights.directionsZ[i];
+	float toSide = lights.cosAngles[i] * std::sqrt(std::max(0.0f, lengthSq - alongAxis * alongAxis)) - alongAxis * lights.sinAngles[i];
+	bool coneHit = toSide <= boxRadius && alongAxis <= boxRadius + range && alongAxis >= -boxRadius;
+
+	return sphereHit && coneHit;
+}
+
+
+// Appends the indices of the lights that intersect the box. Tests 4 lights at a time with SSE where available.
+static size_t FindClusterLights(const Aabb& box, const LightArrays& lights, const uint32_t* lightIndices, size_t count, std::vector<uint32_t>& clusterLights) {
+	mathfu::Vector<float, 3> boxCenter = (box.min + box.max) * 0.5f;
+	float boxRadius = (box.max - box.min).Length() * 0.5f;
+	size_t numFound = 0;
+	size_t i = 0;
+
+#ifdef INL_LIGHT_CLUSTERS_SSE
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 minX = _mm_set1_ps(box.min.x()), minY = _mm_set1_ps(box.min.y()), minZ = _mm_set1_ps(box.min.z());
+	const __m128 maxX = _mm_set1_ps(box.max.x()), maxY = _mm_set1_ps(box.max.y()), maxZ = _mm_set1_ps(box.max.z());
+	const __m128 centerX = _mm_set1_ps(boxCenter.x()), centerY = _mm_set1_ps(boxCenter.y()), centerZ = _mm_set1_ps(boxCenter.z());
+	const __m128 radius = _mm_set1_ps(boxRadius);
+	const __m128 negRadius = _mm_set1_ps(-boxRadius);
+
+	for (; i + 4 <= count; i += 4) {
+		const __m128 x = _mm_loadu_ps(lights.centersX + i);
+		const __m128 y = _mm_loadu_ps(lights.centersY + i);
+		const __m128 z = _mm_loadu_ps(lights.centersZ + i);
+		const __m128 range = _mm_loadu_ps(lights.ranges + i);
+
+		__m128 ex = _mm_max_ps(zero, _mm_max_ps(_mm_sub_ps(minX, x), _mm_sub_ps(x, maxX)));
+		__m128 ey = _mm_max_ps(zero, _mm_max_ps(_mm_sub_ps(minY, y), _mm_sub_ps(y, maxY)));
+		__m128 ez = _mm_max_ps(zero, _mm_max_ps(_mm_sub_ps(minZ, z), _mm_sub_ps(z, maxZ)));
+		__m128 distanceSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey)), _mm_mul_ps(ez, ez));
+		__m128 hit = _mm_cmple_ps(distanceSq, _mm_mul_ps(range, range));
+
+		__m128 vx = _mm_sub_ps(centerX, x), vy = _mm_sub_ps(centerY, y), vz = _mm_sub_ps(centerZ, z);
+		__m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+		__m128 alongAxis = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, _mm_loadu_ps(lights.directionsX + i)),
+												 _mm_mul_ps(vy, _mm_loadu_ps(lights.directionsY + i))),
+									  _mm_mul_ps(vz, _mm_loadu_ps(lights.directionsZ + i)));
+		__m128 fromAxis = _mm_sqrt_ps(_mm_max_ps(zero, _mm_sub_ps(lengthSq, _mm_mul_ps(alongAxis, alongAxis))));
+		__m128 toSide = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(lights.cosAngles + i), fromAxis), _mm_mul_ps(alongAxis, _mm_loadu_ps(lights.sinAngles + i)));
+		hit = _mm_and_ps(hit, _mm_cmple_ps(toSide, radius));
+		hit = _mm_and_ps(hit, _mm_cmple_ps(alongAxis, _mm_add_ps(radius, range)));
+		hit = _mm_and_ps(hit, _mm_cmpge_ps(alongAxis, negRadius));
+
+		int mask = _mm_movemask_ps(hit);
+		for (int lane = 0; lane < 4; ++lane) {
+			if (mask & (1 << lane)) {
+				clusterLights.push_back(lightIndices[i + lane]);
+				++numFound;
+			}
+		}
+	}
+#endif
+
+	for (; i < count; ++i) {
+		if (IntersectsCluster(box, boxCenter, boxRadius, lights, i)) {
+			clusterLights.push_back(lightIndices[i]);
+			++numFound;
+		}
+	}
+
+	return numFound;
+}
+
+
+LightClusters::LightClusters(unsigned tilesX, unsigned tilesY, unsigned numSlices)
+	: m_tilesX(tilesX), m_tilesY(tilesY), m_numSlices(numSlices)
+{
+	if (tilesX == 0 || tilesY == 0 || numSlices == 0) {
+		throw std::invalid_argument("Light clusters need at least one tile and slice.");
+	}
+	m_offsets.resize(GetNumClusters(), 0);
+	m_counts.resize(GetNumClusters(), 0);
+}
+
+
+void LightClusters::Build(const Camera& camera,
+						  const std::vector<const PointLight*>& pointLights,
+						  const std::vector<const SpotLight*>& spotLights,
+						  size_t maxIndices)
+{
+	mathfu::Matrix<float, 4, 4> projection = camera.GetPerspectiveMatrixRH();
+	m_nearPlane = camera.GetNearPlane();
+	m_farPlane = camera.GetFarPlane();
+	m_tanHalfFovX = 1.0f / projection(0, 0);
+	m_tanHalfFovY = 1.0f / projection(1, 1);
+	m_sliceScale = m_numSlices / std::log(m_farPlane / m_nearPlane);
+	m_sliceBias = -std::log(m_nearPlane) * m_sliceScale;
+
+	m_pointLights = pointLights;
+	m_spotLights = spotLights;
+	ConvertLights(camera.GetViewMatrixRH());
+
+	// Each thread bins a range of slices into a list of its own, the lists are joined in order
+	size_t numLights = m_ranges.size();
+	size_t numThreads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), m_numSlices);
+	numThreads = std::max<size_t>(1, std::min(numThreads, GetNumClusters() * numLights / MinTestsPerThread));
+
+	std::vector<std::vector<uint32_t>> threadIndices(numThreads);
+	if (numThreads == 1) {
+		BinSlices(0, m_numSlices, threadIndices[0]);
+	}
+	else {
+		std::vector<std::future<void>> workers;
+		for (size_t i = 1; i < numThreads; ++i) {
+			workers.push_back(std::async(std::launch::async, &LightClusters::BinSlices, this,
+										 unsigned(m_numSlices * i / numThreads),
+										 unsigned(m_numSlices * (i + 1) / numThreads),
+										 std::ref(threadIndices[i])));
+		}
+		BinSlices(0, unsigned(m_numSlices / numThreads), threadIndices[0]);
+		for (auto& worker : workers) {
+			worker.get();
+		}
+	}
+
+	m_lightIndices.clear();
+	size_t cluster = 0;
+	for (size_t i = 0; i < numThreads; ++i) {
+		size_t endCluster = ClusterIndex(0, 0, unsigned(m_numSlices * (i + 1) / numThreads));
+		auto source = threadIndices[i].begin();
+		for (; cluster < endCluster; ++cluster) {
+			uint32_t count = m_counts[cluster];
+			uint32_t kept = (uint32_t)std::min<size_t>(count, maxIndices - std::min(maxIndices, m_lightIndices.size()));
+			m_offsets[cluster] = (uint32_t)m_lightIndices.size();
+			m_counts[cluster] = kept;
+			m_lightIndices.insert(m_lightIndices.end(), source, source + kept);
+			source += count;
+		}
+	}
+}
+
+
+size_t LightClusters::ClusterIndex(unsigned tileX, unsigned tileY, unsigned slice) const {
+	return (size_t(slice) * m_tilesY + tileY) * m_tilesX + tileX;
+}
+
+
+unsigned LightClusters::SliceOf(float viewDistance) const {
+	if (viewDistance <= m_nearPlane) {
+		return 0;
+	}
+	float slice = std::floor(std::log(viewDistance) * m_sliceScale + m_sliceBias);
+	return (unsigned)std::min(std::max(slice, 0.0f), float(m_numSlices - 1));
+}
+
+
+Aabb LightClusters::ClusterBounds(size_t cluster) const {
+	unsigned tileX = unsigned(cluster % m_tilesX);
+	unsigned tileY = unsigned(cluster / m_tilesX % m_tilesY);
+	unsigned slice = unsigned(cluster / m_tilesX / m_tilesY);
+
+	float nearDistance = SliceNear(slice);
+	float farDistance = SliceNear(slice + 1);
+
+	// the tile's edges in NDC, rows go from the top of the screen
+	float left = -1.0f + 2.0f * tileX / m_tilesX;
+	float right = -1.0f + 2.0f * (tileX + 1) / m_tilesX;
+	float top = 1.0f - 2.0f * tileY / m_tilesY;
+	float bottom = 1.0f - 2.0f * (tileY + 1) / m_tilesY;
+
+	// the edges are lines through the eye, so the box is spanned by the near and far end of each edge
+	Aabb bounds;
+	bounds.min.x() = std::min(left * nearDistance, left * farDistance) * m_tanHalfFovX;
+	bounds.max.x() = std::max(right * nearDistance, right * farDistance) * m_tanHalfFovX;
+	bounds.min.y() = std::min(bottom * nearDistance, bottom * farDistance) * m_tanHalfFovY;
+	bounds.max.y() = std::max(top * nearDistance, top * farDistance) * m_tanHalfFovY;
+	bounds.min.z() = -farDistance;
+	bounds.max.z() = -nearDistance;
+	return bounds;
+}
+
+
+void LightClusters::ConvertLights(const mathfu::Matrix<float, 4, 4>& view) {
+	size_t numLights = m_pointLights.size() + m_spotLights.size();
+	for (auto* components : { &m_centersX, &m_centersY, &m_centersZ, &m_ranges, &m_directionsX, &m_directionsY, &m_directionsZ, &m_cosAngles, &m_sinAngles }) {
+		components->clear();
+		components->reserve(numLights);
+	}
+
+	auto addLight = [this, &view](const mathfu::Vector<float, 3>& position, float range, const mathfu::Vector<float, 3>& direction, float cosAngle, float sinAngle) {
+		mathfu::Vector<float, 4> center = view * mathfu::Vector<float, 4>(position, 1.0f);
+		mathfu::Vector<float, 4> axis = view * mathfu::Vector<float, 4>(direction, 0.0f);
+		m_centersX.push_back(center.x());
+		m_centersY.push_back(center.y());
+		m_centersZ.push_back(center.z());
+		m_ranges.push_back(range);
+		m_directionsX.push_back(axis.x());
+		m_directionsY.push_back(axis.y());
+		m_directionsZ.push_back(axis.z());
+		m_cosAngles.push_back(cosAngle);
+		m_sinAngles.push_back(sinAngle);
+	};
+
+	// a point light is a cone of half a turn, which never fails the cone test
+	for (const PointLight* light : m_pointLights) {
+		addLight(light->GetPosition(), light->GetRange(), { 0, 0, 0 }, -1.0f, 0.0f);
+	}
+	for (const SpotLight* light : m_spotLights) {
+		addLight(light->GetPosition(), light->GetRange(), light->GetDirection(), std::cos(light->GetAngle()), std::sin(light->GetAngle()));
+	}
+}
+
+
+void LightClusters::BinSlices(unsigned firstSlice, unsigned endSlice, std::vector<uint32_t>& lightIndices) {
+	std::vector<uint32_t> candidates;
+	std::vector<float> candidateComponents[9];
+	const std::vector<float>* components[9] = { &m_centersX, &m_centersY, &m_centersZ, &m_ranges, &m_directionsX, &m_directionsY, &m_directionsZ, &m_cosAngles, &m_sinAngles };
+
+	for (unsigned slice = firstSlice; slice < endSlice; ++slice) {
+		// Only the lights that reach the slice's depth range are tested against its tiles
+		float nearDistance = SliceNear(slice);
+		float farDistance = SliceNear(slice + 1);
+		candidates.clear();
+		for (uint32_t i = 0; i < (uint32_t)m_ranges.size(); ++i) {
+			float distance = -m_centersZ[i];
+			if (distance - m_ranges[i] <= farDistance && distance + m_ranges[i] >= nearDistance) {
+				candidates.push_back(i);
+			}
+		}
+		for (int c = 0; c < 9; ++c) {
+			candidateComponents[c].resize(candidates.size());
+			for (size_t i = 0; i < candidates.size(); ++i) {
+				candidateComponents[c][i] = (*components[c])[candidates[i]];
+			}
+		}
+		LightArrays candidateLights{
+			candidateComponents[0].data(), candidateComponents[1].data(), candidateComponents[2].data(),
+			candidateComponents[3].data(), candidateComponents[4].data(), candidateComponents[5].data(),
+			candidateComponents[6].data(), candidateComponents[7].data(), candidateComponents[8].data() };
+
+		for (unsigned tileY = 0; tileY < m_tilesY; ++tileY) {
+			for (unsigned tileX = 0; tileX < m_tilesX; ++tileX) {
+				size_t cluster = ClusterIndex(tileX, tileY, slice);
+				size_t numFound = FindClusterLights(ClusterBounds(cluster), candidateLights, candidates.data(), candidates.size(), lightIndices);
+				m_counts[cluster] = (uint32_t)numFound;
+			}
+		}
+	}
+}
+
+
+float LightClusters::SliceNear(unsigned slice) const {
+	return m_nearPlane * std::pow(m_farPlane / m_nearPlane, float(slice) / float(m_numSlices));
+}
+
+
+} // namespace gxeng
+} // namespace inl
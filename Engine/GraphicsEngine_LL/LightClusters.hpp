@@ -0,0 +1,111 @@
+#pragma once
+
+#include "BoundingVolume.hpp"
+
+#include <mathfu/vector_3.h>
+#include <mathfu/matrix_4x4.h>
+
+#include <vector>
+#include <limits>
+#include <cstdint>
+
+
+namespace inl {
+namespace gxeng {
+
+
+class Camera;
+class PointLight;
+class SpotLight;
+
+
+/// <summary>
+/// Bins lights into the froxels of the camera's view: the screen is split into tiles,
+/// the view range into slices that get exponentially thicker with distance.
+/// <para />
+/// Each cluster gets a compact list of the lights that may reach it, so shading a pixel only
+/// has to loop over the lights of its cluster.
+/// </summary>
+/// <remarks>
+/// Lights are numbered in the order they are given: point lights first, then spot lights.
+/// Lights are tested against the clusters' view space bounding boxes, spot lights are also tested by their cone.
+/// The results are conservative, lights may be listed in clusters near their edge that they do not reach.
+/// </remarks>
+class LightClusters {
+public:
+	LightClusters(unsigned tilesX = 16, unsigned tilesY = 8, unsigned numSlices = 16);
+
+	/// <summary> Bins the lights into the clusters of the camera's view. </summary>
+	/// <param name="maxIndices"> Capacity of the light index list. If there are more light-cluster pairs,
+	///		the clusters that do not fit are cut short. </param>
+	void Build(const Camera& camera,
+			   const std::vector<const PointLight*>& pointLights,
+			   const std::vector<const SpotLight*>& spotLights,
+			   size_t maxIndices = std::numeric_limits<size_t>::max());
+
+	unsigned GetTilesX() const { return m_tilesX; }
+	unsigned GetTilesY() const { return m_tilesY; }
+	unsigned GetNumSlices() const { return m_numSlices; }
+	size_t GetNumClusters() const { return size_t(m_tilesX) * m_tilesY * m_numSlices; }
+
+	/// <summary> Clusters are ordered by slice, then row from the top of the screen, then column from the left. </summary>
+	size_t ClusterIndex(unsigned tileX, unsigned tileY, unsigned slice) const;
+
+	/// <summary> The slice that contains the view distance, which is the distance along the camera's look direction. </summary>
+	/// <remarks> The shaders find the slice as floor(log(distance) * scale + bias), see GetSliceScale and GetSliceBias. </remarks>
+	unsigned SliceOf(float viewDistance) const;
+	float GetSliceScale() const { return m_sliceScale; }
+	float GetSliceBias() const { return m_sliceBias; }
+
+	/// <summary> View space bounding box of a cluster, as of the last Build. The camera looks along -z. </summary>
+	Aabb ClusterBounds(size_t cluster) const;
+
+	/// <summary> Where each cluster's lights start in the light index list. </summary>
+	const std::vector<uint32_t>& GetOffsets() const { return m_offsets; }
+	/// <summary> The number of lights of each cluster. </summary>
+	const std::vector<uint32_t>& GetCounts() const { return m_counts; }
+	/// <summary> The lights of all clusters, one cluster after the other. </summary>
+	const std::vector<uint32_t>& GetLightIndices() const { return m_lightIndices; }
+
+	/// <summary> The lights binned by the last Build. </summary>
+	const std::vector<const PointLight*>& GetPointLights() const { return m_pointLights; }
+	const std::vector<const SpotLight*>& GetSpotLights() const { return m_spotLights; }
+private:
+	void ConvertLights(const mathfu::Matrix<float, 4, 4>& view);
+	void BinSlices(unsigned firstSlice, unsigned endSlice, std::vector<uint32_t>& lightIndices);
+	float SliceNear(unsigned slice) const;
+private:
+	unsigned m_tilesX;
+	unsigned m_tilesY;
+	unsigned m_numSlices;
+
+	// camera of the last build
+	float m_nearPlane = 1;
+	float m_farPlane = 2;
+	float m_tanHalfFovX = 1;
+	float m_tanHalfFovY = 1;
+	float m_sliceScale = 0;
+	float m_sliceBias = 0;
+
+	std::vector<const PointLight*> m_pointLights;
+	std::vector<const SpotLight*> m_spotLights;
+
+	// view space lights as separate components for SIMD, point lights have a zero direction and a 180 degree cone
+	std::vector<float> m_centersX;
+	std::vector<float> m_centersY;
+	std::vector<float> m_centersZ;
+	std::vector<float> m_ranges;
+	std::vector<float> m_directionsX;
+	std::vector<float> m_directionsY;
+	std::vector<float> m_directionsZ;
+	std::vector<float> m_cosAngles;
+	std::vector<float> m_sinAngles;
+
+	std::vector<uint32_t> m_offsets;
+	std::vector<uint32_t> m_counts;
+	std::vector<uint32_t> m_lightIndices;
+};
+
+
+} // namespace gxeng
+} // namespace inl
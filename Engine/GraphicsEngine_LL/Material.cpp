@@ -1,5 +1,7 @@
 #include "Material.hpp"
 #include <stack>
+#include <mutex>
+#include <unordered_map>
 
 
 
@@ -35,17 +37,100 @@ void MaterialShaderEquation::SetSourceCode(const std::string& code) {
 // ShaderGraph
 //------------------------------------------------------------------------------
 
+struct GeneratedCodeEntry {
+	std::vector<std::string> functions;
+	std::vector<MaterialShaderGraph::Link> links;
+	std::string code;
+};
+
+struct GeneratedCodeCache {
+	std::mutex mutex;
+	std::unordered_multimap<uint64_t, GeneratedCodeEntry> entries;
+};
+
+static GeneratedCodeCache& GetGeneratedCodeCache() {
+	static GeneratedCodeCache cache;
+	return cache;
+}
+
+static uint64_t HashGraph(const std::vector<std::string>& functions, const std::vector<MaterialShaderGraph::Link>& links) {
+	// FNV-1a over the length-prefixed sources and the links
+	uint64_t hash = 14695981039346656037ull;
+	auto Append = [&hash](const void* data, size_t size) {
+		for (size_t i = 0; i < size; ++i) {
+			hash = (hash ^ static_cast<const uint8_t*>(data)[i]) * 1099511628211ull;
+		}
+	};
+	for (const auto& function : functions) {
+		uint64_t size = function.size();
+		Append(&size, sizeof(size));
+		Append(function.data(), function.size());
+	}
+	for (const auto& link : links) {
+		int fields[3] = { link.sourceNode, link.sinkNode, link.sinkPort };
+		Append(fields, sizeof(fields));
+	}
+	return hash;
+}
+
+static bool operator==(const MaterialShaderGraph::Link& lhs, const MaterialShaderGraph::Link& rhs) {
+	return lhs.sourceNode == rhs.sourceNode && lhs.sinkNode == rhs.sinkNode && lhs.sinkPort == rhs.sinkPort;
+}
+
+
 std::string MaterialShaderGraph::GetShaderCode(ShaderManager& shaderManager) const {
+	std::vector<std::string> functions(m_nodes.size());
+	for (size_t i = 0; i < m_nodes.size(); ++i) {
+		functions[i] = m_nodes[i]->GetShaderCode(shaderManager);
+	}
+
+	GeneratedCodeCache& cache = GetGeneratedCodeCache();
+	uint64_t hash = HashGraph(functions, m_links);
+	{
+		std::lock_guard<std::mutex> lkg(cache.mutex);
+		auto range = cache.entries.equal_range(hash);
+		for (auto it = range.first; it != range.second; ++it) {
+			if (it->second.functions == functions && it->second.links == m_links) {
+				return it->second.code;
+			}
+		}
+	}
+
+	// Generate outside the lock. If two threads race on the same graph, both
+	// generate the same code and the second insert is simply skipped.
+	GeneratedCodeEntry entry{ functions, m_links, GenerateShaderCode(std::move(functions)) };
+	std::string code = entry.code;
+	{
+		std::lock_guard<std::mutex> lkg(cache.mutex);
+		auto range = cache.entries.equal_range(hash);
+		bool exists = std::any_of(range.first, range.second, [&entry](const auto& cached) {
+			return cached.second.functions == entry.functions && cached.second.links == entry.links;
+		});
+		if (!exists) {
+			cache.entries.insert({ hash, std::move(entry) });
+		}
+	}
+	return code;
+}
+
+
+void MaterialShaderGraph::ClearCodeCache() {
+	GeneratedCodeCache& cache = GetGeneratedCodeCache();
+	std::lock_guard<std::mutex> lkg(cache.mutex);
+	cache.entries.clear();
+}
+
+
+std::string MaterialShaderGraph::GenerateShaderCode(std::vector<std::string> functions) const {
 	std::vector<ShaderNode> shaderNodes(m_nodes.size());
 	std::vector<std::vector<eMaterialShaderParamType>> shaderNodeParams(m_nodes.size());
 	std::vector<eMaterialShaderParamType> shaderNodeReturns(m_nodes.size());
-	std::vector<std::string> functions(m_nodes.size());
+	std::vector<std::vector<HlslToken>> tokens(m_nodes.size());
 
-	// collect individual shader codes and set number of input params for each node
+	// parse individual shader codes and set number of input params for each node
 	for (size_t i = 0; i < m_nodes.size(); ++i) {
-		MaterialShader* shader = m_nodes[i].get();
-		functions[i] = shader->GetShaderCode(shaderManager);
-		ExtractShaderParameters(functions[i], shaderNodeReturns[i], shaderNodeParams[i]);
+		tokens[i] = TokenizeHlsl(functions[i]);
+		ExtractShaderParameters(tokens[i], shaderNodeReturns[i], shaderNodeParams[i]);
 
 		for (auto p : shaderNodeParams[i]) {
 			if (p == eMaterialShaderParamType::UNKNOWN) { 
@@ -123,7 +208,7 @@ std::string MaterialShaderGraph::GetShaderCode(ShaderManager& shaderManager) con
 		std::stringstream ss;
 		ss << "main_" << topologicalOrder.size();
 		shaderNodes[node].SetFunctionName(ss.str());
-		functions[node] = std::regex_replace(functions[node], std::regex("main"), ss.str());
+		functions[node] = RenameHlslIdentifier(functions[node], tokens[node], "main", ss.str());
 		topologicalOrder.push_back(node);
 		shaderNodes[node].SetFunctionReturn(GetParameterString(shaderNodeReturns[node]));
 	};
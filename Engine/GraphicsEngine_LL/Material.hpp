@@ -1,10 +1,10 @@
 #pragma once
 
 #include "ShaderManager.hpp"
+#include "HlslTokenizer.hpp"
 
 #include <BaseLibrary/Graph_All.hpp>
 
-#include <regex>
 #include <sstream>
 #include <iterator>
 #include <algorithm>
@@ -84,9 +84,17 @@ private:
 	};
 
 public:
+	/// <summary> Generates a single main function that evaluates the whole graph. </summary>
+	/// <remarks> Generated code is cached by the graph's topology and its nodes' source code,
+	///		so graphs used by many materials are only processed once. </remarks>
 	std::string GetShaderCode(ShaderManager& shaderManager) const override;
 
 	void SetGraph(std::vector<std::unique_ptr<MaterialShader>> nodes, std::vector<Link> links);
+
+	/// <summary> Drops all cached generated code. </summary>
+	static void ClearCodeCache();
+private:
+	std::string GenerateShaderCode(std::vector<std::string> functions) const;
 private:
 	std::vector<std::unique_ptr<MaterialShader>> m_nodes;
 	std::vector<Link> m_links;
@@ -94,115 +102,6 @@ private:
 
 
 
-inline std::string RemoveComments(std::string code) {
-	std::stringstream ss(code);
-
-	// remove single line comments by trimming commented-out tails, line-by-line
-	std::string noSingleLine;
-	std::string singleLine;
-	while (std::getline(ss, singleLine)) {
-		size_t idx = singleLine.find_first_of("//");
-		if (idx != singleLine.npos) {
-			singleLine = singleLine.substr(0, idx - 1);
-		}
-		noSingleLine += singleLine;
-	}
-
-	// remove multiline comments by replacing regex template " /*anything*/ " to empty string
-	std::stringstream noComment;
-	std::regex multilinePattern(R"(/\*.*\*/)");
-	std::regex_replace(std::ostreambuf_iterator<char>(noComment), noSingleLine.begin(), noSingleLine.end(), multilinePattern, "");
-
-	std::string ret = noComment.str();
-	return ret;
-}
-
-
-inline std::string FindFunctionSignature(std::string code, const std::string& functionName) {
-	// regex to match " functionName ( anything ) { " 
-	std::regex signaturePattern(functionName + R"(\s*\(.*\)\s*\{)");
-
-	// find matches
-	std::smatch matches;
-	if (!std::regex_search(code, matches, signaturePattern)) {
-		throw std::invalid_argument("No main function found in material shader.");
-	}
-
-	// march back towards return type over whitespaces
-	intptr_t matchIdx = matches[0].first - code.cbegin();
-	matchIdx -= 1;
-	while (matchIdx >= 0 && isspace(code[matchIdx])) {
-		--matchIdx;
-	}
-
-	// march back over return type's characters
-	intptr_t returnIdx = matchIdx;
-	while (returnIdx >= 0 && !isspace(code[returnIdx])) {
-		--returnIdx;
-	}
-	returnIdx = std::max(intptr_t(0), returnIdx);
-
-	// return type spans across range [returnIdx, matchIdx], it being empty range means failure
-	if (matchIdx == returnIdx) {
-		throw std::invalid_argument("Main function has no return type.");
-	}
-
-	// walk back from match's end until ')'
-	intptr_t matchEndIdx = matches[0].second - code.begin();
-	while (code[matchEndIdx] != ')') {
-		matchEndIdx--;
-	}
-
-	return code.substr(returnIdx, matchEndIdx - returnIdx);
-}
-
-inline void SplitFunctionSignature(std::string signature, std::string& returnType, std::vector<std::pair<std::string, std::string>>& parameters) {
-	// extract part between the parentheses
-	size_t opening = signature.find_first_of('(');
-	size_t closing = signature.find_first_of(')');
-	std::stringstream paramString(signature.substr(opening + 1, closing - opening - 1));
-
-	// split the parameters string to individual parameters, and process them
-	std::string param;
-	while (getline(paramString, param, ',')) {
-		if (param.size() == 0) {
-			throw std::invalid_argument("Parameter of main has zero characters.");
-		}
-		// trim leading and trailing whitespaces
-		intptr_t firstChar = 0;
-		while (firstChar < param.size() && isspace(param[firstChar])) {
-			++firstChar;
-		}
-		intptr_t lastChar = param.size() - 1;
-		while (lastChar >= firstChar && isspace(param[lastChar])) {
-			--lastChar;
-		}
-		if (firstChar >= lastChar) {
-			throw std::invalid_argument("Parameter of main has no type specifier or declaration name.");
-		}
-		param = param.substr(firstChar, lastChar);
-
-		// split param to type and name
-		firstChar = 0;
-		while (!isspace(param[firstChar])) {
-			++firstChar;
-		}
-		lastChar = param.size() - 1;
-		while (!isspace(param[lastChar])) {
-			--lastChar;
-		}
-
-		parameters.push_back({ param.substr(0, firstChar), param.substr(lastChar+1, param.npos) });
-	}
-
-	// get return type
-	intptr_t lastChar = 0;
-	while (!isspace(signature[lastChar])) {
-		++lastChar;
-	}
-	returnType = signature.substr(0, lastChar);
-}
-
 inline std::string GetParameterString(eMaterialShaderParamType type) {
 	switch (type) {
 		case eMaterialShaderParamType::COLOR: return "float4";
@@ -230,19 +129,14 @@ inline eMaterialShaderParamType GetParameterType(std::string typeString) {
 	}
 }
 
-inline void ExtractShaderParameters(std::string code, eMaterialShaderParamType& returnType, std::vector<eMaterialShaderParamType>& parameters) {
-	code = RemoveComments(code);
-	std::string signature = FindFunctionSignature(code, "main");
-
-	std::string returnTypeStr;
-	std::vector<std::pair<std::string, std::string>> paramList;
-	SplitFunctionSignature(signature, returnTypeStr, paramList);
+inline void ExtractShaderParameters(const std::vector<HlslToken>& tokens, eMaterialShaderParamType& returnType, std::vector<eMaterialShaderParamType>& parameters) {
+	HlslFunctionSignature signature = FindHlslFunctionSignature(tokens, "main");
 
-	returnType = GetParameterType(returnTypeStr);
+	returnType = GetParameterType(signature.returnType);
 
 	// collect results
 	std::vector<eMaterialShaderParamType> params;
-	for (const auto& p : paramList) {
+	for (const auto& p : signature.parameters) {
 		eMaterialShaderParamType type = GetParameterType(p.first);
 		params.push_back(type);
 	}
@@ -250,21 +144,23 @@ inline void ExtractShaderParameters(std::string code, eMaterialShaderParamType&
 	parameters = std::move(params);
 }
 
+inline void ExtractShaderParameters(const std::string& code, eMaterialShaderParamType& returnType, std::vector<eMaterialShaderParamType>& parameters) {
+	ExtractShaderParameters(TokenizeHlsl(code), returnType, parameters);
+}
+
 
 
 
 // TEST IMPLEMENTATION
 inline std::string MaterialGenPixelShader(std::string shadingFunction) {
 	// get material shading function's HLSL code
+	std::vector<HlslToken> tokens = TokenizeHlsl(shadingFunction);
 	eMaterialShaderParamType returnType;
 	std::vector<eMaterialShaderParamType> params;
-	ExtractShaderParameters(shadingFunction, returnType, params);
+	ExtractShaderParameters(tokens, returnType, params);
 
 	// rename "main" to something else
-	std::stringstream renameMain;
-	std::regex renameRegex("main");
-	std::regex_replace(std::ostreambuf_iterator<char>(renameMain), shadingFunction.begin(), shadingFunction.end(), renameRegex, "mtl_shader");
-	shadingFunction = renameMain.str();
+	shadingFunction = RenameHlslIdentifier(shadingFunction, tokens, "main", "mtl_shader");
 
 	// add constant buffer, textures and samplers according to shader parameters
 	std::stringstream constantBuffer;
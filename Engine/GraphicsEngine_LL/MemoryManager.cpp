@@ -54,6 +54,9 @@ VertexBuffer MemoryManager::CreateVertexBuffer(eResourceHeapType heap, size_t si
 	MemoryObjDesc desc = AllocateResource(heap, gxapi::ResourceDesc::Buffer(size));
 
 	VertexBuffer result(std::move(desc));
+	if (heap == eResourceHeapType::UPLOAD) {
+		result.RecordState(gxapi::eResourceState::GENERIC_READ);
+	}
 	return result;
 }
 
@@ -62,6 +65,9 @@ IndexBuffer MemoryManager::CreateIndexBuffer(eResourceHeapType heap, size_t size
 	MemoryObjDesc desc = AllocateResource(heap, gxapi::ResourceDesc::Buffer(size));
 
 	IndexBuffer result(std::move(desc), indexCount);
+	if (heap == eResourceHeapType::UPLOAD) {
+		result.RecordState(gxapi::eResourceState::GENERIC_READ);
+	}
 	return result;
 }
 
@@ -149,6 +155,19 @@ MemoryObjDesc MemoryManager::AllocateResource(eResourceHeapType heap, const gxap
 	case eResourceHeapType::CRITICAL: 
 		return m_criticalHeap.Allocate(std::move(desc), pClearValue);
 		break;
+	case eResourceHeapType::UPLOAD:
+		if (desc.type != gxapi::eResourceType::BUFFER) {
+			throw gxapi::InvalidArgument("Only buffers can be placed in the upload heap.");
+		}
+		return MemoryObjDesc(
+			m_graphicsApi->CreateCommittedResource(
+				gxapi::HeapProperties{gxapi::eHeapType::UPLOAD},
+				gxapi::eHeapFlags::NONE,
+				desc,
+				gxapi::eResourceState::GENERIC_READ
+			)
+		);
+		break;
 	default:
 		assert(false);
 	}
@@ -19,7 +19,10 @@
 namespace inl {
 namespace gxeng {
 
-enum class eResourceHeapType { CRITICAL };
+/// <summary> Where resources are placed. </summary>
+/// <remarks> UPLOAD resources are buffers in CPU-visible memory that stay in GENERIC_READ state.
+///		The GPU reads them slower, but the CPU can write them at any time without a copy. </remarks>
+enum class eResourceHeapType { CRITICAL, UPLOAD };
 
 class MemoryManager {
 public:
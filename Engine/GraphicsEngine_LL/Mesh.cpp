@@ -2,6 +2,10 @@
 #include "VertexElementCompressor.hpp"
 #include <BaseLibrary/ArrayView.hpp>
 
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+
 using exc::ArrayView;
 
 
@@ -9,64 +13,141 @@ namespace inl {
 namespace gxeng {
 
 
-
-void Mesh::Set(const VertexBase* vertices, size_t numVertices, const unsigned* indices, size_t numIndices) {
+std::unique_ptr<uint8_t[]> Mesh::CompressVertices(const VertexBase* vertices, size_t numVertices, uint32_t& stride) {
 	// Create constants
 	auto& elements = vertices[0].GetElements();
 	std::vector<bool> elementMap(elements.size(), true);
-	uint32_t compressedStride = (uint32_t)VertexCompressor::Size(*vertices, elementMap);
+	stride = (uint32_t)VertexCompressor::Size(*vertices, elementMap);
 
 	// Create a view to iterate over vertices
-	ArrayView<const VertexBase> inputArrayView{vertices, numVertices, vertices->StructureSize() };
+	ArrayView<const VertexBase> inputArrayView{ vertices, numVertices, vertices->StructureSize() };
 
 	// Create buffer for compressed vertices of stream
-	std::unique_ptr<uint8_t[]> compressedData = std::make_unique<uint8_t[]>(compressedStride * numVertices);
+	std::unique_ptr<uint8_t[]> compressedData = std::make_unique<uint8_t[]>(stride * numVertices);
 
 	// Fill stream
-	ArrayView<VertexBase> outputArrayView{ reinterpret_cast<VertexBase*>(compressedData.get()), numVertices, compressedStride };
-	for (size_t i=0; i<numVertices; i++) {
+	ArrayView<VertexBase> outputArrayView{ reinterpret_cast<VertexBase*>(compressedData.get()), numVertices, stride };
+	for (size_t i = 0; i < numVertices; i++) {
 		VertexCompressor::Compress(inputArrayView[i], elementMap, &outputArrayView[i]);
 	}
+	return compressedData;
+}
+
+
+std::vector<mathfu::Vector<float, 3>> Mesh::GatherPositions(const VertexBase* vertexData, size_t numVertices) {
+	std::vector<mathfu::Vector<float, 3>> positions;
+	if (numVertices == 0) {
+		return positions;
+	}
+	ArrayView<const VertexBase> vertices{ vertexData, numVertices, vertexData->StructureSize() };
+
+	auto& elements = vertices[0].GetElements();
+	auto positionElement = std::find_if(elements.begin(), elements.end(), [](const VertexBase::Element& element) {
+		return element.semantic == eVertexElementSemantic::POSITION;
+	});
+	if (positionElement == elements.end()) {
+		return positions;
+	}
+
+	positions.reserve(numVertices);
+	for (size_t i = 0; i < numVertices; ++i) {
+		positions.push_back(dynamic_cast<const VertexPart<eVertexElementSemantic::POSITION>&>(vertices[i]).GetPosition(positionElement->index));
+	}
+	return positions;
+}
+
+
+void Mesh::SetBounds(const Aabb& boundingBox, const BoundingSphere& boundingSphere) {
+	m_boundingBox = boundingBox;
+	m_boundingSphere = boundingSphere;
+	++m_boundsVersion;
+}
+
+
+
+void Mesh::Set(const VertexBase* vertices, size_t numVertices, const unsigned* indices, size_t numIndices, bool buildMeshlets) {
+	uint32_t compressedStride;
+	std::unique_ptr<uint8_t[]> compressedData = CompressVertices(vertices, numVertices, compressedStride);
+
+	auto positions = GatherPositions(vertices, numVertices);
 
 	// Set data
 	VertexStream stream;
 	stream.stride = compressedStride;
 	stream.count = numVertices;
 	stream.data = compressedData.get();
-	MeshBuffer::Set(&stream, &stream + 1, indices, indices + numIndices);
+	if (buildMeshlets) {
+		if (positions.empty()) {
+			throw std::invalid_argument("Meshlets need vertex positions.");
+		}
+		Meshlets meshlets;
+		meshlets.Build(positions.data(), positions.size(), indices, numIndices);
+
+		// Lay the vertices out meshlet after meshlet
+		const std::vector<uint32_t>& order = meshlets.GetVertices();
+		std::unique_ptr<uint8_t[]> orderedData = std::make_unique<uint8_t[]>(compressedStride * order.size());
+		for (size_t i = 0; i < order.size(); ++i) {
+			std::memcpy(orderedData.get() + i * compressedStride, compressedData.get() + order[i] * compressedStride, compressedStride);
+		}
+		stream.count = order.size();
+		stream.data = orderedData.get();
+		const std::vector<uint16_t>& drawIndices = meshlets.GetDrawIndices();
+		MeshBuffer::Set(&stream, &stream + 1, drawIndices.data(), drawIndices.data() + drawIndices.size(), false);
+		m_meshlets = std::move(meshlets);
+	}
+	else {
+		MeshBuffer::Set(&stream, &stream + 1, indices, indices + numIndices);
+		m_meshlets.Clear();
+	}
 
 	// Set stream elements.
 	m_streamElements.clear();
 	m_streamElements.push_back(vertices->GetElements());
+
+	// Compute bounds for culling.
+	SetBounds(ComputeAabb(positions.data(), positions.size()), ComputeBoundingSphere(positions.data(), positions.size()));
 }
 
 
 void Mesh::Update(const VertexBase* vertices, size_t numVertices, size_t offsetInVertices) {
-	// Create constants
-	auto& elements = vertices[0].GetElements();
-	std::vector<bool> elementMap(elements.size(), true);
-	size_t compressedStride = VertexCompressor::Size(*vertices, elementMap);
-
-	// Create a view to iterate over vertices
-	ArrayView<const VertexBase> inputArrayView{ vertices, numVertices, vertices->StructureSize() };
-
-	// Create a stream
-	std::unique_ptr<uint8_t[]> compressedData = std::make_unique<uint8_t[]>(compressedStride * numVertices);
-
-	// Fill stream
-	ArrayView<VertexBase> outputArrayView{ reinterpret_cast<VertexBase*>(compressedData.get()), numVertices, compressedStride };
-	for (size_t i = 0; i<numVertices; i++) {
-		VertexCompressor::Compress(inputArrayView[i], elementMap, &outputArrayView[i]);
+	if (HasMeshlets()) {
+		throw std::logic_error("Vertices of meshes split into meshlets are reordered, they cannot be updated by their original place.");
 	}
 
+	uint32_t compressedStride;
+	std::unique_ptr<uint8_t[]> compressedData = CompressVertices(vertices, numVertices, compressedStride);
+
 	// Update data
 	MeshBuffer::Update(0, compressedData.get(), numVertices, offsetInVertices);
+
+	// Grow bounds to contain the new vertices. The old vertices are not known, so bounds never shrink here.
+	auto positions = GatherPositions(vertices, numVertices);
+	if (!positions.empty()) {
+		SetBounds(Merge(m_boundingBox, ComputeAabb(positions.data(), positions.size())),
+				  Merge(m_boundingSphere, ComputeBoundingSphere(positions.data(), positions.size())));
+	}
 }
 
 
 void Mesh::Clear() {
 	MeshBuffer::Clear();
 	m_streamElements.clear();
+	m_meshlets.Clear();
+	SetBounds(Aabb{}, BoundingSphere{});
+	m_occluderPositions.clear();
+	m_occluderIndices.clear();
+}
+
+
+void Mesh::SetOccluder(const mathfu::Vector<float, 3>* positions, size_t numPositions, const unsigned* indices, size_t numIndices) {
+	for (size_t i = 0; i < numIndices; ++i) {
+		if (indices[i] >= numPositions) {
+			throw std::out_of_range("Occluder index refers to a position that does not exist.");
+		}
+	}
+
+	m_occluderPositions.assign(positions, positions + numPositions);
+	m_occluderIndices.assign(indices, indices + numIndices - numIndices % 3);
 }
 
 
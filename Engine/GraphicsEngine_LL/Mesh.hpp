@@ -2,8 +2,11 @@
 
 #include "MeshBuffer.hpp"
 #include "Vertex.hpp"
+#include "BoundingVolume.hpp"
+#include "Meshlets.hpp"
 
 #include <type_traits>
+#include <memory>
 
 
 namespace inl {
@@ -14,8 +17,12 @@ public:
 
 public:
 	Mesh(MemoryManager* memoryManager) : MeshBuffer(memoryManager) {}
+	virtual ~Mesh() = default;
 
-	void Set(const VertexBase* vertices, size_t numVertices, const unsigned* indices, size_t numIndices);
+	/// <param name="buildMeshlets"> Splits the mesh into meshlets that draws can cull one by one.
+	///		Vertices are reordered and indices are 16-bit however large the mesh is, see Meshlets. </param>
+	void Set(const VertexBase* vertices, size_t numVertices, const unsigned* indices, size_t numIndices, bool buildMeshlets = false);
+	/// <exception cref="std::logic_error"> If the mesh has meshlets, its vertices are not in their original order. </exception>
 	void Update(const VertexBase* vertices, size_t numVertices, size_t offsetInVertices);
 	void Clear();
 
@@ -24,10 +31,46 @@ public:
 	using MeshBuffer::GetVertexBufferStride;
 	using MeshBuffer::GetIndexBuffer;
 	using MeshBuffer::GetIndexBuffer32Bit;
+	using MeshBuffer::GetBufferVersion;
 
 	const std::vector<VertexBase::Element>& GetVertexBufferElements(size_t streamIndex) const;
-private:
+
+	/// <summary> Bounding box of the vertex positions in the mesh's local space. </summary>
+	const Aabb& GetBoundingBox() const { return m_boundingBox; }
+	/// <summary> Bounding sphere of the vertex positions in the mesh's local space. </summary>
+	const BoundingSphere& GetBoundingSphere() const { return m_boundingSphere; }
+	/// <summary> Changes whenever the bounds change, so that the bounds of entities using the mesh can be updated. </summary>
+	uint64_t GetBoundsVersion() const { return m_boundsVersion; }
+
+	/// <summary> Whether the mesh was split into meshlets. Such meshes are drawn by the meshlets' draws. </summary>
+	bool HasMeshlets() const { return !m_meshlets.IsEmpty(); }
+	const Meshlets& GetMeshlets() const { return m_meshlets; }
+
+	/// <summary>
+	/// Sets a simplified shape of the mesh that hides other meshes during occlusion culling.
+	/// The shape should fit inside the mesh, otherwise it hides things the mesh does not.
+	/// </summary>
+	/// <param name="indices"> Triangle list of the positions. </param>
+	void SetOccluder(const mathfu::Vector<float, 3>* positions, size_t numPositions, const unsigned* indices, size_t numIndices);
+	/// <summary> Whether the mesh has an occluder shape set. </summary>
+	bool IsOccluder() const { return !m_occluderIndices.empty(); }
+	const std::vector<mathfu::Vector<float, 3>>& GetOccluderPositions() const { return m_occluderPositions; }
+	const std::vector<unsigned>& GetOccluderIndices() const { return m_occluderIndices; }
+protected:
+	/// <summary> Packs vertices into the layout of the vertex buffer. </summary>
+	static std::unique_ptr<uint8_t[]> CompressVertices(const VertexBase* vertices, size_t numVertices, uint32_t& stride);
+	/// <summary> The first position of each vertex, or nothing if vertices have no position. </summary>
+	static std::vector<mathfu::Vector<float, 3>> GatherPositions(const VertexBase* vertices, size_t numVertices);
+	void SetBounds(const Aabb& boundingBox, const BoundingSphere& boundingSphere);
+protected:
 	std::vector<std::vector<VertexBase::Element>> m_streamElements;
+	Aabb m_boundingBox;
+	BoundingSphere m_boundingSphere;
+	uint64_t m_boundsVersion = 0;
+private:
+	Meshlets m_meshlets;
+	std::vector<mathfu::Vector<float, 3>> m_occluderPositions;
+	std::vector<unsigned> m_occluderIndices;
 };
 
 
@@ -40,9 +40,20 @@ void MeshBuffer::Update(uint32_t streamIndex, const void* vertexData, size_t ver
 }
 
 
+void MeshBuffer::SetBuffers(std::vector<VertexBuffer> vertexBuffers, std::vector<size_t> vertexStrides, IndexBuffer indexBuffer, bool index32Bit) {
+	assert(vertexBuffers.size() == vertexStrides.size());
+	m_vertexBuffers = std::move(vertexBuffers);
+	m_vertexStrides = std::move(vertexStrides);
+	m_indexBuffer = std::move(indexBuffer);
+	m_isIndex32Bit = index32Bit;
+	++m_bufferVersion;
+}
+
+
 void MeshBuffer::Clear() {
 	m_vertexBuffers.clear();
 	m_indexBuffer = IndexBuffer();
+	++m_bufferVersion;
 }
 
 
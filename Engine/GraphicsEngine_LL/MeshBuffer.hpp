@@ -4,6 +4,8 @@
 #include <memory>
 #include <cstdint>
 #include <type_traits>
+#include <algorithm>
+#include <stdexcept>
 
 #include "MemoryObject.hpp"
 #include "MemoryManager.hpp"
@@ -34,8 +36,13 @@ class MeshBuffer {
 public:
 	MeshBuffer(MemoryManager* memoryManager);
 
+	/// <summary> Sets the mesh's data, indices are 32-bit if there are more vertices than 16-bit indices can address. </summary>
 	template <class StreamIt, class IndexIt>
 	void Set(StreamIt firstStream, StreamIt lastStream, IndexIt firstIndex, IndexIt lastIndex);
+	/// <summary> Sets the mesh's data with indices of the given size. </summary>
+	/// <remarks> 16-bit indices may be used for any number of vertices if the draws offset the indices. </remarks>
+	template <class StreamIt, class IndexIt>
+	void Set(StreamIt firstStream, StreamIt lastStream, IndexIt firstIndex, IndexIt lastIndex, bool index32Bit);
 
 	void Update(uint32_t streamIndex, const void* vertexData, size_t vertexCount, size_t offsetInVertex);
 	void Clear();
@@ -45,6 +52,11 @@ public:
 	size_t GetVertexBufferStride(size_t streamIndex) const;
 	const IndexBuffer& GetIndexBuffer() const;
 	bool GetIndexBuffer32Bit() const { return m_isIndex32Bit; }
+	/// <summary> Changes whenever the buffers are replaced, so that draws recorded with the old ones can be found out of date. </summary>
+	uint64_t GetBufferVersion() const { return m_bufferVersion; }
+protected:
+	/// <summary> Takes buffers that are already filled, nothing is uploaded. </summary>
+	void SetBuffers(std::vector<VertexBuffer> vertexBuffers, std::vector<size_t> vertexStrides, IndexBuffer indexBuffer, bool index32Bit);
 private:
 	template <class StreamIt, class IndexIt>
 	eValidationResult Validate(StreamIt firstStream, StreamIt lastStream, IndexIt firstIndex, IndexIt lastIndex);
@@ -53,6 +65,7 @@ private:
 	std::vector<size_t> m_vertexStrides;
 	IndexBuffer m_indexBuffer;
 	bool m_isIndex32Bit;
+	uint64_t m_bufferVersion = 0;
 	MemoryManager* m_memoryManager;
 };
 
@@ -60,6 +73,14 @@ private:
 
 template <class StreamIt, class IndexIt>
 void MeshBuffer::Set(StreamIt firstStream, StreamIt lastStream, IndexIt firstIndex, IndexIt lastIndex) {
+	// Not perfect, but hey, why'd you give more vertices if they are not indexed?
+	bool using32BitIndex = firstStream != lastStream && firstStream->count > 0xFFFFu;
+	Set(firstStream, lastStream, firstIndex, lastIndex, using32BitIndex);
+}
+
+
+template <class StreamIt, class IndexIt>
+void MeshBuffer::Set(StreamIt firstStream, StreamIt lastStream, IndexIt firstIndex, IndexIt lastIndex, bool using32BitIndex) {
 	static_assert(std::is_same<VertexStream, std::decay_t<decltype(*firstStream)>>::value, "Not a VertexStream iterator.");
 	static_assert(std::is_integral<std::decay_t<decltype(*firstIndex)>>::value, "Indices must be of integral type.");
 
@@ -79,6 +100,9 @@ void MeshBuffer::Set(StreamIt firstStream, StreamIt lastStream, IndexIt firstInd
 	case eValidationResult::OK:
 		break;
 	}
+	if (!using32BitIndex && std::any_of(firstIndex, lastIndex, [](auto index) { return index > 0xFFFFu; })) {
+		throw std::invalid_argument("Indices do not fit in 16 bits.");
+	}
 
 
 	// Create vertex buffers.
@@ -96,10 +120,7 @@ void MeshBuffer::Set(StreamIt firstStream, StreamIt lastStream, IndexIt firstInd
 
 
 	// Create index buffer.
-	size_t numVertices = firstStream->count; // all must have the same number of verts, see Validate
 	size_t numIndices = std::distance(firstIndex, lastIndex);
-	// Not perfect, but hey, why'd you give more vertices if they are not indexed?
-	bool using32BitIndex = numVertices > 0xFFFFu;
 	unsigned indexStride = using32BitIndex ? sizeof(uint32_t) : sizeof(uint16_t);
 	size_t indexTotalSize = numIndices * indexStride;
 	IndexBuffer newIndexBuffer = m_memoryManager->CreateIndexBuffer(eResourceHeapType::CRITICAL, indexTotalSize, numIndices);
@@ -113,6 +134,7 @@ void MeshBuffer::Set(StreamIt firstStream, StreamIt lastStream, IndexIt firstInd
 		m_vertexStrides.push_back(streamIt->stride);
 	}
 	m_isIndex32Bit = using32BitIndex;
+	++m_bufferVersion;
 
 
 	// Fill the vertex buffers.
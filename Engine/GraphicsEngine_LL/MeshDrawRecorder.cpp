@@ -0,0 +1,92 @@
+#include "MeshDrawRecorder.hpp"
+
+#include "Mesh.hpp"
+#include "GraphicsContext.hpp"
+#include "GraphicsCommandList.hpp"
+
+
+namespace inl {
+namespace gxeng {
+
+
+std::unique_ptr<gxapi::ICommandSignature> MeshDrawRecorder::CreateMeshletSignature(gxapi::IGraphicsApi* graphicsApi) {
+	return std::unique_ptr<gxapi::ICommandSignature>(graphicsApi->CreateCommandSignature(IndirectDrawList().GetSignatureDesc()));
+}
+
+
+MeshDrawRecorder::MeshDrawRecorder(GraphicsContext& context, VolatileViewHeap& viewHeap, GraphicsCommandList& commandList, gxapi::ICommandSignature* meshletSignature)
+	: m_context(context),
+	m_viewHeap(viewHeap),
+	m_commandList(commandList),
+	m_meshletSignature(meshletSignature)
+{}
+
+
+mathfu::VectorPacked<float, 4>* MeshDrawRecorder::AllocateInstanceData(size_t numRows) {
+	m_instanceData.resize(numRows);
+	return m_instanceData.data();
+}
+
+
+void MeshDrawRecorder::BindInstanceData(BindParameter parameter) {
+	size_t size = m_instanceData.size() * sizeof(m_instanceData[0]);
+	VolatileConstBuffer buffer = m_context.CreateVolatileConstBuffer(m_instanceData.data(), size);
+	ConstBufferView cbv = m_context.CreateCbv(buffer, 0, size, m_viewHeap);
+	m_commandList.BindGraphics(parameter, cbv);
+}
+
+
+void MeshDrawRecorder::Draw(Mesh* mesh,
+							uint32_t numInstances,
+							const mathfu::Matrix<float, 4, 4>& modelViewProjection,
+							const mathfu::Matrix<float, 4, 4>& world,
+							const mathfu::Vector<float, 3>* eye)
+{
+	BindMesh(mesh);
+
+	if (!mesh->HasMeshlets()) {
+		m_commandList.DrawIndexedInstanced((unsigned)mesh->GetIndexBuffer().GetIndexCount(), 0, 0, numInstances);
+		return;
+	}
+
+	const std::vector<MeshletDraw>* draws = &mesh->GetMeshlets().GetDraws();
+	if (numInstances == 1) {
+		mesh->GetMeshlets().Cull(modelViewProjection, world, eye, m_meshletDraws);
+		draws = &m_meshletDraws;
+	}
+	if (draws->size() == 1) {
+		m_commandList.DrawIndexedInstanced(draws->front().numIndices, draws->front().firstIndex, (int)draws->front().baseVertex, numInstances);
+	}
+	else if (!draws->empty()) {
+		// Draws of separate meshlet runs are submitted at once
+		m_meshletDrawList.Clear();
+		for (const MeshletDraw& draw : *draws) {
+			m_meshletDrawList.AddDraw({ draw.numIndices, numInstances, draw.firstIndex, (int32_t)draw.baseVertex, 0 });
+		}
+		VolatileConstBuffer arguments = m_context.CreateVolatileConstBuffer(m_meshletDrawList.GetData(), (uint32_t)m_meshletDrawList.GetSize());
+		m_commandList.ExecuteIndirect(m_meshletSignature, (unsigned)m_meshletDrawList.GetDrawCount(), arguments);
+	}
+}
+
+
+void MeshDrawRecorder::BindMesh(Mesh* mesh) {
+	if (mesh == m_boundMesh) {
+		return;
+	}
+
+	m_vertexBuffers.clear();
+	m_sizes.clear();
+	m_strides.clear();
+	for (size_t streamID = 0; streamID < mesh->GetNumStreams(); streamID++) {
+		m_vertexBuffers.push_back(&mesh->GetVertexBuffer(streamID));
+		m_sizes.push_back((unsigned)m_vertexBuffers.back()->GetSize());
+		m_strides.push_back((unsigned)mesh->GetVertexBufferStride(streamID));
+	}
+	m_commandList.SetVertexBuffers(0, (unsigned)m_vertexBuffers.size(), m_vertexBuffers.data(), m_sizes.data(), m_strides.data());
+	m_commandList.SetIndexBuffer(&mesh->GetIndexBuffer(), mesh->GetIndexBuffer32Bit());
+	m_boundMesh = mesh;
+}
+
+
+} // namespace gxeng
+} // namespace inl
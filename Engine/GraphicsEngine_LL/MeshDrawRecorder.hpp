@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Binder.hpp"
+#include "Meshlets.hpp"
+#include "IndirectDrawList.hpp"
+
+#include "../GraphicsApi_LL/ICommandSignature.hpp"
+#include "../GraphicsApi_LL/IGraphicsApi.hpp"
+
+#include <mathfu/vector_3.h>
+#include <mathfu/vector_4.h>
+#include <mathfu/matrix_4x4.h>
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+
+namespace inl {
+namespace gxeng {
+
+
+class Mesh;
+class VertexBuffer;
+class GraphicsContext;
+class GraphicsCommandList;
+class VolatileViewHeap;
+
+
+/// <summary>
+/// Records the instanced draws of meshes, as batched by DrawPacketBuilder, into a command list:
+/// uploads the instances' data, binds the mesh's buffers and draws the meshlets that may show.
+/// </summary>
+/// <remarks>
+/// Keeps the state of one command list, parallel recording uses a recorder per list.
+/// The meshlet command signature is created once with CreateMeshletSignature and shared by all of them.
+/// </remarks>
+class MeshDrawRecorder {
+public:
+	/// <summary> Signature of the indirect draws of meshlet runs, they only set draw arguments. </summary>
+	static std::unique_ptr<gxapi::ICommandSignature> CreateMeshletSignature(gxapi::IGraphicsApi* graphicsApi);
+
+	/// <param name="meshletSignature"> Signature of the indirect draws of meshlet runs, see CreateMeshletSignature. </param>
+	MeshDrawRecorder(GraphicsContext& context, VolatileViewHeap& viewHeap, GraphicsCommandList& commandList, gxapi::ICommandSignature* meshletSignature);
+
+	/// <summary> Space for the data of the next draw's instances, valid until BindInstanceData. </summary>
+	/// <param name="numRows"> Number of float4 rows of all instances together. </param>
+	mathfu::VectorPacked<float, 4>* AllocateInstanceData(size_t numRows);
+	/// <summary> Uploads the instance data to a volatile constant buffer and binds it to the parameter. </summary>
+	void BindInstanceData(BindParameter parameter);
+
+	/// <summary> Draws instances of the mesh, binding its buffers unless the previous draw used the same mesh. </summary>
+	/// <remarks> A single instance draws only the meshlets it may show, see Meshlets::Cull. Instanced draws draw all of them. </remarks>
+	/// <param name="modelViewProjection"> Transform of the first instance to clip space. </param>
+	/// <param name="world"> Transform of the first instance to world space. </param>
+	/// <param name="eye"> The camera's position in world space, or null to keep meshlets that face away. </param>
+	void Draw(Mesh* mesh,
+			  uint32_t numInstances,
+			  const mathfu::Matrix<float, 4, 4>& modelViewProjection,
+			  const mathfu::Matrix<float, 4, 4>& world,
+			  const mathfu::Vector<float, 3>* eye);
+private:
+	void BindMesh(Mesh* mesh);
+private:
+	GraphicsContext& m_context;
+	VolatileViewHeap& m_viewHeap;
+	GraphicsCommandList& m_commandList;
+	gxapi::ICommandSignature* m_meshletSignature;
+
+	const Mesh* m_boundMesh = nullptr;
+	std::vector<mathfu::VectorPacked<float, 4>> m_instanceData;
+	std::vector<MeshletDraw> m_meshletDraws;
+	IndirectDrawList m_meshletDrawList;
+	std::vector<const VertexBuffer*> m_vertexBuffers;
+	std::vector<unsigned> m_sizes;
+	std::vector<unsigned> m_strides;
+};
+
+
+} // namespace gxeng
+} // namespace inl
@@ -1,68 +1,97 @@
 #include "MeshEntity.hpp"
 
+#include <stdexcept>
+
 namespace inl {
 namespace gxeng {
 
 
-MeshEntity::MeshEntity() :
-	m_mesh(nullptr),
-	m_texture(nullptr),
-	m_position(0, 0, 0),
-	m_rotation(0, mathfu::Vector<float, 3>(1, 0, 0)),
-	m_scale(1, 1, 1)
+MeshEntity::MeshEntity(std::shared_ptr<MeshEntityStore> store) :
+	m_store(std::move(store)),
+	m_handle(m_store->Create())
 {}
 
 
+MeshEntity::~MeshEntity() {
+	m_store->Destroy(m_handle);
+}
+
+
 
 void MeshEntity::SetMesh(Mesh* mesh) {
-	m_mesh = mesh;
+	m_store->SetMesh(GetStoreIndex(), mesh);
 }
 Mesh* MeshEntity::GetMesh() const {
-	return m_mesh;
+	return m_store->MeshAt(GetStoreIndex());
 }
 
 void MeshEntity::SetTexture(Image* texture) {
-	m_texture = texture;
+	m_store->TextureAt(GetStoreIndex()) = texture;
 }
 Image* MeshEntity::GetTexture() const {
-	return m_texture;
+	return m_store->TextureAt(GetStoreIndex());
+}
+
+
+void MeshEntity::SetParent(const MeshEntity* parent) {
+	if (parent == nullptr) {
+		m_store->SetParent(GetStoreIndex(), {});
+		return;
+	}
+	if (parent->m_store != m_store) {
+		throw std::invalid_argument("Parent entity must be in the same store.");
+	}
+	m_store->SetParent(GetStoreIndex(), parent->m_handle);
 }
 
 
 void MeshEntity::SetPosition(mathfu::Vector<float, 3> pos) {
-	m_position = pos;
+	m_store->SetPosition(GetStoreIndex(), pos);
 }
 
 
 void MeshEntity::SetRotation(mathfu::Quaternion<float> rotation) {
-	m_rotation = rotation;
+	m_store->SetRotation(GetStoreIndex(), rotation);
 }
 
 
 void MeshEntity::SetScale(mathfu::Vector<float, 3> scale) {
-	m_scale = scale;
+	m_store->SetScale(GetStoreIndex(), scale);
 }
 
 
 mathfu::Vector<float, 3> MeshEntity::GetPosition() const {
-	return m_position;
+	return m_store->Position(GetStoreIndex());
 }
 
 
 mathfu::Quaternion<float> MeshEntity::GetRotation() const {
-	return m_rotation;
+	return m_store->Rotation(GetStoreIndex());
 }
 
 
 mathfu::Vector<float, 3> MeshEntity::GetScale() const {
-	return m_scale;
+	return m_store->Scale(GetStoreIndex());
 }
 
 
 mathfu::Matrix<float, 4, 4> MeshEntity::GetTransform() const {
-	using Mat4 = mathfu::Matrix<float, 4, 4>;
+	return m_store->ComputeWorldMatrix(GetStoreIndex());
+}
+
+
+const MeshEntityStore& MeshEntity::GetStore() const {
+	return *m_store;
+}
+
+
+size_t MeshEntity::GetStoreIndex() const {
+	return m_store->IndexOf(m_handle);
+}
+
 
-	return Mat4::FromTranslationVector(m_position) * m_rotation.ToMatrix4() * Mat4::FromScaleVector(m_scale);
+MeshEntityHandle MeshEntity::GetStoreHandle() const {
+	return m_handle;
 }
 
 
@@ -6,6 +6,10 @@
 #include <mathfu/quaternion.h>
 #include <mathfu/matrix_4x4.h>
 
+#include "MeshEntityStore.hpp"
+
+#include <memory>
+
 namespace inl {
 namespace gxeng {
 
@@ -14,15 +18,27 @@ class Mesh;
 class Image;
 
 
+/// <summary>
+/// A mesh placed in the world. The entity's data lives in a MeshEntityStore,
+/// this object only holds its handle and frees the data when destroyed.
+/// </summary>
 class MeshEntity {
 public:
-	MeshEntity();
+	MeshEntity(std::shared_ptr<MeshEntityStore> store);
+	MeshEntity(const MeshEntity&) = delete;
+	MeshEntity& operator=(const MeshEntity&) = delete;
+	~MeshEntity();
 
 	void SetMesh(Mesh* mesh);
 	Mesh* GetMesh() const;
 	void SetTexture(Image* texture);
 	Image* GetTexture() const;
 
+	/// <summary> Attaches the entity to a parent entity, or detaches it if parent is null.
+	///		The position, rotation and scale are then relative to the parent. </summary>
+	/// <exception cref="std::invalid_argument"> If the parent is in another store, or is the entity itself or one of its descendants. </exception>
+	void SetParent(const MeshEntity* parent);
+
 	void SetPosition(mathfu::Vector<float, 3> pos);
 	void SetRotation(mathfu::Quaternion<float> rotation);
 	void SetScale(mathfu::Vector<float, 3> scale);
@@ -31,14 +47,19 @@ public:
 	mathfu::Quaternion<float> GetRotation() const;
 	mathfu::Vector<float, 3> GetScale() const;
 
+	/// <summary> Transform from the entity's space to world space, including the parents' transforms. </summary>
 	mathfu::Matrix<float, 4, 4> GetTransform() const;
 
+	/// <summary> The store holding the entity's data. </summary>
+	const MeshEntityStore& GetStore() const;
+	/// <summary> The entity's current index in the store's arrays. Changes when other entities are destroyed. </summary>
+	size_t GetStoreIndex() const;
+	/// <summary> The entity's handle in the store, which stays the same while the entity lives. </summary>
+	MeshEntityHandle GetStoreHandle() const;
+
 private:
-	Mesh* m_mesh;
-	Image* m_texture;
-	mathfu::Vector<float, 3> m_position;
-	mathfu::Quaternion<float> m_rotation;
-	mathfu::Vector<float, 3> m_scale;
+	std::shared_ptr<MeshEntityStore> m_store;
+	MeshEntityHandle m_handle;
 };
 
 
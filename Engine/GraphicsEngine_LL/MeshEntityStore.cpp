@@ -0,0 +1,362 @@
+#include "MeshEntityStore.hpp"
+#include "TransformBatch.hpp"
+
+#include <stdexcept>
+#include <future>
+#include <thread>
+#include <algorithm>
+
+
+namespace inl {
+namespace gxeng {
+
+
+// Levels are only split across threads if each thread gets at least this many entities.
+static constexpr size_t MinEntitiesPerThread = 4096;
+
+
+// Reorders values so that values[i] becomes the old values[order[i]].
+template <class T>
+static void Permute(std::vector<T>& values, const std::vector<uint32_t>& order) {
+	std::vector<T> permuted;
+	permuted.reserve(values.size());
+	for (uint32_t oldIndex : order) {
+		permuted.push_back(std::move(values[oldIndex]));
+	}
+	values = std::move(permuted);
+}
+
+
+
+MeshEntityHandle MeshEntityStore::Create() {
+	uint32_t index = (uint32_t)m_positions.size();
+
+	// reuse a free slot, or make a new one
+	uint32_t slot;
+	if (m_firstFreeSlot != MeshEntityHandle::InvalidIndex) {
+		slot = m_firstFreeSlot;
+		m_firstFreeSlot = m_slots[slot].index;
+		m_slots[slot].index = index;
+	}
+	else {
+		slot = (uint32_t)m_slots.size();
+		m_slots.push_back({ index, 0 });
+	}
+
+	m_slotOfIndex.push_back(slot);
+	m_positions.push_back({ 0, 0, 0 });
+	m_rotations.push_back(mathfu::Quaternion<float>(0, mathfu::Vector<float, 3>(1, 0, 0)));
+	m_scales.push_back({ 1, 1, 1 });
+	m_meshes.push_back(nullptr);
+	m_textures.push_back(nullptr);
+	m_worldMatrices.push_back(mathfu::Matrix<float, 4, 4>::Identity());
+	m_normalMatrices.push_back(mathfu::Matrix<float, 4, 4>::Identity());
+	m_dirty.push_back(0);
+	m_parentHandles.push_back({});
+	m_parentIndices.push_back(MeshEntityHandle::InvalidIndex);
+
+	// a root after the deeper levels breaks the order
+	m_hierarchyChanged |= m_levelEnds.size() > 1;
+
+	return { slot, m_slots[slot].generation };
+}
+
+
+void MeshEntityStore::Destroy(MeshEntityHandle handle) {
+	size_t index = IndexOf(handle);
+	size_t last = m_positions.size() - 1;
+
+	m_numDirty -= m_dirty[index];
+
+	// move the last entity into the hole
+	if (index != last) {
+		m_slotOfIndex[index] = m_slotOfIndex[last];
+		m_positions[index] = m_positions[last];
+		m_rotations[index] = m_rotations[last];
+		m_scales[index] = m_scales[last];
+		m_meshes[index] = m_meshes[last];
+		m_textures[index] = m_textures[last];
+		m_worldMatrices[index] = m_worldMatrices[last];
+		m_normalMatrices[index] = m_normalMatrices[last];
+		m_dirty[index] = m_dirty[last];
+		m_parentHandles[index] = m_parentHandles[last];
+		m_parentIndices[index] = m_parentIndices[last];
+		m_slots[m_slotOfIndex[index]].index = (uint32_t)index;
+	}
+	m_slotOfIndex.pop_back();
+	m_positions.pop_back();
+	m_rotations.pop_back();
+	m_scales.pop_back();
+	m_meshes.pop_back();
+	m_textures.pop_back();
+	m_worldMatrices.pop_back();
+	m_normalMatrices.pop_back();
+	m_dirty.pop_back();
+	m_parentHandles.pop_back();
+	m_parentIndices.pop_back();
+
+	// children are detached and the moved entity may be out of order, see UpdateHierarchy
+	m_hierarchyChanged |= m_levelEnds.size() > 1;
+
+	// invalidate outstanding handles and free the slot
+	Slot& slot = m_slots[handle.slot];
+	++slot.generation;
+	slot.index = m_firstFreeSlot;
+	m_firstFreeSlot = handle.slot;
+}
+
+
+bool MeshEntityStore::IsValid(MeshEntityHandle handle) const {
+	return handle.slot < m_slots.size()
+		&& m_slots[handle.slot].generation == handle.generation
+		&& m_slots[handle.slot].index < m_slotOfIndex.size()
+		&& m_slotOfIndex[m_slots[handle.slot].index] == handle.slot;
+}
+
+
+size_t MeshEntityStore::IndexOf(MeshEntityHandle handle) const {
+	if (!IsValid(handle)) {
+		throw std::out_of_range("Handle does not refer to a live mesh entity.");
+	}
+	return m_slots[handle.slot].index;
+}
+
+
+MeshEntityHandle MeshEntityStore::HandleAt(size_t index) const {
+	uint32_t slot = m_slotOfIndex[index];
+	return { slot, m_slots[slot].generation };
+}
+
+
+size_t MeshEntityStore::Size() const {
+	return m_positions.size();
+}
+
+
+void MeshEntityStore::SetParent(size_t index, MeshEntityHandle parent) {
+	if (IsValid(parent)) {
+		for (uint32_t ancestor = (uint32_t)IndexOf(parent); ancestor != MeshEntityHandle::InvalidIndex; ancestor = ParentIndex(ancestor)) {
+			if (ancestor == index) {
+				throw std::invalid_argument("An entity cannot be attached to itself or its descendants.");
+			}
+		}
+		m_parentHandles[index] = parent;
+	}
+	else {
+		m_parentHandles[index] = {};
+	}
+
+	m_hierarchyChanged = true;
+	MarkDirty(index);
+}
+
+
+MeshEntityHandle MeshEntityStore::Parent(size_t index) const {
+	return IsValid(m_parentHandles[index]) ? m_parentHandles[index] : MeshEntityHandle{};
+}
+
+
+size_t MeshEntityStore::UpdateWorldMatrices() {
+	m_movedEntities.clear();
+	if (m_hierarchyChanged) {
+		UpdateHierarchy();
+	}
+	if (m_levelEnds.size() <= 1) {
+		m_levelEnds.assign(1, m_positions.size()); // flat, entities may have been added or removed
+	}
+	if (m_numDirty == 0) {
+		return 0;
+	}
+
+	// Levels one after the other, so that parents are done before their children.
+	size_t updated = 0;
+	size_t first = 0;
+	for (size_t end : m_levelEnds) {
+		size_t count = end - first;
+		size_t numThreads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), count / MinEntitiesPerThread);
+		if (numThreads <= 1) {
+			updated += UpdateLevel(first, end);
+		}
+		else {
+			std::vector<std::future<size_t>> workers;
+			for (size_t i = 1; i < numThreads; ++i) {
+				workers.push_back(std::async(std::launch::async, &MeshEntityStore::UpdateLevel, this, first + count * i / numThreads, first + count * (i + 1) / numThreads));
+			}
+			updated += UpdateLevel(first, first + count / numThreads);
+			for (auto& worker : workers) {
+				updated += worker.get();
+			}
+		}
+		first = end;
+	}
+
+	// Dirty flags now include the entities moved by their parents
+	for (size_t i = 0; i < m_dirty.size(); ++i) {
+		if (m_dirty[i]) {
+			m_movedEntities.push_back(HandleAt(i));
+			m_dirty[i] = 0;
+		}
+	}
+	m_numDirty = 0;
+	return updated;
+}
+
+
+mathfu::Matrix<float, 4, 4> MeshEntityStore::ComputeWorldMatrix(size_t index) const {
+	bool moved = m_hierarchyChanged;
+	for (uint32_t current = (uint32_t)index; current != MeshEntityHandle::InvalidIndex && !moved; current = ParentIndex(current)) {
+		moved = IsDirty(current);
+	}
+	if (!moved) {
+		return m_worldMatrices[index];
+	}
+
+	mathfu::Matrix<float, 4, 4> world = LocalMatrix(index);
+	for (uint32_t parent = ParentIndex(index); parent != MeshEntityHandle::InvalidIndex; parent = ParentIndex(parent)) {
+		world = LocalMatrix(parent) * world;
+	}
+	return world;
+}
+
+
+void MeshEntityStore::ComputeMvps(const mathfu::Matrix<float, 4, 4>& viewProjection, std::vector<mathfu::Matrix<float, 4, 4>>& mvps) const {
+	mvps.resize(m_worldMatrices.size());
+	MultiplyTransforms(viewProjection, m_worldMatrices.data(), mvps.data(), m_worldMatrices.size());
+}
+
+
+void MeshEntityStore::MarkDirty(size_t index) {
+	m_numDirty += !m_dirty[index];
+	m_dirty[index] = 1;
+}
+
+
+mathfu::Matrix<float, 4, 4> MeshEntityStore::LocalMatrix(size_t index) const {
+	using Mat4 = mathfu::Matrix<float, 4, 4>;
+	return Mat4::FromTranslationVector(m_positions[index]) * m_rotations[index].ToMatrix4() * Mat4::FromScaleVector(m_scales[index]);
+}
+
+
+uint32_t MeshEntityStore::ParentIndex(size_t index) const {
+	const MeshEntityHandle& parent = m_parentHandles[index];
+	return IsValid(parent) ? m_slots[parent.slot].index : MeshEntityHandle::InvalidIndex;
+}
+
+
+void MeshEntityStore::UpdateHierarchy() {
+	size_t size = m_positions.size();
+
+	// Children of destroyed entities become roots
+	for (size_t i = 0; i < size; ++i) {
+		if (m_parentHandles[i].slot != MeshEntityHandle::InvalidIndex && !IsValid(m_parentHandles[i])) {
+			m_parentHandles[i] = {};
+			MarkDirty(i);
+		}
+	}
+
+	// Depth of each entity, walking up until an entity of known depth.
+	// Children may precede their parents until sorted.
+	std::vector<uint32_t> depths(size, MeshEntityHandle::InvalidIndex);
+	std::vector<uint32_t> path;
+	for (size_t i = 0; i < size; ++i) {
+		uint32_t depth = 0;
+		for (uint32_t current = (uint32_t)i; current != MeshEntityHandle::InvalidIndex; current = ParentIndex(current)) {
+			if (depths[current] != MeshEntityHandle::InvalidIndex) {
+				depth = depths[current] + 1;
+				break;
+			}
+			path.push_back(current);
+		}
+		for (auto it = path.rbegin(); it != path.rend(); ++it) {
+			depths[*it] = depth++;
+		}
+		path.clear();
+	}
+
+	if (!std::is_sorted(depths.begin(), depths.end())) {
+		SortByDepth(depths);
+	}
+
+	m_levelEnds.clear();
+	for (size_t i = 0; i < size; ++i) {
+		m_parentIndices[i] = ParentIndex(i);
+		if (i + 1 == size || depths[i + 1] != depths[i]) {
+			m_levelEnds.push_back(i + 1);
+		}
+	}
+
+	m_hierarchyChanged = false;
+}
+
+
+void MeshEntityStore::SortByDepth(std::vector<uint32_t>& depths) {
+	// Counting sort, stable so that the order within levels is kept
+	uint32_t maxDepth = *std::max_element(depths.begin(), depths.end());
+	std::vector<size_t> levelFirsts(maxDepth + 2, 0);
+	for (uint32_t depth : depths) {
+		++levelFirsts[depth + 1];
+	}
+	for (size_t level = 1; level < levelFirsts.size(); ++level) {
+		levelFirsts[level] += levelFirsts[level - 1];
+	}
+	std::vector<uint32_t> order(depths.size());
+	for (size_t i = 0; i < depths.size(); ++i) {
+		order[levelFirsts[depths[i]]++] = (uint32_t)i;
+	}
+
+	Permute(m_slotOfIndex, order);
+	Permute(m_positions, order);
+	Permute(m_rotations, order);
+	Permute(m_scales, order);
+	Permute(m_meshes, order);
+	Permute(m_textures, order);
+	Permute(m_worldMatrices, order);
+	Permute(m_normalMatrices, order);
+	Permute(m_dirty, order);
+	Permute(m_parentHandles, order);
+	Permute(depths, order);
+
+	for (size_t i = 0; i < m_slotOfIndex.size(); ++i) {
+		m_slots[m_slotOfIndex[i]].index = (uint32_t)i;
+	}
+}
+
+
+size_t MeshEntityStore::UpdateLevel(size_t first, size_t end) {
+	// Entities move with their parents, parents are on the previous level and are already done
+	for (size_t i = first; i < end; ++i) {
+		uint32_t parent = m_parentIndices[i];
+		if (parent != MeshEntityHandle::InvalidIndex && m_dirty[parent]) {
+			m_dirty[i] = 1;
+		}
+	}
+
+	// Compose runs of consecutive dirty entities together.
+	size_t updated = 0;
+	for (size_t runFirst = first; runFirst < end; ) {
+		if (!m_dirty[runFirst]) {
+			++runFirst;
+			continue;
+		}
+		size_t runEnd = runFirst;
+		while (runEnd < end && m_dirty[runEnd]) {
+			++runEnd;
+		}
+		ComposeTransforms(&m_positions[runFirst], &m_rotations[runFirst], &m_scales[runFirst], &m_worldMatrices[runFirst], runEnd - runFirst);
+		for (size_t i = runFirst; i < runEnd; ++i) {
+			uint32_t parent = m_parentIndices[i];
+			if (parent != MeshEntityHandle::InvalidIndex) {
+				m_worldMatrices[i] = m_worldMatrices[parent] * m_worldMatrices[i];
+			}
+			m_normalMatrices[i] = m_worldMatrices[i].Inverse().Transpose();
+		}
+		updated += runEnd - runFirst;
+		runFirst = runEnd;
+	}
+
+	return updated;
+}
+
+
+} // namespace gxeng
+} // namespace inl
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <mathfu/vector.h>
+#include <mathfu/vector_3.h>
+#include <mathfu/quaternion.h>
+#include <mathfu/matrix_4x4.h>
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+
+namespace inl {
+namespace gxeng {
+
+
+class Mesh;
+class Image;
+
+
+/// <summary> Identifies an entity in a MeshEntityStore. Stays the same while the entity lives. </summary>
+struct MeshEntityHandle {
+	static constexpr uint32_t InvalidIndex = ~uint32_t(0);
+
+	uint32_t slot = InvalidIndex;
+	uint32_t generation = 0;
+
+	bool operator==(const MeshEntityHandle& rhs) const { return slot == rhs.slot && generation == rhs.generation; }
+	bool operator!=(const MeshEntityHandle& rhs) const { return !(*this == rhs); }
+};
+
+
+/// <summary>
+/// Dense storage for the data of mesh entities.
+/// <para />
+/// Each property lives in its own contiguous array (structure of arrays), and live entities
+/// always occupy indices [0, Size()), so passes over all entities are linear in memory.
+/// Entities are referred to by generational handles. A handle's slot maps to the entity's
+/// current index, and destroying an entity moves the last one into its place, so indices
+/// change but handles don't. Handles of destroyed entities are detected by their generation.
+/// <para />
+/// World matrices are cached per entity. Changing the position, rotation or scale marks the
+/// entity dirty, and UpdateWorldMatrices recomputes the dirty ones in a single batch,
+/// so entities that don't move cost no matrix math.
+/// <para />
+/// Entities may have a parent, their position, rotation and scale are then relative to the parent.
+/// The arrays are kept sorted by depth in the hierarchy, roots first, so parents always precede
+/// their children and world matrices are propagated in a single sweep, one depth level after
+/// the other. Entities of the same level are independent, large levels are split across threads.
+/// A moved entity's whole subtree is recomputed, the rest of the hierarchy is not.
+/// </summary>
+/// <remarks> This class is not thread-safe. </remarks>
+class MeshEntityStore {
+public:
+	/// <summary> Number of entities visited together by ForEachChunk. </summary>
+	static constexpr size_t ChunkSize = 256;
+
+	/// <summary> A contiguous range of entities, pointers point to the first entity of the range. </summary>
+	struct Chunk {
+		size_t first;
+		size_t count;
+		const mathfu::Vector<float, 3>* positions;
+		const mathfu::Quaternion<float>* rotations;
+		const mathfu::Vector<float, 3>* scales;
+		Mesh* const* meshes;
+		Image* const* textures;
+		const mathfu::Matrix<float, 4, 4>* worldMatrices;
+	};
+public:
+	/// <summary> Adds an entity at the origin, with identity rotation and unit scale. </summary>
+	MeshEntityHandle Create();
+
+	/// <summary> Removes the entity. The entity that was last takes its index.
+	///		The entity's children become roots, keeping their position, rotation and scale. </summary>
+	/// <exception cref="std::out_of_range"> If the handle does not refer to a live entity. </exception>
+	void Destroy(MeshEntityHandle handle);
+
+	/// <summary> Whether the handle refers to a live entity. </summary>
+	bool IsValid(MeshEntityHandle handle) const;
+
+	/// <summary> Current index of the entity in the arrays. </summary>
+	/// <exception cref="std::out_of_range"> If the handle does not refer to a live entity. </exception>
+	size_t IndexOf(MeshEntityHandle handle) const;
+
+	/// <summary> Handle of the entity at the index. </summary>
+	MeshEntityHandle HandleAt(size_t index) const;
+
+	/// <summary> Number of live entities. </summary>
+	size_t Size() const;
+
+	void SetPosition(size_t index, const mathfu::Vector<float, 3>& position) { m_positions[index] = position; MarkDirty(index); }
+	void SetRotation(size_t index, const mathfu::Quaternion<float>& rotation) { m_rotations[index] = rotation; MarkDirty(index); }
+	void SetScale(size_t index, const mathfu::Vector<float, 3>& scale) { m_scales[index] = scale; MarkDirty(index); }
+	/// <summary> Changes the entity's bounds as well, so it is reported as moved, see GetMovedEntities. </summary>
+	void SetMesh(size_t index, Mesh* mesh) { m_meshes[index] = mesh; MarkDirty(index); }
+	Mesh*& MeshAt(size_t index) { return m_meshes[index]; }
+	Image*& TextureAt(size_t index) { return m_textures[index]; }
+
+	const mathfu::Vector<float, 3>& Position(size_t index) const { return m_positions[index]; }
+	const mathfu::Quaternion<float>& Rotation(size_t index) const { return m_rotations[index]; }
+	const mathfu::Vector<float, 3>& Scale(size_t index) const { return m_scales[index]; }
+	Mesh* MeshAt(size_t index) const { return m_meshes[index]; }
+	Image* TextureAt(size_t index) const { return m_textures[index]; }
+
+	/// <summary> Attaches the entity to a parent, or makes it a root if the parent handle is invalid.
+	///		Indices of entities may change at the next UpdateWorldMatrices. </summary>
+	/// <exception cref="std::invalid_argument"> If the parent is the entity itself or one of its descendants. </exception>
+	void SetParent(size_t index, MeshEntityHandle parent);
+
+	/// <summary> The entity's parent, an invalid handle for roots. </summary>
+	MeshEntityHandle Parent(size_t index) const;
+
+	/// <summary> Recomputes the world matrices of entities moved since the last call, and of their descendants.
+	///		Reorders the entities if the hierarchy has changed. </summary>
+	/// <returns> The number of matrices recomputed. </returns>
+	size_t UpdateWorldMatrices();
+
+	/// <summary> Entities whose world matrix the last UpdateWorldMatrices recomputed, including the ones moved by their parents. </summary>
+	/// <remarks> Lets spatial indices update only the entities that moved, see Scene::UpdateSpatialIndex. </remarks>
+	const std::vector<MeshEntityHandle>& GetMovedEntities() const { return m_movedEntities; }
+
+	/// <summary> Whether the entity has moved since the last UpdateWorldMatrices. Does not consider the parents. </summary>
+	bool IsDirty(size_t index) const { return m_dirty[index] != 0; }
+
+	/// <summary> World matrix of the entity, computed through the hierarchy if it or an ancestor has moved. </summary>
+	mathfu::Matrix<float, 4, 4> ComputeWorldMatrix(size_t index) const;
+
+	/// <summary> Cached world matrix of the entity, out of date if the entity is dirty. </summary>
+	const mathfu::Matrix<float, 4, 4>& WorldMatrix(size_t index) const { return m_worldMatrices[index]; }
+
+	/// <summary> Cached inverse transpose of the world matrix for transforming normals, out of date if the entity is dirty. </summary>
+	const mathfu::Matrix<float, 4, 4>& NormalMatrix(size_t index) const { return m_normalMatrices[index]; }
+
+	/// <summary> Computes viewProjection * world for every entity, mvps[i] belongs to the entity at index i. </summary>
+	/// <remarks> Call UpdateWorldMatrices first. </remarks>
+	void ComputeMvps(const mathfu::Matrix<float, 4, 4>& viewProjection, std::vector<mathfu::Matrix<float, 4, 4>>& mvps) const;
+
+	/// <summary> Calls func(const Chunk&) for consecutive ranges of at most ChunkSize entities, covering all of them. </summary>
+	template <class Func>
+	void ForEachChunk(Func&& func) const;
+private:
+	struct Slot {
+		uint32_t index; // index in the arrays while alive, next free slot otherwise
+		uint32_t generation;
+	};
+
+	void MarkDirty(size_t index);
+	mathfu::Matrix<float, 4, 4> LocalMatrix(size_t index) const;
+	uint32_t ParentIndex(size_t index) const; // InvalidIndex for roots and orphans
+
+	// Detaches orphans, sorts by depth, and finds the levels.
+	void UpdateHierarchy();
+	void SortByDepth(std::vector<uint32_t>& depths);
+	size_t UpdateLevel(size_t first, size_t end);
+private:
+	std::vector<Slot> m_slots;
+	uint32_t m_firstFreeSlot = MeshEntityHandle::InvalidIndex;
+
+	// per entity, indexed by the entity's current index
+	std::vector<uint32_t> m_slotOfIndex;
+	std::vector<mathfu::Vector<float, 3>> m_positions;
+	std::vector<mathfu::Quaternion<float>> m_rotations;
+	std::vector<mathfu::Vector<float, 3>> m_scales;
+	std::vector<Mesh*> m_meshes;
+	std::vector<Image*> m_textures;
+	std::vector<mathfu::Matrix<float, 4, 4>> m_worldMatrices;
+	std::vector<mathfu::Matrix<float, 4, 4>> m_normalMatrices;
+	std::vector<uint8_t> m_dirty;
+	std::vector<MeshEntityHandle> m_parentHandles;
+	std::vector<uint32_t> m_parentIndices; // rebuilt by UpdateHierarchy
+	size_t m_numDirty = 0;
+	std::vector<MeshEntityHandle> m_movedEntities; // filled by UpdateWorldMatrices
+
+	std::vector<size_t> m_levelEnds; // end index of each depth level
+	bool m_hierarchyChanged = false;
+};
+
+
+template <class Func>
+void MeshEntityStore::ForEachChunk(Func&& func) const {
+	for (size_t first = 0; first < m_positions.size(); first += ChunkSize) {
+		Chunk chunk;
+		chunk.first = first;
+		chunk.count = std::min(ChunkSize, m_positions.size() - first);
+		chunk.positions = m_positions.data() + first;
+		chunk.rotations = m_rotations.data() + first;
+		chunk.scales = m_scales.data() + first;
+		chunk.meshes = m_meshes.data() + first;
+		chunk.textures = m_textures.data() + first;
+		chunk.worldMatrices = m_worldMatrices.data() + first;
+		func(chunk);
+	}
+}
+
+
+} // namespace gxeng
+} // namespace inl
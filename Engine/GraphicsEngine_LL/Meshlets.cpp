@@ -0,0 +1,251 @@
+#include "Meshlets.hpp"
+
+#include <mathfu/vector_4.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+
+namespace inl {
+namespace gxeng {
+
+
+void Meshlets::Build(const mathfu::Vector<float, 3>* positions,
+					 size_t numPositions,
+					 const unsigned* indices,
+					 size_t numIndices,
+					 unsigned maxVertices,
+					 unsigned maxTriangles)
+{
+	if (maxVertices < 3 || maxVertices > MaxVerticesPerMeshlet || maxTriangles == 0) {
+		throw std::invalid_argument("Meshlets must have room for a triangle, and at most 256 vertices.");
+	}
+	if (numIndices % 3 != 0) {
+		throw std::invalid_argument("Index count not divisible by 3. Must be triangles.");
+	}
+	if (std::any_of(indices, indices + numIndices, [numPositions](unsigned index) { return index >= numPositions; })) {
+		throw std::invalid_argument("Indices over-index the positions.");
+	}
+
+	Clear();
+	const size_t numTriangles = numIndices / 3;
+
+	// Triangles around each vertex
+	std::vector<uint32_t> adjacencyOffsets(numPositions + 1, 0);
+	for (size_t i = 0; i < numIndices; ++i) {
+		++adjacencyOffsets[indices[i] + 1];
+	}
+	for (size_t v = 0; v < numPositions; ++v) {
+		adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+	}
+	std::vector<uint32_t> adjacency(numIndices);
+	std::vector<uint32_t> adjacencyFill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (size_t i = 0; i < numIndices; ++i) {
+		adjacency[adjacencyFill[indices[i]]++] = uint32_t(i / 3);
+	}
+
+	std::vector<bool> used(numTriangles, false);
+	std::vector<int> localIndices(numPositions, -1);
+	std::vector<uint32_t> candidates;
+	size_t seed = 0;
+	size_t remaining = numTriangles;
+
+	Meshlet meshlet;
+	auto countNewVertices = [&](size_t triangle) {
+		unsigned a = indices[3 * triangle], b = indices[3 * triangle + 1], c = indices[3 * triangle + 2];
+		return unsigned(localIndices[a] < 0)
+			+ unsigned(localIndices[b] < 0 && b != a)
+			+ unsigned(localIndices[c] < 0 && c != a && c != b);
+	};
+	auto addTriangle = [&](size_t triangle) {
+		used[triangle] = true;
+		--remaining;
+		for (unsigned corner = 0; corner < 3; ++corner) {
+			unsigned vertex = indices[3 * triangle + corner];
+			if (localIndices[vertex] < 0) {
+				localIndices[vertex] = int(meshlet.numVertices++);
+				m_vertices.push_back(vertex);
+				for (uint32_t i = adjacencyOffsets[vertex]; i < adjacencyOffsets[vertex + 1]; ++i) {
+					if (!used[adjacency[i]]) {
+						candidates.push_back(adjacency[i]);
+					}
+				}
+			}
+			m_triangles.push_back(uint8_t(localIndices[vertex]));
+		}
+		++meshlet.numTriangles;
+	};
+	auto finishMeshlet = [&]() {
+		for (uint32_t i = meshlet.firstVertex; i < m_vertices.size(); ++i) {
+			localIndices[m_vertices[i]] = -1;
+		}
+		ComputeBounds(positions, meshlet);
+		m_meshlets.push_back(meshlet);
+		meshlet = Meshlet{};
+		meshlet.firstVertex = uint32_t(m_vertices.size());
+		meshlet.firstTriangle = uint32_t(m_triangles.size() / 3);
+		candidates.clear();
+	};
+
+	while (remaining > 0) {
+		// The neighbour that adds the fewest vertices
+		candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [&used](uint32_t triangle) { return used[triangle]; }), candidates.end());
+		size_t best = numTriangles;
+		unsigned bestNewVertices = 4;
+		for (uint32_t candidate : candidates) {
+			unsigned newVertices = countNewVertices(candidate);
+			if (newVertices < bestNewVertices) {
+				best = candidate;
+				bestNewVertices = newVertices;
+				if (newVertices == 0) {
+					break;
+				}
+			}
+		}
+
+		// A meshlet without neighbours left is done, new meshlets start at the first unused triangle
+		if (best == numTriangles) {
+			if (meshlet.numTriangles > 0) {
+				finishMeshlet();
+				continue;
+			}
+			while (used[seed]) {
+				++seed;
+			}
+			best = seed;
+			bestNewVertices = countNewVertices(best);
+		}
+		if (meshlet.numVertices + bestNewVertices > maxVertices) {
+			finishMeshlet();
+			continue;
+		}
+
+		addTriangle(best);
+		if (meshlet.numTriangles == maxTriangles || meshlet.numVertices == maxVertices) {
+			finishMeshlet();
+		}
+	}
+	if (meshlet.numTriangles > 0) {
+		finishMeshlet();
+	}
+
+	// A new base vertex starts where the vertices would not fit in 16-bit indices
+	uint32_t baseVertex = 0;
+	m_drawIndices.reserve(m_triangles.size());
+	for (Meshlet& current : m_meshlets) {
+		if (current.firstVertex + current.numVertices - baseVertex > MaxVerticesPerBase) {
+			baseVertex = current.firstVertex;
+		}
+		current.baseVertex = baseVertex;
+		for (uint32_t i = 3 * current.firstTriangle; i < 3 * (current.firstTriangle + current.numTriangles); ++i) {
+			m_drawIndices.push_back(uint16_t(current.firstVertex + m_triangles[i] - baseVertex));
+		}
+	}
+	Cull(Frustum{}, nullptr, m_draws);
+}
+
+
+void Meshlets::Clear() {
+	m_meshlets.clear();
+	m_vertices.clear();
+	m_triangles.clear();
+	m_drawIndices.clear();
+	m_draws.clear();
+}
+
+
+void Meshlets::Cull(const Frustum& frustum, const mathfu::Vector<float, 3>* eye, std::vector<MeshletDraw>& draws) const {
+	draws.clear();
+	for (const Meshlet& meshlet : m_meshlets) {
+		if (!frustum.IsVisible(meshlet.bounds)) {
+			continue;
+		}
+
+		// Every point of the bounds is seen within 90 degrees minus the normals' spread from the axis,
+		// so every triangle faces away
+		if (eye != nullptr) {
+			mathfu::Vector<float, 3> toCenter = meshlet.bounds.center - *eye;
+			float alongAxis = mathfu::Vector<float, 3>::DotProduct(toCenter, meshlet.coneAxis);
+			if (alongAxis >= meshlet.coneCutoff * toCenter.Length() + meshlet.bounds.radius * (1.0f + meshlet.coneCutoff)) {
+				continue;
+			}
+		}
+
+		uint32_t firstIndex = 3 * meshlet.firstTriangle;
+		uint32_t numIndices = 3 * meshlet.numTriangles;
+		if (!draws.empty() && draws.back().baseVertex == meshlet.baseVertex && draws.back().firstIndex + draws.back().numIndices == firstIndex) {
+			draws.back().numIndices += numIndices;
+		}
+		else {
+			draws.push_back({ firstIndex, numIndices, meshlet.baseVertex });
+		}
+	}
+}
+
+
+void Meshlets::Cull(const mathfu::Matrix<float, 4, 4>& modelViewProjection,
+					const mathfu::Matrix<float, 4, 4>& world,
+					const mathfu::Vector<float, 3>* eye,
+					std::vector<MeshletDraw>& draws) const
+{
+	Frustum frustum(modelViewProjection);
+	float determinant =
+		world(0, 0) * (world(1, 1) * world(2, 2) - world(2, 1) * world(1, 2))
+		- world(0, 1) * (world(1, 0) * world(2, 2) - world(2, 0) * world(1, 2))
+		+ world(0, 2) * (world(1, 0) * world(2, 1) - world(2, 0) * world(1, 1));
+	if (eye == nullptr || determinant <= 0.0f) {
+		Cull(frustum, nullptr, draws);
+		return;
+	}
+
+	// Facing is kept by transforms that do not mirror, so the test can be done in the mesh's space
+	mathfu::Vector<float, 3> localEye = (world.Inverse() * mathfu::Vector<float, 4>(*eye, 1.0f)).xyz();
+	Cull(frustum, &localEye, draws);
+}
+
+
+void Meshlets::ComputeBounds(const mathfu::Vector<float, 3>* positions, Meshlet& meshlet) {
+	std::vector<mathfu::Vector<float, 3>> meshletPositions;
+	meshletPositions.reserve(meshlet.numVertices);
+	for (uint32_t i = meshlet.firstVertex; i < meshlet.firstVertex + meshlet.numVertices; ++i) {
+		meshletPositions.push_back(positions[m_vertices[i]]);
+	}
+	meshlet.bounds = ComputeBoundingSphere(meshletPositions.data(), meshletPositions.size());
+
+	// Degenerate triangles are never drawn and have no say in the cone
+	std::vector<mathfu::Vector<float, 3>> normals;
+	normals.reserve(meshlet.numTriangles);
+	mathfu::Vector<float, 3> normalSum = { 0, 0, 0 };
+	for (uint32_t i = 3 * meshlet.firstTriangle; i < 3 * (meshlet.firstTriangle + meshlet.numTriangles); i += 3) {
+		const mathfu::Vector<float, 3>& a = meshletPositions[m_triangles[i]];
+		const mathfu::Vector<float, 3>& b = meshletPositions[m_triangles[i + 1]];
+		const mathfu::Vector<float, 3>& c = meshletPositions[m_triangles[i + 2]];
+		mathfu::Vector<float, 3> normal = mathfu::Vector<float, 3>::CrossProduct(b - a, c - a);
+		float length = normal.Length();
+		if (length > 0.0f) {
+			normals.push_back(normal / length);
+			normalSum += normals.back();
+		}
+	}
+
+	meshlet.coneAxis = { 0, 0, 1 };
+	meshlet.coneCutoff = 1.0f;
+	float sumLength = normalSum.Length();
+	if (normals.empty() || sumLength < 1e-6f) {
+		return;
+	}
+	mathfu::Vector<float, 3> axis = normalSum / sumLength;
+	float minCos = 1.0f;
+	for (const auto& normal : normals) {
+		minCos = std::min(minCos, mathfu::Vector<float, 3>::DotProduct(axis, normal));
+	}
+	if (minCos > 0.0f) {
+		meshlet.coneAxis = axis;
+		meshlet.coneCutoff = std::sqrt(std::max(0.0f, 1.0f - minCos * minCos));
+	}
+}
+
+
+} // namespace gxeng
+} // namespace inl
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "BoundingVolume.hpp"
+#include "FrustumCulling.hpp"
+
+#include <mathfu/vector_3.h>
+#include <mathfu/matrix_4x4.h>
+
+#include <vector>
+#include <cstdint>
+
+
+namespace inl {
+namespace gxeng {
+
+
+/// <summary> A small cluster of a mesh's triangles that is culled as a whole. </summary>
+struct Meshlet {
+	/// <summary> The meshlet's vertices in the meshlet vertex order, see Meshlets::GetVertices. </summary>
+	uint32_t firstVertex = 0;
+	uint32_t numVertices = 0;
+	/// <summary> The meshlet's triangles, see Meshlets::GetTriangles. </summary>
+	uint32_t firstTriangle = 0;
+	uint32_t numTriangles = 0;
+	/// <summary> The vertex that the meshlet's draw indices are relative to. </summary>
+	uint32_t baseVertex = 0;
+
+	/// <summary> Bounds of the meshlet's vertices. </summary>
+	BoundingSphere bounds;
+	/// <summary> Average direction of the triangles' normals. </summary>
+	mathfu::Vector<float, 3> coneAxis = { 0, 0, 1 };
+	/// <summary> Sine of the largest angle between the axis and a normal, 1 if the normals are too spread to cull by. </summary>
+	float coneCutoff = 1.0f;
+};
+
+
+/// <summary> A range of the draw indices drawn with one draw call. </summary>
+struct MeshletDraw {
+	uint32_t firstIndex;
+	uint32_t numIndices;
+	uint32_t baseVertex;
+};
+
+
+/// <summary>
+/// Splits a mesh into meshlets of a few dozen vertices and triangles,
+/// so that parts of the mesh can be culled on their own.
+/// <para />
+/// Meshlets are built greedily: each one grows by the neighbouring triangle that adds the fewest new vertices.
+/// Vertices are laid out meshlet after meshlet, so vertices on meshlet borders are duplicated.
+/// </summary>
+/// <remarks>
+/// Draw indices are 16-bit and relative to each meshlet's base vertex, so meshes of any size keep 16-bit
+/// index buffers. Meshlets that share a base vertex and follow each other are drawn with one call.
+/// </remarks>
+class Meshlets {
+public:
+	/// <summary> Local indices are 8-bit. </summary>
+	static constexpr unsigned MaxVerticesPerMeshlet = 256;
+	/// <summary> Draw indices are 16-bit. </summary>
+	static constexpr uint32_t MaxVerticesPerBase = 0x10000;
+public:
+	/// <summary> Partitions the triangle list into meshlets. </summary>
+	/// <param name="positions"> Vertex positions, backfaces are found by counter-clockwise front faces. </param>
+	/// <exception cref="std::invalid_argument"> If the limits are out of range, indices over-index the positions,
+	///		or the index count is not divisible by 3. </exception>
+	void Build(const mathfu::Vector<float, 3>* positions,
+			   size_t numPositions,
+			   const unsigned* indices,
+			   size_t numIndices,
+			   unsigned maxVertices = 64,
+			   unsigned maxTriangles = 124);
+	void Clear();
+	bool IsEmpty() const { return m_meshlets.empty(); }
+
+	const std::vector<Meshlet>& GetMeshlets() const { return m_meshlets; }
+	/// <summary> The original vertex of each vertex of the meshlets, meshlet after meshlet. </summary>
+	const std::vector<uint32_t>& GetVertices() const { return m_vertices; }
+	/// <summary> Three indices per triangle into its meshlet's vertices. </summary>
+	const std::vector<uint8_t>& GetTriangles() const { return m_triangles; }
+	/// <summary> Triangles as indices into the meshlet vertex order, relative to their meshlet's base vertex. </summary>
+	const std::vector<uint16_t>& GetDrawIndices() const { return m_drawIndices; }
+	/// <summary> Draws of all meshlets, one per base vertex. </summary>
+	const std::vector<MeshletDraw>& GetDraws() const { return m_draws; }
+
+	/// <summary> Fills draws with the meshlets that may be visible. Consecutive visible meshlets are merged. </summary>
+	/// <param name="frustum"> The view frustum in the mesh's space. </param>
+	/// <param name="eye"> The camera's position in the mesh's space, or null to keep meshlets that face away. </param>
+	void Cull(const Frustum& frustum, const mathfu::Vector<float, 3>* eye, std::vector<MeshletDraw>& draws) const;
+
+	/// <summary> Fills draws with the meshlets that one instance of the mesh may show. </summary>
+	/// <remarks> Mirrored instances keep meshlets that face away, as their front faces are flipped. </remarks>
+	/// <param name="modelViewProjection"> Transform of the instance from the mesh's space to clip space. </param>
+	/// <param name="world"> Transform of the instance to world space. </param>
+	/// <param name="eye"> The camera's position in world space, or null to keep meshlets that face away. </param>
+	void Cull(const mathfu::Matrix<float, 4, 4>& modelViewProjection,
+			  const mathfu::Matrix<float, 4, 4>& world,
+			  const mathfu::Vector<float, 3>* eye,
+			  std::vector<MeshletDraw>& draws) const;
+private:
+	void ComputeBounds(const mathfu::Vector<float, 3>* positions, Meshlet& meshlet);
+private:
+	std::vector<Meshlet> m_meshlets;
+	std::vector<uint32_t> m_vertices;
+	std::vector<uint8_t> m_triangles;
+	std::vector<uint16_t> m_drawIndices;
+	std::vector<MeshletDraw> m_draws;
+};
+
+
+} // namespace gxeng
+} // namespace inl
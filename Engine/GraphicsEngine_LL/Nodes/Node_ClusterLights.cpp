@@ -0,0 +1,96 @@
+#include "Node_ClusterLights.hpp"
+
+#include "../PointLight.hpp"
+#include "../SpotLight.hpp"
+
+#include <algorithm>
+
+
+namespace inl::gxeng::nodes {
+
+
+ClusterLights::ClusterLights()
+	: m_clusters(LightClusterTilesX, LightClusterTilesY, LightClusterSlices)
+{
+	this->GetInput<0>().Set({});
+	this->GetInput<1>().Set({});
+	this->GetInput<2>().Set({});
+}
+
+
+Task ClusterLights::GetTask() {
+	return Task({ [this](const ExecutionContext& context) {
+		const Camera* camera = this->GetInput<0>().Get();
+		this->GetInput<0>().Clear();
+
+		const EntityCollection<PointLight>* pointLights = this->GetInput<1>().Get();
+		this->GetInput<1>().Clear();
+
+		const EntityCollection<SpotLight>* spotLights = this->GetInput<2>().Get();
+		this->GetInput<2>().Clear();
+
+		if (camera == nullptr) {
+			this->GetOutput<0>().Set(nullptr);
+			return ExecutionResult{};
+		}
+
+		GatherLights(pointLights, spotLights, *camera);
+		m_clusters.Build(*camera, m_pointLights, m_spotLights, MaxClusteredLightIndices);
+		this->GetOutput<0>().Set(&m_clusters);
+
+		return ExecutionResult{};
+	} });
+}
+
+
+void ClusterLights::GatherLights(const EntityCollection<PointLight>* pointLights, const EntityCollection<SpotLight>* spotLights, const Camera& camera) {
+	Frustum frustum(camera.GetPerspectiveMatrixRH() * camera.GetViewMatrixRH());
+	mathfu::Vector3f eye = camera.GetPosition();
+
+	// Lights are culled by the sphere of their range, spot lights' cones are left to the clusters
+	m_pointLights.clear();
+	m_spotLights.clear();
+	m_distances.clear();
+	if (pointLights) {
+		for (const PointLight* light : *pointLights) {
+			if (frustum.IsVisible(BoundingSphere{ light->GetPosition(), light->GetRange() })) {
+				m_distances.push_back({ (light->GetPosition() - eye).Length() - light->GetRange(), (uint32_t)m_pointLights.size() });
+				m_pointLights.push_back(light);
+			}
+		}
+	}
+	if (spotLights) {
+		for (const SpotLight* light : *spotLights) {
+			if (frustum.IsVisible(BoundingSphere{ light->GetPosition(), light->GetRange() })) {
+				m_distances.push_back({ (light->GetPosition() - eye).Length() - light->GetRange(), uint32_t(m_pointLights.size() + m_spotLights.size()) });
+				m_spotLights.push_back(light);
+			}
+		}
+	}
+
+	if (m_distances.size() <= MaxClusteredLights) {
+		return;
+	}
+
+	// Too many lights for the shaders, keep the nearest ones in their original order
+	std::nth_element(m_distances.begin(), m_distances.begin() + MaxClusteredLights, m_distances.end());
+	m_distances.resize(MaxClusteredLights);
+	std::sort(m_distances.begin(), m_distances.end(), [](const auto& lhs, const auto& rhs) { return lhs.second < rhs.second; });
+
+	size_t numPointLights = m_pointLights.size();
+	size_t numKeptPointLights = 0;
+	size_t numKeptSpotLights = 0;
+	for (const auto& kept : m_distances) {
+		if (kept.second < numPointLights) {
+			m_pointLights[numKeptPointLights++] = m_pointLights[kept.second];
+		}
+		else {
+			m_spotLights[numKeptSpotLights++] = m_spotLights[kept.second - numPointLights];
+		}
+	}
+	m_pointLights.resize(numKeptPointLights);
+	m_spotLights.resize(numKeptSpotLights);
+}
+
+
+} // namespace inl::gxeng::nodes
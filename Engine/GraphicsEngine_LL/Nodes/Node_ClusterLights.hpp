@@ -0,0 +1,61 @@
+#pragma once
+
+#include "../GraphicsNode.hpp"
+
+#include "../Scene.hpp"
+#include "../Camera.hpp"
+#include "../LightClusters.hpp"
+#include "../FrustumCulling.hpp"
+
+#include <vector>
+
+
+namespace inl::gxeng::nodes {
+
+
+/// <summary> Maximum number of point and spot lights the shaders can shade in a frame. </summary>
+constexpr size_t MaxClusteredLights = 512;
+
+/// <summary> Maximum total length of the clusters' light lists the shaders can read. </summary>
+constexpr size_t MaxClusteredLightIndices = 14336;
+
+/// <summary> Size of the cluster grid the shaders index. </summary>
+constexpr unsigned LightClusterTilesX = 16;
+constexpr unsigned LightClusterTilesY = 8;
+constexpr unsigned LightClusterSlices = 16;
+
+
+/// <summary>
+/// Bins the point and spot lights in the camera's view into clusters.
+/// </summary>
+/// <remarks>
+/// Lights are culled by their bounding sphere first. If more than MaxClusteredLights remain,
+/// the ones nearest to the camera are kept. The output is owned by the node and rebuilt every frame.
+/// </remarks>
+class ClusterLights :
+	virtual public GraphicsNode,
+	// Inputs: camera, point lights, spot lights
+	virtual public exc::InputPortConfig<const Camera*, const EntityCollection<PointLight>*, const EntityCollection<SpotLight>*>,
+	// Outputs: lights of each cluster
+	virtual public exc::OutputPortConfig<const LightClusters*>
+{
+public:
+	ClusterLights();
+
+	void Update() override {}
+	void Notify(exc::InputPortBase* sender) override {}
+	void InitGraphics(const GraphicsContext& context) override {}
+
+	Task GetTask() override;
+
+private:
+	void GatherLights(const EntityCollection<PointLight>* pointLights, const EntityCollection<SpotLight>* spotLights, const Camera& camera);
+private:
+	LightClusters m_clusters;
+	std::vector<const PointLight*> m_pointLights;
+	std::vector<const SpotLight*> m_spotLights;
+	std::vector<std::pair<float, uint32_t>> m_distances;
+};
+
+
+} // namespace inl::gxeng::nodes
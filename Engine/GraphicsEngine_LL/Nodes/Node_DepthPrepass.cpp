@@ -4,12 +4,27 @@
 #include "../Mesh.hpp"
 #include "../Image.hpp"
 #include "../DirectionalLight.hpp"
+#include "../ParallelRecording.hpp"
 
 #include <array>
 
 namespace inl::gxeng::nodes {
 
 
+// Shader of the node, requested up front and created by InitGraphics
+static constexpr const char* ShaderName = "DepthPrepass";
+
+
+// An instance's transform is a world matrix, the instances of a draw must fit into a 64 KiB constant buffer.
+static constexpr uint32_t MaxInstancesPerDraw = 65536 / (sizeof(float) * 4 * 4);
+
+// Constant buffers bound in the root signature must start at multiples of this.
+static constexpr size_t ConstantBufferAlignment = 256;
+
+// Fewer draws are not worth a command list and a thread of their own.
+static constexpr size_t MinBatchesPerList = 256;
+
+
 static bool CheckMeshFormat(const Mesh& mesh) {
 	for (size_t i = 0; i < mesh.GetNumStreams(); i++) {
 		auto& elements = mesh.GetVertexBufferElements(i);
@@ -55,11 +70,19 @@ DepthPrepass::DepthPrepass(gxapi::IGraphicsApi * graphicsApi, unsigned width, un
 	BindParameterDesc transformBindParamDesc;
 	m_transformBindParam = BindParameter(eBindParameterType::CONSTANT, 0);
 	transformBindParamDesc.parameter = m_transformBindParam;
-	transformBindParamDesc.constantSize = sizeof(float) * 4 * 4;
+	transformBindParamDesc.constantSize = 0; // instance transforms are in a constant buffer
 	transformBindParamDesc.relativeAccessFrequency = 0;
 	transformBindParamDesc.relativeChangeFrequency = 0;
 	transformBindParamDesc.shaderVisibility = gxapi::eShaderVisiblity::VERTEX;
 
+	BindParameterDesc viewProjectionBindParamDesc;
+	m_viewProjectionBindParam = BindParameter(eBindParameterType::CONSTANT, 1);
+	viewProjectionBindParamDesc.parameter = m_viewProjectionBindParam;
+	viewProjectionBindParamDesc.constantSize = sizeof(float) * 4 * 4; // bundles inherit it from the command list
+	viewProjectionBindParamDesc.relativeAccessFrequency = 0;
+	viewProjectionBindParamDesc.relativeChangeFrequency = 0;
+	viewProjectionBindParamDesc.shaderVisibility = gxapi::eShaderVisiblity::VERTEX;
+
 	BindParameterDesc sampBindParamDesc;
 	sampBindParamDesc.parameter = BindParameter(eBindParameterType::SAMPLER, 0);
 	sampBindParamDesc.constantSize = 0;
@@ -77,7 +100,14 @@ DepthPrepass::DepthPrepass(gxapi::IGraphicsApi * graphicsApi, unsigned width, un
 	samplerDesc.registerSpace = 0;
 	samplerDesc.shaderVisibility = gxapi::eShaderVisiblity::PIXEL;
 
-	m_binder = Binder{ graphicsApi,{ transformBindParamDesc, sampBindParamDesc },{ samplerDesc } };
+	m_binder = Binder{ graphicsApi,{ transformBindParamDesc, viewProjectionBindParamDesc, sampBindParamDesc },{ samplerDesc } };
+
+	m_meshletSignature = MeshDrawRecorder::CreateMeshletSignature(graphicsApi);
+}
+
+
+void DepthPrepass::RequestShaders(const GraphicsContext& context) {
+	context.RequestShader(ShaderName, ShaderParts::VertexPixel(), "");
 }
 
 
@@ -86,11 +116,7 @@ void DepthPrepass::InitGraphics(const GraphicsContext & context) {
 
 	InitRenderTarget();
 
-	ShaderParts shaderParts;
-	shaderParts.vs = true;
-	shaderParts.ps = true;
-
-	auto shader = m_graphicsContext.CreateShader("DepthPrepass", shaderParts, "");
+	auto shader = m_graphicsContext.CreateShader(ShaderName, ShaderParts::VertexPixel(), "");
 
 	std::vector<gxapi::InputElementDesc> inputElementDesc = {
 		gxapi::InputElementDesc("POSITION", 0, gxapi::eFormat::R32G32B32_FLOAT, 0, 0),
@@ -114,7 +140,7 @@ void DepthPrepass::InitGraphics(const GraphicsContext & context) {
 
 	psoDesc.numRenderTargets = 0;
 
-	m_PSO.reset(m_graphicsContext.CreatePSO(psoDesc));
+	m_PSO = m_graphicsContext.CreatePSO(psoDesc);
 }
 
 
@@ -131,11 +157,7 @@ Task DepthPrepass::GetTask() {
 		this->GetOutput<0>().Set(pipeline::Texture2D(m_depthTargetSrv, m_dsv));
 
 		if (entities) {
-			GraphicsCommandList cmdList = context.GetGraphicsCommandList();
-			CopyCommandList cpyCmdList = context.GetCopyCommandList();
-
-			RenderScene(m_dsv, *entities, camera, cmdList);
-			result.AddCommandList(std::move(cmdList));
+			RenderScene(m_dsv, *entities, camera, context, result);
 		}
 
 		return result;
@@ -182,8 +204,70 @@ void DepthPrepass::RenderScene(
 	DepthStencilView2D& dsv,
 	const EntityCollection<MeshEntity>& entities,
 	const Camera* camera,
-	GraphicsCommandList& commandList
+	const ExecutionContext& context,
+	ExecutionResult& result
 ) {
+	// Clear the depth buffer once, in a list of its own
+	GraphicsCommandList prologue = context.GetGraphicsCommandList();
+	prologue.SetResourceState(dsv.GetResource(), 0, gxapi::eResourceState::DEPTH_WRITE);
+	prologue.ClearDepthStencil(dsv, 1, 0);
+	result.AddCommandList(std::move(prologue));
+
+	mathfu::Matrix4x4f view = camera->GetViewMatrixRH();
+	mathfu::Matrix4x4f projection = camera->GetPerspectiveMatrixRH();
+
+	auto viewProjection = projection * view;
+
+	// Compute the MVPs of all entities at once, entities are all in the engine's store
+	if (!entities.IsEmpty()) {
+		(*entities.begin())->GetStore().ComputeMvps(viewProjection, m_mvps);
+	}
+
+	// Entities that have not changed lately are drawn by bundles of their group, the rest directly
+	m_staticDraws.Update(entities);
+
+	// Sort the draws by mesh, then front to back, so that draws of the same mesh become one instanced draw
+	m_drawEntities.clear();
+	m_drawPackets.Clear();
+	for (const MeshEntity* entity : m_staticDraws.GetDynamicEntities()) {
+		if (!CheckMeshFormat(*entity->GetMesh())) {
+			assert(false);
+			continue;
+		}
+		float depth = m_mvps[entity->GetStoreIndex()](3, 3) / camera->GetFarPlane();
+		m_drawPackets.Add((uint32_t)m_drawEntities.size(), 0, entity->GetMesh(), nullptr, depth);
+		m_drawEntities.push_back(entity);
+	}
+	m_drawPackets.Build(MaxInstancesPerDraw);
+
+	// Groups are recorded again only when their entities have changed
+	const std::vector<size_t>& visibleGroups = m_staticDraws.GetVisibleGroups();
+	if (!visibleGroups.empty()) {
+		m_groupBundles.resize(m_staticDraws.GetNumGroups());
+		GraphicsCommandList bundleList = context.GetGraphicsCommandList();
+		SetRenderState(dsv, viewProjection, bundleList);
+		for (size_t groupIndex : visibleGroups) {
+			const StaticDrawCache::Group& group = m_staticDraws.GetGroup(groupIndex);
+			if (group.changed) {
+				m_groupBundles[groupIndex] = RecordGroup(group);
+				m_staticDraws.MarkRecorded(groupIndex);
+			}
+			bundleList.ExecuteBundle(m_groupBundles[groupIndex]);
+		}
+		result.AddCommandList(std::move(bundleList));
+	}
+
+	// Record the draws on several threads
+	mathfu::Vector3f eye = camera->GetPosition();
+	RecordInParallel(context, result, m_drawPackets.GetBatches().size(), MinBatchesPerList,
+		[this, &dsv, &viewProjection, &eye](GraphicsCommandList& commandList, VolatileViewHeap& viewHeap, size_t firstBatch, size_t endBatch) {
+			SetRenderState(dsv, viewProjection, commandList);
+			RecordDraws(firstBatch, endBatch, eye, viewHeap, commandList);
+		});
+}
+
+
+void DepthPrepass::SetRenderState(DepthStencilView2D& dsv, const mathfu::Matrix4x4f& viewProjection, GraphicsCommandList& commandList) {
 	commandList.SetRenderTargets(0, nullptr, &dsv);
 
 	gxapi::Rectangle rect{ 0, (int)m_dsv.GetResource().GetHeight(), 0, (int)m_dsv.GetResource().GetWidth() };
@@ -198,45 +282,101 @@ void DepthPrepass::RenderScene(
 	commandList.SetViewports(1, &viewport);
 
 	commandList.SetResourceState(dsv.GetResource(), 0, gxapi::eResourceState::DEPTH_WRITE);
-	commandList.ClearDepthStencil(dsv, 1, 0);
 
 	commandList.SetPipelineState(m_PSO.get());
 	commandList.SetGraphicsBinder(&m_binder);
 	commandList.SetPrimitiveTopology(gxapi::ePrimitiveTopology::TRIANGLELIST);
 
-	mathfu::Matrix4x4f view = camera->GetViewMatrixRH();
-	mathfu::Matrix4x4f projection = camera->GetPerspectiveMatrixRH();
+	std::array<mathfu::VectorPacked<float, 4>, 4> viewProjectionData;
+	viewProjection.Pack(viewProjectionData.data());
+	commandList.BindGraphics(m_viewProjectionBindParam, viewProjectionData.data(), sizeof(viewProjectionData), 0);
+}
 
-	auto viewProjection = projection * view;
-	
-	std::vector<const gxeng::VertexBuffer*> vertexBuffers;
-	std::vector<unsigned> sizes;
-	std::vector<unsigned> strides;
-
-	// Iterate over all entities
-	for (const MeshEntity* entity : entities) {
-		// Get entity parameters
-		Mesh* mesh = entity->GetMesh();
-		auto position = entity->GetPosition();
-
-		// Draw mesh
-		if (!CheckMeshFormat(*mesh)) {
+
+std::shared_ptr<GraphicsBundle> DepthPrepass::RecordGroup(const StaticDrawCache::Group& group) {
+	// Sort the group's draws by mesh, the order does not follow the camera
+	m_groupPackets.Clear();
+	for (size_t i = 0; i < group.entities.size(); ++i) {
+		if (!CheckMeshFormat(*group.entities[i]->GetMesh())) {
 			assert(false);
 			continue;
 		}
+		m_groupPackets.Add((uint32_t)i, 0, group.entities[i]->GetMesh(), nullptr, 0.0f);
+	}
+	m_groupPackets.Build(MaxInstancesPerDraw);
+	const std::vector<DrawPacket>& packets = m_groupPackets.GetPackets();
+	const std::vector<DrawPacketBuilder::Batch>& batches = m_groupPackets.GetBatches();
+
+	// The transforms of all batches go into one buffer that lives as long as the bundle
+	constexpr size_t alignment = ConstantBufferAlignment / sizeof(mathfu::VectorPacked<float, 4>);
+	std::vector<mathfu::VectorPacked<float, 4>> instanceData;
+	std::vector<size_t> batchOffsets;
+	for (const DrawPacketBuilder::Batch& batch : batches) {
+		size_t offset = instanceData.size();
+		batchOffsets.push_back(offset * sizeof(instanceData[0]));
+		instanceData.resize(offset + (batch.count * 4 + alignment - 1) / alignment * alignment);
+		for (uint32_t i = 0; i < batch.count; ++i) {
+			const MeshEntity* entity = group.entities[packets[batch.first + i].index];
+			entity->GetStore().WorldMatrix(entity->GetStoreIndex()).Pack(&instanceData[offset + i * 4]);
+		}
+	}
+
+	std::shared_ptr<GraphicsBundle> bundle = m_graphicsContext.CreateBundle();
+	if (!batches.empty()) {
+		PersistentConstBuffer instanceBuffer = m_graphicsContext.CreatePersistentConstBuffer(instanceData.data(), instanceData.size() * sizeof(instanceData[0]));
+		bundle->SetPipelineState(m_PSO.get());
+		bundle->SetGraphicsBinder(&m_binder);
+		bundle->SetPrimitiveTopology(gxapi::ePrimitiveTopology::TRIANGLELIST);
+
+		std::vector<const gxeng::VertexBuffer*> vertexBuffers;
+		std::vector<unsigned> sizes;
+		std::vector<unsigned> strides;
+		for (size_t batchIndex = 0; batchIndex < batches.size(); ++batchIndex) {
+			const DrawPacketBuilder::Batch& batch = batches[batchIndex];
+			Mesh* mesh = group.entities[packets[batch.first].index]->GetMesh();
+
+			bundle->BindGraphics(m_transformBindParam, instanceBuffer, batchOffsets[batchIndex]);
+			ConvertToSubmittable(mesh, vertexBuffers, sizes, strides);
+			bundle->SetVertexBuffers(0, (unsigned)vertexBuffers.size(), vertexBuffers.data(), sizes.data(), strides.data());
+			bundle->SetIndexBuffer(&mesh->GetIndexBuffer(), mesh->GetIndexBuffer32Bit());
+
+			// Meshlets can't be culled for a camera that is not known yet, all of them are drawn
+			if (mesh->HasMeshlets()) {
+				for (const MeshletDraw& draw : mesh->GetMeshlets().GetDraws()) {
+					bundle->DrawIndexedInstanced(draw.numIndices, draw.firstIndex, (int)draw.baseVertex, batch.count);
+				}
+			}
+			else {
+				bundle->DrawIndexedInstanced((unsigned)mesh->GetIndexBuffer().GetIndexCount(), 0, 0, batch.count);
+			}
+		}
+	}
+	bundle->Close();
+	return bundle;
+}
 
-		ConvertToSubmittable(mesh, vertexBuffers, sizes, strides);
 
-		auto MVP = viewProjection * entity->GetTransform();
+void DepthPrepass::RecordDraws(size_t firstBatch, size_t endBatch, const mathfu::Vector3f& eye, VolatileViewHeap& viewHeap, GraphicsCommandList& commandList) {
+	const std::vector<DrawPacket>& packets = m_drawPackets.GetPackets();
+	const std::vector<DrawPacketBuilder::Batch>& batches = m_drawPackets.GetBatches();
 
-		std::array<mathfu::VectorPacked<float, 4>, 4> transformCBData;
-		MVP.Pack(transformCBData.data());
+	MeshDrawRecorder recorder(m_graphicsContext, viewHeap, commandList, m_meshletSignature.get());
 
-		commandList.BindGraphics(m_transformBindParam, transformCBData.data(), sizeof(transformCBData), 0);
+	for (size_t batchIndex = firstBatch; batchIndex < endBatch; ++batchIndex) {
+		const DrawPacketBuilder::Batch& batch = batches[batchIndex];
+		const MeshEntity* firstEntity = m_drawEntities[packets[batch.first].index];
+		const MeshEntityStore& store = firstEntity->GetStore();
+
+		// An instance's transform is its world matrix
+		mathfu::VectorPacked<float, 4>* instanceData = recorder.AllocateInstanceData(batch.count * 4);
+		for (uint32_t i = 0; i < batch.count; ++i) {
+			size_t storeIndex = m_drawEntities[packets[batch.first + i].index]->GetStoreIndex();
+			store.WorldMatrix(storeIndex).Pack(&instanceData[i * 4]);
+		}
+		recorder.BindInstanceData(m_transformBindParam);
 
-		commandList.SetVertexBuffers(0, (unsigned)vertexBuffers.size(), vertexBuffers.data(), sizes.data(), strides.data());
-		commandList.SetIndexBuffer(&mesh->GetIndexBuffer(), mesh->GetIndexBuffer32Bit());
-		commandList.DrawIndexedInstanced((unsigned)mesh->GetIndexBuffer().GetIndexCount());
+		size_t storeIndex = firstEntity->GetStoreIndex();
+		recorder.Draw(firstEntity->GetMesh(), batch.count, m_mvps[storeIndex], store.WorldMatrix(storeIndex), &eye);
 	}
 }
 
@@ -11,7 +11,11 @@
 #include "../GraphicsContext.hpp"
 #include "../PipelineTypes.hpp"
 #include "../WindowResizeListener.hpp"
+#include "../DrawPackets.hpp"
+#include "../MeshDrawRecorder.hpp"
+#include "../StaticDrawCache.hpp"
 #include "GraphicsApi_LL/IPipelineState.hpp"
+#include "GraphicsApi_LL/ICommandSignature.hpp"
 #include "GraphicsApi_LL/IGxapiManager.hpp"
 
 namespace inl::gxeng::nodes {
@@ -28,6 +32,7 @@ public:
 
 	void Update() override {}
 	void Notify(exc::InputPortBase* sender) override {}
+	void RequestShaders(const GraphicsContext& context) override;
 	void InitGraphics(const GraphicsContext& context) override;
 
 	Task GetTask() override;
@@ -45,7 +50,17 @@ protected:
 	GraphicsContext m_graphicsContext;
 	Binder m_binder;
 	BindParameter m_transformBindParam;
-	std::unique_ptr<gxapi::IPipelineState> m_PSO;
+	BindParameter m_viewProjectionBindParam;
+	std::shared_ptr<gxapi::IPipelineState> m_PSO;
+	std::unique_ptr<gxapi::ICommandSignature> m_meshletSignature;
+
+	std::vector<mathfu::Matrix4x4f> m_mvps;
+	std::vector<const MeshEntity*> m_drawEntities;
+	DrawPacketBuilder m_drawPackets;
+
+	StaticDrawCache m_staticDraws;
+	std::vector<std::shared_ptr<GraphicsBundle>> m_groupBundles; // indexed by group
+	DrawPacketBuilder m_groupPackets;
 
 private:
 	void InitRenderTarget();
@@ -53,7 +68,11 @@ private:
 		DepthStencilView2D& dsv,
 		const EntityCollection<MeshEntity>& entities,
 		const Camera* camera,
-		GraphicsCommandList& commandList);
+		const ExecutionContext& context,
+		ExecutionResult& result);
+	void SetRenderState(DepthStencilView2D& dsv, const mathfu::Matrix4x4f& viewProjection, GraphicsCommandList& commandList);
+	std::shared_ptr<GraphicsBundle> RecordGroup(const StaticDrawCache::Group& group);
+	void RecordDraws(size_t firstBatch, size_t endBatch, const mathfu::Vector3f& eye, VolatileViewHeap& viewHeap, GraphicsCommandList& commandList);
 };
 
 
@@ -9,6 +9,10 @@
 namespace inl::gxeng::nodes {
 
 
+// Shader of the node, requested up front and created by InitGraphics
+static constexpr const char* ShaderName = "DrawSky";
+
+
 DrawSky::DrawSky(gxapi::IGraphicsApi * graphicsApi):
 	m_binder(graphicsApi, {})
 {
@@ -41,6 +45,11 @@ DrawSky::DrawSky(gxapi::IGraphicsApi * graphicsApi):
 }
 
 
+void DrawSky::RequestShaders(const GraphicsContext& context) {
+	context.RequestShader(ShaderName, ShaderParts::VertexPixel(), "");
+}
+
+
 void DrawSky::InitGraphics(const GraphicsContext & context) {
 	m_graphicsContext = context;
 
@@ -57,11 +66,7 @@ void DrawSky::InitGraphics(const GraphicsContext & context) {
 	m_fsq = m_graphicsContext.CreateVertexBuffer(vertices.data(), sizeof(float)*vertices.size());
 	m_fsqIndices = m_graphicsContext.CreateIndexBuffer(indices.data(), sizeof(uint16_t)*indices.size(), indices.size());
 
-	ShaderParts shaderParts;
-	shaderParts.vs = true;
-	shaderParts.ps = true;
-
-	auto shader = m_graphicsContext.CreateShader("DrawSky", shaderParts, "");
+	auto shader = m_graphicsContext.CreateShader(ShaderName, ShaderParts::VertexPixel(), "");
 
 	std::vector<gxapi::InputElementDesc> inputElementDesc = {
 		gxapi::InputElementDesc("POSITION", 0, gxapi::eFormat::R32G32B32_FLOAT, 0, 0)
@@ -91,7 +96,7 @@ void DrawSky::InitGraphics(const GraphicsContext & context) {
 	psoDesc.numRenderTargets = 1;
 	psoDesc.renderTargetFormats[0] = gxapi::eFormat::R16G16B16A16_FLOAT;
 
-	m_PSO.reset(m_graphicsContext.CreatePSO(psoDesc));
+	m_PSO = m_graphicsContext.CreatePSO(psoDesc);
 }
 
 
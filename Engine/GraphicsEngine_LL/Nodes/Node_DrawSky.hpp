@@ -27,6 +27,7 @@ public:
 
 	void Update() override {}
 	void Notify(exc::InputPortBase* sender) override {}
+	void RequestShaders(const GraphicsContext& context) override;
 	void InitGraphics(const GraphicsContext& context) override;
 
 	Task GetTask() override {
@@ -63,7 +64,7 @@ protected:
 protected:
 	Binder m_binder;
 	BindParameter m_cbBindParam;
-	std::unique_ptr<gxapi::IPipelineState> m_PSO;
+	std::shared_ptr<gxapi::IPipelineState> m_PSO;
 
 private:
 	void Render(
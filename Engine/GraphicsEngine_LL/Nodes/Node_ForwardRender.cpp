@@ -4,12 +4,47 @@
 #include "../Mesh.hpp"
 #include "../Image.hpp"
 #include "../DirectionalLight.hpp"
+#include "../PointLight.hpp"
+#include "../SpotLight.hpp"
+#include "../ParallelRecording.hpp"
 
 #include <array>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 namespace inl::gxeng::nodes {
 
 
+// Shader of the node, requested up front and created by InitGraphics
+static constexpr const char* ShaderName = "ForwardRender";
+
+
+// An instance's transforms are a world and a normal matrix, the instances of a draw must fit into a 64 KiB constant buffer.
+static constexpr uint32_t MaxInstancesPerDraw = 65536 / (sizeof(float) * 4 * 4 * 2);
+
+// Constant buffers bound in the root signature must start at multiples of this.
+static constexpr size_t ConstantBufferAlignment = 256;
+
+// Fewer draws are not worth a command list and a thread of their own.
+static constexpr size_t MinBatchesPerList = 256;
+
+// Layout of the shadow constant buffer in ForwardRender.hlsl, in float4s:
+// inverse view-projection, cascade matrices, cascade far distances, screen size and cascade count.
+static constexpr size_t ShadowDataSize = 4 + 4 * MaxShadowCascades + 1 + 1;
+
+// Layout of the light constant buffer in ForwardRender.hlsl, in 32 bit words: tile and slice scales, grid size and light count,
+// three float4s per light, one word per cluster with the offset and count of its lights, 16 bit light indices.
+static constexpr size_t LightClusterCount = LightClusterTilesX * LightClusterTilesY * LightClusterSlices;
+static constexpr size_t LightsOffset = 8;
+static constexpr size_t ClustersOffset = LightsOffset + 12 * MaxClusteredLights;
+static constexpr size_t LightIndicesOffset = ClustersOffset + LightClusterCount;
+static constexpr size_t LightDataSize = LightIndicesOffset + MaxClusteredLightIndices / 2;
+static_assert(LightClusterCount % 4 == 0 && MaxClusteredLightIndices % 8 == 0, "Light data must be whole float4s.");
+static_assert(LightDataSize * sizeof(uint32_t) <= 65536, "Light data must fit into a constant buffer.");
+static_assert(MaxClusteredLightIndices <= 65536, "Light offsets must fit into 16 bits.");
+
+
 static bool CheckMeshFormat(const Mesh& mesh) {
 	for (size_t i = 0; i < mesh.GetNumStreams(); i++) {
 		auto& elements = mesh.GetVertexBufferElements(i);
@@ -55,7 +90,7 @@ ForwardRender::ForwardRender(gxapi::IGraphicsApi * graphicsApi, unsigned width,
 	BindParameterDesc transformBindParamDesc;
 	m_transformBindParam = BindParameter(eBindParameterType::CONSTANT, 0);
 	transformBindParamDesc.parameter = m_transformBindParam;
-	transformBindParamDesc.constantSize = sizeof(float) * 4 * 4 * 2;
+	transformBindParamDesc.constantSize = 0; // instance transforms are in a constant buffer
 	transformBindParamDesc.relativeAccessFrequency = 0;
 	transformBindParamDesc.relativeChangeFrequency = 0;
 	transformBindParamDesc.shaderVisibility = gxapi::eShaderVisiblity::VERTEX;
@@ -69,12 +104,53 @@ ForwardRender::ForwardRender(gxapi::IGraphicsApi * graphicsApi, unsigned width,
 	sunBindParamDesc.shaderVisibility = gxapi::eShaderVisiblity::PIXEL;
 
 	BindParameterDesc albedoBindParamDesc;
-	m_albedoBindParam = BindParameter(eBindParameterType::TEXTURE, 0);
+	m_albedoBindParam = BindParameter(eBindParameterType::TEXTURE, 0, 1);
 	albedoBindParamDesc.parameter = m_albedoBindParam;
 	albedoBindParamDesc.constantSize = 0;
 	albedoBindParamDesc.relativeAccessFrequency = 0;
 	albedoBindParamDesc.relativeChangeFrequency = 0;
 	albedoBindParamDesc.shaderVisibility = gxapi::eShaderVisiblity::PIXEL;
+	albedoBindParamDesc.numDescriptors = TextureTable::DefaultCapacity; // the texture table, draws pick their texture by index
+
+	BindParameterDesc textureIndexBindParamDesc;
+	m_textureIndexBindParam = BindParameter(eBindParameterType::CONSTANT, 5);
+	textureIndexBindParamDesc.parameter = m_textureIndexBindParam;
+	textureIndexBindParamDesc.constantSize = sizeof(uint32_t);
+	textureIndexBindParamDesc.relativeAccessFrequency = 1;
+	textureIndexBindParamDesc.relativeChangeFrequency = 1;
+	textureIndexBindParamDesc.shaderVisibility = gxapi::eShaderVisiblity::PIXEL;
+
+	BindParameterDesc shadowBindParamDesc;
+	m_shadowBindParam = BindParameter(eBindParameterType::CONSTANT, 2);
+	shadowBindParamDesc.parameter = m_shadowBindParam;
+	shadowBindParamDesc.constantSize = 0; // cascades are in a constant buffer
+	shadowBindParamDesc.relativeAccessFrequency = 0;
+	shadowBindParamDesc.relativeChangeFrequency = 0;
+	shadowBindParamDesc.shaderVisibility = gxapi::eShaderVisiblity::PIXEL;
+
+	BindParameterDesc shadowMapBindParamDesc;
+	m_shadowMapBindParam = BindParameter(eBindParameterType::TEXTURE, 1);
+	shadowMapBindParamDesc.parameter = m_shadowMapBindParam;
+	shadowMapBindParamDesc.constantSize = 0;
+	shadowMapBindParamDesc.relativeAccessFrequency = 0;
+	shadowMapBindParamDesc.relativeChangeFrequency = 0;
+	shadowMapBindParamDesc.shaderVisibility = gxapi::eShaderVisiblity::PIXEL;
+
+	BindParameterDesc lightsBindParamDesc;
+	m_lightsBindParam = BindParameter(eBindParameterType::CONSTANT, 3);
+	lightsBindParamDesc.parameter = m_lightsBindParam;
+	lightsBindParamDesc.constantSize = 0; // lights and clusters are in a constant buffer
+	lightsBindParamDesc.relativeAccessFrequency = 0;
+	lightsBindParamDesc.relativeChangeFrequency = 0;
+	lightsBindParamDesc.shaderVisibility = gxapi::eShaderVisiblity::PIXEL;
+
+	BindParameterDesc viewProjectionBindParamDesc;
+	m_viewProjectionBindParam = BindParameter(eBindParameterType::CONSTANT, 4);
+	viewProjectionBindParamDesc.parameter = m_viewProjectionBindParam;
+	viewProjectionBindParamDesc.constantSize = sizeof(float) * 4 * 4; // bundles inherit it from the command list
+	viewProjectionBindParamDesc.relativeAccessFrequency = 0;
+	viewProjectionBindParamDesc.relativeChangeFrequency = 0;
+	viewProjectionBindParamDesc.shaderVisibility = gxapi::eShaderVisiblity::VERTEX;
 
 	BindParameterDesc sampBindParamDesc;
 	sampBindParamDesc.parameter = BindParameter(eBindParameterType::SAMPLER, 0);
@@ -93,7 +169,34 @@ ForwardRender::ForwardRender(gxapi::IGraphicsApi * graphicsApi, unsigned width,
 	samplerDesc.registerSpace = 0;
 	samplerDesc.shaderVisibility = gxapi::eShaderVisiblity::PIXEL;
 
-	m_binder = Binder{ graphicsApi,{ transformBindParamDesc, sunBindParamDesc, albedoBindParamDesc, sampBindParamDesc },{ samplerDesc } };
+	BindParameterDesc shadowSampBindParamDesc;
+	shadowSampBindParamDesc.parameter = BindParameter(eBindParameterType::SAMPLER, 1);
+	shadowSampBindParamDesc.constantSize = 0;
+	shadowSampBindParamDesc.relativeAccessFrequency = 0;
+	shadowSampBindParamDesc.relativeChangeFrequency = 0;
+	shadowSampBindParamDesc.shaderVisibility = gxapi::eShaderVisiblity::PIXEL;
+
+	gxapi::StaticSamplerDesc shadowSamplerDesc;
+	shadowSamplerDesc.shaderRegister = 1;
+	shadowSamplerDesc.filter = gxapi::eTextureFilterMode::COMPARISON_MIN_MAG_LINEAR_MIP_POINT;
+	shadowSamplerDesc.addressU = gxapi::eTextureAddressMode::CLAMP;
+	shadowSamplerDesc.addressV = gxapi::eTextureAddressMode::CLAMP;
+	shadowSamplerDesc.addressW = gxapi::eTextureAddressMode::CLAMP;
+	shadowSamplerDesc.compareFunc = gxapi::eComparisonFunction::LESS_EQUAL;
+	shadowSamplerDesc.mipLevelBias = 0.f;
+	shadowSamplerDesc.registerSpace = 0;
+	shadowSamplerDesc.shaderVisibility = gxapi::eShaderVisiblity::PIXEL;
+
+	m_binder = Binder{ graphicsApi,
+		{ transformBindParamDesc, sunBindParamDesc, albedoBindParamDesc, textureIndexBindParamDesc, shadowBindParamDesc, shadowMapBindParamDesc, lightsBindParamDesc, viewProjectionBindParamDesc, sampBindParamDesc, shadowSampBindParamDesc },
+		{ samplerDesc, shadowSamplerDesc } };
+
+	m_meshletSignature = MeshDrawRecorder::CreateMeshletSignature(graphicsApi);
+}
+
+
+void ForwardRender::RequestShaders(const GraphicsContext& context) {
+	context.RequestShader(ShaderName, ShaderParts::VertexPixel(), "");
 }
 
 
@@ -102,11 +205,7 @@ void ForwardRender::InitGraphics(const GraphicsContext & context) {
 
 	InitRenderTarget();
 
-	ShaderParts shaderParts;
-	shaderParts.vs = true;
-	shaderParts.ps = true;
-
-	auto shader = m_graphicsContext.CreateShader("ForwardRender", shaderParts, "");
+	auto shader = m_graphicsContext.CreateShader(ShaderName, ShaderParts::VertexPixel(), "");
 
 	std::vector<gxapi::InputElementDesc> inputElementDesc = {
 		gxapi::InputElementDesc("POSITION", 0, gxapi::eFormat::R32G32B32_FLOAT, 0, 0),
@@ -138,7 +237,7 @@ void ForwardRender::InitGraphics(const GraphicsContext & context) {
 	psoDesc.numRenderTargets = 1;
 	psoDesc.renderTargetFormats[0] = gxapi::eFormat::R16G16B16A16_FLOAT;
 
-	m_PSO.reset(m_graphicsContext.CreatePSO(psoDesc));
+	m_PSO = m_graphicsContext.CreatePSO(psoDesc);
 }
 
 
@@ -158,17 +257,21 @@ Task ForwardRender::GetTask() {
 		const DirectionalLight* sun = this->GetInput<3>().Get();
 		this->GetInput<3>().Clear();
 
+		const ShadowCascades* shadowCascades = this->GetInput<4>().Get();
+		this->GetInput<4>().Clear();
+
+		const LightClusters* lightClusters = this->GetInput<5>().Get();
+		this->GetInput<5>().Clear();
+
 		this->GetOutput<0>().Set(pipeline::Texture2D(m_renderTargetSrv, m_rtv));
 
 		if (entities) {
-			GraphicsCommandList cmdList = context.GetGraphicsCommandList();
 			CopyCommandList cpyCmdList = context.GetCopyCommandList();
 
 			pipeline::RenderTexture2D depthTarget = depthStencil.QueryWrite(cpyCmdList, m_graphicsContext);
 			assert(depthTarget.type == pipeline::RenderTextureType::DEPTH_STENCIL);
 
-			RenderScene(depthTarget.dsv, *entities, camera, sun, cmdList);
-			result.AddCommandList(std::move(cmdList));
+			RenderScene(depthTarget.dsv, *entities, camera, sun, shadowCascades, lightClusters, context, result);
 		}
 
 		return result;
@@ -211,13 +314,106 @@ void ForwardRender::RenderScene(
 	const EntityCollection<MeshEntity>& entities,
 	const Camera* camera,
 	const DirectionalLight* sun,
+	const ShadowCascades* shadowCascades,
+	const LightClusters* lightClusters,
+	const ExecutionContext& context,
+	ExecutionResult& result
+) {
+	// Clear the render target once, in a list of its own
+	GraphicsCommandList prologue = context.GetGraphicsCommandList();
+	auto pRTV = &m_rtv;
+	prologue.SetResourceState(m_rtv.GetResource(), 0, gxapi::eResourceState::RENDER_TARGET);
+	prologue.SetRenderTargets(1, &pRTV, &dsv);
+	prologue.ClearRenderTarget(m_rtv, gxapi::ColorRGBA(0, 0, 0, 1));
+	result.AddCommandList(std::move(prologue));
+
+	mathfu::Matrix4x4f view = camera->GetViewMatrixRH();
+	mathfu::Matrix4x4f projection = camera->GetPerspectiveMatrixRH();
+
+	auto viewProjection = projection * view;
+
+	// Compute the MVPs of all entities at once, entities are all in the engine's store
+	if (!entities.IsEmpty()) {
+		(*entities.begin())->GetStore().ComputeMvps(viewProjection, m_mvps);
+	}
+
+	// Entities that have not changed lately are drawn by bundles of their group, the rest directly,
+	// the same entities as in the depth prepass
+	m_staticDraws.Update(entities);
+
+	// Sort the draws by mesh and texture, then front to back, so that draws of the same mesh
+	// and texture become one instanced draw
+	m_drawEntities.clear();
+	m_drawPackets.Clear();
+	for (const MeshEntity* entity : m_staticDraws.GetDynamicEntities()) {
+		if (!CheckMeshFormat(*entity->GetMesh())) {
+			continue;
+		}
+		float depth = m_mvps[entity->GetStoreIndex()](3, 3) / camera->GetFarPlane();
+		m_drawPackets.Add((uint32_t)m_drawEntities.size(), 0, entity->GetMesh(), entity->GetTexture(), depth);
+		m_drawEntities.push_back(entity);
+	}
+	m_drawPackets.Build(MaxInstancesPerDraw);
+
+	// The shaders find the world position of pixels from their depth, and look it up in the cascade
+	// that covers the pixel's view distance
+	std::array<mathfu::VectorPacked<float, 4>, ShadowDataSize> shadowData = {};
+	viewProjection.Inverse().Pack(&shadowData[0]);
+	size_t numCascades = shadowCascades ? shadowCascades->cascades.size() : 0;
+	mathfu::Vector4f cascadeFarDistances(0, 0, 0, 0);
+	for (size_t i = 0; i < numCascades; ++i) {
+		shadowCascades->cascades[i].viewProjection.Pack(&shadowData[4 + 4 * i]);
+		cascadeFarDistances[(int)i] = shadowCascades->cascades[i].farDistance;
+	}
+	cascadeFarDistances.Pack(&shadowData[4 + 4 * MaxShadowCascades]);
+	mathfu::Vector4f((float)m_width, (float)m_height, (float)numCascades, 0).Pack(&shadowData[4 + 4 * MaxShadowCascades + 1]);
+	VolatileConstBuffer shadowBuffer = m_graphicsContext.CreateVolatileConstBuffer(shadowData.data(), sizeof(shadowData));
+
+	// The lights and the clusters' light lists go up in one buffer
+	PackLights(lightClusters);
+	VolatileConstBuffer lightBuffer = m_graphicsContext.CreateVolatileConstBuffer(m_lightData.data(), m_lightData.size() * sizeof(uint32_t));
+
+	// Groups are recorded again only when their entities have changed, their texture index is recorded with them
+	const std::vector<size_t>& visibleGroups = m_staticDraws.GetVisibleGroups();
+	if (!visibleGroups.empty()) {
+		m_groupBundles.resize(m_staticDraws.GetNumGroups());
+		GraphicsCommandList bundleList = context.GetGraphicsCommandList();
+		VolatileViewHeap viewHeap = context.GetVolatileViewHeap();
+		SetRenderState(dsv, viewProjection, sun, shadowCascades, shadowBuffer, lightBuffer, viewHeap, bundleList);
+		for (size_t groupIndex : visibleGroups) {
+			const StaticDrawCache::Group& group = m_staticDraws.GetGroup(groupIndex);
+			if (group.changed) {
+				m_groupBundles[groupIndex] = RecordGroup(group);
+				m_staticDraws.MarkRecorded(groupIndex);
+			}
+			bundleList.ExecuteBundle(m_groupBundles[groupIndex]);
+		}
+		result.AddCommandList(std::move(bundleList));
+	}
+
+	// Record the draws on several threads
+	mathfu::Vector3f eye = camera->GetPosition();
+	RecordInParallel(context, result, m_drawPackets.GetBatches().size(), MinBatchesPerList,
+		[this, &dsv, &viewProjection, sun, shadowCascades, &shadowBuffer, &lightBuffer, &eye](GraphicsCommandList& commandList, VolatileViewHeap& viewHeap, size_t firstBatch, size_t endBatch) {
+			SetRenderState(dsv, viewProjection, sun, shadowCascades, shadowBuffer, lightBuffer, viewHeap, commandList);
+			RecordDraws(firstBatch, endBatch, eye, viewHeap, commandList);
+		});
+}
+
+
+void ForwardRender::SetRenderState(
+	DepthStencilView2D& dsv,
+	const mathfu::Matrix4x4f& viewProjection,
+	const DirectionalLight* sun,
+	const ShadowCascades* shadowCascades,
+	VolatileConstBuffer& shadowBuffer,
+	VolatileConstBuffer& lightBuffer,
+	VolatileViewHeap& viewHeap,
 	GraphicsCommandList& commandList
 ) {
-	// Set render target
 	auto pRTV = &m_rtv;
 	commandList.SetResourceState(m_rtv.GetResource(), 0, gxapi::eResourceState::RENDER_TARGET);
 	commandList.SetRenderTargets(1, &pRTV, &dsv);
-	commandList.ClearRenderTarget(m_rtv, gxapi::ColorRGBA(0, 0, 0, 1));
 
 	gxapi::Rectangle rect{ 0, (int)m_rtv.GetResource().GetHeight(), 0, (int)m_rtv.GetResource().GetWidth() };
 	gxapi::Viewport viewport;
@@ -237,52 +433,194 @@ void ForwardRender::RenderScene(
 	commandList.SetGraphicsBinder(&m_binder);
 	commandList.SetPrimitiveTopology(gxapi::ePrimitiveTopology::TRIANGLELIST);
 
-	mathfu::Matrix4x4f view = camera->GetViewMatrixRH();
-	mathfu::Matrix4x4f projection = camera->GetPerspectiveMatrixRH();
+	// All textures are bound at once, draws only set the index of theirs
+	assert(m_graphicsContext.GetTextureTable() != nullptr);
+	commandList.BindGraphics(m_albedoBindParam, *m_graphicsContext.GetTextureTable());
+
+	std::array<mathfu::VectorPacked<float, 4>, 4> viewProjectionData;
+	viewProjection.Pack(viewProjectionData.data());
+	commandList.BindGraphics(m_viewProjectionBindParam, viewProjectionData.data(), sizeof(viewProjectionData), 0);
+
+	std::array<mathfu::VectorPacked<float, 4>, 2> sunCBData;
+	auto sunDir = mathfu::Vector4f(sun->GetDirection(), 0.0);
+	auto sunColor = mathfu::Vector4f(sun->GetColor(), 0.0);
+
+	sunDir.Pack(sunCBData.data());
+	sunColor.Pack(sunCBData.data() + 1);
+	commandList.BindGraphics(m_sunBindParam, sunCBData.data(), sizeof(sunCBData), 0);
+
+	ConstBufferView shadowCbv = m_graphicsContext.CreateCbv(shadowBuffer, 0, sizeof(mathfu::VectorPacked<float, 4>) * ShadowDataSize, viewHeap);
+	commandList.BindGraphics(m_shadowBindParam, shadowCbv);
+	if (shadowCascades) {
+		// each cascade is a slice, the shadow map has no mips
+		Texture2D& shadowMap = const_cast<Texture2D&>(shadowCascades->shadowMaps.GetResource());
+		for (unsigned i = 0; i < shadowMap.GetArrayCount(); ++i) {
+			commandList.SetResourceState(shadowMap, i, gxapi::eResourceState::PIXEL_SHADER_RESOURCE);
+		}
+		commandList.BindGraphics(m_shadowMapBindParam, shadowCascades->shadowMaps);
+	}
 
-	auto viewProjection = projection * view;
+	ConstBufferView lightCbv = m_graphicsContext.CreateCbv(lightBuffer, 0, sizeof(uint32_t) * LightDataSize, viewHeap);
+	commandList.BindGraphics(m_lightsBindParam, lightCbv);
+}
+
+
+void ForwardRender::PackLights(const LightClusters* lightClusters) {
+	m_lightData.assign(LightDataSize, 0);
+	auto packFloat = [this](size_t word, float value) {
+		std::memcpy(&m_lightData[word], &value, sizeof(value));
+	};
+	auto packVector = [&packFloat](size_t word, const mathfu::Vector3f& value, float w) {
+		packFloat(word, value.x());
+		packFloat(word + 1, value.y());
+		packFloat(word + 2, value.z());
+		packFloat(word + 3, w);
+	};
 
-	{
-		std::array<mathfu::VectorPacked<float, 4>, 2> sunCBData;
-		auto sunDir = mathfu::Vector4f(sun->GetDirection(), 0.0);
-		auto sunColor = mathfu::Vector4f(sun->GetColor(), 0.0);
+	// Pixels find their tile from their position on screen and their slice from their view distance
+	packFloat(0, float(LightClusterTilesX) / m_width);
+	packFloat(1, float(LightClusterTilesY) / m_height);
+	m_lightData[4] = LightClusterTilesX;
+	m_lightData[5] = LightClusterTilesY;
+	m_lightData[6] = LightClusterSlices;
+	if (lightClusters == nullptr) {
+		return;
+	}
+	assert(lightClusters->GetNumClusters() == LightClusterCount);
+	packFloat(2, lightClusters->GetSliceScale());
+	packFloat(3, lightClusters->GetSliceBias());
+
+	// Lights are position and range, color and cosine of the cone's angle, direction,
+	// point lights have an angle that spot lights cannot have
+	const auto& pointLights = lightClusters->GetPointLights();
+	const auto& spotLights = lightClusters->GetSpotLights();
+	size_t numLights = std::min(pointLights.size() + spotLights.size(), MaxClusteredLights);
+	m_lightData[7] = (uint32_t)numLights;
+	for (size_t i = 0; i < numLights; ++i) {
+		size_t word = LightsOffset + 12 * i;
+		if (i < pointLights.size()) {
+			packVector(word, pointLights[i]->GetPosition(), pointLights[i]->GetRange());
+			packVector(word + 4, pointLights[i]->GetColor(), -2.0f);
+			packVector(word + 8, { 0, 0, 0 }, 0.0f);
+		}
+		else {
+			const SpotLight* light = spotLights[i - pointLights.size()];
+			packVector(word, light->GetPosition(), light->GetRange());
+			packVector(word + 4, light->GetColor(), std::cos(light->GetAngle()));
+			packVector(word + 8, light->GetDirection(), 0.0f);
+		}
+	}
 
-		sunDir.Pack(sunCBData.data());
-		sunColor.Pack(sunCBData.data() + 1);
-		commandList.BindGraphics(m_sunBindParam, sunCBData.data(), sizeof(sunCBData), 0);
+	const std::vector<uint32_t>& offsets = lightClusters->GetOffsets();
+	const std::vector<uint32_t>& counts = lightClusters->GetCounts();
+	const std::vector<uint32_t>& lightIndices = lightClusters->GetLightIndices();
+	size_t numIndices = std::min(lightIndices.size(), MaxClusteredLightIndices);
+	for (size_t cluster = 0; cluster < LightClusterCount; ++cluster) {
+		uint32_t count = (uint32_t)std::min<size_t>(counts[cluster], numIndices - std::min<size_t>(offsets[cluster], numIndices));
+		m_lightData[ClustersOffset + cluster] = offsets[cluster] | (count << 16);
 	}
-	
-	std::vector<const gxeng::VertexBuffer*> vertexBuffers;
-	std::vector<unsigned> sizes;
-	std::vector<unsigned> strides;
-
-	// Iterate over all entities
-	for (const MeshEntity* entity : entities) {
-		// Get entity parameters
-		Mesh* mesh = entity->GetMesh();
-		auto position = entity->GetPosition();
-
-		// Draw mesh
-		if (!CheckMeshFormat(*mesh)) {
+	for (size_t i = 0; i < numIndices; ++i) {
+		m_lightData[LightIndicesOffset + i / 2] |= (lightIndices[i] & 0xFFFF) << (16 * (i % 2));
+	}
+}
+
+
+std::shared_ptr<GraphicsBundle> ForwardRender::RecordGroup(const StaticDrawCache::Group& group) {
+	// Sort the group's draws by mesh, the order does not follow the camera, the texture is the group's
+	m_groupPackets.Clear();
+	for (size_t i = 0; i < group.entities.size(); ++i) {
+		if (!CheckMeshFormat(*group.entities[i]->GetMesh())) {
 			continue;
 		}
+		m_groupPackets.Add((uint32_t)i, 0, group.entities[i]->GetMesh(), nullptr, 0.0f);
+	}
+	m_groupPackets.Build(MaxInstancesPerDraw);
+	const std::vector<DrawPacket>& packets = m_groupPackets.GetPackets();
+	const std::vector<DrawPacketBuilder::Batch>& batches = m_groupPackets.GetBatches();
+
+	// The transforms of all batches go into one buffer that lives as long as the bundle
+	constexpr size_t alignment = ConstantBufferAlignment / sizeof(mathfu::VectorPacked<float, 4>);
+	std::vector<mathfu::VectorPacked<float, 4>> instanceData;
+	std::vector<size_t> batchOffsets;
+	for (const DrawPacketBuilder::Batch& batch : batches) {
+		size_t offset = instanceData.size();
+		batchOffsets.push_back(offset * sizeof(instanceData[0]));
+		instanceData.resize(offset + (batch.count * 8 + alignment - 1) / alignment * alignment);
+		for (uint32_t i = 0; i < batch.count; ++i) {
+			const MeshEntity* entity = group.entities[packets[batch.first + i].index];
+			const MeshEntityStore& store = entity->GetStore();
+			size_t storeIndex = entity->GetStoreIndex();
+			store.WorldMatrix(storeIndex).Pack(&instanceData[offset + i * 8]);
+			store.NormalMatrix(storeIndex).Pack(&instanceData[offset + i * 8 + 4]);
+		}
+	}
+
+	std::shared_ptr<GraphicsBundle> bundle = m_graphicsContext.CreateBundle();
+	if (!batches.empty()) {
+		PersistentConstBuffer instanceBuffer = m_graphicsContext.CreatePersistentConstBuffer(instanceData.data(), instanceData.size() * sizeof(instanceData[0]));
+		bundle->SetPipelineState(m_PSO.get());
+		bundle->SetGraphicsBinder(&m_binder);
+		bundle->SetPrimitiveTopology(gxapi::ePrimitiveTopology::TRIANGLELIST);
+
+		// The texture table is inherited from the command list, the index stays valid while the texture exists
+		uint32_t textureIndex = group.texture->GetTableIndex();
+		bundle->BindGraphics(m_textureIndexBindParam, &textureIndex, sizeof(textureIndex), 0);
+
+		std::vector<const gxeng::VertexBuffer*> vertexBuffers;
+		std::vector<unsigned> sizes;
+		std::vector<unsigned> strides;
+		for (size_t batchIndex = 0; batchIndex < batches.size(); ++batchIndex) {
+			const DrawPacketBuilder::Batch& batch = batches[batchIndex];
+			Mesh* mesh = group.entities[packets[batch.first].index]->GetMesh();
+
+			bundle->BindGraphics(m_transformBindParam, instanceBuffer, batchOffsets[batchIndex]);
+			ConvertToSubmittable(mesh, vertexBuffers, sizes, strides);
+			bundle->SetVertexBuffers(0, (unsigned)vertexBuffers.size(), vertexBuffers.data(), sizes.data(), strides.data());
+			bundle->SetIndexBuffer(&mesh->GetIndexBuffer(), mesh->GetIndexBuffer32Bit());
+
+			// Meshlets can't be culled for a camera that is not known yet, all of them are drawn
+			if (mesh->HasMeshlets()) {
+				for (const MeshletDraw& draw : mesh->GetMeshlets().GetDraws()) {
+					bundle->DrawIndexedInstanced(draw.numIndices, draw.firstIndex, (int)draw.baseVertex, batch.count);
+				}
+			}
+			else {
+				bundle->DrawIndexedInstanced((unsigned)mesh->GetIndexBuffer().GetIndexCount(), 0, 0, batch.count);
+			}
+		}
+	}
+	bundle->Close();
+	return bundle;
+}
+
 
-		ConvertToSubmittable(mesh, vertexBuffers, sizes, strides);
+void ForwardRender::RecordDraws(size_t firstBatch, size_t endBatch, const mathfu::Vector3f& eye, VolatileViewHeap& viewHeap, GraphicsCommandList& commandList) {
+	const std::vector<DrawPacket>& packets = m_drawPackets.GetPackets();
+	const std::vector<DrawPacketBuilder::Batch>& batches = m_drawPackets.GetBatches();
 
-		auto world = entity->GetTransform();
-		auto MVP = viewProjection * world;
-		auto worldInvTr = world.Inverse().Transpose();
+	MeshDrawRecorder recorder(m_graphicsContext, viewHeap, commandList, m_meshletSignature.get());
 
-		std::array<mathfu::VectorPacked<float, 4>, 8> transformCBData;
-		MVP.Pack(transformCBData.data());
-		worldInvTr.Pack(transformCBData.data() + 4);
+	for (size_t batchIndex = firstBatch; batchIndex < endBatch; ++batchIndex) {
+		const DrawPacketBuilder::Batch& batch = batches[batchIndex];
+		const MeshEntity* firstEntity = m_drawEntities[packets[batch.first].index];
+		Image* texture = firstEntity->GetTexture();
+		const MeshEntityStore& store = firstEntity->GetStore();
+
+		// An instance's transforms are its world and normal matrices
+		mathfu::VectorPacked<float, 4>* instanceData = recorder.AllocateInstanceData(batch.count * 8);
+		for (uint32_t i = 0; i < batch.count; ++i) {
+			size_t storeIndex = m_drawEntities[packets[batch.first + i].index]->GetStoreIndex();
+			store.WorldMatrix(storeIndex).Pack(&instanceData[i * 8]);
+			store.NormalMatrix(storeIndex).Pack(&instanceData[i * 8 + 4]);
+		}
+		recorder.BindInstanceData(m_transformBindParam);
 
-		commandList.BindGraphics(m_albedoBindParam, *entity->GetTexture()->GetSrv());
-		commandList.BindGraphics(m_transformBindParam, transformCBData.data(), sizeof(transformCBData), 0);
+		// Only the index is set, repeated indices are filtered by the command list
+		uint32_t textureIndex = texture->GetTableIndex();
+		commandList.BindGraphics(m_textureIndexBindParam, &textureIndex, sizeof(textureIndex), 0);
 
-		commandList.SetVertexBuffers(0, (unsigned)vertexBuffers.size(), vertexBuffers.data(), sizes.data(), strides.data());
-		commandList.SetIndexBuffer(&mesh->GetIndexBuffer(), mesh->GetIndexBuffer32Bit());
-		commandList.DrawIndexedInstanced((unsigned)mesh->GetIndexBuffer().GetIndexCount());
+		size_t storeIndex = firstEntity->GetStoreIndex();
+		recorder.Draw(firstEntity->GetMesh(), batch.count, m_mvps[storeIndex], store.WorldMatrix(storeIndex), &eye);
 	}
 }
 
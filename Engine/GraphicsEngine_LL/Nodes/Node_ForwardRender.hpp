@@ -3,6 +3,7 @@
 #include "../GraphicsNode.hpp"
 
 #include "Node_GenCSM.hpp"
+#include "Node_ClusterLights.hpp"
 
 #include "../Scene.hpp"
 #include "../Camera.hpp"
@@ -11,15 +12,19 @@
 #include "../GraphicsContext.hpp"
 #include "../PipelineTypes.hpp"
 #include "../WindowResizeListener.hpp"
+#include "../DrawPackets.hpp"
+#include "../MeshDrawRecorder.hpp"
+#include "../StaticDrawCache.hpp"
 #include "GraphicsApi_LL/IPipelineState.hpp"
+#include "GraphicsApi_LL/ICommandSignature.hpp"
 #include "GraphicsApi_LL/IGxapiManager.hpp"
 
 namespace inl::gxeng::nodes {
 
 class ForwardRender :
 	virtual public GraphicsNode,
-	// Inputs: depth stencil (from depth prepass), geometry, camera, sun
-	virtual public exc::InputPortConfig<pipeline::Texture2D, const EntityCollection<MeshEntity>*, const Camera*, const DirectionalLight*>,
+	// Inputs: depth stencil (from depth prepass), geometry, camera, sun, sun's shadow, point and spot lights
+	virtual public exc::InputPortConfig<pipeline::Texture2D, const EntityCollection<MeshEntity>*, const Camera*, const DirectionalLight*, const ShadowCascades*, const LightClusters*>,
 	virtual public exc::OutputPortConfig<pipeline::Texture2D>,
 	public WindowResizeListener
 {
@@ -28,6 +33,7 @@ public:
 
 	void Update() override {}
 	void Notify(exc::InputPortBase* sender) override {}
+	void RequestShaders(const GraphicsContext& context) override;
 	void InitGraphics(const GraphicsContext& context) override;
 
 	Task GetTask() override;
@@ -46,8 +52,23 @@ protected:
 	Binder m_binder;
 	BindParameter m_transformBindParam;
 	BindParameter m_sunBindParam;
-	BindParameter m_albedoBindParam;
-	std::unique_ptr<gxapi::IPipelineState> m_PSO;
+	BindParameter m_albedoBindParam; // all textures, see TextureTable
+	BindParameter m_textureIndexBindParam;
+	BindParameter m_shadowBindParam;
+	BindParameter m_shadowMapBindParam;
+	BindParameter m_lightsBindParam;
+	BindParameter m_viewProjectionBindParam;
+	std::shared_ptr<gxapi::IPipelineState> m_PSO;
+	std::unique_ptr<gxapi::ICommandSignature> m_meshletSignature;
+
+	std::vector<mathfu::Matrix4x4f> m_mvps;
+	std::vector<const MeshEntity*> m_drawEntities;
+	DrawPacketBuilder m_drawPackets;
+	std::vector<uint32_t> m_lightData;
+
+	StaticDrawCache m_staticDraws;
+	std::vector<std::shared_ptr<GraphicsBundle>> m_groupBundles; // indexed by group
+	DrawPacketBuilder m_groupPackets;
 
 private:
 	void InitRenderTarget();
@@ -56,7 +77,22 @@ private:
 		const EntityCollection<MeshEntity>& entities,
 		const Camera* camera,
 		const DirectionalLight* sun,
+		const ShadowCascades* shadowCascades,
+		const LightClusters* lightClusters,
+		const ExecutionContext& context,
+		ExecutionResult& result);
+	void PackLights(const LightClusters* lightClusters);
+	void SetRenderState(
+		DepthStencilView2D& dsv,
+		const mathfu::Matrix4x4f& viewProjection,
+		const DirectionalLight* sun,
+		const ShadowCascades* shadowCascades,
+		VolatileConstBuffer& shadowBuffer,
+		VolatileConstBuffer& lightBuffer,
+		VolatileViewHeap& viewHeap,
 		GraphicsCommandList& commandList);
+	std::shared_ptr<GraphicsBundle> RecordGroup(const StaticDrawCache::Group& group);
+	void RecordDraws(size_t firstBatch, size_t endBatch, const mathfu::Vector3f& eye, VolatileViewHeap& viewHeap, GraphicsCommandList& commandList);
 };
 
 } // namespace inl::gxeng::nodes
@@ -0,0 +1,102 @@
+#include "Node_FrustumCull.hpp"
+
+#include "../MeshEntity.hpp"
+#include "../Mesh.hpp"
+
+
+namespace inl::gxeng::nodes {
+
+
+FrustumCull::FrustumCull() {
+	this->GetInput<0>().Set({});
+	this->GetInput<1>().Set({});
+	this->GetInput<2>().Set({});
+}
+
+
+Task FrustumCull::GetTask() {
+	return Task({ [this](const ExecutionContext& context) {
+		const EntityCollection<MeshEntity>* entities = this->GetInput<0>().Get();
+		this->GetInput<0>().Clear();
+
+		const Camera* camera = this->GetInput<1>().Get();
+		this->GetInput<1>().Clear();
+
+		const Scene* scene = this->GetInput<2>().Get();
+		this->GetInput<2>().Clear();
+
+		if (entities == nullptr && scene == nullptr) {
+			this->GetOutput<0>().Set(nullptr);
+			return ExecutionResult{};
+		}
+
+		if (camera == nullptr && scene == nullptr) {
+			this->GetOutput<0>().Set(entities);
+			return ExecutionResult{};
+		}
+
+		Cull(entities, scene, camera);
+		this->GetOutput<0>().Set(&m_visibleEntities);
+
+		return ExecutionResult{};
+	} });
+}
+
+
+void FrustumCull::Cull(const EntityCollection<MeshEntity>* entities, const Scene* scene, const Camera* camera) {
+	Frustum frustum = camera != nullptr ? Frustum(camera->GetPerspectiveMatrixRH() * camera->GetViewMatrixRH()) : Frustum();
+
+	m_candidates.clear();
+	m_centersX.clear();
+	m_centersY.clear();
+	m_centersZ.clear();
+	m_radii.clear();
+
+	// The spatial index skips the scene's entities far from the frustum, but tests the entities
+	// of its leaves together, so they are tested one by one below.
+	if (scene != nullptr) {
+		m_indexedEntities.clear();
+		scene->QueryMeshEntities(frustum, m_indexedEntities);
+		for (MeshEntity* entity : m_indexedEntities) {
+			AddCandidate(entity);
+		}
+	}
+	if (entities != nullptr) {
+		for (MeshEntity* entity : *entities) {
+			AddCandidate(entity);
+		}
+	}
+
+	m_visibleIndices.resize(m_candidates.size());
+	size_t numVisible = CullSpheres(frustum,
+									m_centersX.data(),
+									m_centersY.data(),
+									m_centersZ.data(),
+									m_radii.data(),
+									m_candidates.size(),
+									m_visibleIndices.data());
+
+	m_visibleEntities.Clear();
+	for (size_t i = 0; i < numVisible; ++i) {
+		m_visibleEntities.Add(m_candidates[m_visibleIndices[i]]);
+	}
+}
+
+
+void FrustumCull::AddCandidate(MeshEntity* entity) {
+	// Gather world space bounds, entities without a mesh have nothing to draw.
+	const Mesh* mesh = entity->GetMesh();
+	if (mesh == nullptr) {
+		return;
+	}
+
+	BoundingSphere sphere = TransformSphere(mesh->GetBoundingSphere(), entity->GetTransform());
+	m_candidates.push_back(entity);
+	m_centersX.push_back(sphere.center.x());
+	m_centersY.push_back(sphere.center.y());
+	m_centersZ.push_back(sphere.center.z());
+	m_radii.push_back(sphere.radius);
+}
+
+
+} // namespace inl::gxeng::nodes
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "../GraphicsNode.hpp"
+
+#include "../Scene.hpp"
+#include "../Camera.hpp"
+#include "../FrustumCulling.hpp"
+
+#include <vector>
+
+
+namespace inl::gxeng::nodes {
+
+
+/// <summary>
+/// Filters out the mesh entities that are outside the camera's view frustum.
+/// </summary>
+/// <remarks>
+/// If the scene is given, its mesh entities are found through the scene's spatial index, so entities far
+/// outside the frustum are not visited at all, and the geometry input only holds the entities that are not
+/// in the scene, like terrain chunks. Entities are tested by the bounding sphere of their mesh transformed to world space.
+/// The output collection is owned by the node and rebuilt every frame.
+/// </remarks>
+class FrustumCull :
+	virtual public GraphicsNode,
+	// Inputs: geometry, camera, scene (optional)
+	virtual public exc::InputPortConfig<const EntityCollection<MeshEntity>*, const Camera*, const Scene*>,
+	// Outputs: visible geometry
+	virtual public exc::OutputPortConfig<const EntityCollection<MeshEntity>*>
+{
+public:
+	FrustumCull();
+
+	void Update() override {}
+	void Notify(exc::InputPortBase* sender) override {}
+	void InitGraphics(const GraphicsContext& context) override {}
+
+	Task GetTask() override;
+
+private:
+	/// <summary> Everything is visible without a camera. </summary>
+	void Cull(const EntityCollection<MeshEntity>* entities, const Scene* scene, const Camera* camera);
+	void AddCandidate(MeshEntity* entity);
+private:
+	EntityCollection<MeshEntity> m_visibleEntities;
+	std::vector<MeshEntity*> m_indexedEntities; // entities of the scene found by its spatial index
+
+	// world space bounding spheres of the tested entities, as separate components for SIMD
+	std::vector<MeshEntity*> m_candidates;
+	std::vector<float> m_centersX;
+	std::vector<float> m_centersY;
+	std::vector<float> m_centersZ;
+	std::vector<float> m_radii;
+	std::vector<uint32_t> m_visibleIndices;
+};
+
+
+} // namespace inl::gxeng::nodes
@@ -1,23 +1,31 @@
 #include "Node_GenCSM.hpp"
 
-#include "../DirectionalLight.hpp"
 #include "../MeshEntity.hpp"
 #include "../Mesh.hpp"
-#include "../Image.hpp"
-#include "../GraphicsEngine.hpp"
+#include "../BoundingVolume.hpp"
+#include "../ParallelRecording.hpp"
 
 #include <GraphicsApi_LL/IGxapiManager.hpp>
 
 #include <mathfu/matrix_4x4.h>
 
-#include <array>
+#include <algorithm>
 
 
-// OBSOLETE, please update
-#if 0
 namespace inl::gxeng::nodes {
 
 
+// Shader of the node, requested up front and created by InitGraphics
+static constexpr const char* ShaderName = "GenCSM";
+
+
+// An instance's transform is an MVP, the instances of a draw must fit into a 64 KiB constant buffer.
+static constexpr uint32_t MaxInstancesPerDraw = 65536 / (sizeof(float) * 4 * 4);
+
+// How far towards the sun from a cascade's part of the view entities still cast shadows into it.
+static constexpr float CasterDistance = 100.0f;
+
+
 static bool CheckMeshFormat(const Mesh& mesh) {
 	for (size_t i = 0; i < mesh.GetNumStreams(); i++) {
 		auto& elements = mesh.GetVertexBufferElements(i);
@@ -31,143 +39,47 @@ static bool CheckMeshFormat(const Mesh& mesh) {
 }
 
 
-static void ConvertToSubmittable(
-	Mesh* mesh,
-	std::vector<const gxeng::VertexBuffer*>& vertexBuffers,
-	std::vector<unsigned>& sizes,
-	std::vector<unsigned>& strides
-) {
-	vertexBuffers.clear();
-	sizes.clear();
-	strides.clear();
-
-	for (int streamID = 0; streamID < mesh->GetNumStreams(); streamID++) {
-		vertexBuffers.push_back(&mesh->GetVertexBuffer(streamID));
-		sizes.push_back((unsigned)vertexBuffers.back()->GetSize());
-		strides.push_back((unsigned)mesh->GetVertexBufferStride(streamID));
-	}
-
-	assert(vertexBuffers.size() == sizes.size());
-	assert(sizes.size() == strides.size());
-}
-
-
-mathfu::Matrix4x4f LightViewTransform(const DirectionalLight * light) {
-	auto dir = -light->GetDirection();
-
-	auto z = dir;
-	auto x = mathfu::Vector3f::CrossProduct({ 0, 1, 0 }, z);
-	if (x.LengthSquared() < 0.0001f) {
-		x = mathfu::Vector3f(1, 0, 0);
-	}
-	else {
-		x.Normalize();
+GenCSM::GenCSM(gxapi::IGraphicsApi* graphicsApi, unsigned resolution, unsigned numCascades) :
+	m_binder(graphicsApi, {}),
+	m_resolution(resolution),
+	m_numCascades(numCascades)
+{
+	if (numCascades == 0 || numCascades > MaxShadowCascades) {
+		throw std::invalid_argument("[GenCSM] Number of cascades must be between 1 and MaxShadowCascades.");
 	}
-	auto y = mathfu::Vector3f::CrossProduct(z, x);
-
-	return mathfu::Matrix4x4f(x.x(), x.y(), x.z(), 0, y.x(), y.y(), y.z(), 0, z.x(), z.y(), z.z(), 0, 0, 0, 0, 1).Inverse();
-}
 
+	this->GetInput<0>().Set({});
+	this->GetInput<1>().Set({});
+	this->GetInput<2>().Set({});
+	this->GetInput<3>().Set({});
 
-mathfu::Matrix4x4f LightDirectionalProjectionTransform(const mathfu::Matrix4x4f & lightViewTransform, const Camera * camera) {
-	// Get camera frustum in world space than transform it to sun view space and fit an aabb on it.
-	// This aabb is the ortho proj.
+	m_drawPackets.resize(numCascades);
 
-	const std::array<mathfu::Vector4f, 8> camFrustum = {
-		// near plane
-		mathfu::Vector4f(-1.f, -1.f, -0.f, 1.f),
-		mathfu::Vector4f(+1.f, -1.f, -0.f, 1.f),
-		mathfu::Vector4f(+1.f, +1.f, -0.f, 1.f),
-		mathfu::Vector4f(-1.f, +1.f, -0.f, 1.f),
-
-		// far plane
-		mathfu::Vector4f(-1.f, -1.f, +1.f, 1.f),
-		mathfu::Vector4f(+1.f, -1.f, +1.f, 1.f),
-		mathfu::Vector4f(+1.f, +1.f, +1.f, 1.f),
-		mathfu::Vector4f(-1.f, +1.f, +1.f, 1.f)
-	};
+	BindParameterDesc transformBindParamDesc;
+	m_transformBindParam = BindParameter(eBindParameterType::CONSTANT, 0);
+	transformBindParamDesc.parameter = m_transformBindParam;
+	transformBindParamDesc.constantSize = 0; // instance transforms are in a constant buffer
+	transformBindParamDesc.relativeAccessFrequency = 0;
+	transformBindParamDesc.relativeChangeFrequency = 0;
+	transformBindParamDesc.shaderVisibility = gxapi::eShaderVisiblity::VERTEX;
 
-	auto camProjToWorld = (camera->GetPerspectiveMatrixRH() * camera->GetViewMatrixRH()).Inverse();
-	auto transform = lightViewTransform * camProjToWorld;
-
-	mathfu::Vector4f aabbMin = mathfu::Vector4f(INFINITY, INFINITY, INFINITY, INFINITY);
-	mathfu::Vector4f aabbMax = -aabbMin;
-
-	for (const auto& curr : camFrustum) {
-		auto v = transform * curr;
-		float w = v.w();
-		v /= w;
-		aabbMin = mathfu::Vector4f::Min(aabbMin, v);
-		aabbMax = mathfu::Vector4f::Max(aabbMax, v);
-	}
+	m_binder = Binder{ graphicsApi,{ transformBindParamDesc },{} };
 
-	float depth = aabbMax.z() - aabbMin.z();
-
-	// RIGHT HANDED
-	return mathfu::Matrix4x4f::Ortho(aabbMin.x(), aabbMax.x(), aabbMin.y(), aabbMax.y(), aabbMax.z() + depth, aabbMin.z(), 1.f);
+	m_meshletSignature = MeshDrawRecorder::CreateMeshletSignature(graphicsApi);
 }
 
 
-GenCSM::GenCSM(
-	gxapi::IGraphicsApi* graphicsApi,
-	unsigned width,
-	unsigned height
-) :
-	m_width(width),
-	m_height(height),
-	m_binder(graphicsApi, {})
-{
-	this->GetInput<0>().Set(nullptr);
-
-	m_cascades.subCameras.resize(m_cascadeCount);
-
-	BindParameterDesc cbBindParamDesc;
-	m_cbBindParam = BindParameter(eBindParameterType::CONSTANT, 0);
-	cbBindParamDesc.parameter = m_cbBindParam;
-	cbBindParamDesc.constantSize = sizeof(float) * 4 * 4;
-	cbBindParamDesc.relativeAccessFrequency = 0;
-	cbBindParamDesc.relativeChangeFrequency = 0;
-	cbBindParamDesc.shaderVisibility = gxapi::eShaderVisiblity::VERTEX;
-
-	BindParameterDesc texBindParamDesc;
-	m_texBindParam = BindParameter(eBindParameterType::TEXTURE, 0);
-	texBindParamDesc.parameter = m_texBindParam;
-	texBindParamDesc.constantSize = 0;
-	texBindParamDesc.relativeAccessFrequency = 0;
-	texBindParamDesc.relativeChangeFrequency = 0;
-	texBindParamDesc.shaderVisibility = gxapi::eShaderVisiblity::PIXEL;
-
-	BindParameterDesc sampBindParamDesc;
-	sampBindParamDesc.parameter = BindParameter(eBindParameterType::SAMPLER, 0);
-	sampBindParamDesc.constantSize = 0;
-	sampBindParamDesc.relativeAccessFrequency = 0;
-	sampBindParamDesc.relativeChangeFrequency = 0;
-	sampBindParamDesc.shaderVisibility = gxapi::eShaderVisiblity::PIXEL;
-
-	gxapi::StaticSamplerDesc samplerDesc;
-	samplerDesc.shaderRegister = 0;
-	samplerDesc.filter = gxapi::eTextureFilterMode::MIN_MAG_MIP_LINEAR;
-	samplerDesc.addressU = gxapi::eTextureAddressMode::WRAP;
-	samplerDesc.addressV = gxapi::eTextureAddressMode::WRAP;
-	samplerDesc.addressW = gxapi::eTextureAddressMode::WRAP;
-	samplerDesc.mipLevelBias = 0.f;
-	samplerDesc.registerSpace = 0;
-	samplerDesc.shaderVisibility = gxapi::eShaderVisiblity::PIXEL;
-
-	m_binder = Binder{ graphicsApi,{ cbBindParamDesc, texBindParamDesc, sampBindParamDesc },{ samplerDesc } };
+void GenCSM::RequestShaders(const GraphicsContext& context) {
+	context.RequestShader(ShaderName, ShaderParts::VertexPixel(), "");
 }
 
 
 void GenCSM::InitGraphics(const GraphicsContext& context) {
 	m_graphicsContext = context;
 
-	InitBuffers();
-
-	ShaderParts shaderParts;
-	shaderParts.vs = true;
-	shaderParts.ps = true;
+	InitShadowMaps();
 
-	auto shader = m_graphicsContext.CreateShader("GenCSM", shaderParts, "");
+	auto shader = m_graphicsContext.CreateShader(ShaderName, ShaderParts::VertexPixel(), "");
 
 	std::vector<gxapi::InputElementDesc> inputElementDesc = {
 		gxapi::InputElementDesc("POSITION", 0, gxapi::eFormat::R32G32B32_FLOAT, 0, 0),
@@ -181,26 +93,36 @@ void GenCSM::InitGraphics(const GraphicsContext& context) {
 	psoDesc.rootSignature = m_binder.GetRootSignature();
 	psoDesc.vs = shader.vs;
 	psoDesc.ps = shader.ps;
+	// back faces go into the shadow map, so lit front faces don't shadow themselves
 	psoDesc.rasterization = gxapi::RasterizerState(gxapi::eFillMode::SOLID, gxapi::eCullMode::DRAW_CW);
 	psoDesc.primitiveTopologyType = gxapi::ePrimitiveTopologyType::TRIANGLE;
-	psoDesc.blending.multiTarget[0].enableBlending = false;
-	psoDesc.blending.multiTarget[0].enableLogicOp = false;
-	psoDesc.blending.multiTarget[1].enableBlending = false;
-	psoDesc.blending.multiTarget[1].enableLogicOp = false;
 
 	psoDesc.depthStencilState = gxapi::DepthStencilState(true, true);
+	psoDesc.depthStencilState.enableStencilTest = false;
+
 	psoDesc.depthStencilFormat = gxapi::eFormat::D32_FLOAT;
 
 	psoDesc.numRenderTargets = 0;
 
-	m_PSO.reset(m_graphicsContext.CreatePSO(psoDesc));
+	m_PSO = m_graphicsContext.CreatePSO(psoDesc);
 }
 
 
 Task GenCSM::GetTask() {
-	return Task({ [this](const ExecutionContext& context) {
+	// The scheduler runs the subtasks of a task one after the other,
+	// so the cascades are recorded on threads of their own by the second subtask.
+	ElementaryTask recordCascades = [this](const ExecutionContext& context) {
 		ExecutionResult result;
+		RecordInParallel(context, result, m_shadowCascades.cascades.size(), 1,
+			[this](GraphicsCommandList& commandList, VolatileViewHeap& viewHeap, size_t firstCascade, size_t endCascade) {
+				for (size_t cascadeIndex = firstCascade; cascadeIndex < endCascade; ++cascadeIndex) {
+					RenderCascade((unsigned)cascadeIndex, commandList, viewHeap);
+				}
+			});
+		return result;
+	};
 
+	ElementaryTask cullCascades = [this](const ExecutionContext& context) {
 		const Camera* camera = this->GetInput<0>().Get();
 		this->GetInput<0>().Clear();
 
@@ -210,140 +132,169 @@ Task GenCSM::GetTask() {
 		const EntityCollection<MeshEntity>* entities = this->GetInput<2>().Get();
 		this->GetInput<2>().Clear();
 
-		if (entities) {
-			GraphicsCommandList cmdList = context.GetGraphicsCommandList();
-			RenderScene(camera, sun, *entities, context.GetFrameNumber(), cmdList);
-			result.AddCommandList(std::move(cmdList));
-		}
-
-		this->GetOutput<0>().Set(&m_cascades);
+		const Scene* scene = this->GetInput<3>().Get();
+		this->GetInput<3>().Clear();
 
-		return result;
-	} });
-}
+		CullCascades(camera, sun, entities, scene);
+		this->GetOutput<0>().Set(&m_shadowCascades);
 
+		return ExecutionResult{};
+	};
 
-void GenCSM::SetShadowMapSize(unsigned width, unsigned height) {
-	m_width = width;
-	m_height = height;
-	InitBuffers();
+	Task task;
+	task.InitSequential({ cullCascades, recordCascades });
+	return task;
 }
 
 
-void GenCSM::InitBuffers() {
+void GenCSM::InitShadowMaps() {
 	using gxapi::eFormat;
 
-	m_cascades.mapArray = DepthStencilArrayPack(
-		m_width,
-		m_height,
-		m_cascadeCount,
-		eFormat::D32_FLOAT,
-		eFormat::R32_FLOAT,
-		eFormat::R32_TYPELESS,
-		m_graphicsContext);
+	Texture2D tex = m_graphicsContext.CreateDepthStencil2D(m_resolution, m_resolution, eFormat::R32_TYPELESS, true, (uint16_t)m_numCascades);
+
+	m_dsvs.clear();
+	for (unsigned cascadeIndex = 0; cascadeIndex < m_numCascades; ++cascadeIndex) {
+		gxapi::DsvTexture2DArray dsvDesc;
+		dsvDesc.activeArraySize = 1;
+		dsvDesc.firstArrayElement = cascadeIndex;
+		dsvDesc.firstMipLevel = 0;
+		m_dsvs.push_back(m_graphicsContext.CreateDsv(tex, eFormat::D32_FLOAT, dsvDesc));
+	}
+
+	gxapi::SrvTexture2DArray srvDesc;
+	srvDesc.activeArraySize = m_numCascades;
+	srvDesc.firstArrayElement = 0;
+	srvDesc.numMipLevels = -1;
+	srvDesc.mipLevelClamping = 0;
+	srvDesc.mostDetailedMip = 0;
+	srvDesc.planeIndex = 0;
+	m_shadowCascades.shadowMaps = m_graphicsContext.CreateSrv(tex, eFormat::R32_FLOAT, srvDesc);
 }
 
 
-Camera& GenCSM::CalculateSubCamera(const Camera* camera, unsigned cascadeID) {
-	// maps every x in range [0, 1] to an exponentialy
-	// increasing curve in the range [0, 1]
-	auto Exponential = [](float x) {
-		constexpr float steepness = 32;
-		return (std::pow(steepness, x) - 1.f) / (steepness - 1.f);
-	};
+void GenCSM::CullCascades(const Camera* camera, const DirectionalLight* sun, const EntityCollection<MeshEntity>* entities, const Scene* scene) {
+	m_shadowCascades.cascades.clear();
+	m_casters.clear();
+
+	if (camera == nullptr || sun == nullptr || (entities == nullptr && scene == nullptr)) {
+		return;
+	}
+
+	// Fit the cascades on the camera's frustum
+	std::vector<float> splits = ComputeCascadeSplits(camera->GetNearPlane(), camera->GetFarPlane(), m_numCascades);
+	mathfu::Matrix4x4f lightView = LightViewTransform(sun->GetDirection());
+	for (unsigned cascadeIndex = 0; cascadeIndex < m_numCascades; ++cascadeIndex) {
+		m_shadowCascades.cascades.push_back(
+			FitShadowCascade(*camera, lightView, splits[cascadeIndex], splits[cascadeIndex + 1], m_resolution, CasterDistance));
+	}
 
-	assert(m_cascades.subCameras.size() == m_cascadeCount);
-	assert(cascadeID < m_cascadeCount);
+	m_candidates.clear();
+	m_centersX.clear();
+	m_centersY.clear();
+	m_centersZ.clear();
+	m_radii.clear();
+
+	// The spatial index skips the scene's entities outside all cascades' volumes,
+	// the cascades overlap, so entities found by several are kept once
+	if (scene != nullptr) {
+		m_indexedEntities.clear();
+		for (const ShadowCascade& cascade : m_shadowCascades.cascades) {
+			scene->QueryMeshEntities(Frustum(cascade.viewProjection), m_indexedEntities);
+		}
+		std::sort(m_indexedEntities.begin(), m_indexedEntities.end());
+		m_indexedEntities.erase(std::unique(m_indexedEntities.begin(), m_indexedEntities.end()), m_indexedEntities.end());
+		for (const MeshEntity* entity : m_indexedEntities) {
+			AddCandidate(entity);
+		}
+	}
+	if (entities != nullptr) {
+		for (const MeshEntity* entity : *entities) {
+			AddCandidate(entity);
+		}
+	}
 
-	const float origDepth = camera->GetFarPlane() - camera->GetNearPlane();
-	const float origNear = camera->GetNearPlane();
-	
-	const float nearOffset = origDepth * Exponential(float(cascadeID) / m_cascadeCount);
-	const float farOffset = origDepth * Exponential(float(cascadeID + 1) / m_cascadeCount);
-	const float newFar = origNear + farOffset;
-	const float newNear = origNear + nearOffset;
+	CullShadowCasters(m_shadowCascades.cascades,
+					  m_centersX.data(),
+					  m_centersY.data(),
+					  m_centersZ.data(),
+					  m_radii.data(),
+					  m_candidates.size(),
+					  m_casters);
+}
 
-	Camera& cam = m_cascades.subCameras[cascadeID];
-	cam = *camera;
-	cam.SetNearPlane(newNear);
-	cam.SetFarPlane(newFar);
 
-	return cam;
+void GenCSM::AddCandidate(const MeshEntity* entity) {
+	// Gather world space bounds, entities without a drawable mesh cast no shadows
+	const Mesh* mesh = entity->GetMesh();
+	if (mesh == nullptr || !CheckMeshFormat(*mesh)) {
+		return;
+	}
+
+	BoundingSphere sphere = TransformSphere(mesh->GetBoundingSphere(), entity->GetTransform());
+	m_candidates.push_back(entity);
+	m_centersX.push_back(sphere.center.x());
+	m_centersY.push_back(sphere.center.y());
+	m_centersZ.push_back(sphere.center.z());
+	m_radii.push_back(sphere.radius);
 }
 
 
-void GenCSM::RenderScene(
-	const Camera* camera,
-	const DirectionalLight* sun,
-	const EntityCollection<MeshEntity>& entities,
-	uint64_t frameID,
-	GraphicsCommandList & commandList
-) {
-	// Set render target
-	//const int cascadeID = frameID % m_cascadeCount;
-	//const int cascadeID = 0;
-	for (int cascadeID = 0; cascadeID < m_cascadeCount; cascadeID++) {
-		assert(m_cascades.mapArray.dsvs.size() == m_cascadeCount);
-		auto& renderTargetDsv = m_cascades.mapArray.dsvs[cascadeID];
-
-		commandList.SetRenderTargets(0, nullptr, &renderTargetDsv);
-
-		gxapi::Rectangle rect{ 0, static_cast<int>(m_height), 0, static_cast<int>(m_width) };
-		gxapi::Viewport viewport;
-		viewport.width = (float)rect.right;
-		viewport.height = (float)rect.bottom;
-		viewport.topLeftX = 0;
-		viewport.topLeftY = 0;
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
-		commandList.SetScissorRects(1, &rect);
-		commandList.SetViewports(1, &viewport);
-
-		commandList.SetResourceState(renderTargetDsv.GetResource(), cascadeID, gxapi::eResourceState::DEPTH_WRITE);
-		commandList.ClearDepthStencil(renderTargetDsv, 1, 0);
-
-		commandList.SetPipelineState(m_PSO.get());
-		commandList.SetGraphicsBinder(&m_binder);
-		commandList.SetPrimitiveTopology(gxapi::ePrimitiveTopology::TRIANGLELIST);
-
-		Camera& subcamera = CalculateSubCamera(camera, cascadeID);
-
-		auto view = LightViewTransform(sun);
-		auto viewProjection = LightDirectionalProjectionTransform(view, &subcamera) * view;
-
-		std::vector<const gxeng::VertexBuffer*> vertexBuffers;
-		std::vector<unsigned> sizes;
-		std::vector<unsigned> strides;
-
-		// Iterate over all entities
-		for (const MeshEntity* entity : entities) {
-			// Get entity parameters
-			Mesh* mesh = entity->GetMesh();
-			auto position = entity->GetPosition();
-
-			// Draw mesh
-			if (!CheckMeshFormat(*mesh)) {
-				assert(false);
-				continue;
-			}
-
-			ConvertToSubmittable(mesh, vertexBuffers, sizes, strides);
-
-			auto world = entity->GetTransform();
-			auto MVP = viewProjection * world;
-
-			std::array<mathfu::VectorPacked<float, 4>, 4> cbufferData;
-			MVP.Pack(cbufferData.data());
-
-			commandList.BindGraphics(m_texBindParam, *entity->GetTexture()->GetSrv());
-			commandList.BindGraphics(m_cbBindParam, cbufferData.data(), sizeof(cbufferData), 0);
-			commandList.SetVertexBuffers(0, (unsigned)vertexBuffers.size(), vertexBuffers.data(), sizes.data(), strides.data());
-			commandList.SetIndexBuffer(&mesh->GetIndexBuffer(), mesh->GetIndexBuffer32Bit());
-			commandList.DrawIndexedInstanced((unsigned)mesh->GetIndexBuffer().GetIndexCount());
+void GenCSM::RenderCascade(unsigned cascadeIndex, GraphicsCommandList& commandList, VolatileViewHeap& viewHeap) {
+	const ShadowCascade& cascade = m_shadowCascades.cascades[cascadeIndex];
+	DepthStencilView2D& dsv = m_dsvs[cascadeIndex];
+
+	// The cascade's slice is its subresource, the texture has no mips
+	commandList.SetResourceState(dsv.GetResource(), cascadeIndex, gxapi::eResourceState::DEPTH_WRITE);
+	commandList.ClearDepthStencil(dsv, 1, 0);
+	commandList.SetRenderTargets(0, nullptr, &dsv);
+
+	gxapi::Rectangle rect{ 0, (int)m_resolution, 0, (int)m_resolution };
+	gxapi::Viewport viewport;
+	viewport.width = (float)rect.right;
+	viewport.height = (float)rect.bottom;
+	viewport.topLeftX = 0;
+	viewport.topLeftY = 0;
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	commandList.SetScissorRects(1, &rect);
+	commandList.SetViewports(1, &viewport);
+
+	commandList.SetPipelineState(m_PSO.get());
+	commandList.SetGraphicsBinder(&m_binder);
+	commandList.SetPrimitiveTopology(gxapi::ePrimitiveTopology::TRIANGLELIST);
+
+	// Draws of the same mesh become one instanced draw, front to back as seen from the sun
+	const std::vector<uint32_t>& casters = m_casters[cascadeIndex];
+	DrawPacketBuilder& drawPackets = m_drawPackets[cascadeIndex];
+	drawPackets.Clear();
+	for (uint32_t casterIndex : casters) {
+		mathfu::Vector4f center(m_centersX[casterIndex], m_centersY[casterIndex], m_centersZ[casterIndex], 1.0f);
+		float depth = (cascade.viewProjection * center).z();
+		drawPackets.Add(casterIndex, 0, m_candidates[casterIndex]->GetMesh(), nullptr, depth);
+	}
+	drawPackets.Build(MaxInstancesPerDraw);
+
+	const std::vector<DrawPacket>& packets = drawPackets.GetPackets();
+	MeshDrawRecorder recorder(m_graphicsContext, viewHeap, commandList, m_meshletSignature.get());
+
+	for (const DrawPacketBuilder::Batch& batch : drawPackets.GetBatches()) {
+		const MeshEntity* firstEntity = m_candidates[packets[batch.first].index];
+		const MeshEntityStore& store = firstEntity->GetStore();
+
+		// An instance's transform is an MVP
+		mathfu::VectorPacked<float, 4>* instanceData = recorder.AllocateInstanceData(batch.count * 4);
+		for (uint32_t i = 0; i < batch.count; ++i) {
+			size_t storeIndex = m_candidates[packets[batch.first + i].index]->GetStoreIndex();
+			mathfu::Matrix4x4f mvp = cascade.viewProjection * store.WorldMatrix(storeIndex);
+			mvp.Pack(&instanceData[i * 4]);
 		}
+		recorder.BindInstanceData(m_transformBindParam);
+
+		// Meshlets facing away from the camera may face the sun, so they are only culled by the cascade
+		const mathfu::Matrix4x4f& world = store.WorldMatrix(firstEntity->GetStoreIndex());
+		recorder.Draw(firstEntity->GetMesh(), batch.count, cascade.viewProjection * world, world, nullptr);
 	}
 }
 
 
 } // namespace inl::gxeng::nodes
-#endif
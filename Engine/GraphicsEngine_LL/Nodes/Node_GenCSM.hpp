@@ -4,102 +4,90 @@
 
 #include "../Scene.hpp"
 #include "../Camera.hpp"
-#include "../ConstBufferHeap.hpp"
+#include "../DirectionalLight.hpp"
 #include "../GraphicsContext.hpp"
 #include "../PipelineTypes.hpp"
-#include "../WindowResizeListener.hpp"
+#include "../CascadedShadows.hpp"
+#include "../DrawPackets.hpp"
+#include "../MeshDrawRecorder.hpp"
 #include "GraphicsApi_LL/IPipelineState.hpp"
+#include "GraphicsApi_LL/ICommandSignature.hpp"
 #include "GraphicsApi_LL/IGxapiManager.hpp"
 
 #include <vector>
 
 
-
-// OBSOLETE
-// this class should be updated to match current pipeline
-
-#if 0
 namespace inl::gxeng::nodes {
 
 
-/// <summary>
-/// Takes a directional light and returns a transformation that acts
-/// as a view transform when rendering a shadow map.
-/// </summary>
-mathfu::Matrix4x4f LightViewTransform(const DirectionalLight* light);
-
-/// <summary>
-/// Takes a view transformation of a directional light and 
-/// returns a transformation that acts as a projection transform when
-/// rendering shadow map for the corresponding directional light, and camera.
-/// The frustum of the light is fitted on the camera frustum.
-/// </summary>
-mathfu::Matrix4x4f LightDirectionalProjectionTransform(const mathfu::Matrix4x4f& lightViewTransform, const Camera* camera);
-
-
-// A single shadow map and the corresponding camera for cascaded shadow maps
-struct ShadowMapCascade {
-	Camera subCamera;
-	DepthStencilPack map;
-};
-
-// Contains shadow maps and their corresponding camera for each cascade of
-// a cascaded shadow map
+/// <summary> Cascaded shadow map of a directional light. </summary>
 struct ShadowCascades {
-	DepthStencilArrayPack mapArray;
-	std::vector<Camera> subCameras;
+	/// <summary> Depth as seen from the light, one array slice per cascade. </summary>
+	TextureView2D shadowMaps;
+
+	/// <summary> The cascades the slices were drawn with, empty if nothing was drawn. </summary>
+	std::vector<ShadowCascade> cascades;
 };
 
 
-// Cascaded shadow mapping
+/// <summary>
+/// Draws the cascaded shadow map of the sun.
+/// <para />
+/// Each cascade only draws the entities that overlap its volume in the light's space,
+/// so the cost grows with the casters of each cascade, not with the whole scene for every cascade.
+/// If the scene is given, its mesh entities are found through the scene's spatial index, and the
+/// entities input only holds the entities that are not in the scene, like terrain chunks.
+/// The cascades are culled in one subtask, then the next subtask records each cascade
+/// into a command list of its own, on several threads.
+/// </summary>
 class GenCSM :
 	virtual public GraphicsNode,
-	virtual public exc::InputPortConfig<const Camera*, const DirectionalLight*, const EntityCollection<MeshEntity>*>,
+	// Inputs: camera, sun, entities (entities outside the camera's view cast shadows too), scene (optional)
+	virtual public exc::InputPortConfig<const Camera*, const DirectionalLight*, const EntityCollection<MeshEntity>*, const Scene*>,
 	virtual public exc::OutputPortConfig<const ShadowCascades*>
 {
 public:
-	GenCSM(
-		gxapi::IGraphicsApi* graphicsApi,
-		unsigned width,
-		unsigned height);
+	/// <param name="resolution"> Width and height of each cascade's shadow map. </param>
+	/// <param name="numCascades"> At most MaxShadowCascades. </param>
+	GenCSM(gxapi::IGraphicsApi* graphicsApi, unsigned resolution = 2048, unsigned numCascades = MaxShadowCascades);
 
 	void Update() override {}
 	void Notify(exc::InputPortBase* sender) override {}
-	void InitGraphics(const GraphicsContext&) override;
+	void RequestShaders(const GraphicsContext& context) override;
+	void InitGraphics(const GraphicsContext& context) override;
 
 	Task GetTask() override;
 
-	void SetShadowMapSize(unsigned width, unsigned height);
-
 protected:
-	unsigned m_width;
-	unsigned m_height;
+	unsigned m_resolution;
+	unsigned m_numCascades;
 
-	MemoryManager* m_memoryManager;
+	std::vector<DepthStencilView2D> m_dsvs; // one per cascade
+	ShadowCascades m_shadowCascades;
 
 protected:
 	GraphicsContext m_graphicsContext;
 	Binder m_binder;
-	BindParameter m_cbBindParam;
-	BindParameter m_texBindParam;
-	std::unique_ptr<gxapi::IPipelineState> m_PSO;
-
-protected:
-	unsigned m_cascadeCount = 5;
-	ShadowCascades_DEPRECATED m_cascades;
-	//std::vector<ShadowMapCascade> m_cascades; // cameras for subfrusta
+	BindParameter m_transformBindParam;
+	std::shared_ptr<gxapi::IPipelineState> m_PSO;
+	std::unique_ptr<gxapi::ICommandSignature> m_meshletSignature;
+
+	// Filled by the culling subtask, read while recording the cascades
+	std::vector<MeshEntity*> m_indexedEntities; // entities of the scene found by its spatial index
+	std::vector<const MeshEntity*> m_candidates;
+	std::vector<float> m_centersX;
+	std::vector<float> m_centersY;
+	std::vector<float> m_centersZ;
+	std::vector<float> m_radii;
+	std::vector<std::vector<uint32_t>> m_casters; // indices into m_candidates for each cascade
+	std::vector<DrawPacketBuilder> m_drawPackets; // one per cascade
 
 private:
-	void InitBuffers();
-	Camera& CalculateSubCamera(const Camera* camera, unsigned cascadeID);
-	void RenderScene(
-		const Camera* camera,
-		const DirectionalLight* sun,
-		const EntityCollection<MeshEntity>& entities,
-		uint64_t frameID,
-		GraphicsCommandList& commandList);
+	void InitShadowMaps();
+	void CullCascades(const Camera* camera, const DirectionalLight* sun, const EntityCollection<MeshEntity>* entities, const Scene* scene);
+	void AddCandidate(const MeshEntity* entity);
+	void RenderCascade(unsigned cascadeIndex, GraphicsCommandList& commandList, VolatileViewHeap& viewHeap);
 };
 
 
 } // namespace inl::gxeng::nodes
-#endif
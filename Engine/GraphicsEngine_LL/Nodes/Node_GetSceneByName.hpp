@@ -4,6 +4,9 @@
 
 #include "../Scene.hpp"
 #include "../DirectionalLight.hpp"
+#include "../PointLight.hpp"
+#include "../SpotLight.hpp"
+#include "../TerrainEntity.hpp"
 
 namespace inl {
 namespace gxeng {
@@ -13,7 +16,7 @@ namespace nodes {
 class GetSceneByName :
 	virtual public GraphicsNode,
 	virtual public exc::InputPortConfig<std::string>,
-	virtual public exc::OutputPortConfig<const EntityCollection<MeshEntity>*, const DirectionalLight*>
+	virtual public exc::OutputPortConfig<const EntityCollection<MeshEntity>*, const DirectionalLight*, const EntityCollection<PointLight>*, const EntityCollection<SpotLight>*, const EntityCollection<TerrainEntity>*, const Scene*>
 {
 public:
 	GetSceneByName() {}
@@ -39,6 +42,10 @@ public:
 			// set scene parameters to output ports
 			this->GetOutput<0>().Set(&scene->GetMeshEntities());
 			this->GetOutput<1>().Set(&scene->GetSun());
+			this->GetOutput<2>().Set(&scene->GetPointLights());
+			this->GetOutput<3>().Set(&scene->GetSpotLights());
+			this->GetOutput<4>().Set(&scene->GetTerrainEntities());
+			this->GetOutput<5>().Set(scene); // for querying the mesh entities by place
 			
 			return ExecutionResult{};
 		} });
@@ -0,0 +1,99 @@
+#include "Node_OcclusionCull.hpp"
+
+#include "../MeshEntity.hpp"
+#include "../Mesh.hpp"
+
+#include <future>
+#include <thread>
+#include <algorithm>
+
+
+namespace inl::gxeng::nodes {
+
+
+OcclusionCull::OcclusionCull() {
+	this->GetInput<0>().Set({});
+	this->GetInput<1>().Set({});
+}
+
+
+Task OcclusionCull::GetTask() {
+	return Task({ [this](const ExecutionContext& context) {
+		const EntityCollection<MeshEntity>* entities = this->GetInput<0>().Get();
+		this->GetInput<0>().Clear();
+
+		const Camera* camera = this->GetInput<1>().Get();
+		this->GetInput<1>().Clear();
+
+		if (entities == nullptr) {
+			this->GetOutput<0>().Set(nullptr);
+			return ExecutionResult{};
+		}
+
+		if (camera == nullptr) {
+			this->GetOutput<0>().Set(entities);
+			return ExecutionResult{};
+		}
+
+		Cull(*entities, *camera);
+		this->GetOutput<0>().Set(&m_visibleEntities);
+
+		return ExecutionResult{};
+	} });
+}
+
+
+void OcclusionCull::Cull(const EntityCollection<MeshEntity>& entities, const Camera& camera) {
+	mathfu::Matrix4x4f viewProjection = camera.GetPerspectiveMatrixRH() * camera.GetViewMatrixRH();
+
+	// Draw occluders, test the rest.
+	m_occlusionBuffer.Clear();
+	m_candidates.clear();
+	m_visibleEntities.Clear();
+	for (MeshEntity* entity : entities) {
+		const Mesh* mesh = entity->GetMesh();
+		if (mesh != nullptr && mesh->IsOccluder()) {
+			const auto& positions = mesh->GetOccluderPositions();
+			const auto& indices = mesh->GetOccluderIndices();
+			m_occlusionBuffer.RasterizeOccluder(positions.data(), positions.size(), indices.data(), indices.size(), viewProjection * entity->GetTransform());
+			m_visibleEntities.Add(entity);
+		}
+		else if (mesh != nullptr) {
+			m_candidates.push_back(entity);
+		}
+	}
+	m_occlusionBuffer.UpdateHierarchy();
+
+	// Each worker fills its own part of the visibility mask.
+	auto testRange = [this, &viewProjection](size_t first, size_t last) {
+		for (size_t i = first; i < last; ++i) {
+			const MeshEntity* entity = m_candidates[i];
+			Aabb box = TransformAabb(entity->GetMesh()->GetBoundingBox(), entity->GetTransform());
+			m_visibilityMask[i] = !m_occlusionBuffer.IsOccluded(box, viewProjection);
+		}
+	};
+
+	// At most one worker per core, the candidates are split evenly between them
+	size_t count = m_candidates.size();
+	size_t numWorkers = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), count / MinEntitiesPerWorker);
+	numWorkers = std::max<size_t>(1, numWorkers);
+
+	m_visibilityMask.resize(count);
+	std::vector<std::future<void>> workers;
+	for (size_t i = 1; i < numWorkers; ++i) {
+		workers.push_back(std::async(std::launch::async, testRange, count * i / numWorkers, count * (i + 1) / numWorkers));
+	}
+	testRange(0, count / numWorkers);
+	for (auto& worker : workers) {
+		worker.get();
+	}
+
+	for (size_t i = 0; i < m_candidates.size(); ++i) {
+		if (m_visibilityMask[i]) {
+			m_visibleEntities.Add(m_candidates[i]);
+		}
+	}
+}
+
+
+} // namespace inl::gxeng::nodes
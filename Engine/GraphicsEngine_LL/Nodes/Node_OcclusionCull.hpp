@@ -0,0 +1,53 @@
+#pragma once
+
+#include "../GraphicsNode.hpp"
+
+#include "../Scene.hpp"
+#include "../Camera.hpp"
+#include "../OcclusionCulling.hpp"
+
+#include <vector>
+
+
+namespace inl::gxeng::nodes {
+
+
+/// <summary>
+/// Filters out the mesh entities that are hidden behind occluders.
+/// </summary>
+/// <remarks>
+/// Entities whose mesh has an occluder shape are rasterized into a small depth buffer on the CPU,
+/// then the world bounding box of every other entity is tested against it on worker threads.
+/// Occluders themselves always pass. The output collection is owned by the node and rebuilt every frame.
+/// </remarks>
+class OcclusionCull :
+	virtual public GraphicsNode,
+	// Inputs: geometry, camera
+	virtual public exc::InputPortConfig<const EntityCollection<MeshEntity>*, const Camera*>,
+	// Outputs: visible geometry
+	virtual public exc::OutputPortConfig<const EntityCollection<MeshEntity>*>
+{
+public:
+	OcclusionCull();
+
+	void Update() override {}
+	void Notify(exc::InputPortBase* sender) override {}
+	void InitGraphics(const GraphicsContext& context) override {}
+
+	Task GetTask() override;
+
+private:
+	void Cull(const EntityCollection<MeshEntity>& entities, const Camera& camera);
+private:
+	/// <summary> Candidates are only split across threads if each thread gets at least this many. </summary>
+	static constexpr size_t MinEntitiesPerWorker = 1024;
+
+	OcclusionBuffer m_occlusionBuffer;
+	EntityCollection<MeshEntity> m_visibleEntities;
+
+	std::vector<MeshEntity*> m_candidates;
+	std::vector<uint8_t> m_visibilityMask;
+};
+
+
+} // namespace inl::gxeng::nodes
@@ -4,6 +4,10 @@
 namespace inl::gxeng::nodes {
 
 
+// Shader of the node, requested up front and created by InitGraphics
+static constexpr const char* ShaderName = "RenderToBackBuffer";
+
+
 RenderToBackBuffer::RenderToBackBuffer(gxapi::IGraphicsApi * graphicsApi):
 	m_binder(graphicsApi, {})
 {
@@ -36,6 +40,11 @@ RenderToBackBuffer::RenderToBackBuffer(gxapi::IGraphicsApi * graphicsApi):
 }
 
 
+void RenderToBackBuffer::RequestShaders(const GraphicsContext& context) {
+	context.RequestShader(ShaderName, ShaderParts::VertexPixel(), "");
+}
+
+
 void RenderToBackBuffer::InitGraphics(const GraphicsContext& context) {
 	m_graphicsContext = context;
 
@@ -52,11 +61,7 @@ void RenderToBackBuffer::InitGraphics(const GraphicsContext& context) {
 	m_fsq = m_graphicsContext.CreateVertexBuffer(vertices.data(), sizeof(float)*vertices.size());
 	m_fsqIndices = m_graphicsContext.CreateIndexBuffer(indices.data(), sizeof(uint16_t)*indices.size(), indices.size());
 
-	ShaderParts shaderParts;
-	shaderParts.vs = true;
-	shaderParts.ps = true;
-
-	auto shader = m_graphicsContext.CreateShader("RenderToBackBuffer", shaderParts, "");
+	auto shader = m_graphicsContext.CreateShader(ShaderName, ShaderParts::VertexPixel(), "");
 
 	std::vector<gxapi::InputElementDesc> inputElementDesc = {
 		gxapi::InputElementDesc("POSITION", 0, gxapi::eFormat::R32G32B32_FLOAT, 0, 0)
@@ -73,7 +78,7 @@ void RenderToBackBuffer::InitGraphics(const GraphicsContext& context) {
 	psoDesc.numRenderTargets = 1;
 	psoDesc.renderTargetFormats[0] = gxapi::eFormat::R8G8B8A8_UNORM;
 
-	m_PSO.reset(m_graphicsContext.CreatePSO(psoDesc));
+	m_PSO = m_graphicsContext.CreatePSO(psoDesc);
 }
 
 
@@ -25,6 +25,7 @@ public:
 
 	void Update() override {}
 	void Notify(exc::InputPortBase* sender) override {}
+	void RequestShaders(const GraphicsContext& context) override;
 	void InitGraphics(const GraphicsContext& context) override;
 
 	Task GetTask() override {
@@ -54,7 +55,7 @@ protected:
 protected:
 	Binder m_binder;
 	BindParameter m_texBindParam;
-	std::unique_ptr<gxapi::IPipelineState> m_PSO;
+	std::shared_ptr<gxapi::IPipelineState> m_PSO;
 
 private:
 	void Render(
@@ -0,0 +1,51 @@
+#include "Node_TerrainLod.hpp"
+
+#include "../MeshEntity.hpp"
+
+
+namespace inl::gxeng::nodes {
+
+
+TerrainLod::TerrainLod(unsigned width, unsigned height)
+	: m_height(height)
+{
+	this->GetInput<0>().Set({});
+	this->GetInput<1>().Set({});
+}
+
+
+Task TerrainLod::GetTask() {
+	return Task({ [this](const ExecutionContext& context) {
+		const EntityCollection<TerrainEntity>* terrains = this->GetInput<0>().Get();
+		this->GetInput<0>().Clear();
+
+		const Camera* camera = this->GetInput<1>().Get();
+		this->GetInput<1>().Clear();
+
+		m_chunks.Clear();
+		if (terrains != nullptr && camera != nullptr) {
+			CollectChunks(*terrains, *camera);
+		}
+		this->GetOutput<0>().Set(&m_chunks);
+
+		return ExecutionResult{};
+	} });
+}
+
+
+void TerrainLod::WindowResized(unsigned width, unsigned height) {
+	m_height = height;
+}
+
+
+void TerrainLod::CollectChunks(const EntityCollection<TerrainEntity>& terrains, const Camera& camera) {
+	for (TerrainEntity* terrain : terrains) {
+		terrain->SelectLod(camera, m_height);
+		for (MeshEntity* chunk : terrain->GetDrawnChunks()) {
+			m_chunks.Add(chunk);
+		}
+	}
+}
+
+
+} // namespace inl::gxeng::nodes
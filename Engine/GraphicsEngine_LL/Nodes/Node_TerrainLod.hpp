@@ -0,0 +1,51 @@
+#pragma once
+
+#include "../GraphicsNode.hpp"
+
+#include "../Scene.hpp"
+#include "../Camera.hpp"
+#include "../TerrainEntity.hpp"
+#include "../WindowResizeListener.hpp"
+
+#include <vector>
+
+
+namespace inl::gxeng::nodes {
+
+
+/// <summary>
+/// Selects the detail of terrains for the camera, and outputs the terrains' chunks to draw.
+/// </summary>
+/// <remarks>
+/// The output collection is owned by the node. The chunks are not part of the scene's spatial index,
+/// nodes culling through the index take them as a separate collection.
+/// </remarks>
+class TerrainLod :
+	virtual public GraphicsNode,
+	// Inputs: terrains, camera
+	virtual public exc::InputPortConfig<const EntityCollection<TerrainEntity>*, const Camera*>,
+	// Outputs: the terrains' chunks
+	virtual public exc::OutputPortConfig<const EntityCollection<MeshEntity>*>,
+	public WindowResizeListener
+{
+public:
+	TerrainLod(unsigned width, unsigned height);
+
+	void Update() override {}
+	void Notify(exc::InputPortBase* sender) override {}
+	void InitGraphics(const GraphicsContext& context) override {}
+
+	Task GetTask() override;
+
+	void WindowResized(unsigned width, unsigned height) override;
+
+private:
+	void CollectChunks(const EntityCollection<TerrainEntity>& terrains, const Camera& camera);
+private:
+	unsigned m_height;
+
+	EntityCollection<MeshEntity> m_chunks;
+};
+
+
+} // namespace inl::gxeng::nodes
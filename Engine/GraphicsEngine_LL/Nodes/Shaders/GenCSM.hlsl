@@ -1,28 +1,26 @@
+// must match MaxInstancesPerDraw in Node_GenCSM.cpp
+#define MAX_INSTANCES 1024
 
-struct Transform
+struct Transforms
 {
-	float4x4 MVP;
+	float4x4 MVP[MAX_INSTANCES];
 };
 
 
-ConstantBuffer<Transform> cb : register(b0);
-SamplerState theSampler : register(s0);
-Texture2DArray<float4> albedoTex : register(t0);
+ConstantBuffer<Transforms> transforms : register(b0);
 
 
 struct PS_Input
 {
 	float4 position : SV_POSITION;
-	float2 texCoord : TEX_COORD;
 };
 
 
-PS_Input VSMain(float4 position : POSITION, float4 texCoord : TEX_COORD)
+PS_Input VSMain(float4 position : POSITION, uint instanceId : SV_InstanceID)
 {
 	PS_Input result;
 
-	result.position = mul(cb.MVP, position);
-	result.texCoord = texCoord.xy;
+	result.position = mul(transforms.MVP[instanceId], position);
 
 	return result;
 }
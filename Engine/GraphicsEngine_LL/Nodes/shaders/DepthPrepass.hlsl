@@ -1,11 +1,19 @@
+// must match MaxInstancesPerDraw in Node_DepthPrepass.cpp
+#define MAX_INSTANCES 1024
 
-struct Transform
+struct Transforms
 {
-	float4x4 MVP;
+	float4x4 world[MAX_INSTANCES];
+};
+
+struct Camera
+{
+	float4x4 viewProjection;
 };
 
 
-ConstantBuffer<Transform> transform : register(b0);
+ConstantBuffer<Transforms> transforms : register(b0);
+ConstantBuffer<Camera> camera : register(b1);
 
 struct PS_Input
 {
@@ -13,11 +21,12 @@ struct PS_Input
 };
 
 
-PS_Input VSMain(float4 position : POSITION)
+PS_Input VSMain(float4 position : POSITION, uint instanceId : SV_InstanceID)
 {
 	PS_Input result;
 
-	result.position = mul(transform.MVP, position);
+	// must match ForwardRender.hlsl to the bit, forward rendering tests depth for equality
+	result.position = mul(camera.viewProjection, mul(transforms.world[instanceId], position));
 
 	return result;
 }
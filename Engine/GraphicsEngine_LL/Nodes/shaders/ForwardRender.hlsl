@@ -1,20 +1,80 @@
+// must match MaxInstancesPerDraw in Node_ForwardRender.cpp
+#define MAX_INSTANCES 512
 
 struct Transform
 {
-	float4x4 MVP;
+	float4x4 world;
 	float4x4 worldInvTr;
 };
 
+struct Transforms
+{
+	Transform instances[MAX_INSTANCES];
+};
+
+struct Camera
+{
+	float4x4 viewProjection;
+};
+
+// must match TextureTable::DefaultCapacity
+#define MAX_TEXTURES 1024
+
+struct Material
+{
+	uint textureIndex; // in the texture table
+};
+
 struct Sun
 {
 	float4 dir; // in world space
 	float4 color;
 };
 
-ConstantBuffer<Transform> transform : register(b0);
+// must match MaxShadowCascades in CascadedShadows.hpp
+#define MAX_CASCADES 4
+
+// keeps lit surfaces from shadowing themselves
+#define SHADOW_BIAS 0.001
+
+struct Shadow
+{
+	float4x4 invViewProjection; // camera's clip space to world space
+	float4x4 cascades[MAX_CASCADES]; // world space to the cascades' clip space
+	float4 cascadeFar; // view distance where each cascade ends
+	float2 screenSize;
+	float numCascades; // no shadows if zero
+};
+
+// must match the constants in Node_ClusterLights.hpp
+#define MAX_LIGHTS 512
+#define MAX_LIGHT_INDICES 14336
+#define NUM_CLUSTERS (16 * 8 * 16)
+
+// spot lights fade out over this part of their cone
+#define SPOT_FADE 0.2
+
+struct Lights
+{
+	float2 tileScale; // pixels to tiles
+	float sliceScale; // log of view distance to slices
+	float sliceBias;
+	uint4 grid; // tiles in x and y, slices, number of lights
+	float4 lights[MAX_LIGHTS * 3]; // world position and range, color and cos of cone angle (negative for point lights), direction
+	uint4 clusters[NUM_CLUSTERS / 4]; // offset of the cluster's lights in the lower, count in the upper 16 bits
+	uint4 lightIndices[MAX_LIGHT_INDICES / 8]; // 16 bits each
+};
+
+ConstantBuffer<Transforms> transforms : register(b0);
 ConstantBuffer<Sun> sun : register(b1);
+ConstantBuffer<Shadow> shadow : register(b2);
+ConstantBuffer<Lights> localLights : register(b3);
+ConstantBuffer<Camera> camera : register(b4);
+ConstantBuffer<Material> material : register(b5);
 SamplerState theSampler : register(s0);
-Texture2DArray<float4> albedoTex : register(t0);
+SamplerComparisonState shadowSampler : register(s1);
+Texture2DArray<float4> textures[MAX_TEXTURES] : register(t0, space1);
+Texture2DArray<float> shadowMap : register(t1);
 
 
 struct PS_Input
@@ -25,13 +85,15 @@ struct PS_Input
 };
 
 
-PS_Input VSMain(float4 position : POSITION, float4 normal : NORMAL, float4 texCoord : TEX_COORD)
+PS_Input VSMain(float4 position : POSITION, float4 normal : NORMAL, float4 texCoord : TEX_COORD, uint instanceId : SV_InstanceID)
 {
 	PS_Input result;
+	Transform transform = transforms.instances[instanceId];
 
 	float3 worldNormal = normalize(mul(transform.worldInvTr, float4(normal.xyz, 0.0)).xyz);
 
-	result.position = mul(transform.MVP, position);
+	// must match DepthPrepass.hlsl to the bit, depth is tested for equality
+	result.position = mul(camera.viewProjection, mul(transform.world, position));
 	result.normal = worldNormal;
 	result.texCoord = texCoord.xy;
 
@@ -39,10 +101,70 @@ PS_Input VSMain(float4 position : POSITION, float4 normal : NORMAL, float4 texCo
 }
 
 
+float3 WorldPosition(float4 screenPosition)
+{
+	float2 ndc = screenPosition.xy / shadow.screenSize * float2(2.0, -2.0) + float2(-1.0, 1.0);
+	float4 worldPosition = mul(shadow.invViewProjection, float4(ndc, screenPosition.z, 1.0));
+	return worldPosition.xyz / worldPosition.w;
+}
+
+
+// 1 where the sun reaches the pixel, 0 in shadow
+float SunVisibility(float4 screenPosition, float3 worldPosition)
+{
+	// pick the cascade by view distance, which is w in the pixel shader
+	uint numCascades = (uint)shadow.numCascades;
+	uint cascade = 0;
+	while (cascade < numCascades && screenPosition.w > shadow.cascadeFar[cascade]) {
+		++cascade;
+	}
+	if (cascade >= numCascades) {
+		return 1.0;
+	}
+
+	float4 lightPosition = mul(shadow.cascades[cascade], float4(worldPosition, 1.0));
+	float2 shadowCoords = lightPosition.xy * float2(0.5, -0.5) + 0.5;
+	return shadowMap.SampleCmpLevelZero(shadowSampler, float3(shadowCoords, cascade), lightPosition.z - SHADOW_BIAS);
+}
+
+
+// Light of the point and spot lights binned into the pixel's cluster
+float3 LocalLights(float4 screenPosition, float3 worldPosition, float3 normal)
+{
+	uint2 tile = min((uint2)(screenPosition.xy * localLights.tileScale), localLights.grid.xy - 1);
+	uint slice = (uint)clamp(floor(log(screenPosition.w) * localLights.sliceScale + localLights.sliceBias), 0.0, localLights.grid.z - 1.0);
+	uint cluster = (slice * localLights.grid.y + tile.y) * localLights.grid.x + tile.x;
+	uint packedCluster = localLights.clusters[cluster / 4][cluster % 4];
+	uint offset = packedCluster & 0xFFFF;
+	uint count = packedCluster >> 16;
+
+	float3 result = 0.0;
+	for (uint i = 0; i < count; ++i) {
+		uint index = offset + i;
+		uint light = (localLights.lightIndices[index / 8][(index % 8) / 2] >> (16 * (index % 2))) & 0xFFFF;
+		float4 positionRange = localLights.lights[3 * light];
+		float4 colorAngle = localLights.lights[3 * light + 1];
+		float3 direction = localLights.lights[3 * light + 2].xyz;
+
+		float3 toLight = positionRange.xyz - worldPosition;
+		float distance = length(toLight);
+		toLight /= max(distance, 1e-4);
+		float falloff = saturate(1.0 - distance / positionRange.w);
+		float cone = colorAngle.w < 0.0 ? 1.0 : smoothstep(colorAngle.w, lerp(colorAngle.w, 1.0, SPOT_FADE), dot(-toLight, direction));
+		result += colorAngle.rgb * max(0.0, dot(normal, toLight)) * falloff * falloff * cone;
+	}
+	return result;
+}
+
+
 float4 PSMain(PS_Input input): SV_TARGET
 {
 	float3 coords = {input.texCoord.x, 1-input.texCoord.y, 0.0};
 	
-	float3 albedo = albedoTex.Sample(theSampler, coords).rgb;
-	return float4(max(0.0, dot(normalize(input.normal), -sun.dir)) * albedo, 1.0);
+	float3 albedo = textures[material.textureIndex].Sample(theSampler, coords).rgb;
+	float3 normal = normalize(input.normal);
+	float3 worldPosition = WorldPosition(input.position);
+	float sunlight = max(0.0, dot(normal, -sun.dir.xyz)) * SunVisibility(input.position, worldPosition);
+	float3 light = sunlight + LocalLights(input.position, worldPosition, normal);
+	return float4(light * albedo, 1.0);
 }
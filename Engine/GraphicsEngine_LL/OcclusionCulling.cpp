@@ -0,0 +1,225 @@
+#include "OcclusionCulling.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define INL_OCCLUSION_CULLING_SSE
+#endif
+
+
+namespace inl {
+namespace gxeng {
+
+
+// Vertices closer to the eye than this are treated as crossing the near plane.
+static constexpr float MinW = 1e-5f;
+
+
+static mathfu::Vector<float, 4> ToClipSpace(const mathfu::Matrix<float, 4, 4>& transform, const mathfu::Vector<float, 3>& v) {
+	return transform * mathfu::Vector<float, 4>(v.x(), v.y(), v.z(), 1.0f);
+}
+
+
+OcclusionBuffer::OcclusionBuffer(int width, int height) {
+	m_tilesX = (std::max(width, 1) + TileSize - 1) / TileSize;
+	m_tilesY = (std::max(height, 1) + TileSize - 1) / TileSize;
+	m_width = m_tilesX * TileSize;
+	m_height = m_tilesY * TileSize;
+	m_depth.resize(m_width * m_height);
+	m_tileMaxDepth.resize(m_tilesX * m_tilesY);
+	Clear();
+}
+
+
+void OcclusionBuffer::Clear() {
+	std::fill(m_depth.begin(), m_depth.end(), 1.0f);
+	std::fill(m_tileMaxDepth.begin(), m_tileMaxDepth.end(), 1.0f);
+}
+
+
+void OcclusionBuffer::RasterizeOccluder(const mathfu::Vector<float, 3>* positions,
+										size_t numPositions,
+										const unsigned* indices,
+										size_t numIndices,
+										const mathfu::Matrix<float, 4, 4>& mvp)
+{
+	m_transformed.resize(numPositions);
+	for (size_t i = 0; i < numPositions; ++i) {
+		m_transformed[i] = ToClipSpace(mvp, positions[i]);
+	}
+
+	for (size_t i = 0; i + 2 < numIndices; i += 3) {
+		const auto& v0 = m_transformed[indices[i + 0]];
+		const auto& v1 = m_transformed[indices[i + 1]];
+		const auto& v2 = m_transformed[indices[i + 2]];
+
+		// Clipping would make the occluder smaller anyway, skipping is simpler and still safe.
+		if (v0.w() < MinW || v1.w() < MinW || v2.w() < MinW || v0.z() < 0 || v1.z() < 0 || v2.z() < 0) {
+			continue;
+		}
+
+		RasterizeTriangle(v0, v1, v2);
+	}
+}
+
+
+void OcclusionBuffer::RasterizeTriangle(const mathfu::Vector<float, 4>& v0, const mathfu::Vector<float, 4>& v1, const mathfu::Vector<float, 4>& v2) {
+	// to pixel coordinates, y pointing down
+	float x[3], y[3], z[3];
+	const mathfu::Vector<float, 4>* v[3] = { &v0, &v1, &v2 };
+	for (int i = 0; i < 3; ++i) {
+		float invW = 1.0f / v[i]->w();
+		x[i] = (v[i]->x() * invW * 0.5f + 0.5f) * m_width;
+		y[i] = (0.5f - v[i]->y() * invW * 0.5f) * m_height;
+		z[i] = v[i]->z() * invW;
+	}
+
+	float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	if (std::abs(area) < 1e-8f) {
+		return;
+	}
+	if (area < 0) {
+		// draw back faces as well by flipping them to the front
+		std::swap(x[1], x[2]);
+		std::swap(y[1], y[2]);
+		std::swap(z[1], z[2]);
+		area = -area;
+	}
+
+	int minX = std::max(0, (int)std::floor(std::min({ x[0], x[1], x[2] })));
+	int maxX = std::min(m_width - 1, (int)std::ceil(std::max({ x[0], x[1], x[2] })));
+	int minY = std::max(0, (int)std::floor(std::min({ y[0], y[1], y[2] })));
+	int maxY = std::min(m_height - 1, (int)std::ceil(std::max({ y[0], y[1], y[2] })));
+	if (minX > maxX || minY > maxY) {
+		return;
+	}
+
+	// edge i is opposite to vertex i, e(px, py) = a * px + b * py + c is positive inside
+	float a[3], b[3], c[3];
+	for (int i = 0; i < 3; ++i) {
+		int j = (i + 1) % 3, k = (i + 2) % 3;
+		a[i] = y[j] - y[k];
+		b[i] = x[k] - x[j];
+		c[i] = x[j] * y[k] - x[k] * y[j];
+	}
+
+	// depth is linear in screen space: z = z0 + dzdx * (px - x0) + dzdy * (py - y0)
+	float dzdx = (a[0] * z[0] + a[1] * z[1] + a[2] * z[2]) / area;
+	float dzdy = (b[0] * z[0] + b[1] * z[1] + b[2] * z[2]) / area;
+	float zc = z[0] - dzdx * x[0] - dzdy * y[0];
+
+	// pixels are covered if their center is inside
+#ifdef INL_OCCLUSION_CULLING_SSE
+	// four pixels of a row at a time, rows start at multiples of 4 since the width is a multiple of the tile size
+	minX &= ~3;
+	const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+	const __m128 zero = _mm_setzero_ps();
+	for (int py = minY; py <= maxY; ++py) {
+		float cy = py + 0.5f;
+		__m128 rowE0 = _mm_set1_ps(b[0] * cy + c[0]);
+		__m128 rowE1 = _mm_set1_ps(b[1] * cy + c[1]);
+		__m128 rowE2 = _mm_set1_ps(b[2] * cy + c[2]);
+		__m128 rowZ = _mm_set1_ps(dzdy * cy + zc);
+		float* row = &m_depth[py * m_width];
+		for (int px = minX; px <= maxX; px += 4) {
+			__m128 cx = _mm_add_ps(_mm_set1_ps(float(px)), laneOffsets);
+			__m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[0]), cx), rowE0);
+			__m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[1]), cx), rowE1);
+			__m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[2]), cx), rowE2);
+			__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+			if (_mm_movemask_ps(inside) == 0) {
+				continue;
+			}
+			__m128 depth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(dzdx), cx), rowZ);
+			__m128 old = _mm_loadu_ps(row + px);
+			__m128 nearest = _mm_min_ps(old, depth);
+			_mm_storeu_ps(row + px, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, old)));
+		}
+	}
+#else
+	for (int py = minY; py <= maxY; ++py) {
+		float cy = py + 0.5f;
+		float* row = &m_depth[py * m_width];
+		for (int px = minX; px <= maxX; ++px) {
+			float cx = px + 0.5f;
+			if (a[0] * cx + b[0] * cy + c[0] < 0 || a[1] * cx + b[1] * cy + c[1] < 0 || a[2] * cx + b[2] * cy + c[2] < 0) {
+				continue;
+			}
+			row[px] = std::min(row[px], dzdx * cx + dzdy * cy + zc);
+		}
+	}
+#endif
+}
+
+
+void OcclusionBuffer::UpdateHierarchy() {
+	for (int ty = 0; ty < m_tilesY; ++ty) {
+		for (int tx = 0; tx < m_tilesX; ++tx) {
+			float farthest = 0.0f;
+			for (int py = ty * TileSize; py < (ty + 1) * TileSize; ++py) {
+				const float* row = &m_depth[py * m_width + tx * TileSize];
+				farthest = std::max(farthest, *std::max_element(row, row + TileSize));
+			}
+			m_tileMaxDepth[ty * m_tilesX + tx] = farthest;
+		}
+	}
+}
+
+
+bool OcclusionBuffer::IsOccluded(const Aabb& box, const mathfu::Matrix<float, 4, 4>& viewProjection) const {
+	// screen rectangle and nearest depth of the box's corners
+	float minX = std::numeric_limits<float>::infinity(), maxX = -minX;
+	float minY = minX, maxY = -minX;
+	float nearest = minX;
+	for (int corner = 0; corner < 8; ++corner) {
+		mathfu::Vector<float, 3> position(corner & 1 ? box.max.x() : box.min.x(),
+										  corner & 2 ? box.max.y() : box.min.y(),
+										  corner & 4 ? box.max.z() : box.min.z());
+		mathfu::Vector<float, 4> clip = ToClipSpace(viewProjection, position);
+		if (clip.w() < MinW || clip.z() < 0) {
+			return false;
+		}
+		float invW = 1.0f / clip.w();
+		float x = (clip.x() * invW * 0.5f + 0.5f) * m_width;
+		float y = (0.5f - clip.y() * invW * 0.5f) * m_height;
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+		nearest = std::min(nearest, clip.z() * invW);
+	}
+
+	// parts outside the screen are not visible anyway, the frustum culling decides about boxes entirely outside
+	if (maxX < 0 || maxY < 0 || minX > m_width || minY > m_height) {
+		return false;
+	}
+
+	// every pixel the rectangle touches must have an occluder in front of the box
+	int firstX = std::max(0, (int)std::floor(minX)), lastX = std::min(m_width - 1, (int)std::floor(maxX));
+	int firstY = std::max(0, (int)std::floor(minY)), lastY = std::min(m_height - 1, (int)std::floor(maxY));
+	for (int ty = firstY / TileSize; ty <= lastY / TileSize; ++ty) {
+		for (int tx = firstX / TileSize; tx <= lastX / TileSize; ++tx) {
+			if (m_tileMaxDepth[ty * m_tilesX + tx] < nearest) {
+				continue;
+			}
+			int pyEnd = std::min(lastY, (ty + 1) * TileSize - 1);
+			int pxEnd = std::min(lastX, (tx + 1) * TileSize - 1);
+			for (int py = std::max(firstY, ty * TileSize); py <= pyEnd; ++py) {
+				for (int px = std::max(firstX, tx * TileSize); px <= pxEnd; ++px) {
+					if (m_depth[py * m_width + px] >= nearest) {
+						return false;
+					}
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+
+} // namespace gxeng
+} // namespace inl
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "BoundingVolume.hpp"
+
+#include <mathfu/matrix_4x4.h>
+
+#include <vector>
+#include <cstdint>
+
+
+namespace inl {
+namespace gxeng {
+
+
+/// <summary>
+/// Low resolution depth buffer rasterized on the CPU for occlusion culling.
+/// <para />
+/// Occluders are drawn with RasterizeOccluder, then after UpdateHierarchy, boxes can be tested
+/// against the occluders with IsOccluded. Each pixel keeps the nearest occluder depth, and each
+/// tile of TileSize x TileSize pixels keeps the farthest depth of its pixels, so most boxes
+/// are decided by a few tiles without looking at pixels.
+/// Depth is D3D clip space depth, 0 at the near plane and 1 at the far plane.
+/// </summary>
+/// <remarks> Testing is thread-safe, rasterizing is not. </remarks>
+class OcclusionBuffer {
+public:
+	static constexpr int TileSize = 8;
+public:
+	/// <summary> Creates a buffer of the given size, rounded up to whole tiles. </summary>
+	OcclusionBuffer(int width = 256, int height = 144);
+
+	int GetWidth() const { return m_width; }
+	int GetHeight() const { return m_height; }
+
+	/// <summary> Removes all occluders. </summary>
+	void Clear();
+
+	/// <summary> Draws the triangles of an occluder. </summary>
+	/// <param name="mvp"> Transforms the positions to clip space. </param>
+	/// <remarks> Triangles crossing the near plane are skipped, so they never hide anything. Both faces are drawn. </remarks>
+	void RasterizeOccluder(const mathfu::Vector<float, 3>* positions,
+						   size_t numPositions,
+						   const unsigned* indices,
+						   size_t numIndices,
+						   const mathfu::Matrix<float, 4, 4>& mvp);
+
+	/// <summary> Updates the per tile depths. Call after rasterizing and before testing. </summary>
+	void UpdateHierarchy();
+
+	/// <summary> Whether the box is certainly hidden by the occluders. </summary>
+	/// <param name="viewProjection"> Transforms the box to clip space. </param>
+	/// <remarks> Boxes crossing the near plane or entirely outside the screen are never occluded. </remarks>
+	bool IsOccluded(const Aabb& box, const mathfu::Matrix<float, 4, 4>& viewProjection) const;
+
+	/// <summary> Nearest occluder depth at the pixel, 1 if there is no occluder. </summary>
+	float GetDepth(int x, int y) const { return m_depth[y * m_width + x]; }
+private:
+	void RasterizeTriangle(const mathfu::Vector<float, 4>& v0, const mathfu::Vector<float, 4>& v1, const mathfu::Vector<float, 4>& v2);
+private:
+	int m_width;
+	int m_height;
+	int m_tilesX;
+	int m_tilesY;
+	std::vector<float> m_depth;
+	std::vector<float> m_tileMaxDepth;
+	std::vector<mathfu::Vector<float, 4>> m_transformed;
+};
+
+
+} // namespace gxeng
+} // namespace inl
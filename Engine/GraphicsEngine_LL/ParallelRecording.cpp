@@ -0,0 +1,27 @@
+#include "ParallelRecording.hpp"
+
+
+namespace inl {
+namespace gxeng {
+
+
+std::vector<RecordingChunk> SplitRecording(size_t count, size_t minItemsPerChunk, size_t maxChunks) {
+	std::vector<RecordingChunk> chunks;
+	if (count == 0) {
+		return chunks;
+	}
+
+	size_t numChunks = std::min(std::max(maxChunks, size_t(1)), std::max(count / std::max(minItemsPerChunk, size_t(1)), size_t(1)));
+	size_t first = 0;
+	for (size_t i = 0; i < numChunks; ++i) {
+		size_t end = count * (i + 1) / numChunks;
+		chunks.push_back({ first, end });
+		first = end;
+	}
+
+	return chunks;
+}
+
+
+} // namespace gxeng
+} // namespace inl
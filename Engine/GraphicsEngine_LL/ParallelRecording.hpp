@@ -0,0 +1,72 @@
+#pragma once
+
+#include "ExecutionContext.hpp"
+#include "ExecutionResult.hpp"
+#include "GraphicsCommandList.hpp"
+#include "VolatileViewHeap.hpp"
+
+#include <vector>
+#include <future>
+#include <thread>
+#include <algorithm>
+
+
+namespace inl {
+namespace gxeng {
+
+
+/// <summary> Items [first, end) recorded into one command list. </summary>
+struct RecordingChunk {
+	size_t first;
+	size_t end;
+};
+
+
+/// <summary> Splits items into at most maxChunks chunks of nearly equal size, with at least
+///		minItemsPerChunk items in each but the only chunk. </summary>
+/// <returns> The chunks in order, none if there are no items. </returns>
+std::vector<RecordingChunk> SplitRecording(size_t count, size_t minItemsPerChunk, size_t maxChunks);
+
+
+/// <summary>
+/// Records items into several graphics command lists on several threads, and adds the lists to
+/// the result in the order of the items.
+/// Each list has its own scratch space and volatile view heap, so recording needs no locking.
+/// </summary>
+/// <param name="record"> Called as record(commandList, viewHeap, first, end) for each chunk, concurrently.
+///		Lists don't inherit state from each other, each must set the render targets, pipeline state etc. </param>
+template <class RecordFunc>
+void RecordInParallel(const ExecutionContext& context, ExecutionResult& result, size_t count, size_t minItemsPerChunk, RecordFunc&& record) {
+	size_t maxChunks = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<RecordingChunk> chunks = SplitRecording(count, minItemsPerChunk, maxChunks);
+
+	std::vector<GraphicsCommandList> lists;
+	std::vector<VolatileViewHeap> viewHeaps;
+	for (size_t i = 0; i < chunks.size(); ++i) {
+		lists.push_back(context.GetGraphicsCommandList());
+		viewHeaps.push_back(context.GetVolatileViewHeap());
+	}
+
+	// the first chunk is recorded on this thread
+	std::vector<std::future<void>> workers;
+	for (size_t i = 1; i < chunks.size(); ++i) {
+		workers.push_back(std::async(std::launch::async, [&, i] {
+			record(lists[i], viewHeaps[i], chunks[i].first, chunks[i].end);
+		}));
+	}
+	if (!chunks.empty()) {
+		record(lists[0], viewHeaps[0], chunks[0].first, chunks[0].end);
+	}
+	for (auto& worker : workers) {
+		worker.get();
+	}
+
+	for (size_t i = 0; i < chunks.size(); ++i) {
+		result.AddCommandList(std::move(lists[i]));
+		result.GiveVolatileViewHeap(std::move(viewHeaps[i]));
+	}
+}
+
+
+} // namespace gxeng
+} // namespace inl
@@ -0,0 +1,404 @@
+#include "PipelineStateCache.hpp"
+#include "RootSignatureCache.hpp"
+
+#include "../GraphicsApi_LL/IGraphicsApi.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <cstring>
+
+
+namespace inl {
+namespace gxeng {
+
+
+static constexpr uint32_t CacheFileMagic = 0x43535049; // "IPSC"
+static constexpr uint32_t CacheFileVersion = 1;
+
+namespace fs = std::experimental::filesystem;
+
+
+static constexpr uint32_t GraphicsKeyTag = 'G';
+static constexpr uint32_t ComputeKeyTag = 'C';
+
+
+PipelineStateCache::PipelineStateCache(gxapi::IGraphicsApi* gxApi)
+	: m_gxApi(gxApi)
+{}
+
+
+std::shared_ptr<gxapi::IPipelineState> PipelineStateCache::Get(const gxapi::GraphicsPipelineStateDesc& desc) {
+	return GetOrCreate(desc);
+}
+
+
+std::shared_ptr<gxapi::IPipelineState> PipelineStateCache::Get(const gxapi::ComputePipelineStateDesc& desc) {
+	return GetOrCreate(desc);
+}
+
+
+template <class DescT>
+std::shared_ptr<gxapi::IPipelineState> PipelineStateCache::GetOrCreate(const DescT& desc) {
+	bool persistent;
+	std::vector<uint32_t> key = Serialize(desc, persistent);
+	uint64_t hash = Hash(key);
+
+	auto findLive = [&]() -> std::shared_ptr<gxapi::IPipelineState> {
+		auto candidates = m_liveEntries.equal_range(hash);
+		for (auto it = candidates.first; it != candidates.second;) {
+			std::shared_ptr<gxapi::IPipelineState> pipelineState = it->second.pipelineState.lock();
+			if (!pipelineState) {
+				// drop entries whose PSO is no longer used
+				it = m_liveEntries.erase(it);
+				continue;
+			}
+			if (it->second.key == key) {
+				return pipelineState;
+			}
+			++it;
+		}
+		return nullptr;
+	};
+
+	std::unique_lock<std::mutex> lk(m_mutex);
+	if (auto pipelineState = findLive()) {
+		return pipelineState;
+	}
+	// copy the blob so that compilation can run without holding the lock
+	const std::vector<uint8_t>* storedBlob = persistent ? FindBlob(hash, key) : nullptr;
+	std::vector<uint8_t> blob = storedBlob ? *storedBlob : std::vector<uint8_t>{};
+	lk.unlock();
+
+	std::shared_ptr<gxapi::IPipelineState> pipelineState(Create(desc, storedBlob ? &blob : nullptr));
+	std::vector<uint8_t> compiledBlob;
+	if (persistent && !storedBlob) {
+		compiledBlob = pipelineState->GetCachedBlob();
+	}
+
+	lk.lock();
+	// another thread might have created the same PSO meanwhile
+	if (auto existing = findLive()) {
+		return existing;
+	}
+	m_liveEntries.insert({ hash, LiveEntry{ key, pipelineState } });
+	if (!compiledBlob.empty() && !FindBlob(hash, key)) {
+		m_blobEntries.insert({ hash, BlobEntry{ std::move(key), std::move(compiledBlob) } });
+	}
+
+	return pipelineState;
+}
+
+
+gxapi::IPipelineState* PipelineStateCache::Create(gxapi::GraphicsPipelineStateDesc desc, const std::vector<uint8_t>* blob) {
+	if (blob) {
+		desc.cachedState = { blob->data(), blob->size() };
+	}
+	return m_gxApi->CreateGraphicsPipelineState(desc);
+}
+
+
+gxapi::IPipelineState* PipelineStateCache::Create(gxapi::ComputePipelineStateDesc desc, const std::vector<uint8_t>* blob) {
+	if (blob) {
+		desc.cachedState = { blob->data(), blob->size() };
+	}
+	return m_gxApi->CreateComputePipelineState(desc);
+}
+
+
+std::vector<std::shared_ptr<gxapi::IPipelineState>> PipelineStateCache::GetLivePipelineStates() const {
+	std::lock_guard<std::mutex> lkg(m_mutex);
+
+	std::vector<std::shared_ptr<gxapi::IPipelineState>> pipelineStates;
+	for (const auto& entry : m_liveEntries) {
+		if (auto pipelineState = entry.second.pipelineState.lock()) {
+			pipelineStates.push_back(std::move(pipelineState));
+		}
+	}
+	return pipelineStates;
+}
+
+
+const std::vector<uint8_t>* PipelineStateCache::FindBlob(uint64_t hash, const std::vector<uint32_t>& key) const {
+	auto candidates = m_blobEntries.equal_range(hash);
+	for (auto it = candidates.first; it != candidates.second; ++it) {
+		if (it->second.key == key) {
+			return &it->second.blob;
+		}
+	}
+	return nullptr;
+}
+
+
+//------------------------------------------------------------------------------
+// Persistence
+//------------------------------------------------------------------------------
+
+bool PipelineStateCache::Load(const std::string& path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		return false;
+	}
+
+	// Sizes read from the file are checked against what is left of it before anything is allocated
+	file.seekg(0, std::ios::end);
+	uint64_t remaining = (uint64_t)file.tellg();
+	file.seekg(0, std::ios::beg);
+
+	auto read = [&file, &remaining](void* data, uint64_t size) {
+		if (size > remaining) {
+			return false;
+		}
+		file.read(reinterpret_cast<char*>(data), size);
+		remaining -= size;
+		return (bool)file;
+	};
+
+	uint32_t magic, version, count;
+	if (!read(&magic, 4) || !read(&version, 4) || !read(&count, 4)
+		|| magic != CacheFileMagic || version != CacheFileVersion)
+	{
+		return false;
+	}
+
+	// an entry is at least its two sizes
+	if (count > remaining / 8) {
+		return false;
+	}
+
+	std::vector<BlobEntry> entries(count);
+	for (auto& entry : entries) {
+		uint32_t keySize, blobSize;
+		if (!read(&keySize, 4) || uint64_t(keySize) * sizeof(uint32_t) > remaining) {
+			return false;
+		}
+		entry.key.resize(keySize);
+		if (!read(entry.key.data(), keySize * sizeof(uint32_t)) || !read(&blobSize, 4) || blobSize > remaining) {
+			return false;
+		}
+		entry.blob.resize(blobSize);
+		if (!read(entry.blob.data(), blobSize)) {
+			return false;
+		}
+	}
+
+	std::lock_guard<std::mutex> lkg(m_mutex);
+	for (auto& entry : entries) {
+		uint64_t hash = Hash(entry.key);
+		if (!FindBlob(hash, entry.key)) {
+			m_blobEntries.insert({ hash, std::move(entry) });
+		}
+	}
+
+	return true;
+}
+
+
+void PipelineStateCache::Save(const std::string& path) const {
+	// Written to a temporary file first, so a failed save leaves the previous cache file intact.
+	std::stringstream tempName;
+	tempName << path << "." << std::this_thread::get_id() << ".tmp";
+	fs::path tempPath = tempName.str();
+
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			throw std::runtime_error("Could not open pipeline cache file for writing: " + path);
+		}
+
+		auto write = [&file](const void* data, size_t size) {
+			file.write(reinterpret_cast<const char*>(data), size);
+		};
+
+		std::lock_guard<std::mutex> lkg(m_mutex);
+
+		uint32_t count = (uint32_t)m_blobEntries.size();
+		write(&CacheFileMagic, 4);
+		write(&CacheFileVersion, 4);
+		write(&count, 4);
+		for (const auto& entry : m_blobEntries) {
+			uint32_t keySize = (uint32_t)entry.second.key.size();
+			uint32_t blobSize = (uint32_t)entry.second.blob.size();
+			write(&keySize, 4);
+			write(entry.second.key.data(), keySize * sizeof(uint32_t));
+			write(&blobSize, 4);
+			write(entry.second.blob.data(), blobSize);
+		}
+
+		if (!file) {
+			file.close();
+			std::error_code ec;
+			fs::remove(tempPath, ec);
+			throw std::runtime_error("Failed to write pipeline cache file: " + path);
+		}
+	}
+
+	std::error_code ec;
+	fs::rename(tempPath, path, ec);
+	if (ec) {
+		fs::remove(tempPath, ec);
+		throw std::runtime_error("Failed to replace pipeline cache file: " + path);
+	}
+}
+
+
+size_t PipelineStateCache::GetNumBlobs() const {
+	std::lock_guard<std::mutex> lkg(m_mutex);
+	return m_blobEntries.size();
+}
+
+
+//------------------------------------------------------------------------------
+// Serialization
+//------------------------------------------------------------------------------
+
+std::vector<uint32_t> PipelineStateCache::Serialize(const gxapi::GraphicsPipelineStateDesc& desc, bool& persistent) {
+	auto floatBits = [](float value) {
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	};
+
+	std::vector<uint32_t> key;
+	persistent = true;
+
+	key.push_back(GraphicsKeyTag);
+	SerializeRootSignature(key, desc.rootSignature, persistent);
+
+	SerializeShader(key, desc.vs);
+	SerializeShader(key, desc.gs);
+	SerializeShader(key, desc.hs);
+	SerializeShader(key, desc.ds);
+	SerializeShader(key, desc.ps);
+
+	const auto& rasterization = desc.rasterization;
+	key.push_back((uint32_t)rasterization.fillMode);
+	key.push_back((uint32_t)rasterization.cullMode);
+	key.push_back((uint32_t)rasterization.depthBias);
+	key.push_back(floatBits(rasterization.depthBiasClamp));
+	key.push_back(floatBits(rasterization.slopeScaledDepthBias));
+	key.push_back(rasterization.depthClipEnabled);
+	key.push_back(rasterization.multisampleEnabled);
+	key.push_back(rasterization.lineAntialiasingEnabled);
+	key.push_back(rasterization.forcedSampleCount);
+	key.push_back((uint32_t)rasterization.conservativeRasterization);
+
+	const auto& depthStencil = desc.depthStencilState;
+	key.push_back(depthStencil.enableDepthTest);
+	key.push_back(depthStencil.enableDepthStencilWrite);
+	key.push_back((uint32_t)depthStencil.depthFunc);
+	key.push_back(depthStencil.enableStencilTest);
+	key.push_back(depthStencil.stencilReadMask);
+	key.push_back(depthStencil.stencilWriteMask);
+	for (const auto& face : { depthStencil.cwFace, depthStencil.ccwFace }) {
+		key.push_back((uint32_t)face.stencilOpOnStencilFail);
+		key.push_back((uint32_t)face.stencilOpOnDepthFail);
+		key.push_back((uint32_t)face.stencilOpOnPass);
+		key.push_back((uint32_t)face.stencilFunc);
+	}
+
+	key.push_back(desc.blending.alphaToCoverage);
+	key.push_back(desc.blending.independentBlending);
+	for (const auto& target : desc.blending.multiTarget) {
+		gxapi::eColorMask mask = target.mask;
+		key.push_back(target.enableBlending);
+		key.push_back(target.enableLogicOp);
+		key.push_back((uint32_t)target.colorOperand1);
+		key.push_back((uint32_t)target.colorOperand2);
+		key.push_back((uint32_t)target.colorOperation);
+		key.push_back((uint32_t)target.alphaOperand1);
+		key.push_back((uint32_t)target.alphaOperand2);
+		key.push_back((uint32_t)target.alphaOperation);
+		key.push_back((uint32_t)static_cast<gxapi::bitflag_enum_impl::eColorMask_Base::eColorMask>(mask));
+		key.push_back((uint32_t)target.logicOperation);
+	}
+	key.push_back(desc.blendSampleMask);
+
+	key.push_back(desc.inputLayout.numElements);
+	for (unsigned i = 0; i < desc.inputLayout.numElements; ++i) {
+		const auto& element = desc.inputLayout.elements[i];
+		uint64_t nameHash = element.semanticName ? Hash(element.semanticName, std::strlen(element.semanticName)) : 0;
+		key.push_back((uint32_t)nameHash);
+		key.push_back((uint32_t)(nameHash >> 32));
+		key.push_back(element.semanticIndex);
+		key.push_back((uint32_t)element.format);
+		key.push_back(element.inputSlot);
+		key.push_back(element.offset);
+		key.push_back((uint32_t)element.classifiacation);
+		key.push_back(element.instanceDataStepRate);
+	}
+	key.push_back((uint32_t)desc.primitiveTopologyType);
+	key.push_back((uint32_t)desc.triangleStripCutIndex);
+
+	key.push_back(desc.numRenderTargets);
+	for (auto format : desc.renderTargetFormats) {
+		key.push_back((uint32_t)format);
+	}
+	key.push_back((uint32_t)desc.depthStencilFormat);
+	key.push_back(desc.multisampleCount);
+	key.push_back(desc.multisampleQuality);
+
+	key.push_back(desc.addDebugInfo);
+
+	return key;
+}
+
+
+std::vector<uint32_t> PipelineStateCache::Serialize(const gxapi::ComputePipelineStateDesc& desc, bool& persistent) {
+	std::vector<uint32_t> key;
+	persistent = true;
+
+	key.push_back(ComputeKeyTag);
+	SerializeRootSignature(key, desc.rootSignature, persistent);
+	SerializeShader(key, desc.cs);
+	key.push_back(desc.addDebugInfo);
+
+	return key;
+}
+
+
+void PipelineStateCache::SerializeRootSignature(std::vector<uint32_t>& key, const gxapi::IRootSignature* rootSignature, bool& persistent) {
+	std::vector<uint32_t> rootSignatureKey;
+	if (RootSignatureCache::FindKey(rootSignature, rootSignatureKey)) {
+		key.push_back((uint32_t)rootSignatureKey.size());
+		key.insert(key.end(), rootSignatureKey.begin(), rootSignatureKey.end());
+	}
+	else {
+		// not shared through the root signature cache, only the object itself identifies it
+		uint64_t address = (uint64_t)reinterpret_cast<uintptr_t>(rootSignature);
+		key.push_back(~0u);
+		key.push_back((uint32_t)address);
+		key.push_back((uint32_t)(address >> 32));
+		persistent = false;
+	}
+}
+
+
+void PipelineStateCache::SerializeShader(std::vector<uint32_t>& key, const gxapi::ShaderByteCodeDesc& shader) {
+	uint64_t hash = shader.sizeOfByteCode > 0 ? Hash(shader.shaderByteCode, shader.sizeOfByteCode) : 0;
+	key.push_back((uint32_t)shader.sizeOfByteCode);
+	key.push_back((uint32_t)hash);
+	key.push_back((uint32_t)(hash >> 32));
+}
+
+
+uint64_t PipelineStateCache::Hash(const void* data, size_t size, uint64_t hash) {
+	// FNV-1a
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+
+uint64_t PipelineStateCache::Hash(const std::vector<uint32_t>& key) {
+	return Hash(key.data(), key.size() * sizeof(uint32_t));
+}
+
+
+} // namespace gxeng
+} // namespace inl
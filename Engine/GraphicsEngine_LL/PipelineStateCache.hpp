@@ -0,0 +1,102 @@
+#pragma once
+
+#include "../GraphicsApi_LL/IPipelineState.hpp"
+#include "../GraphicsApi_LL/Common.hpp"
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+
+
+namespace inl {
+namespace gxapi {
+	class IGraphicsApi;
+}
+}
+
+
+namespace inl {
+namespace gxeng {
+
+
+/// <summary>
+/// Shares pipeline state objects between nodes and keeps compiled pipelines across runs.
+/// <para />
+/// PSOs are identified by a canonical serialization of their description, in which
+/// shader stages are represented by the hash of their bytecode. Nodes that request
+/// the same pipeline get the same object, and a PSO is released when the last node
+/// using it drops its reference.
+/// <para />
+/// The driver's compiled blob of each PSO is remembered and can be written to disk
+/// with Save. After Load, creating the same PSO again passes the blob to the driver,
+/// which then skips most of the compilation.
+/// <para />
+/// This class is thread safe.
+/// </summary>
+class PipelineStateCache {
+public:
+	PipelineStateCache(gxapi::IGraphicsApi* gxApi);
+
+	/// <summary> Returns a PSO for the description, creates one if there's no such object yet. </summary>
+	std::shared_ptr<gxapi::IPipelineState> Get(const gxapi::GraphicsPipelineStateDesc& desc);
+
+	/// <summary> Returns a PSO for the description, creates one if there's no such object yet. </summary>
+	std::shared_ptr<gxapi::IPipelineState> Get(const gxapi::ComputePipelineStateDesc& desc);
+
+	/// <summary> References to the PSOs still in use, to keep them alive while the GPU may use them. </summary>
+	std::vector<std::shared_ptr<gxapi::IPipelineState>> GetLivePipelineStates() const;
+
+	/// <summary> Reads compiled blobs from a file written by Save. </summary>
+	/// <returns> False if the file does not exist or is not a valid cache file. </returns>
+	bool Load(const std::string& path);
+
+	/// <summary> Writes compiled blobs of all PSOs created so far or previously loaded to a file. </summary>
+	/// <exception cref="std::runtime_error"> If the file could not be written. </exception>
+	void Save(const std::string& path) const;
+
+	/// <summary> Number of PSOs that have a compiled blob. </summary>
+	size_t GetNumBlobs() const;
+
+	/// <summary> Flattens the description into a sequence of words. Equal descriptions give equal sequences. </summary>
+	/// <param name="persistent"> Set to false if the sequence is only valid in this process,
+	///		i.e. because the root signature is not known to RootSignatureCache. </param>
+	static std::vector<uint32_t> Serialize(const gxapi::GraphicsPipelineStateDesc& desc, bool& persistent);
+
+	/// <summary> Flattens the description into a sequence of words. Equal descriptions give equal sequences. </summary>
+	static std::vector<uint32_t> Serialize(const gxapi::ComputePipelineStateDesc& desc, bool& persistent);
+private:
+	struct LiveEntry {
+		std::vector<uint32_t> key;
+		std::weak_ptr<gxapi::IPipelineState> pipelineState;
+	};
+	struct BlobEntry {
+		std::vector<uint32_t> key;
+		std::vector<uint8_t> blob;
+	};
+
+	template <class DescT>
+	std::shared_ptr<gxapi::IPipelineState> GetOrCreate(const DescT& desc);
+
+	gxapi::IPipelineState* Create(gxapi::GraphicsPipelineStateDesc desc, const std::vector<uint8_t>* blob);
+	gxapi::IPipelineState* Create(gxapi::ComputePipelineStateDesc desc, const std::vector<uint8_t>* blob);
+
+	const std::vector<uint8_t>* FindBlob(uint64_t hash, const std::vector<uint32_t>& key) const;
+
+	static void SerializeRootSignature(std::vector<uint32_t>& key, const gxapi::IRootSignature* rootSignature, bool& persistent);
+	static void SerializeShader(std::vector<uint32_t>& key, const gxapi::ShaderByteCodeDesc& shader);
+	static uint64_t Hash(const void* data, size_t size, uint64_t hash = 14695981039346656037ull);
+	static uint64_t Hash(const std::vector<uint32_t>& key);
+private:
+	gxapi::IGraphicsApi* m_gxApi;
+
+	mutable std::mutex m_mutex;
+	std::unordered_multimap<uint64_t, LiveEntry> m_liveEntries;
+	std::unordered_multimap<uint64_t, BlobEntry> m_blobEntries;
+};
+
+
+} // namespace gxeng
+} // namespace inl
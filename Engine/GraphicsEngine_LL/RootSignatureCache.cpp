@@ -0,0 +1,141 @@
+#include "RootSignatureCache.hpp"
+
+#include "../GraphicsApi_LL/IGraphicsApi.hpp"
+
+#include <cstring>
+
+
+namespace inl {
+namespace gxeng {
+
+
+std::mutex RootSignatureCache::s_mutex;
+std::unordered_multimap<size_t, RootSignatureCache::Entry> RootSignatureCache::s_entries;
+
+
+std::shared_ptr<gxapi::IRootSignature> RootSignatureCache::Get(gxapi::IGraphicsApi* gxApi, const gxapi::RootSignatureDesc& desc) {
+	std::vector<uint32_t> key = Serialize(desc);
+	size_t hash = Hash(key);
+
+	std::lock_guard<std::mutex> lkg(s_mutex);
+
+	auto candidates = s_entries.equal_range(hash);
+	for (auto it = candidates.first; it != candidates.second;) {
+		std::shared_ptr<gxapi::IRootSignature> rootSignature = it->second.rootSignature.lock();
+		if (!rootSignature) {
+			// drop entries whose root signature is no longer used
+			it = s_entries.erase(it);
+			continue;
+		}
+		if (it->second.gxApi == gxApi && it->second.key == key) {
+			return rootSignature;
+		}
+		++it;
+	}
+
+	std::shared_ptr<gxapi::IRootSignature> rootSignature(gxApi->CreateRootSignature(desc));
+	s_entries.insert({ hash, Entry{ gxApi, std::move(key), rootSignature } });
+
+	return rootSignature;
+}
+
+
+bool RootSignatureCache::FindKey(const gxapi::IRootSignature* rootSignature, std::vector<uint32_t>& key) {
+	if (rootSignature == nullptr) {
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lkg(s_mutex);
+
+	for (const auto& entry : s_entries) {
+		if (entry.second.rootSignature.lock().get() == rootSignature) {
+			key = entry.second.key;
+			return true;
+		}
+	}
+	return false;
+}
+
+
+std::vector<uint32_t> RootSignatureCache::Serialize(const gxapi::RootSignatureDesc& desc) {
+	auto floatBits = [](float value) {
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	};
+
+	std::vector<uint32_t> key;
+
+	key.push_back((uint32_t)desc.rootParameters.size());
+	for (const auto& param : desc.rootParameters) {
+		key.push_back((uint32_t)param.type);
+		key.push_back((uint32_t)param.shaderVisibility);
+		switch (param.type) {
+			case gxapi::RootParameterDesc::CONSTANT: {
+				const auto& constant = param.As<gxapi::RootParameterDesc::CONSTANT>();
+				key.push_back(constant.shaderRegister);
+				key.push_back(constant.registerSpace);
+				key.push_back(constant.numConstants);
+				break;
+			}
+			case gxapi::RootParameterDesc::CBV:
+			case gxapi::RootParameterDesc::SRV:
+			case gxapi::RootParameterDesc::UAV: {
+				const auto& descriptor = param.type == gxapi::RootParameterDesc::CBV ? param.As<gxapi::RootParameterDesc::CBV>()
+					: param.type == gxapi::RootParameterDesc::SRV ? param.As<gxapi::RootParameterDesc::SRV>()
+					: param.As<gxapi::RootParameterDesc::UAV>();
+				key.push_back(descriptor.shaderRegister);
+				key.push_back(descriptor.registerSpace);
+				break;
+			}
+			case gxapi::RootParameterDesc::DESCRIPTOR_TABLE: {
+				const auto& ranges = param.As<gxapi::RootParameterDesc::DESCRIPTOR_TABLE>().ranges;
+				key.push_back((uint32_t)ranges.size());
+				for (const auto& range : ranges) {
+					key.push_back((uint32_t)range.type);
+					key.push_back(range.numDescriptors);
+					key.push_back(range.baseShaderRegister);
+					key.push_back(range.registerSpace);
+					key.push_back(range.offsetFromTableStart);
+				}
+				break;
+			}
+			default:
+				break;
+		}
+	}
+
+	key.push_back((uint32_t)desc.staticSamplers.size());
+	for (const auto& sampler : desc.staticSamplers) {
+		key.push_back((uint32_t)sampler.filter);
+		key.push_back((uint32_t)sampler.addressU);
+		key.push_back((uint32_t)sampler.addressV);
+		key.push_back((uint32_t)sampler.addressW);
+		key.push_back(floatBits(sampler.mipLevelBias));
+		key.push_back(sampler.maxAnisotropy);
+		key.push_back((uint32_t)sampler.compareFunc);
+		key.push_back((uint32_t)sampler.border);
+		key.push_back(floatBits(sampler.minMipLevel));
+		key.push_back(floatBits(sampler.maxMipLevel));
+		key.push_back(sampler.shaderRegister);
+		key.push_back(sampler.registerSpace);
+		key.push_back((uint32_t)sampler.shaderVisibility);
+	}
+
+	return key;
+}
+
+
+size_t RootSignatureCache::Hash(const std::vector<uint32_t>& key) {
+	// FNV-1a
+	uint64_t hash = 14695981039346656037ull;
+	for (uint32_t word : key) {
+		hash ^= word;
+		hash *= 1099511628211ull;
+	}
+	return (size_t)hash;
+}
+
+
+} // namespace gxeng
+} // namespace inl
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "../GraphicsApi_LL/IRootSignature.hpp"
+#include "../GraphicsApi_LL/Common.hpp"
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <cstdint>
+
+
+namespace inl {
+namespace gxapi {
+	class IGraphicsApi;
+}
+}
+
+
+namespace inl {
+namespace gxeng {
+
+
+/// <summary>
+/// Shares root signature objects between binders with identical layouts.
+/// <para />
+/// Root signatures are identified by their canonical description, so nodes that
+/// bind the same parameters end up with the very same root signature object,
+/// and switching between them needs no root signature change on the command list.
+/// A root signature is released when the last binder using it is destroyed.
+/// <para />
+/// This class is thread safe.
+/// </summary>
+class RootSignatureCache {
+public:
+	/// <summary> Returns a root signature for the description, creates one if there's no such object yet. </summary>
+	static std::shared_ptr<gxapi::IRootSignature> Get(gxapi::IGraphicsApi* gxApi, const gxapi::RootSignatureDesc& desc);
+
+	/// <summary> Flattens the description into a sequence of words. Equal descriptions give equal sequences. </summary>
+	static std::vector<uint32_t> Serialize(const gxapi::RootSignatureDesc& desc);
+
+	/// <summary> Finds the serialized description of a root signature created by this cache. </summary>
+	/// <returns> False if the root signature was not created by the cache. </returns>
+	static bool FindKey(const gxapi::IRootSignature* rootSignature, std::vector<uint32_t>& key);
+private:
+	struct Entry {
+		gxapi::IGraphicsApi* gxApi;
+		std::vector<uint32_t> key;
+		std::weak_ptr<gxapi::IRootSignature> rootSignature;
+	};
+
+	static size_t Hash(const std::vector<uint32_t>& key);
+
+	static std::mutex s_mutex;
+	static std::unordered_multimap<size_t, Entry> s_entries;
+};
+
+
+} // namespace gxeng
+} // namespace inl
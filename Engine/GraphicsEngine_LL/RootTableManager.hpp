@@ -1,6 +1,9 @@
 #pragma once
 
 #include <vector>
+#include <unordered_map>
+#include <functional>
+#include <algorithm>
 #include <utility>
 #include <cassert>
 #include <type_traits>
@@ -13,18 +16,30 @@ namespace inl::gxeng {
 
 
 struct DescriptorTableState {
-	DescriptorTableState() : slot(0), committed(false) {}
-	DescriptorTableState(DescriptorArrayRef&& reference, int slot)
-		: reference(std::move(reference)), slot(slot), committed(false)
+	DescriptorTableState() : slot(0), dirty(true), bound(false), reserved(false) {}
+	DescriptorTableState(int slot, size_t numDescriptors)
+		: slot(slot), dirty(true), bound(false), reserved(false), bindings(numDescriptors)
 	{}
 
 	DescriptorArrayRef reference; // current place in scratch space
 	int slot; // which root signature slot it belongs to
-	bool committed; // true if modifying descriptor in sratch space would break previous draw calls
+	bool dirty; // true if bindings changed since reference was last resolved
+	bool bound; // true if reference is set as the root table on the command list
+	bool reserved; // true if the table points to the reserved range of the scratch space instead of its bindings
 	std::vector<gxapi::DescriptorHandle> bindings; // currently bound descriptor handle, staging heap sources
 };
 
 
+/// <summary>
+/// A scratch space range that was already filled with a certain combination of descriptors.
+/// Such ranges are never modified, so any table with the same bindings may point to them.
+/// </summary>
+struct CachedDescriptorTable {
+	std::vector<gxapi::DescriptorHandle> bindings;
+	DescriptorArrayRef reference;
+};
+
+
 
 template <gxapi::eCommandListType Type>
 class RootTableManager {
@@ -36,16 +51,36 @@ protected:
 public:
 	RootTableManager();
 	RootTableManager(gxapi::IGraphicsApi* graphicsApi, CommandListT* commandList);
-	void SetBinder(Binder* binder);
+	/// <summary> Sets the root signature of the binder unless the previous binder had the same one. </summary>
+	/// <returns> True if the root signature was set. </returns>
+	bool SetBinder(Binder* binder);
 	void SetDescriptorHeap(StackDescHeap* heap);
+
+	/// <summary> Forgets the binder and the tables, the next binder sets its root signature again.
+	///		Used after the state of the command list was cleared. </summary>
+	void InvalidateRootSignature();
+
+	/// <summary> Number of root signature and root argument calls passed on to the command list. </summary>
+	size_t GetNumSubmittedCalls() const { return m_numSubmittedCalls; }
+	/// <summary> Number of root signature and root argument calls dropped because they would have set what was already set. </summary>
+	size_t GetNumFilteredCalls() const { return m_numFilteredCalls; }
+
+	/// <summary> Resolves and sets all changed root tables. Call this right before each drawcall. </summary>
+	/// <exception cref="std::bad_alloc"> If the current scratch space is full. </exception>
 	void CommitDrawCall();
 	void UpdateBinding(gxapi::DescriptorHandle handle, int rootSignatureSlot, int indexInTable);
+	/// <summary> Points the table to the reserved range of the scratch space, which holds the texture table. </summary>
+	void UpdateReservedTable(int rootSignatureSlot);
 private:
-	/// <summary> Updates a binding which is managed on the scratch space. </summary>
+	/// <summary> Updates a binding which is managed on the scratch space. Nothing is copied until the next draw. </summary>
 	void UpdateRootTable(gxapi::DescriptorHandle, int rootSignatureSlot, int indexInTable);
 
-	/// <summary> Copies a whole scratch space table to a fresh range in scratch space. </summary>
-	void DuplicateRootTable(DescriptorTableState& table);
+	/// <summary> Points the table to a scratch space range holding its bindings.
+	/// An identical range is reused if there is one, otherwise a new range is filled. </summary>
+	void ResolveRootTable(DescriptorTableState& table);
+
+	/// <summary> Copies the bindings to the destination range, merging contiguous source descriptors. </summary>
+	void CopyBindings(const std::vector<gxapi::DescriptorHandle>& bindings, DescriptorArrayRef& destination);
 
 	/// <summary> Get reference to root table state identified by it's root signature slot. </summary>
 	DescriptorTableState&  FindRootTable(int rootSignatureSlot);
@@ -53,12 +88,14 @@ private:
 	/// <summary> Calculates root table states based on the currently bound Binder. </summary>
 	void InitRootTables();
 
-	/// <summary> Marks all root tables committed. Call this after each drawcall. </summary>
+	/// <summary> Resolves and sets all dirty root tables. </summary>
 	void CommitRootTables();
 
-	/// <summary> Copies ALL scratch space tables to a fresh range. Used after a new scratch space is bound. </summary>
+	/// <summary> Forgets ALL scratch space ranges. Used after a new scratch space is bound. </summary>
 	void RenewRootTables();
 
+	static size_t HashBindings(const std::vector<gxapi::DescriptorHandle>& bindings);
+
 	void SetRootDescriptorTable(gxapi::IGraphicsCommandList* list, unsigned parameterIndex, gxapi::DescriptorHandle baseHandle);
 	void SetRootDescriptorTable(gxapi::IComputeCommandList* list, unsigned parameterIndex, gxapi::DescriptorHandle baseHandle);
 	void SetRootSignature(gxapi::IGraphicsCommandList* list, gxapi::IRootSignature* sig);
@@ -68,8 +105,17 @@ protected:
 	CommandListT* m_commandList;
 	Binder* m_binder;
 	StackDescHeap* m_heap;
+	size_t m_numSubmittedCalls = 0;
+	size_t m_numFilteredCalls = 0;
 private:
 	std::vector<DescriptorTableState> m_rootTableStates;
+	std::unordered_multimap<size_t, CachedDescriptorTable> m_tableCache; // ranges on the current scratch space by hash of bindings
+
+	// reused between copies to avoid allocations
+	std::vector<gxapi::DescriptorHandle> m_srcRangeStarts;
+	std::vector<uint32_t> m_srcRangeLengths;
+	std::vector<gxapi::DescriptorHandle> m_dstRangeStarts;
+	std::vector<uint32_t> m_dstRangeLengths;
 };
 
 
@@ -78,6 +124,8 @@ template <gxapi::eCommandListType Type>
 RootTableManager<Type>::RootTableManager() {
 	m_graphicsApi = nullptr;
 	m_commandList = nullptr;
+	m_binder = nullptr;
+	m_heap = nullptr;
 }
 
 
@@ -85,14 +133,32 @@ template <gxapi::eCommandListType Type>
 RootTableManager<Type>::RootTableManager(gxapi::IGraphicsApi* graphicsApi, CommandListT* commandList) {
 	m_graphicsApi = graphicsApi;
 	m_commandList = commandList;
+	m_binder = nullptr;
+	m_heap = nullptr;
 }
 
 
 template <gxapi::eCommandListType Type>
-void RootTableManager<Type>::SetBinder(Binder* binder) {
+bool RootTableManager<Type>::SetBinder(Binder* binder) {
+	// binders with the same layout share their root signature, bound tables remain valid
+	if (m_binder != nullptr && m_binder->GetRootSignature() == binder->GetRootSignature()) {
+		m_binder = binder;
+		++m_numFilteredCalls;
+		return false;
+	}
+
 	m_binder = binder;
 	SetRootSignature(m_commandList, m_binder->GetRootSignature());
 	InitRootTables();
+	++m_numSubmittedCalls;
+	return true;
+}
+
+
+template <gxapi::eCommandListType Type>
+void RootTableManager<Type>::InvalidateRootSignature() {
+	m_binder = nullptr;
+	m_rootTableStates.clear();
 }
 
 
@@ -120,48 +186,103 @@ template <gxapi::eCommandListType Type>
 void RootTableManager<Type>::UpdateRootTable(gxapi::DescriptorHandle handle, int rootSignatureSlot, int indexInTable) {
 	DescriptorTableState& table = FindRootTable(rootSignatureSlot);
 
-	// if table is committed, duplicate it so that recent drawcalls won't be broken
-	if (table.committed) {
-		// update handle in advance so that duplicate will copy it instead and we save time
+	// binding the same descriptor again does not change the table
+	if (table.reserved || table.bindings[indexInTable] != handle) {
 		table.bindings[indexInTable] = handle;
-		DuplicateRootTable(table);
+		table.reserved = false;
+		table.dirty = true;
+	}
+}
 
-		// update table root parameters
-		SetRootDescriptorTable(m_commandList, rootSignatureSlot, table.reference.Get(0));
+
+template <gxapi::eCommandListType Type>
+void RootTableManager<Type>::UpdateReservedTable(int rootSignatureSlot) {
+	DescriptorTableState& table = FindRootTable(rootSignatureSlot);
+
+	if (!table.reserved) {
+		table.reserved = true;
+		table.dirty = true;
 	}
-	// just update the binding
-	else {
-		table.bindings[indexInTable] = handle;
-		m_graphicsApi->CopyDescriptors(handle, table.reference.Get(indexInTable), 1, gxapi::eDescriptorHeapType::CBV_SRV_UAV);
+}
+
+
+template <gxapi::eCommandListType Type>
+void RootTableManager<Type>::ResolveRootTable(DescriptorTableState& table) {
+	// the reserved range is filled when the scratch space is requested
+	if (table.reserved) {
+		table.reference = m_heap->GetReservedRange();
+		return;
 	}
+
+	size_t hash = HashBindings(table.bindings);
+
+	// look for a range that already holds the very same descriptors
+	auto candidates = m_tableCache.equal_range(hash);
+	for (auto it = candidates.first; it != candidates.second; ++it) {
+		if (it->second.bindings == table.bindings) {
+			table.reference = it->second.reference;
+			return;
+		}
+	}
+
+	// allocate new space on scratch space, may throw bad_alloc
+	DescriptorArrayRef space = m_heap->Allocate((uint32_t)table.bindings.size());
+	CopyBindings(table.bindings, space);
+
+	m_tableCache.insert({ hash, CachedDescriptorTable{ table.bindings, space } });
+	table.reference = space;
 }
 
+
 template <gxapi::eCommandListType Type>
-void RootTableManager<Type>::DuplicateRootTable(DescriptorTableState& table) {
-	uint32_t numDescriptors = (uint32_t)table.bindings.size();
+void RootTableManager<Type>::CopyBindings(const std::vector<gxapi::DescriptorHandle>& bindings, DescriptorArrayRef& destination) {
+	const size_t increment = m_heap->GetHeap()->GetIncrementSize();
+
+	m_srcRangeStarts.clear();
+	m_srcRangeLengths.clear();
+	m_dstRangeStarts.clear();
+	m_dstRangeLengths.clear();
+
+	// Source ranges are split where the staging descriptors are not adjacent,
+	// destination ranges only where a slot is left unbound.
+	const gxapi::DescriptorHandle* prev = nullptr;
+	for (size_t i = 0; i < bindings.size(); ++i) {
+		const gxapi::DescriptorHandle& curr = bindings[i];
+		if (curr.cpuAddress == nullptr) {
+			prev = nullptr;
+			continue;
+		}
+
+		if (prev != nullptr && static_cast<const char*>(curr.cpuAddress) == static_cast<const char*>(prev->cpuAddress) + increment) {
+			++m_srcRangeLengths.back();
+		}
+		else {
+			m_srcRangeStarts.push_back(curr);
+			m_srcRangeLengths.push_back(1);
+		}
 
-	// allocate new space on scratch space
-	DescriptorArrayRef space = m_heap->Allocate(numDescriptors);
+		if (prev != nullptr) {
+			++m_dstRangeLengths.back();
+		}
+		else {
+			m_dstRangeStarts.push_back(destination.Get((uint32_t)i));
+			m_dstRangeLengths.push_back(1);
+		}
 
-	// copy old descriptors to new space
-	std::vector<gxapi::DescriptorHandle> sourceDescHandles(numDescriptors);
-	std::vector<uint32_t> sourceRangeSizes(numDescriptors, 1);
-	for (size_t i = 0; i < numDescriptors; ++i) {
-		sourceDescHandles[i] = table.bindings[i];
+		prev = &curr;
 	}
 
-	gxapi::DescriptorHandle destDescHandle = space.Get(0);
+	if (m_srcRangeStarts.empty()) {
+		return;
+	}
 
 	m_graphicsApi->CopyDescriptors(
-		sourceDescHandles.size(), sourceDescHandles.data(), sourceRangeSizes.data(),
-		1, &destDescHandle, &numDescriptors,
+		m_srcRangeStarts.size(), m_srcRangeStarts.data(), m_srcRangeLengths.data(),
+		m_dstRangeStarts.size(), m_dstRangeStarts.data(), m_dstRangeLengths.data(),
 		gxapi::eDescriptorHeapType::CBV_SRV_UAV);
-
-	// update table parameters
-	table.committed = false;
-	table.reference = space;
 }
 
+
 template <gxapi::eCommandListType Type>
 auto RootTableManager<Type>::FindRootTable(int rootSignatureSlot) -> DescriptorTableState& {
 	// root table states are already sorted by init
@@ -215,10 +336,8 @@ void RootTableManager<Type>::InitRootTables() {
 			}
 			assert(descriptorCountTotal == largestIndex);
 
-			// add record for this table
-			m_rootTableStates.push_back({ m_heap->Allocate((uint32_t)descriptorCountTotal), (int)slot });
-			SetRootDescriptorTable(m_commandList, m_rootTableStates.back().slot, m_rootTableStates.back().reference.Get(0));
-			m_rootTableStates.back().bindings.resize(descriptorCountTotal);
+			// add record for this table, scratch space is assigned on the first draw
+			m_rootTableStates.push_back({ (int)slot, descriptorCountTotal });
 		}
 	}
 }
@@ -226,15 +345,39 @@ void RootTableManager<Type>::InitRootTables() {
 template <gxapi::eCommandListType Type>
 void RootTableManager<Type>::CommitRootTables() {
 	for (auto& table : m_rootTableStates) {
-		table.committed = true;
+		if (!table.dirty) {
+			continue;
+		}
+
+		DescriptorArrayRef previous = table.reference;
+		ResolveRootTable(table);
+		table.dirty = false;
+
+		bool sameRange = previous.IsValid() && previous.Get(0) == table.reference.Get(0);
+		if (!table.bound || !sameRange) {
+			SetRootDescriptorTable(m_commandList, table.slot, table.reference.Get(0));
+			table.bound = true;
+		}
 	}
 }
 
 template <gxapi::eCommandListType Type>
 void RootTableManager<Type>::RenewRootTables() {
+	m_tableCache.clear();
 	for (auto& table : m_rootTableStates) {
-		DuplicateRootTable(table);
+		table.reference = DescriptorArrayRef();
+		table.dirty = true;
+		table.bound = false;
+	}
+}
+
+template <gxapi::eCommandListType Type>
+size_t RootTableManager<Type>::HashBindings(const std::vector<gxapi::DescriptorHandle>& bindings) {
+	size_t hash = bindings.size();
+	for (const auto& handle : bindings) {
+		hash ^= std::hash<const void*>{}(handle.cpuAddress) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
 	}
+	return hash;
 }
 
 template <gxapi::eCommandListType Type>
@@ -1,4 +1,6 @@
 #include "Scene.hpp"
+#include "MeshEntity.hpp"
+#include "Mesh.hpp"
 
 
 namespace inl {
@@ -37,6 +39,152 @@ const DirectionalLight& Scene::GetSun() const {
 	return *m_sun;
 }
 
+EntityCollection<TerrainEntity>& Scene::GetTerrainEntities() {
+	return m_terrainEntities;
+}
+
+const EntityCollection<TerrainEntity>& Scene::GetTerrainEntities() const {
+	return m_terrainEntities;
+}
+
+EntityCollection<PointLight>& Scene::GetPointLights() {
+	return m_pointLights;
+}
+
+const EntityCollection<PointLight>& Scene::GetPointLights() const {
+	return m_pointLights;
+}
+
+EntityCollection<SpotLight>& Scene::GetSpotLights() {
+	return m_spotLights;
+}
+
+const EntityCollection<SpotLight>& Scene::GetSpotLights() const {
+	return m_spotLights;
+}
+
+
+void Scene::UpdateSpatialIndex(const std::vector<MeshEntityHandle>& movedEntities) {
+	if (m_indexedVersion != m_meshEntities.GetVersion()) {
+		m_indexedEntities.assign(m_meshEntities.begin(), m_meshEntities.end());
+		m_indexedVersion = m_meshEntities.GetVersion();
+
+		m_indexedBounds.resize(m_indexedEntities.size());
+		m_indexedMeshes.resize(m_indexedEntities.size());
+		m_itemOfSlots.clear();
+		for (uint32_t i = 0; i < m_indexedEntities.size(); ++i) {
+			m_indexedBounds[i] = WorldBounds(*m_indexedEntities[i]);
+			m_indexedMeshes[i] = m_indexedEntities[i]->GetMesh();
+			m_itemOfSlots[m_indexedEntities[i]->GetStoreHandle().slot] = i;
+		}
+		m_indexedMeshGroups.clear();
+		GroupByMesh();
+		m_meshEntityHierarchy.Build(m_indexedBounds.data(), m_indexedBounds.size());
+		return;
+	}
+
+	// Only the moved entities of this scene get new bounds, the store reports the moves of all scenes.
+	// Changing the mesh counts as a move.
+	m_movedItems.clear();
+	bool meshesChanged = false;
+	for (const MeshEntityHandle& handle : movedEntities) {
+		auto it = m_itemOfSlots.find(handle.slot);
+		if (it != m_itemOfSlots.end() && m_indexedEntities[it->second]->GetStoreHandle() == handle) {
+			const MeshEntity& entity = *m_indexedEntities[it->second];
+			m_indexedBounds[it->second] = WorldBounds(entity);
+			m_movedItems.push_back(it->second);
+			meshesChanged |= m_indexedMeshes[it->second] != entity.GetMesh();
+			m_indexedMeshes[it->second] = entity.GetMesh();
+		}
+	}
+	if (meshesChanged) {
+		GroupByMesh();
+	}
+
+	// Entities also move when the vertices of their mesh do, e.g. dynamic meshes, without being moved themselves.
+	for (auto& [mesh, indexedMesh] : m_indexedMeshGroups) {
+		if (mesh->GetBoundsVersion() == indexedMesh.boundsVersion) {
+			continue;
+		}
+		indexedMesh.boundsVersion = mesh->GetBoundsVersion();
+		for (uint32_t item : indexedMesh.items) {
+			m_indexedBounds[item] = WorldBounds(*m_indexedEntities[item]);
+			m_movedItems.push_back(item);
+		}
+	}
+
+	if (m_movedItems.empty()) {
+		return;
+	}
+
+	m_meshEntityHierarchy.Refit(m_indexedBounds.data(), m_movedItems);
+	if (m_meshEntityHierarchy.NeedsRebuild()) {
+		m_meshEntityHierarchy.Build(m_indexedBounds.data(), m_indexedBounds.size());
+	}
+}
+
+
+void Scene::QueryMeshEntities(const Frustum& frustum, std::vector<MeshEntity*>& entities) const {
+	std::vector<uint32_t> items;
+	m_meshEntityHierarchy.QueryFrustum(frustum, items);
+	AppendQueriedEntities(items, entities);
+}
+
+void Scene::QueryMeshEntities(const Aabb& aabb, std::vector<MeshEntity*>& entities) const {
+	std::vector<uint32_t> items;
+	m_meshEntityHierarchy.QueryAabb(aabb, items);
+	AppendQueriedEntities(items, entities);
+}
+
+void Scene::QueryMeshEntities(const BoundingSphere& sphere, std::vector<MeshEntity*>& entities) const {
+	std::vector<uint32_t> items;
+	m_meshEntityHierarchy.QuerySphere(sphere, items);
+	AppendQueriedEntities(items, entities);
+}
+
+void Scene::QueryMeshEntities(const Ray& ray, std::vector<MeshEntity*>& entities, float maxDistance) const {
+	std::vector<uint32_t> items;
+	m_meshEntityHierarchy.QueryRay(ray, items, maxDistance);
+	AppendQueriedEntities(items, entities);
+}
+
+const BoundingVolumeHierarchy& Scene::GetMeshEntityHierarchy() const {
+	return m_meshEntityHierarchy;
+}
+
+
+void Scene::AppendQueriedEntities(const std::vector<uint32_t>& items, std::vector<MeshEntity*>& entities) const {
+	for (uint32_t item : items) {
+		entities.push_back(m_indexedEntities[item]);
+	}
+}
+
+
+void Scene::GroupByMesh() {
+	// Meshes already indexed keep their version, their bounds may have changed since
+	std::unordered_map<const Mesh*, IndexedMesh> groups;
+	for (uint32_t i = 0; i < m_indexedMeshes.size(); ++i) {
+		const Mesh* mesh = m_indexedMeshes[i];
+		if (mesh == nullptr) {
+			continue;
+		}
+		auto [it, inserted] = groups.insert({ mesh, IndexedMesh{} });
+		if (inserted) {
+			auto previous = m_indexedMeshGroups.find(mesh);
+			it->second.boundsVersion = previous != m_indexedMeshGroups.end() ? previous->second.boundsVersion : mesh->GetBoundsVersion();
+		}
+		it->second.items.push_back(i);
+	}
+	m_indexedMeshGroups = std::move(groups);
+}
+
+
+Aabb Scene::WorldBounds(const MeshEntity& entity) {
+	// world matrices are up to date when the index is updated
+	const Mesh* mesh = entity.GetMesh();
+	return TransformAabb(mesh ? mesh->GetBoundingBox() : Aabb{}, entity.GetStore().WorldMatrix(entity.GetStoreIndex()));
+}
+
 
 } // namespace gxeng
 } // namespace inl
@@ -1,14 +1,22 @@
 #pragma once
 
 #include "EntityCollection.hpp"
+#include "BoundingVolumeHierarchy.hpp"
+#include "MeshEntityStore.hpp"
+
 #include <string>
+#include <vector>
+#include <unordered_map>
 
 namespace inl {
 namespace gxeng {
 
+class Mesh;
 class MeshEntity;
 class TerrainEntity;
 class DirectionalLight;
+class PointLight;
+class SpotLight;
 class GraphicsEngine;
 
 
@@ -29,17 +37,59 @@ public:
 	void SetSun(DirectionalLight* sun);
 	const DirectionalLight& GetSun() const;
 
-	//EntityCollection<TerrainEntity>& GetTerrainEntities();
-	//const EntityCollection<TerrainEntity>& GetTerrainEntities() const;
+	/// <summary> Brings the spatial index of mesh entities up to date with the entities' current place. </summary>
+	/// <param name="movedEntities"> Entities moved since the last call, as reported by MeshEntityStore::GetMovedEntities.
+	///		All entities of the scene must live in that store. </param>
+	/// <remarks> Call after every MeshEntityStore::UpdateWorldMatrices and before querying the entities.
+	///		Refits the index around the moved entities and the entities whose mesh's bounds changed only,
+	///		rebuilds it if entities were added or removed or refitting made it too slow. </remarks>
+	void UpdateSpatialIndex(const std::vector<MeshEntityHandle>& movedEntities);
+
+	/// <summary> Appends the mesh entities that may be visible in the frustum. </summary>
+	void QueryMeshEntities(const Frustum& frustum, std::vector<MeshEntity*>& entities) const;
+	/// <summary> Appends the mesh entities whose bounding box overlaps the box. </summary>
+	void QueryMeshEntities(const Aabb& aabb, std::vector<MeshEntity*>& entities) const;
+	/// <summary> Appends the mesh entities whose bounding box overlaps the sphere. </summary>
+	void QueryMeshEntities(const BoundingSphere& sphere, std::vector<MeshEntity*>& entities) const;
+	/// <summary> Appends the mesh entities whose bounding box the ray hits. </summary>
+	void QueryMeshEntities(const Ray& ray, std::vector<MeshEntity*>& entities, float maxDistance = std::numeric_limits<float>::infinity()) const;
+
+	const BoundingVolumeHierarchy& GetMeshEntityHierarchy() const;
+
+	EntityCollection<TerrainEntity>& GetTerrainEntities();
+	const EntityCollection<TerrainEntity>& GetTerrainEntities() const;
 
-	//EntityCollection<Light>& GetLights();
-	//const EntityCollection<Light>& GetLights() const;
+	EntityCollection<PointLight>& GetPointLights();
+	const EntityCollection<PointLight>& GetPointLights() const;
 
+	EntityCollection<SpotLight>& GetSpotLights();
+	const EntityCollection<SpotLight>& GetSpotLights() const;
+
+private:
+	struct IndexedMesh {
+		uint64_t boundsVersion; // the mesh's bounds version when the bounds of its entities were last computed
+		std::vector<uint32_t> items; // entities using the mesh, indices into m_indexedEntities
+	};
+
+	void GroupByMesh();
+	void AppendQueriedEntities(const std::vector<uint32_t>& items, std::vector<MeshEntity*>& entities) const;
+	static Aabb WorldBounds(const MeshEntity& entity);
 private:
 	EntityCollection<MeshEntity> m_meshEntities;	
 	DirectionalLight* m_sun = nullptr;
-	//EntityCollection<TerrainEntity> m_terrainEntities;
-	//EntityCollection<Light> m_lights;
+
+	// spatial index, items are indices into m_indexedEntities
+	BoundingVolumeHierarchy m_meshEntityHierarchy;
+	std::vector<MeshEntity*> m_indexedEntities;
+	std::vector<Aabb> m_indexedBounds;
+	std::vector<const Mesh*> m_indexedMeshes; // mesh of each indexed entity when its bounds were computed
+	std::unordered_map<const Mesh*, IndexedMesh> m_indexedMeshGroups;
+	std::unordered_map<uint32_t, uint32_t> m_itemOfSlots; // store slot of the entity -> index into m_indexedEntities
+	std::vector<uint32_t> m_movedItems;
+	uint64_t m_indexedVersion = ~uint64_t(0);
+	EntityCollection<TerrainEntity> m_terrainEntities;
+	EntityCollection<PointLight> m_pointLights;
+	EntityCollection<SpotLight> m_spotLights;
 
 	std::string m_name;
 };
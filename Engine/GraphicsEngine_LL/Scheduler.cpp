@@ -75,6 +75,7 @@ void Scheduler::Execute(FrameContext context) {
 									   std::move(injectAlloc),
 									   {},
 									   {},
+									   {},
 									   context);
 				}
 
@@ -92,6 +93,7 @@ void Scheduler::Execute(FrameContext context) {
 								   std::move(dec.commandAllocator),
 				                   std::move(dec.scratchSpaces),
 								   std::move(usedResourceList),
+								   std::move(dec.executedBundles),
 								   context);
 
 
@@ -123,6 +125,7 @@ void Scheduler::Execute(FrameContext context) {
 						   std::move(injectAlloc),
 						   {},
 						   {},
+						   {},
 						   context);
 	}
 	catch (std::exception& ex) {
@@ -187,6 +190,7 @@ void Scheduler::EnqueueCommandList(CommandQueue& commandQueue,
 								   CmdAllocPtr commandAllocator,
                                    std::vector<ScratchSpacePtr> scratchSpaces,
 								   std::vector<MemoryObject> usedResources,
+								   std::vector<std::shared_ptr<const GraphicsBundle>> executedBundles,
 								   const FrameContext& context)
 {
 	// Enqueue CPU task to make resources resident before the command list runs.
@@ -201,7 +205,7 @@ void Scheduler::EnqueueCommandList(CommandQueue& commandQueue,
 	SyncPoint completionPoint = context.commandQueue->Signal();
 
 	// Enqueue CPU task to clean up resources after command list finished.
-	context.residencyQueue->EnqueueClean(completionPoint, std::move(usedResources), std::move(commandAllocator), std::move(scratchSpaces));
+	context.residencyQueue->EnqueueClean(completionPoint, std::move(usedResources), std::move(commandAllocator), std::move(scratchSpaces), std::move(executedBundles));
 }
 
 
@@ -269,7 +273,7 @@ void Scheduler::RenderFailureScreen(FrameContext context) {
 
 	// Enqueue command list.
 	commandList->Close();
-	EnqueueCommandList(*context.commandQueue, std::move(commandList), std::move(commandAllocator), {}, {}, context);
+	EnqueueCommandList(*context.commandQueue, std::move(commandList), std::move(commandAllocator), {}, {}, {}, context);
 }
 
 
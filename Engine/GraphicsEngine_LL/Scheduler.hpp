@@ -46,6 +46,7 @@ protected:
 								   CmdAllocPtr commandAllocator,
 	                               std::vector<ScratchSpacePtr> scratchSpaces,
 								   std::vector<MemoryObject> usedResources,
+								   std::vector<std::shared_ptr<const GraphicsBundle>> executedBundles,
 								   const FrameContext& context);
 
 	template <class UsedResourceIter>
@@ -5,8 +5,8 @@
 namespace inl {
 namespace gxeng {
 
-ScratchSpacePool::ScratchSpacePool(gxapi::IGraphicsApi* gxApi, gxapi::eDescriptorHeapType type) 
-	: m_gxApi(gxApi), m_type(type)
+ScratchSpacePool::ScratchSpacePool(gxapi::IGraphicsApi* gxApi, gxapi::eDescriptorHeapType type, TextureTable* textureTable) 
+	: m_gxApi(gxApi), m_type(type), m_textureTable(textureTable)
 {}
 
 
@@ -26,15 +26,18 @@ auto ScratchSpacePool::RequestScratchSpace() -> UniquePtr {
 		index = m_allocator.Allocate();
 	}
 
-	if (m_pool[index] != nullptr) {
-		return UniquePtr{ m_pool[index].get(), Deleter{this} };
-	}
-	else {
-		std::unique_ptr<StackDescHeap> ptr(new StackDescHeap{ m_gxApi, m_type, 1000 });
+	if (m_pool[index] == nullptr) {
+		uint32_t reservedSize = m_textureTable != nullptr ? m_textureTable->GetCapacity() : 0;
+		std::unique_ptr<StackDescHeap> ptr(new StackDescHeap{ m_gxApi, m_type, 1000, reservedSize });
 		m_addressToIndex[ptr.get()] = index;
 		m_pool[index] = std::move(ptr);
-		return UniquePtr{ m_pool[index].get(), Deleter{this} };
 	}
+
+	// the scratch space is not used by the GPU until it is returned, so its table can be overwritten
+	if (m_textureTable != nullptr) {
+		m_textureTable->Sync(*m_pool[index]);
+	}
+	return UniquePtr{ m_pool[index].get(), Deleter{this} };
 }
 
 
@@ -3,6 +3,7 @@
 #include "../BaseLibrary/Memory/SlabAllocatorEngine.hpp"
 #include "../GraphicsApi_LL/IGraphicsApi.hpp"
 #include "StackDescHeap.hpp"
+#include "TextureTable.hpp"
 #include <vector>
 #include <map>
 #include <mutex>
@@ -28,7 +29,8 @@ public:
 
 	using UniquePtr = std::unique_ptr<StackDescHeap, Deleter>;
 public:
-	ScratchSpacePool(gxapi::IGraphicsApi* gxApi, gxapi::eDescriptorHeapType type);
+	/// <param name="textureTable"> If not null, scratch spaces reserve room for the table and are synced with it when requested. </param>
+	ScratchSpacePool(gxapi::IGraphicsApi* gxApi, gxapi::eDescriptorHeapType type, TextureTable* textureTable = nullptr);
 	ScratchSpacePool(const ScratchSpacePool&) = delete;
 	ScratchSpacePool(ScratchSpacePool&&) = default;
 	ScratchSpacePool& operator=(const ScratchSpacePool&) = delete;
@@ -42,6 +44,7 @@ private:
 	exc::SlabAllocatorEngine m_allocator;
 	gxapi::IGraphicsApi* m_gxApi;
 	std::map<StackDescHeap*, size_t> m_addressToIndex;
+	TextureTable* m_textureTable;
 
 	std::mutex m_mutex;
 };
@@ -0,0 +1,286 @@
+#include "ShaderCache.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <thread>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#include "../GraphicsApi_LL/DisableWin32Macros.h"
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+namespace inl {
+namespace gxeng {
+
+
+namespace fs = std::experimental::filesystem;
+
+
+static constexpr uint32_t BinaryFileMagic = 0x42535049; // "IPSB"
+static constexpr char BinaryFileExtension[] = ".shbin";
+
+struct BinaryFileHeader {
+	uint32_t magic;
+	uint32_t size;
+	uint64_t key;
+};
+
+
+//------------------------------------------------------------------------------
+// Read-only memory mapping of a whole file
+//------------------------------------------------------------------------------
+
+class MappedFile {
+public:
+	MappedFile(const fs::path& path) {
+#ifdef _WIN32
+		m_file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (m_file == INVALID_HANDLE_VALUE) {
+			return;
+		}
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0) {
+			return;
+		}
+		m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (m_mapping == nullptr) {
+			return;
+		}
+		m_data = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+		m_size = m_data ? (size_t)size.QuadPart : 0;
+#else
+		m_file = open(path.c_str(), O_RDONLY);
+		if (m_file < 0) {
+			return;
+		}
+		struct stat info;
+		if (fstat(m_file, &info) != 0 || info.st_size == 0) {
+			return;
+		}
+		void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+		if (data != MAP_FAILED) {
+			m_data = data;
+			m_size = (size_t)info.st_size;
+		}
+#endif
+	}
+
+	~MappedFile() {
+#ifdef _WIN32
+		if (m_data) { UnmapViewOfFile(m_data); }
+		if (m_mapping) { CloseHandle(m_mapping); }
+		if (m_file != INVALID_HANDLE_VALUE) { CloseHandle(m_file); }
+#else
+		if (m_data) { munmap(m_data, m_size); }
+		if (m_file >= 0) { close(m_file); }
+#endif
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const uint8_t* Data() const { return reinterpret_cast<const uint8_t*>(m_data); }
+	size_t Size() const { return m_size; }
+private:
+#ifdef _WIN32
+	HANDLE m_file = INVALID_HANDLE_VALUE;
+	HANDLE m_mapping = nullptr;
+#else
+	int m_file = -1;
+#endif
+	void* m_data = nullptr;
+	size_t m_size = 0;
+};
+
+
+//------------------------------------------------------------------------------
+// Shader cache
+//------------------------------------------------------------------------------
+
+ShaderCache::ShaderCache()
+	: m_maxSize(0), m_currentSize(0)
+{}
+
+
+void ShaderCache::SetDirectory(fs::path directory, uint64_t maxSize) {
+	std::lock_guard<std::mutex> lkg(m_mutex);
+
+	m_directory = directory;
+	m_maxSize = maxSize;
+	m_currentSize = 0;
+
+	if (m_directory.empty()) {
+		return;
+	}
+
+	std::error_code ec;
+	fs::create_directories(m_directory, ec);
+	if (ec) {
+		m_directory.clear();
+		return;
+	}
+
+	for (auto& entry : fs::directory_iterator(m_directory, ec)) {
+		if (entry.path().extension() == BinaryFileExtension) {
+			m_currentSize += fs::file_size(entry.path(), ec);
+		}
+	}
+	Evict();
+}
+
+
+bool ShaderCache::IsEnabled() const {
+	return !m_directory.empty();
+}
+
+
+bool ShaderCache::Load(uint64_t key, std::vector<uint8_t>& binary) {
+	if (!IsEnabled()) {
+		return false;
+	}
+
+	fs::path path = GetPath(key);
+	{
+		MappedFile file(path);
+		if (file.Size() < sizeof(BinaryFileHeader)) {
+			return false;
+		}
+
+		BinaryFileHeader header;
+		std::memcpy(&header, file.Data(), sizeof(header));
+		if (header.magic != BinaryFileMagic || header.key != key || header.size != file.Size() - sizeof(header)) {
+			return false;
+		}
+
+		const uint8_t* data = file.Data() + sizeof(header);
+		binary.assign(data, data + header.size);
+	}
+
+	// Touch the file so that eviction sees it as recently used.
+	std::error_code ec;
+	fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+
+	return true;
+}
+
+
+void ShaderCache::Store(uint64_t key, const std::vector<uint8_t>& binary) {
+	if (!IsEnabled()) {
+		return;
+	}
+
+	fs::path path = GetPath(key);
+
+	// Unique temporary name per thread, so concurrent stores of the same key don't collide.
+	std::stringstream tempName;
+	tempName << path.filename().string() << "." << std::this_thread::get_id() << ".tmp";
+	fs::path tempPath = m_directory / tempName.str();
+
+	{
+		BinaryFileHeader header;
+		header.magic = BinaryFileMagic;
+		header.size = (uint32_t)binary.size();
+		header.key = key;
+
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(binary.data()), binary.size());
+		if (!file) {
+			file.close();
+			std::error_code ec;
+			fs::remove(tempPath, ec);
+			return;
+		}
+	}
+
+	std::error_code ec;
+	uint64_t oldSize = fs::exists(path, ec) ? fs::file_size(path, ec) : 0;
+	fs::rename(tempPath, path, ec);
+	if (ec) {
+		fs::remove(tempPath, ec);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lkg(m_mutex);
+	m_currentSize += sizeof(BinaryFileHeader) + binary.size() - oldSize;
+	Evict();
+}
+
+
+void ShaderCache::Clear() {
+	std::lock_guard<std::mutex> lkg(m_mutex);
+
+	if (m_directory.empty()) {
+		return;
+	}
+
+	std::error_code ec;
+	for (auto& entry : fs::directory_iterator(m_directory, ec)) {
+		if (entry.path().extension() == BinaryFileExtension) {
+			fs::remove(entry.path(), ec);
+		}
+	}
+	m_currentSize = 0;
+}
+
+
+fs::path ShaderCache::GetPath(uint64_t key) const {
+	std::stringstream ss;
+	ss << std::hex << std::setw(16) << std::setfill('0') << key << BinaryFileExtension;
+	return m_directory / ss.str();
+}
+
+
+void ShaderCache::Evict() {
+	// Called with m_mutex locked.
+	if (m_currentSize <= m_maxSize) {
+		return;
+	}
+
+	struct File {
+		fs::path path;
+		fs::file_time_type lastUse;
+		uint64_t size;
+	};
+	std::vector<File> files;
+
+	std::error_code ec;
+	m_currentSize = 0;
+	for (auto& entry : fs::directory_iterator(m_directory, ec)) {
+		if (entry.path().extension() == BinaryFileExtension) {
+			File file{ entry.path(), fs::last_write_time(entry.path(), ec), fs::file_size(entry.path(), ec) };
+			m_currentSize += file.size;
+			files.push_back(std::move(file));
+		}
+	}
+
+	// Delete least recently used files until we're below 3/4 of the limit,
+	// so that the next few stores don't trigger another directory scan.
+	std::sort(files.begin(), files.end(), [](const File& lhs, const File& rhs) {
+		return lhs.lastUse < rhs.lastUse;
+	});
+	uint64_t targetSize = m_maxSize / 4 * 3;
+	for (auto& file : files) {
+		if (m_currentSize <= targetSize) {
+			break;
+		}
+		if (fs::remove(file.path, ec)) {
+			m_currentSize -= file.size;
+		}
+	}
+}
+
+
+} // namespace gxeng
+} // namespace inl
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+
+
+namespace inl {
+namespace gxeng {
+
+
+/// <summary>
+/// Keeps compiled shader binaries on disk between runs.
+/// <para />
+/// Binaries are stored as one file per key in the cache directory. The key must
+/// identify everything that affects the compiler's output: the source with all of
+/// its includes, the macros, the entry point, the stage and the compile flags.
+/// Files are read through a memory mapping and written to a temporary file first,
+/// which is then renamed, so a crash or a concurrent process never sees half a binary.
+/// When the directory grows over its size limit, the least recently used binaries
+/// are deleted.
+/// </summary>
+/// <remarks> This class is thread-safe. </remarks>
+class ShaderCache {
+public:
+	ShaderCache();
+
+	/// <summary> Sets the directory to store binaries in, and creates it if needed. </summary>
+	/// <param name="directory"> Cache directory. An empty path disables the cache. </param>
+	/// <param name="maxSize"> Binaries are evicted when the total size of the cache exceeds this many bytes. </param>
+	/// <remarks> Must not be called concurrently with Load and Store. </remarks>
+	void SetDirectory(std::experimental::filesystem::path directory, uint64_t maxSize = 256ull * 1024 * 1024);
+
+	/// <summary> Whether a cache directory is set. </summary>
+	bool IsEnabled() const;
+
+	/// <summary> Reads the binary stored for the key. </summary>
+	/// <returns> False if there is no binary for the key or the file is corrupt. </returns>
+	bool Load(uint64_t key, std::vector<uint8_t>& binary);
+
+	/// <summary> Stores the binary for the key, replacing the previous one. </summary>
+	/// <remarks> Failing to write the cache is not an error, the binary is simply not cached. </remarks>
+	void Store(uint64_t key, const std::vector<uint8_t>& binary);
+
+	/// <summary> Deletes all cached binaries. </summary>
+	void Clear();
+private:
+	std::experimental::filesystem::path GetPath(uint64_t key) const;
+	void Evict();
+private:
+	std::experimental::filesystem::path m_directory;
+	uint64_t m_maxSize;
+	uint64_t m_currentSize;
+	std::mutex m_mutex;
+};
+
+
+} // namespace gxeng
+} // namespace inl
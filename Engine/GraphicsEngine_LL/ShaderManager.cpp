@@ -1,8 +1,14 @@
 #include "ShaderManager.hpp"
 
+#include <BaseLibrary/ThreadName.hpp>
+
 #include <thread>
 #include <algorithm>
 #include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_set>
+#include <atomic>
 
 
 namespace inl {
@@ -10,17 +16,41 @@ namespace gxeng {
 
 
 ShaderManager::ShaderManager(gxapi::IGxapiManager* gxapiManager)
-	: m_gxapiManager(gxapiManager)
+	: m_gxapiManager(gxapiManager),
+	m_stopWorkers(false),
+	m_watching(false)
 {
 	unsigned numCores = std::thread::hardware_concurrency();
 	numCores = std::max(1u, numCores); // must be at least one core
 	numCores = std::min(64u, numCores); // there should not be more than 64 cores... too many mutexes
 	m_numCompileMutexes = numCores * 5; // should find some prime larger than X, but that's it for now
 	m_compileMutexes = std::make_unique<std::mutex[]>(m_numCompileMutexes);
+
+	// leave a core for the thread requesting the shaders
+	unsigned numWorkers = std::max(1u, numCores - 1);
+	for (unsigned i = 0; i < numWorkers; ++i) {
+		m_workers.push_back(std::thread(&ShaderManager::WorkerThread, this));
+	}
 }
 
 ShaderManager::~ShaderManager() {
-	// empty
+	EnableHotReload(false);
+
+	{
+		std::lock_guard<std::mutex> lkg(m_jobMutex);
+		m_stopWorkers = true;
+	}
+	m_jobCv.notify_all();
+	for (auto& worker : m_workers) {
+		worker.join();
+	}
+
+	// Whoever waits for a job that never ran gets an error instead of a broken promise
+	for (Job& job : m_jobs) {
+		if (job.cancel) {
+			job.cancel();
+		}
+	}
 }
 
 
@@ -75,7 +105,7 @@ const ShaderProgram& ShaderManager::CreateShader(const std::string& name, Shader
 	// shader does not exist
 	else {
 		// insert new entry for shader
-		auto ins = m_shaders.insert({ name, std::make_unique<ShaderStore>() });
+		auto ins = m_shaders.insert({ shaderId, std::make_unique<ShaderStore>() });
 		it = ins.first;
 	}
 	ShaderStore* shader = it->second.get();
@@ -117,10 +147,34 @@ const ShaderProgram& ShaderManager::CreateShader(const std::string& name, Shader
 	if (partsToCompile.ps) { shader->program.ps = std::move(program.ps); }
 	if (partsToCompile.cs) { shader->program.cs = std::move(program.cs); }
 
+	if (m_watching) {
+		std::vector<std::string> includePaths;
+		HashSourceWithIncludes(shaderSource, &includePaths);
+		TrackDependencies(shaderId, shaderPath, includePaths);
+	}
+
 	return shader->program;
 }
 
 
+std::shared_future<ShaderProgram> ShaderManager::CreateShaderAsync(const std::string& name, ShaderParts parts, const std::string& macros) {
+	auto promise = std::make_shared<std::promise<ShaderProgram>>();
+	std::shared_future<ShaderProgram> result = promise->get_future().share();
+	PushJob([this, promise, name, parts, macros] {
+		try {
+			promise->set_value(CreateShader(name, parts, macros));
+		}
+		catch (...) {
+			promise->set_exception(std::current_exception());
+		}
+	},
+	[promise, name] {
+		promise->set_exception(std::make_exception_ptr(std::runtime_error("Shader manager destroyed before compiling " + name + ".")));
+	});
+	return result;
+}
+
+
 void ShaderManager::SetShaderCompileFlags(gxapi::eShaderCompileFlags flags) {
 	m_compileFlags = flags;
 }
@@ -129,8 +183,205 @@ gxapi::eShaderCompileFlags ShaderManager::GetShaderCompileFlags() const {
 	return m_compileFlags;
 }
 
+void ShaderManager::SetCacheDirectory(std::experimental::filesystem::path directory, uint64_t maxSize) {
+	m_binaryCache.SetDirectory(directory, maxSize);
+}
+
+//------------------------------------------------------------------------------
+// Hot reload
+//------------------------------------------------------------------------------
+
+void ShaderManager::EnableHotReload(bool enable, std::chrono::milliseconds pollInterval) {
+	if (enable == m_watching) {
+		return;
+	}
+
+	if (enable) {
+		m_watching = true;
+		m_watchThread = std::thread(&ShaderManager::WatchThread, this, pollInterval);
+	}
+	else {
+		{
+			std::lock_guard<std::mutex> lkg(m_watchMutex);
+			m_watching = false;
+		}
+		m_watchCv.notify_all();
+		m_watchThread.join();
+	}
+}
+
+
 void ShaderManager::ReloadShaders() {
-	return;
+	std::vector<ShaderId> shaderIds;
+	{
+		std::lock_guard<std::mutex> lkg(m_shaderMutex);
+		for (const auto& shader : m_shaders) {
+			shaderIds.push_back(shader.first);
+		}
+	}
+
+	for (auto& shaderId : shaderIds) {
+		PushJob([this, shaderId] { RecompileShader(shaderId); });
+	}
+}
+
+
+bool ShaderManager::ApplyReloadedShaders(std::vector<std::string>& errors) {
+	decltype(m_reloadedShaders) reloadedShaders;
+	{
+		std::lock_guard<std::mutex> lkg(m_reloadMutex);
+		reloadedShaders = std::move(m_reloadedShaders);
+		m_reloadedShaders.clear();
+		errors = std::move(m_reloadErrors);
+		m_reloadErrors.clear();
+	}
+
+	for (auto& reloaded : reloadedShaders) {
+		std::unique_lock<std::mutex> shaderMapLock(m_shaderMutex);
+		ShaderStore* shader = m_shaders.at(reloaded.first).get();
+		shaderMapLock.unlock();
+
+		size_t nameHash = ShaderIdHash()(reloaded.first);
+		std::lock_guard<std::mutex> shaderLock(m_compileMutexes[nameHash % m_numCompileMutexes]);
+
+		// Only swap the stages that were recompiled, others might have been added since.
+		ShaderProgram& program = reloaded.second;
+		if (program.vs) { shader->program.vs = std::move(program.vs); }
+		if (program.hs) { shader->program.hs = std::move(program.hs); }
+		if (program.ds) { shader->program.ds = std::move(program.ds); }
+		if (program.gs) { shader->program.gs = std::move(program.gs); }
+		if (program.ps) { shader->program.ps = std::move(program.ps); }
+		if (program.cs) { shader->program.cs = std::move(program.cs); }
+	}
+
+	return !reloadedShaders.empty();
+}
+
+
+void ShaderManager::TrackDependencies(const ShaderId& shaderId, const std::string& shaderPath, const std::vector<std::string>& includePaths) {
+	std::lock_guard<std::mutex> lkg(m_watchMutex);
+
+	auto track = [&](const std::string& path) {
+		std::error_code ec;
+		auto time = std::experimental::filesystem::last_write_time(path, ec);
+		if (ec) {
+			return; // not a file, i.e. source added with AddSourceCode
+		}
+		m_dependents[path].insert(shaderId);
+		m_fileTimes.insert({ path, time });
+	};
+
+	track(shaderPath);
+	for (const auto& path : includePaths) {
+		track(path);
+	}
+}
+
+
+void ShaderManager::WatchThread(std::chrono::milliseconds pollInterval) {
+	std::unique_lock<std::mutex> lk(m_watchMutex);
+
+	while (!m_watchCv.wait_for(lk, pollInterval, [this] { return !m_watching; })) {
+		std::vector<std::pair<std::string, std::experimental::filesystem::file_time_type>> files(m_fileTimes.begin(), m_fileTimes.end());
+
+		// stat files without blocking shader creation
+		lk.unlock();
+		std::vector<std::pair<std::string, std::experimental::filesystem::file_time_type>> modifiedFiles;
+		for (const auto& file : files) {
+			std::error_code ec;
+			auto time = std::experimental::filesystem::last_write_time(file.first, ec);
+			if (!ec && time != file.second) {
+				modifiedFiles.push_back({ file.first, time });
+			}
+		}
+		lk.lock();
+
+		std::unordered_set<ShaderId, ShaderIdHash> affectedShaders;
+		for (const auto& file : modifiedFiles) {
+			m_fileTimes[file.first] = file.second;
+			const auto& dependents = m_dependents[file.first];
+			affectedShaders.insert(dependents.begin(), dependents.end());
+		}
+		for (const auto& shaderId : affectedShaders) {
+			PushJob([this, shaderId] { RecompileShader(shaderId); });
+		}
+	}
+}
+
+
+void ShaderManager::RecompileShader(const ShaderId& shaderId) {
+	ShaderParts parts;
+	{
+		std::lock_guard<std::mutex> lkg(m_shaderMutex);
+		auto it = m_shaders.find(shaderId);
+		if (it == m_shaders.end()) {
+			return;
+		}
+		parts = ShaderParts().SetUnion(it->second->parts);
+	}
+
+	std::shared_lock<std::shared_mutex> sourceLock(m_sourceMutex);
+
+	std::string shaderPath;
+	try {
+		auto pathSourcePair = FindShaderCode(shaderId.name);
+		shaderPath = pathSourcePair.first;
+		ShaderProgram program = CompileShader(pathSourcePair.second, shaderId.macros, parts);
+
+		// the includes might have changed too
+		std::vector<std::string> includePaths;
+		HashSourceWithIncludes(pathSourcePair.second, &includePaths);
+		TrackDependencies(shaderId, shaderPath, includePaths);
+
+		std::lock_guard<std::mutex> lkg(m_reloadMutex);
+		m_reloadedShaders[shaderId] = std::move(program);
+	}
+	catch (std::exception& ex) {
+		std::lock_guard<std::mutex> lkg(m_reloadMutex);
+		m_reloadErrors.push_back("Error while reloading shader '" + (shaderPath.empty() ? shaderId.name : shaderPath) + "': " + ex.what());
+	}
+}
+
+
+//------------------------------------------------------------------------------
+// Worker threads
+//------------------------------------------------------------------------------
+
+static thread_local bool isShaderWorkerThread = false;
+
+
+void ShaderManager::PushJob(std::function<void()> job, std::function<void()> cancel) {
+	{
+		std::lock_guard<std::mutex> lkg(m_jobMutex);
+		m_jobs.push_back(Job{ std::move(job), std::move(cancel) });
+	}
+	m_jobCv.notify_one();
+}
+
+
+void ShaderManager::WorkerThread() {
+	SetCurrentThreadName("Shader Compiler Thread");
+	isShaderWorkerThread = true;
+
+	std::unique_lock<std::mutex> lk(m_jobMutex);
+	while (true) {
+		m_jobCv.wait(lk, [this] { return m_stopWorkers || !m_jobs.empty(); });
+		if (m_stopWorkers) {
+			break;
+		}
+
+		std::function<void()> job = std::move(m_jobs.front().run);
+		m_jobs.pop_front();
+
+		lk.unlock();
+		job();
+		lk.lock();
+	}
+}
+
+
+bool ShaderManager::IsWorkerThread() {
+	return isShaderWorkerThread;
 }
 
 
@@ -204,17 +455,70 @@ ShaderProgram ShaderManager::CompileShader(const std::string& sourceCode, const
 		if (parts.cs) { compileIndices[idx] = 5; ++idx; }
 	}
 
+	// Key of the binaries in the on-disk cache, the stage is mixed in below.
+	uint64_t programKey = 0;
+	if (m_binaryCache.IsEnabled()) {
+		std::stringstream options;
+		options << HashSourceWithIncludes(sourceCode) << '|' << macros << '|' << (uint32_t)(gxapi::eShaderCompileFlags::EnumT)m_compileFlags;
+		programKey = std::hash<std::string>()(options.str());
+	}
+
+	auto compileStage = [&](int stageId) {
+		const char* mainName = mainNames[stageId];
+
+		gxapi::ShaderProgramBinary binary;
+		uint64_t stageKey = programKey ^ (std::hash<std::string>()(mainName) + 0x9e3779b97f4a7c15ull * (stageId + 1));
+		if (!m_binaryCache.IsEnabled() || !m_binaryCache.Load(stageKey, binary.data)) {
+			binary = m_gxapiManager->CompileShader(sourceCode.c_str(),
+				mainName,
+				types[stageId],
+				m_compileFlags,
+				&includeProvider,
+				macros.c_str());
+			m_binaryCache.Store(stageKey, binary.data);
+		}
+		return binary;
+	};
+
+	// Stages are compiled by the workers in parallel. Whichever stage no worker has picked up yet
+	// is compiled on this thread, so we only ever wait for stages that are already being compiled.
+	// Workers compile sequentially, as they must not wait for each other.
+	struct StageJob {
+		std::atomic_bool taken{ false };
+		std::packaged_task<gxapi::ShaderProgramBinary()> task;
+	};
+	std::vector<std::shared_ptr<StageJob>> stageJobs;
+	std::vector<std::future<gxapi::ShaderProgramBinary>> stageResults;
+	for (int idx = 0; compileIndices[idx] != -1; ++idx) {
+		auto job = std::make_shared<StageJob>();
+		job->task = std::packaged_task<gxapi::ShaderProgramBinary()>(std::bind(compileStage, compileIndices[idx]));
+		stageResults.push_back(job->task.get_future());
+		stageJobs.push_back(job);
+	}
+	if (!IsWorkerThread() && stageJobs.size() > 1) {
+		for (size_t i = 1; i < stageJobs.size(); ++i) {
+			PushJob([job = stageJobs[i]] {
+				if (!job->taken.exchange(true)) {
+					job->task();
+				}
+			});
+		}
+	}
+	for (auto& job : stageJobs) {
+		if (!job->taken.exchange(true)) {
+			job->task();
+		}
+	}
+	// jobs reference locals of this function, so wait for all of them even if one fails
+	for (auto& result : stageResults) {
+		result.wait();
+	}
+
 	int idx = 0;
 	while (compileIndices[idx] != -1) {
 		const int stageId = compileIndices[idx];
-		const char* mainName = mainNames[stageId];
 		gxapi::eShaderType type = types[stageId];
-		auto binary = m_gxapiManager->CompileShader(sourceCode.c_str(),
-			mainName,
-			type,
-			m_compileFlags,
-			&includeProvider,
-			macros.c_str());
+		gxapi::ShaderProgramBinary binary = stageResults[idx].get();
 
 		ShaderStage* dest;
 		switch (type) {
@@ -225,7 +529,7 @@ ShaderProgram ShaderManager::CompileShader(const std::string& sourceCode, const
 			case gxapi::eShaderType::PIXEL: dest = &ret.ps; break;
 			case gxapi::eShaderType::COMPUTE: dest = &ret.cs; break;
 		}
-		*dest = ShaderStage(std::move(binary.data));
+		*dest = InternBinary(std::move(binary.data));
 		++idx;
 	}
 
@@ -233,6 +537,90 @@ ShaderProgram ShaderManager::CompileShader(const std::string& sourceCode, const
 }
 
 
+uint64_t ShaderManager::HashSourceWithIncludes(const std::string& sourceCode, std::vector<std::string>* includePaths) {
+	// FNV-1a over the source and every file it includes, each include visited once.
+	uint64_t hash = 14695981039346656037ull;
+	auto hashString = [&hash](const std::string& str) {
+		for (unsigned char c : str) {
+			hash ^= c;
+			hash *= 1099511628211ull;
+		}
+		hash ^= 0xFF; // separator
+		hash *= 1099511628211ull;
+	};
+
+	std::unordered_set<std::string> visited;
+	std::vector<std::string> pending = { sourceCode };
+	while (!pending.empty()) {
+		std::string source = std::move(pending.back());
+		pending.pop_back();
+		hashString(source);
+
+		std::istringstream lines(source);
+		std::string line;
+		while (std::getline(lines, line)) {
+			// the preprocessor allows whitespace between # and the directive
+			size_t pound = line.find_first_not_of(" \t");
+			if (pound == line.npos || line[pound] != '#') {
+				continue;
+			}
+			size_t directive = line.find_first_not_of(" \t", pound + 1);
+			if (directive == line.npos || line.compare(directive, 7, "include") != 0) {
+				continue;
+			}
+			size_t open = line.find_first_of("\"<", directive + 7);
+			size_t close = open != line.npos ? line.find_first_of("\">", open + 1) : line.npos;
+			if (close == line.npos) {
+				continue;
+			}
+			std::string includeName = line.substr(open + 1, close - open - 1);
+			if (!visited.insert(includeName).second) {
+				continue;
+			}
+
+			hashString(includeName);
+			try {
+				auto pathSourcePair = FindShaderCode(includeName);
+				if (includePaths) {
+					includePaths->push_back(pathSourcePair.first);
+				}
+				pending.push_back(std::move(pathSourcePair.second));
+			}
+			catch (std::runtime_error&) {
+				// Missing include, the compiler will report it.
+			}
+		}
+	}
+
+	return hash;
+}
+
+
+ShaderStage ShaderManager::InternBinary(std::vector<uint8_t> binary) {
+	uint64_t hash = 14695981039346656037ull;
+	for (uint8_t byte : binary) {
+		hash = (hash ^ byte) * 1099511628211ull;
+	}
+
+	std::lock_guard<std::mutex> lkg(m_binaryMutex);
+	auto range = m_binaries.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it) {
+		if (*it->second == binary) {
+			return ShaderStage(it->second);
+		}
+	}
+	auto shared = std::make_shared<const std::vector<uint8_t>>(std::move(binary));
+	m_binaries.insert({ hash, shared });
+	return ShaderStage(shared);
+}
+
+
+size_t ShaderManager::GetNumUniqueBinaries() const {
+	std::lock_guard<std::mutex> lkg(m_binaryMutex);
+	return m_binaries.size();
+}
+
+
 std::string ShaderManager::StripShaderName(std::string name) {
 	// remove extension from the end, if any
 	size_t extDot = name.find_last_of('.');
@@ -5,33 +5,53 @@
 #include <unordered_set>
 #include <mutex>
 #include <shared_mutex>
+#include <future>
+#include <thread>
+#include <deque>
+#include <chrono>
+#include <functional>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
 
 #include <GraphicsApi_LL/IGxapiManager.hpp>
 #include <GraphicsApi_LL/Common.hpp>
 
+#include "ShaderCache.hpp"
+
 
 namespace inl {
 namespace gxeng {
 
 
 /// <summary> Contains the compiled binaries for a shader stage (VS, PS, etc.). </summary>
+/// <remarks> The binary is immutable and shared by copies of the stage,
+///		as well as by stages compiled to the same bytecode. </remarks>
 class ShaderStage {
 public:
 	ShaderStage() = default;
-	ShaderStage(std::vector<uint8_t> binary) : m_binary(std::move(binary)) {}
+	ShaderStage(std::vector<uint8_t> binary) : m_binary(std::make_shared<const std::vector<uint8_t>>(std::move(binary))) {}
+	ShaderStage(std::shared_ptr<const std::vector<uint8_t>> binary) : m_binary(std::move(binary)) {}
 
-	operator bool() const { return m_binary.size() > 0; }
-	operator gxapi::ShaderByteCodeDesc() const { return gxapi::ShaderByteCodeDesc(m_binary.data(), m_binary.size()); }
+	operator bool() const { return Size() > 0; }
+	operator gxapi::ShaderByteCodeDesc() const { return gxapi::ShaderByteCodeDesc(Data(), Size()); }
 
-	const void* Data() const { return m_binary.data(); }
-	size_t Size() const { return m_binary.size(); }
+	const void* Data() const { return m_binary ? m_binary->data() : nullptr; }
+	size_t Size() const { return m_binary ? m_binary->size() : 0; }
 private:
-	std::vector<uint8_t> m_binary;
+	std::shared_ptr<const std::vector<uint8_t>> m_binary;
 };
 
 /// <summary> Helper class for keeping track of which shader stages have been compiled. </summary>
 struct ShaderParts {
 	bool vs = false, hs = false, ds = false, gs = false, ps = false, cs = false;
+	/// <summary> A vertex and a pixel shader, the stages of most graphics nodes. </summary>
+	static ShaderParts VertexPixel() {
+		ShaderParts parts;
+		parts.vs = true;
+		parts.ps = true;
+		return parts;
+	}
 	bool SubsetOf(const volatile ShaderParts& other) const volatile {
 		return (vs <= other.vs)
 			&& (hs <= other.hs)
@@ -95,6 +115,14 @@ public:
 /// shader codes. Shader binaries are requested by name. If the source code associated
 /// with the requested name is found either as a file, a resource or memory-string,
 /// the code is compiled and the binary is returned.
+/// <para />
+/// Stages of a program are compiled in parallel on the manager's worker threads,
+/// and whole programs can be requested asynchronously with CreateShaderAsync.
+/// <para />
+/// With hot reload enabled, the source files and includes of every created shader
+/// are watched. When any of them changes, the affected programs are recompiled in the
+/// background and swapped in by ApplyReloadedShaders, which should be called at a frame
+/// boundary.
 /// </summary>
 /// <remarks>
 /// This class is designed for concurrent requests for multiple shaders, so it is
@@ -171,15 +199,44 @@ public:
 	gxapi::eShaderCompileFlags GetShaderCompileFlags() const;
 
 
+	/// <summary> Store compiled binaries in this directory and reuse them in later runs. </summary>
+	/// <param name="directory"> Directory of the cache. An empty path disables the on-disk cache. </param>
+	/// <param name="maxSize"> Size limit of the cache directory in bytes. </param>
+	/// <remarks> This method is NOT thread-safe, call it before creating shaders. </remarks>
+	void SetCacheDirectory(std::experimental::filesystem::path directory, uint64_t maxSize = 256ull * 1024 * 1024);
+
+
 	/// <summary> Compile a shader from source. </summary>
 	/// <param name="name"> Name of the shader (tipically file name), without extension. </param>
 	/// <param name="parts"> Which shader stages should be compiled. </param>
 	/// <param name="macros"> A string containing the marco definitions to use for shader compilation. </param>
 	const ShaderProgram& CreateShader(const std::string& name, ShaderParts parts, const std::string& macros = {});
 
+	/// <summary> Compile a shader from source on a worker thread. </summary>
+	/// <returns> The future receives a copy of the compiled program, or the compilation error. </returns>
+	/// <remarks> This method is thread-safe. </remarks>
+	std::shared_future<ShaderProgram> CreateShaderAsync(const std::string& name, ShaderParts parts, const std::string& macros = {});
 
-	/// <summary> It does not do anything, but I guess it will be good for something in the future. </summary>
+
+	/// <summary> Start or stop watching the sources of created shaders for changes. </summary>
+	/// <param name="pollInterval"> How often to check file modification times. </param>
+	/// <remarks> This method is NOT thread-safe. </remarks>
+	void EnableHotReload(bool enable, std::chrono::milliseconds pollInterval = std::chrono::milliseconds(500));
+
+	/// <summary> Recompile all shaders in the background. Use ApplyReloadedShaders to swap them in. </summary>
 	void ReloadShaders();
+
+	/// <summary> Replaces programs with the ones recompiled in the background since the last call. </summary>
+	/// <param name="errors"> Receives the compiler messages of failed recompilations.
+	///		Programs that failed to compile keep their previous binaries. </param>
+	/// <returns> True if any program has been replaced. </returns>
+	/// <remarks> References returned by CreateShader see the new binaries after this call,
+	///		so it must not run concurrently with code using them, i.e. call it between frames. </remarks>
+	bool ApplyReloadedShaders(std::vector<std::string>& errors);
+
+
+	/// <summary> Number of distinct stage binaries compiled so far. Stages with identical bytecode are stored once. </summary>
+	size_t GetNumUniqueBinaries() const;
 private:
 	// Find a source in dirs, resource and codes by its name. Does not lock anything.
 	std::pair<std::string, std::string> FindShaderCode(const std::string& name);
@@ -187,6 +244,25 @@ private:
 	// Compiles a shader to binary according to parameters.
 	ShaderProgram CompileShader(const std::string& sourceCode, const std::string& macros, ShaderParts parts);
 
+	// Hashes the source code together with all files it includes, recursively. Does not lock anything.
+	// Optionally returns the paths of the included files.
+	uint64_t HashSourceWithIncludes(const std::string& sourceCode, std::vector<std::string>* includePaths = nullptr);
+
+	// Returns a stage sharing the memory of an identical binary compiled before, if there's one.
+	ShaderStage InternBinary(std::vector<uint8_t> binary);
+
+	// Runs a job on one of the worker threads. Jobs still queued when the manager is destroyed are cancelled instead.
+	void PushJob(std::function<void()> job, std::function<void()> cancel = {});
+	void WorkerThread();
+	static bool IsWorkerThread();
+
+	// Remembers which files the shader was compiled from. Locks the watch mutex.
+	void TrackDependencies(const ShaderId& shaderId, const std::string& shaderPath, const std::vector<std::string>& includePaths);
+	// Polls the tracked files and schedules recompilation of the shaders depending on modified ones.
+	void WatchThread(std::chrono::milliseconds pollInterval);
+	// Compiles the program again from its current source, and queues it for ApplyReloadedShaders.
+	void RecompileShader(const ShaderId& shaderId);
+
 	// Cuts off extension (only .hlsl, .glsl, .cg, .txt), converts to lowercase.
 	std::string StripShaderName(std::string name);
 private:
@@ -203,6 +279,34 @@ private:
 	size_t m_numCompileMutexes;
 
 	gxapi::eShaderCompileFlags m_compileFlags;
+
+	ShaderCache m_binaryCache;
+
+	std::unordered_multimap<uint64_t, std::shared_ptr<const std::vector<uint8_t>>> m_binaries; // bytecode hash -> binary
+	mutable std::mutex m_binaryMutex;
+
+	// Compiler threads
+	struct Job {
+		std::function<void()> run;
+		std::function<void()> cancel;
+	};
+	std::vector<std::thread> m_workers;
+	std::deque<Job> m_jobs;
+	std::mutex m_jobMutex;
+	std::condition_variable m_jobCv;
+	bool m_stopWorkers;
+
+	// Hot reload
+	std::unordered_map<std::string, std::unordered_set<ShaderId, ShaderIdHash>> m_dependents; // file path -> shaders compiled from it
+	std::unordered_map<std::string, std::experimental::filesystem::file_time_type> m_fileTimes;
+	std::mutex m_watchMutex;
+	std::condition_variable m_watchCv;
+	std::thread m_watchThread;
+	std::atomic_bool m_watching;
+
+	std::unordered_map<ShaderId, ShaderProgram, ShaderIdHash> m_reloadedShaders;
+	std::vector<std::string> m_reloadErrors;
+	std::mutex m_reloadMutex;
 };
 
 
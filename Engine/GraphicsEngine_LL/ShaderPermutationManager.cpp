@@ -0,0 +1,195 @@
+#include "ShaderPermutationManager.hpp"
+
+#include <algorithm>
+#include <future>
+#include <cctype>
+
+
+namespace inl {
+namespace gxeng {
+
+
+ShaderPermutationManager::ShaderPermutationManager(ShaderManager* shaderManager)
+	: m_shaderManager(shaderManager)
+{}
+
+
+auto ShaderPermutationManager::GetMask(const std::string& macros) -> Mask {
+	// split at whitespace and semicolons, except inside quotes
+	std::vector<std::string> definitions;
+	std::string current;
+	bool quote = false;
+	for (size_t i = 0; i < macros.size(); ++i) {
+		char c = macros[i];
+		if (c == '\\' && i + 1 < macros.size()) {
+			current += c;
+			current += macros[++i];
+			continue;
+		}
+		if (c == '"') {
+			quote = !quote;
+		}
+		if (!quote && (isspace((unsigned char)c) || c == ';')) {
+			if (!current.empty()) {
+				definitions.push_back(CanonicalizeDefinition(current));
+				current.clear();
+			}
+			continue;
+		}
+		current += c;
+	}
+	if (!current.empty()) {
+		definitions.push_back(CanonicalizeDefinition(current));
+	}
+
+	std::lock_guard<std::mutex> lkg(m_mutex);
+
+	Mask mask = 0;
+	for (auto& definition : definitions) {
+		auto it = m_definitionBits.find(definition);
+		if (it == m_definitionBits.end()) {
+			if (m_definitions.size() >= MaxMacros) {
+				throw std::out_of_range("Too many distinct shader macro definitions for a permutation mask.");
+			}
+			it = m_definitionBits.insert({ definition, m_definitions.size() }).first;
+			m_definitions.push_back(definition);
+		}
+		mask |= Mask(1) << it->second;
+	}
+
+	return mask;
+}
+
+
+std::string ShaderPermutationManager::GetMacros(Mask mask) const {
+	std::lock_guard<std::mutex> lkg(m_mutex);
+	return BuildMacros(mask);
+}
+
+
+void ShaderPermutationManager::Request(const std::string& shaderName, ShaderParts parts, Mask mask) {
+	std::lock_guard<std::mutex> lkg(m_mutex);
+
+	Permutation& permutation = m_permutations[{ shaderName, mask }];
+	permutation.requestedParts = permutation.requestedParts.SetUnion(parts);
+}
+
+
+bool ShaderPermutationManager::Precompile(std::vector<std::string>& errors) {
+	struct PendingCompile {
+		PermutationId id;
+		ShaderParts parts;
+		std::shared_future<ShaderProgram> program;
+	};
+	std::vector<PendingCompile> pending;
+
+	// Launch all missing permutations at once, the shader manager spreads them over its workers.
+	{
+		std::lock_guard<std::mutex> lkg(m_mutex);
+		for (auto& [id, permutation] : m_permutations) {
+			if (permutation.requestedParts.SubsetOf(permutation.compiledParts)) {
+				continue;
+			}
+			ShaderParts parts = permutation.requestedParts.SetSubtract(permutation.compiledParts);
+			auto program = m_shaderManager->CreateShaderAsync(id.shaderName, parts, BuildMacros(id.mask));
+			pending.push_back({ id, parts, std::move(program) });
+		}
+	}
+
+	bool success = true;
+	for (auto& compile : pending) {
+		try {
+			const ShaderProgram& program = compile.program.get();
+			std::lock_guard<std::mutex> lkg(m_mutex);
+			StoreStages(m_permutations[compile.id], program, compile.parts);
+		}
+		catch (std::exception& ex) {
+			errors.push_back(ex.what());
+			success = false;
+		}
+	}
+
+	return success;
+}
+
+
+const ShaderProgram& ShaderPermutationManager::GetProgram(const std::string& shaderName, ShaderParts parts, Mask mask) {
+	std::unique_lock<std::mutex> lkg(m_mutex);
+
+	Permutation& permutation = m_permutations[{ shaderName, mask }];
+	permutation.requestedParts = permutation.requestedParts.SetUnion(parts);
+	if (parts.SubsetOf(permutation.compiledParts)) {
+		return permutation.program;
+	}
+	std::string macros = BuildMacros(mask);
+	lkg.unlock();
+
+	// Elements of the map are not moved by insertions, so the reference stays valid.
+	ShaderProgram program = m_shaderManager->CreateShader(shaderName, parts, macros);
+
+	lkg.lock();
+	StoreStages(permutation, program, parts);
+	return permutation.program;
+}
+
+
+void ShaderPermutationManager::InvalidatePrograms() {
+	std::lock_guard<std::mutex> lkg(m_mutex);
+
+	for (auto& [id, permutation] : m_permutations) {
+		permutation.compiledParts = ShaderParts();
+		permutation.program = ShaderProgram();
+	}
+}
+
+
+size_t ShaderPermutationManager::GetNumPermutations() const {
+	std::lock_guard<std::mutex> lkg(m_mutex);
+	return m_permutations.size();
+}
+
+
+std::string ShaderPermutationManager::BuildMacros(Mask mask) const {
+	std::vector<const std::string*> definitions;
+	for (size_t bit = 0; bit < m_definitions.size(); ++bit) {
+		if (mask & (Mask(1) << bit)) {
+			definitions.push_back(&m_definitions[bit]);
+		}
+	}
+	std::sort(definitions.begin(), definitions.end(), [](const std::string* lhs, const std::string* rhs) {
+		return *lhs < *rhs;
+	});
+
+	std::string macros;
+	for (auto definition : definitions) {
+		if (!macros.empty()) {
+			macros += ' ';
+		}
+		macros += *definition;
+	}
+	return macros;
+}
+
+
+std::string ShaderPermutationManager::CanonicalizeDefinition(const std::string& definition) {
+	// the compiler needs a value for every macro
+	if (definition.find('=') == definition.npos) {
+		return definition + "=1";
+	}
+	return definition;
+}
+
+
+void ShaderPermutationManager::StoreStages(Permutation& permutation, const ShaderProgram& program, ShaderParts parts) {
+	if (parts.vs) { permutation.program.vs = program.vs; }
+	if (parts.hs) { permutation.program.hs = program.hs; }
+	if (parts.ds) { permutation.program.ds = program.ds; }
+	if (parts.gs) { permutation.program.gs = program.gs; }
+	if (parts.ps) { permutation.program.ps = program.ps; }
+	if (parts.cs) { permutation.program.cs = program.cs; }
+	permutation.compiledParts = permutation.compiledParts.SetUnion(parts);
+}
+
+
+} // namespace gxeng
+} // namespace inl
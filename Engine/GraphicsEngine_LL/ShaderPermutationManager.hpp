@@ -0,0 +1,97 @@
+#pragma once
+
+#include "ShaderManager.hpp"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+
+
+namespace inl {
+namespace gxeng {
+
+
+/// <summary>
+/// Compiles the variants of shaders that materials select with macros.
+/// <para />
+/// Macro sets are canonicalized to bitmasks, one bit per distinct definition, so
+/// "A;B", "B A" and "A=1 B=1" are the same permutation. Nodes register the
+/// permutations they use with Request through GraphicsContext::RequestShader, and
+/// Precompile builds every requested permutation once, in parallel on the shader
+/// manager's workers. Compile count
+/// and time therefore scale with the number of distinct variants, not with the
+/// number of materials. Stages that compile to the same bytecode share one binary
+/// in the shader manager.
+/// </summary>
+/// <remarks> This class is thread-safe. </remarks>
+class ShaderPermutationManager {
+public:
+	using Mask = uint64_t;
+	static constexpr size_t MaxMacros = 64;
+
+	ShaderPermutationManager(ShaderManager* shaderManager);
+
+	/// <summary> Returns the mask of a macro set. Definitions not seen before get new bits. </summary>
+	/// <param name="macros"> Definitions separated by whitespace or ';', like "A B=2".
+	///		Definitions without a value are defined to 1. </param>
+	/// <exception cref="std::out_of_range"> If there would be more than MaxMacros distinct definitions. </exception>
+	Mask GetMask(const std::string& macros);
+
+	/// <summary> Returns the canonical macro string of a mask, with the definitions sorted by name. </summary>
+	std::string GetMacros(Mask mask) const;
+
+	/// <summary> Marks a permutation as used, so that the next Precompile builds it. </summary>
+	void Request(const std::string& shaderName, ShaderParts parts, Mask mask);
+
+	/// <summary> Compiles all requested permutations that are not compiled yet, in parallel. </summary>
+	/// <param name="errors"> Receives the messages of failed compilations. </param>
+	/// <returns> True if all permutations compiled successfully. </returns>
+	bool Precompile(std::vector<std::string>& errors);
+
+	/// <summary> Returns a compiled permutation, compiles it now if it's not requested or precompiled yet. </summary>
+	/// <remarks> The reference remains valid as long as this object lives. </remarks>
+	const ShaderProgram& GetProgram(const std::string& shaderName, ShaderParts parts, Mask mask);
+
+	/// <summary> Forgets the compiled stages but keeps the requests, so that the next GetProgram
+	///		returns the binaries swapped in by ShaderManager::ApplyReloadedShaders. </summary>
+	/// <remarks> Must not be called while references returned by GetProgram are in use, copies keep the old binaries. </remarks>
+	void InvalidatePrograms();
+
+	/// <summary> Number of distinct (shader, macro set) pairs requested so far. </summary>
+	size_t GetNumPermutations() const;
+private:
+	struct PermutationId {
+		std::string shaderName;
+		Mask mask;
+		bool operator==(const PermutationId& rhs) const { return shaderName == rhs.shaderName && mask == rhs.mask; }
+	};
+	struct PermutationIdHash {
+		size_t operator()(const PermutationId& obj) const {
+			return std::hash<std::string>()(obj.shaderName) ^ std::hash<Mask>()(obj.mask);
+		}
+	};
+	struct Permutation {
+		ShaderParts requestedParts;
+		ShaderParts compiledParts;
+		ShaderProgram program;
+	};
+
+	// Joins the definitions of the mask, m_mutex must be locked.
+	std::string BuildMacros(Mask mask) const;
+	static std::string CanonicalizeDefinition(const std::string& definition);
+	static void StoreStages(Permutation& permutation, const ShaderProgram& program, ShaderParts parts);
+private:
+	ShaderManager* m_shaderManager;
+
+	std::vector<std::string> m_definitions; // bit index -> "NAME=VALUE"
+	std::unordered_map<std::string, size_t> m_definitionBits;
+
+	std::unordered_map<PermutationId, Permutation, PermutationIdHash> m_permutations;
+	mutable std::mutex m_mutex;
+};
+
+
+} // namespace gxeng
+} // namespace inl
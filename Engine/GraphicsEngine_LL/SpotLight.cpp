@@ -0,0 +1,69 @@
+#include "SpotLight.hpp"
+
+#include <algorithm>
+
+namespace inl::gxeng {
+
+
+SpotLight::SpotLight(mathfu::Vector3f position, mathfu::Vector3f direction, mathfu::Vector3f color, float range, float angle
+):
+	m_position(position),
+	m_direction(direction.Normalized()),
+	m_color(color),
+	m_range(range)
+{
+	SetAngle(angle);
+}
+
+
+void SpotLight::SetPosition(const mathfu::Vector3f& position) {
+	m_position = position;
+}
+
+
+void SpotLight::SetDirection(const mathfu::Vector3f& dir) {
+	m_direction = dir.Normalized();
+}
+
+
+void SpotLight::SetColor(const mathfu::Vector3f& color) {
+	m_color = color;
+}
+
+
+void SpotLight::SetRange(float range) {
+	m_range = range;
+}
+
+
+void SpotLight::SetAngle(float angle) {
+	m_angle = std::min(std::max(angle, 0.0f), 1.57079633f);
+}
+
+
+mathfu::Vector3f SpotLight::GetPosition() const {
+	return m_position;
+}
+
+
+mathfu::Vector3f SpotLight::GetDirection() const {
+	return m_direction;
+}
+
+
+mathfu::Vector3f SpotLight::GetColor() const {
+	return m_color;
+}
+
+
+float SpotLight::GetRange() const {
+	return m_range;
+}
+
+
+float SpotLight::GetAngle() const {
+	return m_angle;
+}
+
+
+} // namespace inl::gxeng
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <mathfu/mathfu_exc.hpp>
+
+namespace inl::gxeng {
+
+/// <summary> A light that shines in a cone from a point and fades out at its range. </summary>
+class SpotLight {
+public:
+	SpotLight() = default;
+	SpotLight(mathfu::Vector3f position, mathfu::Vector3f direction, mathfu::Vector3f color, float range, float angle);
+
+	void SetPosition(const mathfu::Vector3f& position);
+	void SetDirection(const mathfu::Vector3f& dir);
+	void SetColor(const mathfu::Vector3f& color);
+	void SetRange(float range);
+	/// <summary> Angle between the cone's axis and its side in radians, clamped to [0, pi/2]. </summary>
+	void SetAngle(float angle);
+
+	mathfu::Vector3f GetPosition() const;
+	mathfu::Vector3f GetDirection() const;
+	mathfu::Vector3f GetColor() const;
+	float GetRange() const;
+	float GetAngle() const;
+
+protected:
+	mathfu::Vector3f m_position = { 0, 0, 0 };
+	mathfu::Vector3f m_direction = { 0, 0, -1 };
+	mathfu::Vector3f m_color = { 1, 1, 1 };
+	float m_range = 1.0f;
+	float m_angle = 0.5f;
+};
+
+} // namespace inl::gxeng
@@ -45,12 +45,13 @@ DescriptorArrayRef::DescriptorArrayRef(StackDescHeap* home, uint32_t pos, uint32
 // =======================================================
 
 
-StackDescHeap::StackDescHeap(gxapi::IGraphicsApi* graphicsApi, gxapi::eDescriptorHeapType type, uint32_t size) :
-	m_size(size),
-	m_next(0)
+StackDescHeap::StackDescHeap(gxapi::IGraphicsApi* graphicsApi, gxapi::eDescriptorHeapType type, uint32_t size, uint32_t reservedSize) :
+	m_size(reservedSize + size),
+	m_reservedSize(reservedSize),
+	m_next(reservedSize)
 {
 	assert(type == gxapi::eDescriptorHeapType::CBV_SRV_UAV || type == gxapi::eDescriptorHeapType::SAMPLER);
-	gxapi::DescriptorHeapDesc desc(type, size, true);
+	gxapi::DescriptorHeapDesc desc(type, m_size, true);
 	m_heap.reset(graphicsApi->CreateDescriptorHeap(desc));
 }
 
@@ -67,7 +68,15 @@ DescriptorArrayRef StackDescHeap::Allocate(uint32_t size) {
 
 
 void StackDescHeap::Reset() {
-	m_next = 0;
+	m_next = m_reservedSize;
+}
+
+
+DescriptorArrayRef StackDescHeap::GetReservedRange() {
+	if (m_reservedSize == 0) {
+		return DescriptorArrayRef();
+	}
+	return DescriptorArrayRef(this, 0, m_reservedSize);
 }
 
 
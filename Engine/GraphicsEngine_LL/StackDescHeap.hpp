@@ -49,23 +49,33 @@ protected:
 /// <para />
 /// Each CPU thread that generates command lists should have
 /// exclusive ownership over at least one instance of this class.
+/// <para />
+/// The reserved descriptors at the start of the heap are never allocated,
+/// they hold the texture table, see <see cref="TextureTable"/>.
 /// </summary>
 class StackDescHeap {
 	friend class DescriptorArrayRef;
 public:
-	StackDescHeap(gxapi::IGraphicsApi* graphicsApi, gxapi::eDescriptorHeapType type, uint32_t size);
+	/// <param name="size"> Number of descriptors that can be allocated. </param>
+	/// <param name="reservedSize"> Number of descriptors reserved before the allocated ones. </param>
+	StackDescHeap(gxapi::IGraphicsApi* graphicsApi, gxapi::eDescriptorHeapType type, uint32_t size, uint32_t reservedSize = 0);
 
 	DescriptorArrayRef Allocate(uint32_t size);
 
 	/// <summary>
-	/// Frees all allocations. Next allocation will be placed at the begginning of the heap.
+	/// Frees all allocations. Next allocation will be placed right after the reserved descriptors.
 	/// </summary>
 	void Reset();
 
+	/// <summary> The descriptors at the start of the heap that are never allocated. </summary>
+	DescriptorArrayRef GetReservedRange();
+	uint32_t GetReservedSize() const { return m_reservedSize; }
+
 	gxapi::IDescriptorHeap* GetHeap() const { return m_heap.get(); }
 protected:
 	std::unique_ptr<gxapi::IDescriptorHeap> m_heap;
 	uint32_t m_size;
+	uint32_t m_reservedSize;
 	uint32_t m_next;
 };
 
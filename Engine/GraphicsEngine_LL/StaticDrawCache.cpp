@@ -0,0 +1,187 @@
+#include "StaticDrawCache.hpp"
+
+#include "MeshEntity.hpp"
+#include "Mesh.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+
+
+namespace inl {
+namespace gxeng {
+
+
+static bool IsSameMatrix(const mathfu::Matrix<float, 4, 4>& lhs, const mathfu::Matrix<float, 4, 4>& rhs) {
+	for (int i = 0; i < 16; ++i) {
+		if (lhs[i] != rhs[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+void StaticDrawCache::Update(const EntityCollection<MeshEntity>& entities) {
+	++m_frame;
+	m_dynamicEntities.clear();
+	m_visibleGroups.clear();
+	for (GroupSlot& slot : m_groups) {
+		slot.numVisible = 0;
+	}
+
+	for (const MeshEntity* entity : entities) {
+		const MeshEntityStore& store = entity->GetStore();
+		size_t storeIndex = entity->GetStoreIndex();
+		MeshEntityHandle handle = entity->GetStoreHandle();
+		Mesh* mesh = store.MeshAt(storeIndex);
+		uint64_t meshVersion = mesh ? mesh->GetBufferVersion() : 0;
+		Image* texture = store.TextureAt(storeIndex);
+		const mathfu::Matrix<float, 4, 4>& world = store.WorldMatrix(storeIndex);
+
+		auto indexIt = m_entityIndices.find(entity);
+		if (indexIt != m_entityIndices.end() && m_entities[indexIt->second].handle != handle) {
+			// A new entity has taken the place of a destroyed one
+			Forget(indexIt->second);
+			indexIt = m_entityIndices.end();
+		}
+		if (indexIt == m_entityIndices.end()) {
+			// New entities settle after FramesToSettle more frames, like changed ones
+			indexIt = m_entityIndices.insert({ entity, m_entities.size() }).first;
+			m_entities.push_back({ entity, handle, mesh, meshVersion, texture, world, 0, m_frame, NoGroup });
+		}
+		else {
+			TrackedEntity& tracked = m_entities[indexIt->second];
+			if (tracked.mesh != mesh || tracked.meshVersion != meshVersion || tracked.texture != texture || !IsSameMatrix(tracked.world, world)) {
+				LeaveGroup(tracked);
+				tracked.mesh = mesh;
+				tracked.meshVersion = meshVersion;
+				tracked.texture = texture;
+				tracked.world = world;
+				tracked.unchangedFrames = 0;
+			}
+			else if (tracked.unchangedFrames < FramesToSettle) {
+				++tracked.unchangedFrames;
+			}
+		}
+
+		TrackedEntity& tracked = m_entities[indexIt->second];
+		tracked.lastVisibleFrame = m_frame;
+
+		if (tracked.group == NoGroup && tracked.unchangedFrames >= FramesToSettle) {
+			JoinGroup(tracked);
+		}
+		if (tracked.group != NoGroup) {
+			++m_groups[tracked.group].numVisible;
+		}
+		else {
+			m_dynamicEntities.push_back(entity);
+		}
+	}
+
+	// Entities not seen for a while may have been removed from the scene or destroyed,
+	// their addresses are not touched as they may be dangling
+	for (size_t i = m_entities.size(); i-- > 0;) {
+		if (m_frame - m_entities[i].lastVisibleFrame > FramesToForget) {
+			Forget(i);
+		}
+	}
+
+	// Groups seen whole are drawn by their bundles, the visible entities of the others one by one
+	for (size_t i = 0; i < m_groups.size(); ++i) {
+		const GroupSlot& slot = m_groups[i];
+		if (slot.numVisible == 0) {
+			continue;
+		}
+		if (slot.numVisible == slot.group.entities.size()) {
+			m_visibleGroups.push_back(i);
+		}
+		else {
+			for (const MeshEntity* entity : slot.group.entities) {
+				if (m_entities[m_entityIndices.at(entity)].lastVisibleFrame == m_frame) {
+					m_dynamicEntities.push_back(entity);
+				}
+			}
+		}
+	}
+}
+
+
+void StaticDrawCache::Forget(size_t trackedIndex) {
+	LeaveGroup(m_entities[trackedIndex]);
+	m_entityIndices.erase(m_entities[trackedIndex].entity);
+	if (trackedIndex != m_entities.size() - 1) {
+		m_entities[trackedIndex] = m_entities.back();
+		m_entityIndices[m_entities[trackedIndex].entity] = trackedIndex;
+	}
+	m_entities.pop_back();
+}
+
+
+void StaticDrawCache::JoinGroup(TrackedEntity& tracked) {
+	assert(tracked.group == NoGroup);
+
+	mathfu::Vector<float, 3> position = tracked.world.TranslationVector3D();
+	GroupKey key{
+		tracked.texture,
+		(int)std::floor(position.x() / CellSize),
+		(int)std::floor(position.y() / CellSize),
+		(int)std::floor(position.z() / CellSize)
+	};
+
+	// Entities join the cell's newest group until it is full
+	auto openIt = m_openGroups.find(key);
+	size_t groupIndex;
+	if (openIt != m_openGroups.end() && m_groups[openIt->second].group.entities.size() < MaxGroupSize) {
+		groupIndex = openIt->second;
+	}
+	else {
+		if (!m_freeGroups.empty()) {
+			groupIndex = m_freeGroups.back();
+			m_freeGroups.pop_back();
+		}
+		else {
+			groupIndex = m_groups.size();
+			m_groups.emplace_back();
+		}
+		GroupSlot& slot = m_groups[groupIndex];
+		slot.group.texture = tracked.texture;
+		slot.group.entities.clear();
+		slot.key = key;
+		slot.numVisible = 0;
+		m_openGroups[key] = groupIndex;
+	}
+
+	Group& group = m_groups[groupIndex].group;
+	group.entities.push_back(tracked.entity);
+	group.changed = true;
+	tracked.group = groupIndex;
+}
+
+
+void StaticDrawCache::LeaveGroup(TrackedEntity& tracked) {
+	if (tracked.group == NoGroup) {
+		return;
+	}
+
+	GroupSlot& slot = m_groups[tracked.group];
+	std::vector<const MeshEntity*>& members = slot.group.entities;
+	auto memberIt = std::find(members.begin(), members.end(), tracked.entity);
+	assert(memberIt != members.end());
+	*memberIt = members.back();
+	members.pop_back();
+	slot.group.changed = true;
+
+	if (members.empty()) {
+		auto openIt = m_openGroups.find(slot.key);
+		if (openIt != m_openGroups.end() && openIt->second == tracked.group) {
+			m_openGroups.erase(openIt);
+		}
+		m_freeGroups.push_back(tracked.group);
+	}
+	tracked.group = NoGroup;
+}
+
+
+} // namespace gxeng
+} // namespace inl
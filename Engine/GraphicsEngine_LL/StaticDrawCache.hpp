@@ -0,0 +1,122 @@
+#pragma once
+
+#include "EntityCollection.hpp"
+#include "MeshEntityStore.hpp"
+
+#include <mathfu/matrix_4x4.h>
+
+#include <vector>
+#include <unordered_map>
+#include <map>
+#include <tuple>
+#include <cstdint>
+
+
+namespace inl {
+namespace gxeng {
+
+
+class MeshEntity;
+class Mesh;
+class Image;
+
+
+/// <summary>
+/// Finds the entities that have not changed for a while, so that their draws can be recorded
+/// into bundles once and executed every frame, see GraphicsBundle.
+/// <para />
+/// Entities that stay unchanged for FramesToSettle frames are put into groups of nearby entities
+/// with the same texture, each group is recorded into a bundle of its own. An entity whose mesh,
+/// mesh buffers, texture or world matrix changes leaves its group, which has to be recorded again,
+/// and is drawn directly until it settles again.
+/// <para />
+/// A group is drawn by its bundle when all of its entities are visible. Otherwise the visible ones
+/// are drawn directly, so culled entities are never drawn, and entities removed from the scene or
+/// destroyed leave their group after not being visible for FramesToForget frames.
+/// </summary>
+/// <remarks>
+/// Changes are found by comparing the entities to the previous frame in their store, they need not be reported.
+/// The results only depend on the entities given to Update, so two caches given the same entities
+/// every frame group them the same way.
+/// </remarks>
+class StaticDrawCache {
+public:
+	/// <summary> Frames an entity must stay unchanged before it is put into a group. </summary>
+	static constexpr unsigned FramesToSettle = 8;
+	/// <summary> Frames an entity may not be visible before it is forgotten. </summary>
+	static constexpr unsigned FramesToForget = 64;
+	/// <summary> Groups are made of the entities within the same cell of a grid of this size. </summary>
+	static constexpr float CellSize = 64.0f;
+	/// <summary> Cells with more entities of the same texture are split into several groups. </summary>
+	static constexpr size_t MaxGroupSize = 256;
+
+	struct Group {
+		Image* texture = nullptr;
+		std::vector<const MeshEntity*> entities;
+		/// <summary> The group's entities have changed since it was last recorded, see MarkRecorded. </summary>
+		bool changed = true;
+	};
+public:
+	/// <summary> Finds the changed entities and sorts the visible ones into groups and directly drawn ones. </summary>
+	/// <param name="entities"> The entities visible this frame. </param>
+	void Update(const EntityCollection<MeshEntity>& entities);
+
+	/// <summary> Visible entities that are to be drawn directly. </summary>
+	const std::vector<const MeshEntity*>& GetDynamicEntities() const { return m_dynamicEntities; }
+	/// <summary> Indices of the groups whose entities are all visible, they are to be drawn by their bundles. </summary>
+	const std::vector<size_t>& GetVisibleGroups() const { return m_visibleGroups; }
+
+	/// <summary> Number of group indices, including those of empty groups whose indices are reused later. </summary>
+	size_t GetNumGroups() const { return m_groups.size(); }
+	const Group& GetGroup(size_t index) const { return m_groups[index].group; }
+	/// <summary> Clears the group's changed flag once its bundle has been recorded. </summary>
+	void MarkRecorded(size_t index) { m_groups[index].group.changed = false; }
+
+	/// <summary> Number of entities that are remembered, grouped or not. </summary>
+	size_t GetNumTrackedEntities() const { return m_entities.size(); }
+private:
+	static constexpr size_t NoGroup = ~size_t(0);
+
+	struct TrackedEntity {
+		const MeshEntity* entity;
+		MeshEntityHandle handle;
+		Mesh* mesh;
+		uint64_t meshVersion;
+		Image* texture;
+		mathfu::Matrix<float, 4, 4> world;
+		unsigned unchangedFrames;
+		uint64_t lastVisibleFrame;
+		size_t group;
+	};
+
+	struct GroupKey {
+		Image* texture;
+		int x, y, z;
+
+		bool operator<(const GroupKey& rhs) const { return std::tie(texture, x, y, z) < std::tie(rhs.texture, rhs.x, rhs.y, rhs.z); }
+	};
+
+	struct GroupSlot {
+		Group group;
+		GroupKey key;
+		size_t numVisible;
+	};
+
+	void Forget(size_t trackedIndex);
+	void JoinGroup(TrackedEntity& tracked);
+	void LeaveGroup(TrackedEntity& tracked);
+private:
+	uint64_t m_frame = 0;
+	std::vector<TrackedEntity> m_entities;
+	std::unordered_map<const MeshEntity*, size_t> m_entityIndices; // entity -> index in m_entities
+	std::vector<GroupSlot> m_groups;
+	std::vector<size_t> m_freeGroups;
+	std::map<GroupKey, size_t> m_openGroups; // key -> the group new entities of the cell join
+
+	std::vector<const MeshEntity*> m_dynamicEntities;
+	std::vector<size_t> m_visibleGroups;
+};
+
+
+} // namespace gxeng
+} // namespace inl
@@ -0,0 +1,201 @@
+#include "TerrainEntity.hpp"
+
+#include "Mesh.hpp"
+#include "MeshEntity.hpp"
+#include "Camera.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+
+namespace inl {
+namespace gxeng {
+
+
+// At most this many chunks are generated at the same time.
+static constexpr size_t MaxPendingChunks = 8;
+
+// Quads along each side of a chunk's occluder, a decimated version of its surface.
+static constexpr unsigned OccluderQuads = 4;
+
+// Meshes of chunks not drawn for this many selections are freed, long after the GPU is done with them.
+static constexpr uint64_t ChunkLifetime = 120;
+
+
+TerrainEntity::TerrainEntity(MemoryManager* memoryManager, std::shared_ptr<MeshEntityStore> store) :
+	m_memoryManager(memoryManager),
+	m_store(std::move(store)),
+	m_heightfield(std::make_shared<Heightfield>())
+{}
+
+
+TerrainEntity::~TerrainEntity() {
+	// waits for the workers
+	m_pendingChunks.clear();
+}
+
+
+void TerrainEntity::SetHeightfield(Heightfield heightfield, unsigned chunkQuads) {
+	TerrainQuadtree quadtree(heightfield, chunkQuads);
+
+	m_pendingChunks.clear();
+	m_chunks.clear();
+	m_selectedChunks.clear();
+	m_drawnIndices.clear();
+	m_drawnChunks.clear();
+	m_heightfield = std::make_shared<Heightfield>(std::move(heightfield));
+	m_quadtree = std::move(quadtree);
+}
+
+
+const Heightfield& TerrainEntity::GetHeightfield() const {
+	return *m_heightfield;
+}
+
+
+const TerrainQuadtree& TerrainEntity::GetQuadtree() const {
+	return m_quadtree;
+}
+
+
+void TerrainEntity::SetTexture(Image* texture) {
+	m_texture = texture;
+	for (auto& chunk : m_chunks) {
+		chunk.second.entity->SetTexture(texture);
+	}
+}
+
+
+Image* TerrainEntity::GetTexture() const {
+	return m_texture;
+}
+
+
+void TerrainEntity::SetPosition(mathfu::Vector<float, 3> position) {
+	m_position = position;
+	for (auto& chunk : m_chunks) {
+		chunk.second.entity->SetPosition(position);
+	}
+}
+
+
+mathfu::Vector<float, 3> TerrainEntity::GetPosition() const {
+	return m_position;
+}
+
+
+void TerrainEntity::SetMaxPixelError(float maxPixelError) {
+	m_maxPixelError = maxPixelError;
+}
+
+
+float TerrainEntity::GetMaxPixelError() const {
+	return m_maxPixelError;
+}
+
+
+void TerrainEntity::SelectLod(const Camera& camera, unsigned screenHeight) {
+	++m_selection;
+	m_drawnChunks.clear();
+	if (m_quadtree.GetChunks().empty()) {
+		m_selectedChunks.clear();
+		return;
+	}
+
+	// Select in the terrain's space
+	Frustum frustum(camera.GetPerspectiveMatrixRH() * camera.GetViewMatrixRH() * mathfu::Matrix<float, 4, 4>::FromTranslationVector(m_position));
+	float errorScale = TerrainQuadtree::ErrorScale(camera.GetFOVVertical(), screenHeight);
+	m_quadtree.SelectLod(camera.GetPosition() - m_position, frustum, errorScale, m_maxPixelError, m_selectedChunks);
+
+	// The root is the last resort for chunks without a mesh, it comes first
+	const std::vector<TerrainChunk>& chunks = m_quadtree.GetChunks();
+	RequestChunk(0);
+	m_drawnIndices.clear();
+	for (uint32_t chunk : m_selectedChunks) {
+		RequestChunk(chunk);
+		uint32_t drawn = chunk;
+		while (drawn != TerrainQuadtree::InvalidChunk && m_chunks.count(drawn) == 0) {
+			drawn = chunks[drawn].parent;
+		}
+		if (drawn != TerrainQuadtree::InvalidChunk) {
+			m_drawnIndices.push_back(drawn);
+		}
+	}
+
+	// A stand-in ancestor covers its descendants, which must not be drawn on top of it
+	std::sort(m_drawnIndices.begin(), m_drawnIndices.end());
+	m_drawnIndices.erase(std::unique(m_drawnIndices.begin(), m_drawnIndices.end()), m_drawnIndices.end());
+	for (uint32_t chunk : m_drawnIndices) {
+		bool covered = false;
+		for (uint32_t ancestor = chunks[chunk].parent; ancestor != TerrainQuadtree::InvalidChunk && !covered; ancestor = chunks[ancestor].parent) {
+			covered = std::binary_search(m_drawnIndices.begin(), m_drawnIndices.end(), ancestor);
+		}
+		if (!covered) {
+			ChunkResources& resources = m_chunks[chunk];
+			resources.lastDrawn = m_selection;
+			m_drawnChunks.push_back(resources.entity.get());
+		}
+	}
+}
+
+
+void TerrainEntity::StreamChunks() {
+	for (auto it = m_pendingChunks.begin(); it != m_pendingChunks.end();) {
+		if (it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+			++it;
+			continue;
+		}
+
+		TerrainChunkMesh chunkMesh = it->second.get();
+		ChunkResources& resources = m_chunks[it->first];
+		resources.mesh = std::make_unique<Mesh>(m_memoryManager);
+		resources.mesh->Set(chunkMesh.vertices.data(), chunkMesh.vertices.size(), chunkMesh.indices.data(), chunkMesh.indices.size());
+		resources.mesh->SetOccluder(chunkMesh.occluderPositions.data(), chunkMesh.occluderPositions.size(), chunkMesh.occluderIndices.data(), chunkMesh.occluderIndices.size());
+		resources.entity = std::make_unique<MeshEntity>(m_store);
+		resources.entity->SetMesh(resources.mesh.get());
+		resources.entity->SetTexture(m_texture);
+		resources.entity->SetPosition(m_position);
+		resources.lastDrawn = m_selection;
+		it = m_pendingChunks.erase(it);
+	}
+
+	for (auto it = m_chunks.begin(); it != m_chunks.end();) {
+		if (it->first != 0 && m_selection - it->second.lastDrawn > ChunkLifetime) {
+			it = m_chunks.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+}
+
+
+const std::vector<MeshEntity*>& TerrainEntity::GetDrawnChunks() const {
+	return m_drawnChunks;
+}
+
+
+const std::vector<uint32_t>& TerrainEntity::GetSelectedChunks() const {
+	return m_selectedChunks;
+}
+
+
+void TerrainEntity::RequestChunk(uint32_t chunk) {
+	if (m_chunks.count(chunk) != 0 || m_pendingChunks.count(chunk) != 0 || m_pendingChunks.size() >= MaxPendingChunks) {
+		return;
+	}
+
+	std::shared_ptr<const Heightfield> heightfield = m_heightfield;
+	TerrainChunk chunkDesc = m_quadtree.GetChunks()[chunk];
+	unsigned chunkQuads = m_quadtree.GetChunkQuads();
+	m_pendingChunks[chunk] = std::async(std::launch::async, [heightfield, chunkDesc, chunkQuads]() {
+		TerrainChunkMesh mesh;
+		TerrainQuadtree::GenerateChunkMesh(*heightfield, chunkDesc, chunkQuads, mesh);
+		TerrainQuadtree::GenerateChunkOccluder(*heightfield, chunkDesc, chunkQuads, OccluderQuads, mesh);
+		return mesh;
+	});
+}
+
+
+} // namespace gxeng
+} // namespace inl
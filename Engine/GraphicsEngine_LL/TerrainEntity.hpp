@@ -0,0 +1,98 @@
+#pragma once
+
+#include "TerrainQuadtree.hpp"
+#include "MeshEntityStore.hpp"
+
+#include <mathfu/vector_3.h>
+
+#include <memory>
+#include <vector>
+#include <future>
+#include <unordered_map>
+#include <cstdint>
+
+
+namespace inl {
+namespace gxeng {
+
+
+class MemoryManager;
+class Mesh;
+class MeshEntity;
+class Image;
+class Camera;
+
+
+/// <summary>
+/// A heightfield terrain drawn as a quadtree of chunks, each at the detail its distance from the camera needs.
+/// <para />
+/// Chunk meshes are generated on worker threads when they are first selected, and uploaded once
+/// they are ready. Until then the chunk's nearest ancestor that has a mesh is drawn in its place.
+/// Meshes of chunks that have not been drawn for a while are freed.
+/// </summary>
+class TerrainEntity {
+public:
+	TerrainEntity(MemoryManager* memoryManager, std::shared_ptr<MeshEntityStore> store);
+	TerrainEntity(const TerrainEntity&) = delete;
+	TerrainEntity& operator=(const TerrainEntity&) = delete;
+	~TerrainEntity();
+
+	/// <summary> Replaces the terrain's shape. Drops the meshes of the old shape. </summary>
+	/// <exception cref="std::invalid_argument"> If the heightfield is not chunkQuads * 2^n + 1 samples wide. </exception>
+	void SetHeightfield(Heightfield heightfield, unsigned chunkQuads = 32);
+	const Heightfield& GetHeightfield() const;
+	const TerrainQuadtree& GetQuadtree() const;
+
+	void SetTexture(Image* texture);
+	Image* GetTexture() const;
+
+	/// <summary> Where the heightfield's first sample is in the world. </summary>
+	void SetPosition(mathfu::Vector<float, 3> position);
+	mathfu::Vector<float, 3> GetPosition() const;
+
+	/// <summary> The largest error of the drawn terrain in pixels. Smaller values draw more triangles. </summary>
+	void SetMaxPixelError(float maxPixelError);
+	float GetMaxPixelError() const;
+
+	/// <summary> Selects the chunks to draw for the camera, and starts generating the missing ones. </summary>
+	void SelectLod(const Camera& camera, unsigned screenHeight);
+
+	/// <summary> Uploads the chunk meshes that have finished generating and frees unused ones.
+	///		Call between frames, before uploads are submitted and entities' world matrices are updated. </summary>
+	void StreamChunks();
+
+	/// <summary> The chunks to draw for the last selection, as mesh entities. </summary>
+	const std::vector<MeshEntity*>& GetDrawnChunks() const;
+	/// <summary> The chunks chosen by the last selection, some of which may not have a mesh yet. </summary>
+	const std::vector<uint32_t>& GetSelectedChunks() const;
+private:
+	struct ChunkResources {
+		std::unique_ptr<Mesh> mesh;
+		std::unique_ptr<MeshEntity> entity;
+		uint64_t lastDrawn = 0;
+	};
+
+	void RequestChunk(uint32_t chunk);
+private:
+	MemoryManager* m_memoryManager;
+	std::shared_ptr<MeshEntityStore> m_store;
+
+	// shared with the worker threads generating chunks
+	std::shared_ptr<const Heightfield> m_heightfield;
+	TerrainQuadtree m_quadtree;
+
+	Image* m_texture = nullptr;
+	mathfu::Vector<float, 3> m_position = { 0, 0, 0 };
+	float m_maxPixelError = 2.0f;
+	uint64_t m_selection = 0;
+
+	std::unordered_map<uint32_t, ChunkResources> m_chunks;
+	std::unordered_map<uint32_t, std::future<TerrainChunkMesh>> m_pendingChunks;
+	std::vector<uint32_t> m_selectedChunks;
+	std::vector<uint32_t> m_drawnIndices;
+	std::vector<MeshEntity*> m_drawnChunks;
+};
+
+
+} // namespace gxeng
+} // namespace inl
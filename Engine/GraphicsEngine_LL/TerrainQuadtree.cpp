@@ -0,0 +1,263 @@
+#include "TerrainQuadtree.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+
+namespace inl {
+namespace gxeng {
+
+
+Heightfield::Heightfield(std::vector<float> heights, unsigned size, float spacing)
+	: m_heights(std::move(heights)), m_size(size), m_spacing(spacing)
+{
+	if (m_heights.size() != size_t(size) * size) {
+		throw std::invalid_argument("Heightfield must have size*size heights.");
+	}
+}
+
+
+float Heightfield::At(int x, int y) const {
+	x = std::min(std::max(x, 0), int(m_size) - 1);
+	y = std::min(std::max(y, 0), int(m_size) - 1);
+	return m_heights[size_t(y) * m_size + x];
+}
+
+
+mathfu::Vector<float, 3> Heightfield::NormalAt(int x, int y) const {
+	float slopeX = (At(x + 1, y) - At(x - 1, y)) / (2.0f * m_spacing);
+	float slopeY = (At(x, y + 1) - At(x, y - 1)) / (2.0f * m_spacing);
+	return mathfu::Vector<float, 3>(-slopeX, -slopeY, 1.0f).Normalized();
+}
+
+
+
+TerrainQuadtree::TerrainQuadtree(const Heightfield& heightfield, unsigned chunkQuads)
+	: m_chunkQuads(chunkQuads)
+{
+	unsigned quads = heightfield.GetSize() - 1;
+	if (chunkQuads == 0 || heightfield.GetSize() < 2 || quads % chunkQuads != 0 || ((quads / chunkQuads) & (quads / chunkQuads - 1)) != 0) {
+		throw std::invalid_argument("Heightfield must be chunkQuads * 2^n + 1 samples wide.");
+	}
+
+	// Chunks are split breadth first, so children always come after their parents
+	TerrainChunk root;
+	root.stride = quads / chunkQuads;
+	m_chunks.push_back(root);
+	for (size_t i = 0; i < m_chunks.size(); ++i) {
+		if (m_chunks[i].stride == 1) {
+			continue;
+		}
+		for (unsigned child = 0; child < 4; ++child) {
+			TerrainChunk chunk;
+			chunk.stride = m_chunks[i].stride / 2;
+			chunk.level = m_chunks[i].level + 1;
+			chunk.firstX = m_chunks[i].firstX + (child % 2) * chunk.stride * chunkQuads;
+			chunk.firstY = m_chunks[i].firstY + (child / 2) * chunk.stride * chunkQuads;
+			chunk.parent = uint32_t(i);
+			m_chunks[i].children[child] = uint32_t(m_chunks.size());
+			m_chunks.push_back(chunk);
+		}
+	}
+
+	// Height range and error of each chunk, children before parents so errors only grow upwards
+	for (size_t i = m_chunks.size(); i-- > 0;) {
+		TerrainChunk& chunk = m_chunks[i];
+		unsigned span = chunk.stride * chunkQuads;
+		float minHeight = heightfield.At(chunk.firstX, chunk.firstY);
+		float maxHeight = minHeight;
+		for (unsigned y = chunk.firstY; y <= chunk.firstY + span; ++y) {
+			for (unsigned x = chunk.firstX; x <= chunk.firstX + span; ++x) {
+				minHeight = std::min(minHeight, heightfield.At(x, y));
+				maxHeight = std::max(maxHeight, heightfield.At(x, y));
+			}
+		}
+		chunk.bounds.min = { chunk.firstX * heightfield.GetSpacing(), chunk.firstY * heightfield.GetSpacing(), minHeight };
+		chunk.bounds.max = { (chunk.firstX + span) * heightfield.GetSpacing(), (chunk.firstY + span) * heightfield.GetSpacing(), maxHeight };
+
+		chunk.geometricError = ChunkError(heightfield, chunk);
+		if (!chunk.IsLeaf()) {
+			for (uint32_t child : chunk.children) {
+				chunk.geometricError = std::max(chunk.geometricError, m_chunks[child].geometricError);
+			}
+		}
+	}
+
+	// The meshes on either side of an edge differ by at most the sum of their errors,
+	// skirts cover that for neighbours up to one level coarser
+	for (TerrainChunk& chunk : m_chunks) {
+		float coarserError = chunk.parent != InvalidChunk ? m_chunks[chunk.parent].geometricError : chunk.geometricError;
+		chunk.skirtDepth = chunk.geometricError + coarserError;
+		chunk.bounds.min.z() -= chunk.skirtDepth;
+	}
+}
+
+
+float TerrainQuadtree::ErrorScale(float verticalFov, unsigned screenHeight) {
+	return screenHeight / (2.0f * std::tan(verticalFov * 0.5f));
+}
+
+
+void TerrainQuadtree::SelectLod(const mathfu::Vector<float, 3>& eye,
+								const Frustum& frustum,
+								float errorScale,
+								float maxPixelError,
+								std::vector<uint32_t>& selected) const
+{
+	selected.clear();
+	if (m_chunks.empty()) {
+		return;
+	}
+
+	std::vector<uint32_t> stack = { 0 };
+	while (!stack.empty()) {
+		const TerrainChunk& chunk = m_chunks[stack.back()];
+		uint32_t index = stack.back();
+		stack.pop_back();
+
+		if (!frustum.IsVisible(chunk.bounds)) {
+			continue;
+		}
+
+		// distance to the nearest point of the chunk, error grows without bound as the camera enters the chunk
+		mathfu::Vector<float, 3> nearest = mathfu::Vector<float, 3>::Max(chunk.bounds.min, mathfu::Vector<float, 3>::Min(eye, chunk.bounds.max));
+		float distance = std::max((nearest - eye).Length(), 1e-6f);
+		if (chunk.IsLeaf() || chunk.geometricError * errorScale <= maxPixelError * distance) {
+			selected.push_back(index);
+		}
+		else {
+			for (int child = 3; child >= 0; --child) {
+				stack.push_back(chunk.children[child]);
+			}
+		}
+	}
+}
+
+
+void TerrainQuadtree::GenerateChunkMesh(const Heightfield& heightfield, const TerrainChunk& chunk, unsigned chunkQuads, TerrainChunkMesh& mesh) {
+	const unsigned side = chunkQuads + 1;
+	const float spacing = heightfield.GetSpacing();
+	const float texCoordScale = 1.0f / (heightfield.GetSize() - 1);
+
+	// Vertices are never copied after they are placed, see Vertex
+	mesh.vertices.clear();
+	mesh.vertices.resize(side * side + 4 * chunkQuads);
+	mesh.indices.clear();
+	mesh.indices.reserve(6 * chunkQuads * chunkQuads + 6 * 4 * chunkQuads);
+
+	auto setVertex = [&](unsigned vertex, unsigned x, unsigned y, float depth) {
+		mesh.vertices[vertex].position = { x * spacing, y * spacing, heightfield.At(x, y) - depth };
+		mesh.vertices[vertex].normal = heightfield.NormalAt(x, y);
+		mesh.vertices[vertex].texCoord = { x * texCoordScale, y * texCoordScale };
+	};
+
+	for (unsigned j = 0; j < side; ++j) {
+		for (unsigned i = 0; i < side; ++i) {
+			setVertex(j * side + i, chunk.firstX + i * chunk.stride, chunk.firstY + j * chunk.stride, 0.0f);
+		}
+	}
+
+	// Two triangles per quad, counter-clockwise seen from above
+	for (unsigned j = 0; j < chunkQuads; ++j) {
+		for (unsigned i = 0; i < chunkQuads; ++i) {
+			unsigned corner = j * side + i;
+			mesh.indices.insert(mesh.indices.end(), { corner, corner + 1, corner + side + 1, corner, corner + side + 1, corner + side });
+		}
+	}
+
+	// Skirts: the border walked counter-clockwise from above, each border vertex gets a copy moved down,
+	// the wall between them faces out of the chunk
+	std::vector<unsigned> border;
+	border.reserve(4 * chunkQuads);
+	for (unsigned i = 0; i < chunkQuads; ++i) border.push_back(i);
+	for (unsigned j = 0; j < chunkQuads; ++j) border.push_back(j * side + chunkQuads);
+	for (unsigned i = chunkQuads; i > 0; --i) border.push_back(chunkQuads * side + i);
+	for (unsigned j = chunkQuads; j > 0; --j) border.push_back(j * side);
+
+	const unsigned firstSkirt = side * side;
+	for (unsigned k = 0; k < border.size(); ++k) {
+		unsigned vertex = border[k];
+		setVertex(firstSkirt + k, chunk.firstX + (vertex % side) * chunk.stride, chunk.firstY + (vertex / side) * chunk.stride, chunk.skirtDepth);
+	}
+	for (unsigned k = 0; k < border.size(); ++k) {
+		unsigned next = (k + 1) % border.size();
+		unsigned top = border[k], nextTop = border[next];
+		unsigned bottom = firstSkirt + k, nextBottom = firstSkirt + next;
+		mesh.indices.insert(mesh.indices.end(), { top, bottom, nextBottom, top, nextBottom, nextTop });
+	}
+}
+
+
+void TerrainQuadtree::GenerateChunkOccluder(const Heightfield& heightfield, const TerrainChunk& chunk, unsigned chunkQuads, unsigned occluderQuads, TerrainChunkMesh& mesh) {
+	occluderQuads = std::max(1u, std::min(occluderQuads, chunkQuads));
+	while (chunkQuads % occluderQuads != 0) {
+		--occluderQuads;
+	}
+	const unsigned side = occluderQuads + 1;
+	const unsigned cellQuads = chunkQuads / occluderQuads;
+	const float spacing = heightfield.GetSpacing();
+
+	// A vertex takes the lowest height of the mesh's vertices in the cells around it, so the triangles
+	// spanning a cell stay below every vertex of the mesh in it
+	mesh.occluderPositions.resize(side * side);
+	for (unsigned j = 0; j < side; ++j) {
+		for (unsigned i = 0; i < side; ++i) {
+			unsigned firstI = (i > 0 ? i - 1 : 0) * cellQuads, lastI = std::min(i + 1, occluderQuads) * cellQuads;
+			unsigned firstJ = (j > 0 ? j - 1 : 0) * cellQuads, lastJ = std::min(j + 1, occluderQuads) * cellQuads;
+			float height = std::numeric_limits<float>::infinity();
+			for (unsigned y = firstJ; y <= lastJ; ++y) {
+				for (unsigned x = firstI; x <= lastI; ++x) {
+					height = std::min(height, heightfield.At(chunk.firstX + x * chunk.stride, chunk.firstY + y * chunk.stride));
+				}
+			}
+			unsigned x = chunk.firstX + i * cellQuads * chunk.stride;
+			unsigned y = chunk.firstY + j * cellQuads * chunk.stride;
+			mesh.occluderPositions[j * side + i] = { x * spacing, y * spacing, height };
+		}
+	}
+
+	// Same winding as the mesh's surface
+	mesh.occluderIndices.clear();
+	mesh.occluderIndices.reserve(6 * occluderQuads * occluderQuads);
+	for (unsigned j = 0; j < occluderQuads; ++j) {
+		for (unsigned i = 0; i < occluderQuads; ++i) {
+			unsigned corner = j * side + i;
+			mesh.occluderIndices.insert(mesh.occluderIndices.end(), { corner, corner + 1, corner + side + 1, corner, corner + side + 1, corner + side });
+		}
+	}
+}
+
+
+float TerrainQuadtree::ChunkError(const Heightfield& heightfield, const TerrainChunk& chunk) const {
+	if (chunk.stride == 1) {
+		return 0.0f;
+	}
+
+	// Difference of each sample from the chunk's triangles, split the same way as in GenerateChunkMesh
+	float error = 0.0f;
+	unsigned span = chunk.stride * m_chunkQuads;
+	for (unsigned y = 0; y <= span; ++y) {
+		for (unsigned x = 0; x <= span; ++x) {
+			unsigned cellX = std::min(x / chunk.stride, m_chunkQuads - 1) * chunk.stride;
+			unsigned cellY = std::min(y / chunk.stride, m_chunkQuads - 1) * chunk.stride;
+			float fx = float(x - cellX) / chunk.stride;
+			float fy = float(y - cellY) / chunk.stride;
+			int baseX = chunk.firstX + cellX, baseY = chunk.firstY + cellY;
+			float h00 = heightfield.At(baseX, baseY);
+			float h10 = heightfield.At(baseX + chunk.stride, baseY);
+			float h01 = heightfield.At(baseX, baseY + chunk.stride);
+			float h11 = heightfield.At(baseX + chunk.stride, baseY + chunk.stride);
+			float interpolated = fx >= fy
+				? h00 + fx * (h10 - h00) + fy * (h11 - h10)
+				: h00 + fy * (h01 - h00) + fx * (h11 - h01);
+			error = std::max(error, std::abs(interpolated - heightfield.At(chunk.firstX + x, chunk.firstY + y)));
+		}
+	}
+	return error;
+}
+
+
+} // namespace gxeng
+} // namespace inl
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "BoundingVolume.hpp"
+#include "FrustumCulling.hpp"
+#include "Vertex.hpp"
+
+#include <mathfu/vector_3.h>
+
+#include <vector>
+#include <cstdint>
+
+
+namespace inl {
+namespace gxeng {
+
+
+/// <summary>
+/// Heights of a terrain sampled on a square grid. The terrain lies in the xy plane of its own space,
+/// with the first sample at the origin and heights along +z.
+/// </summary>
+class Heightfield {
+public:
+	Heightfield() = default;
+	/// <param name="heights"> Samples row by row, along x first. </param>
+	/// <param name="spacing"> Distance of neighbouring samples. </param>
+	/// <exception cref="std::invalid_argument"> If there are not size*size heights. </exception>
+	Heightfield(std::vector<float> heights, unsigned size, float spacing);
+
+	/// <summary> Number of samples along each side. </summary>
+	unsigned GetSize() const { return m_size; }
+	float GetSpacing() const { return m_spacing; }
+
+	/// <summary> The sample's height, coordinates outside the grid are clamped to its border. </summary>
+	float At(int x, int y) const;
+	/// <summary> Surface normal at the sample from its neighbours' heights. </summary>
+	mathfu::Vector<float, 3> NormalAt(int x, int y) const;
+private:
+	std::vector<float> m_heights;
+	unsigned m_size = 0;
+	float m_spacing = 1.0f;
+};
+
+
+/// <summary> A square piece of the terrain, drawn as one mesh of a fixed number of quads. </summary>
+struct TerrainChunk {
+	/// <summary> Sample at the chunk's first corner. </summary>
+	unsigned firstX = 0;
+	unsigned firstY = 0;
+	/// <summary> Samples between the mesh's vertices, 1 for the most detailed chunks. </summary>
+	unsigned stride = 1;
+	/// <summary> Depth in the quadtree, 0 for the root. </summary>
+	unsigned level = 0;
+
+	/// <summary> Bounds in the terrain's space, including the skirts. </summary>
+	Aabb bounds;
+	/// <summary> Largest height difference between the chunk's mesh and the heightfield, and between its
+	///		descendants' meshes and the heightfield. Never smaller than the children's. </summary>
+	float geometricError = 0;
+	/// <summary> How far the skirts hang below the chunk's border. </summary>
+	float skirtDepth = 0;
+
+	uint32_t parent = ~uint32_t(0);
+	/// <summary> Children in the order -x-y, +x-y, -x+y, +x+y, all invalid for leaves. </summary>
+	uint32_t children[4] = { ~uint32_t(0), ~uint32_t(0), ~uint32_t(0), ~uint32_t(0) };
+
+	bool IsLeaf() const { return children[0] == ~uint32_t(0); }
+};
+
+
+/// <summary> Vertex layout of the terrain chunks' meshes. </summary>
+using TerrainVertex = Vertex<Position<0>, Normal<0>, TexCoord<0>>;
+
+
+/// <summary> Vertices and triangles of one chunk, ready to be uploaded. </summary>
+struct TerrainChunkMesh {
+	std::vector<TerrainVertex> vertices;
+	std::vector<unsigned> indices;
+
+	/// <summary> Coarse surface for occlusion culling, see TerrainQuadtree::GenerateChunkOccluder. </summary>
+	std::vector<mathfu::Vector<float, 3>> occluderPositions;
+	std::vector<unsigned> occluderIndices;
+};
+
+
+/// <summary>
+/// Chunked level of detail for a heightfield. The root chunk covers the whole terrain at the
+/// coarsest detail, each chunk's four children cover its quarters at twice its detail.
+/// </summary>
+/// <remarks>
+/// Chunks are selected by their screen-space error: their geometric error projected to pixels at their
+/// distance. Neighbouring chunks of different levels do not match along their shared edge, the gap is
+/// hidden by skirts that hang below each chunk's border.
+/// </remarks>
+class TerrainQuadtree {
+public:
+	static constexpr uint32_t InvalidChunk = ~uint32_t(0);
+public:
+	TerrainQuadtree() = default;
+	/// <param name="chunkQuads"> Quads along each side of a chunk's mesh. </param>
+	/// <exception cref="std::invalid_argument"> If the heightfield is not chunkQuads * 2^n + 1 samples wide. </exception>
+	TerrainQuadtree(const Heightfield& heightfield, unsigned chunkQuads = 32);
+
+	/// <summary> All chunks, the root is the first. Children come after their parents. </summary>
+	const std::vector<TerrainChunk>& GetChunks() const { return m_chunks; }
+	unsigned GetChunkQuads() const { return m_chunkQuads; }
+
+	/// <summary> Converts geometric error over distance to pixels. </summary>
+	/// <param name="verticalFov"> The camera's vertical field of view in radians. </param>
+	static float ErrorScale(float verticalFov, unsigned screenHeight);
+
+	/// <summary> Selects the least detailed chunks that cover the visible part of the terrain
+	///		without exceeding the screen-space error. Selected chunks do not overlap. </summary>
+	/// <param name="eye"> The camera's position in the terrain's space. </param>
+	/// <param name="frustum"> The camera's frustum in the terrain's space. </param>
+	/// <param name="errorScale"> See ErrorScale. </param>
+	void SelectLod(const mathfu::Vector<float, 3>& eye,
+				   const Frustum& frustum,
+				   float errorScale,
+				   float maxPixelError,
+				   std::vector<uint32_t>& selected) const;
+
+	/// <summary> Builds the chunk's mesh with skirts. Only reads the heightfield, so chunks can be generated on several threads. </summary>
+	/// <remarks> Positions are in the terrain's space, texture coordinates span [0, 1] over the whole terrain. </remarks>
+	static void GenerateChunkMesh(const Heightfield& heightfield, const TerrainChunk& chunk, unsigned chunkQuads, TerrainChunkMesh& mesh);
+	/// <summary> Builds a decimated version of the chunk's surface without skirts that never rises above the chunk's mesh,
+	///		so it does not hide what the mesh leaves visible from above. </summary>
+	/// <param name="occluderQuads"> Quads along each side, lowered to the nearest divisor of chunkQuads. </param>
+	static void GenerateChunkOccluder(const Heightfield& heightfield, const TerrainChunk& chunk, unsigned chunkQuads, unsigned occluderQuads, TerrainChunkMesh& mesh);
+private:
+	float ChunkError(const Heightfield& heightfield, const TerrainChunk& chunk) const;
+private:
+	std::vector<TerrainChunk> m_chunks;
+	unsigned m_chunkQuads = 0;
+};
+
+
+} // namespace gxeng
+} // namespace inl
@@ -0,0 +1,150 @@
+#include "TextureTable.hpp"
+
+#include "../GraphicsApi_LL/Exception.hpp"
+#include "../GraphicsApi_LL/IDescriptorHeap.hpp"
+
+#include <stdexcept>
+#include <cassert>
+
+
+namespace inl {
+namespace gxeng {
+
+
+TextureTable::TextureTable(gxapi::IGraphicsApi* graphicsApi, uint32_t capacity)
+	: m_graphicsApi(graphicsApi),
+	m_capacity(capacity)
+{
+	m_slots.reserve(capacity);
+}
+
+
+uint32_t TextureTable::Allocate() {
+	std::lock_guard<std::mutex> lkg(m_mutex);
+
+	uint32_t index;
+	if (!m_freeIndices.empty()) {
+		index = m_freeIndices.back();
+		m_freeIndices.pop_back();
+	}
+	else if (m_slots.size() < m_capacity) {
+		index = (uint32_t)m_slots.size();
+		m_slots.emplace_back();
+	}
+	else {
+		throw gxapi::OutOfMemory("Texture table is full.", m_capacity + 1);
+	}
+
+	assert(!m_slots[index].allocated);
+	m_slots[index].allocated = true;
+	++m_numAllocated;
+	return index;
+}
+
+
+void TextureTable::Free(uint32_t index) {
+	std::lock_guard<std::mutex> lkg(m_mutex);
+	CheckAllocated(index);
+
+	Slot& slot = m_slots[index];
+	slot.source = gxapi::DescriptorHandle();
+	slot.version = ++m_version;
+	slot.allocated = false;
+	m_freeIndices.push_back(index);
+	--m_numAllocated;
+}
+
+
+void TextureTable::Set(uint32_t index, gxapi::DescriptorHandle source) {
+	std::lock_guard<std::mutex> lkg(m_mutex);
+	CheckAllocated(index);
+
+	Slot& slot = m_slots[index];
+	slot.source = source;
+	slot.version = ++m_version;
+}
+
+
+uint32_t TextureTable::GetNumAllocated() const {
+	std::lock_guard<std::mutex> lkg(m_mutex);
+	return m_numAllocated;
+}
+
+
+bool TextureTable::IsAllocated(uint32_t index) const {
+	std::lock_guard<std::mutex> lkg(m_mutex);
+	return index < m_slots.size() && m_slots[index].allocated;
+}
+
+
+size_t TextureTable::Sync(StackDescHeap& heap) {
+	if (heap.GetReservedSize() < m_capacity) {
+		throw std::invalid_argument("Heap does not reserve enough descriptors for the texture table.");
+	}
+
+	std::lock_guard<std::mutex> lkg(m_mutex);
+
+	uint64_t& syncedVersion = m_syncedVersions[&heap];
+	if (syncedVersion == m_version) {
+		return 0;
+	}
+
+	m_srcRangeStarts.clear();
+	m_srcRangeLengths.clear();
+	m_dstRangeStarts.clear();
+	m_dstRangeLengths.clear();
+
+	// Freed slots are left as they are, shaders don't read them. Source ranges are split
+	// where the source descriptors are not adjacent, destination ranges where a slot is skipped.
+	DescriptorArrayRef reserved = heap.GetReservedRange();
+	const size_t increment = heap.GetHeap()->GetIncrementSize();
+	size_t numCopied = 0;
+	const Slot* prev = nullptr;
+	for (uint32_t i = 0; i < m_slots.size(); ++i) {
+		const Slot& slot = m_slots[i];
+		if (slot.version <= syncedVersion || slot.source.cpuAddress == nullptr) {
+			prev = nullptr;
+			continue;
+		}
+
+		if (prev != nullptr && static_cast<const char*>(slot.source.cpuAddress) == static_cast<const char*>(prev->source.cpuAddress) + increment) {
+			++m_srcRangeLengths.back();
+		}
+		else {
+			m_srcRangeStarts.push_back(slot.source);
+			m_srcRangeLengths.push_back(1);
+		}
+
+		if (prev != nullptr) {
+			++m_dstRangeLengths.back();
+		}
+		else {
+			m_dstRangeStarts.push_back(reserved.Get(i));
+			m_dstRangeLengths.push_back(1);
+		}
+
+		prev = &slot;
+		++numCopied;
+	}
+
+	if (numCopied > 0) {
+		m_graphicsApi->CopyDescriptors(
+			m_srcRangeStarts.size(), m_srcRangeStarts.data(), m_srcRangeLengths.data(),
+			m_dstRangeStarts.size(), m_dstRangeStarts.data(), m_dstRangeLengths.data(),
+			gxapi::eDescriptorHeapType::CBV_SRV_UAV);
+	}
+
+	syncedVersion = m_version;
+	return numCopied;
+}
+
+
+void TextureTable::CheckAllocated(uint32_t index) const {
+	if (index >= m_slots.size() || !m_slots[index].allocated) {
+		throw std::invalid_argument("Texture table index is not allocated.");
+	}
+}
+
+
+} // namespace gxeng
+} // namespace inl
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "StackDescHeap.hpp"
+
+#include "../GraphicsApi_LL/IGraphicsApi.hpp"
+#include "../GraphicsApi_LL/Common.hpp"
+
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+
+
+namespace inl {
+namespace gxeng {
+
+
+/// <summary>
+/// Shader visible descriptors of all textures, shaders pick textures from the table by index,
+/// so draws only pass the index in root constants instead of binding the texture.
+/// <para />
+/// Every texture is given an index when it is created, which stays the same until it is destroyed,
+/// then the index is given to later textures. The table is copied to the reserved range at the start
+/// of every scratch space when the scratch space is requested, see ScratchSpacePool. Only the
+/// descriptors that changed since the scratch space was last requested are copied.
+/// </summary>
+/// <remarks>
+/// Scratch spaces are not touched while the GPU uses them, so freed indices can be given out right away.
+/// This class is thread safe.
+/// </remarks>
+class TextureTable {
+public:
+	/// <summary> Must match the size of the texture array in the shaders. </summary>
+	static constexpr uint32_t DefaultCapacity = 1024;
+	static constexpr uint32_t InvalidIndex = ~uint32_t(0);
+public:
+	TextureTable(gxapi::IGraphicsApi* graphicsApi, uint32_t capacity = DefaultCapacity);
+	TextureTable(const TextureTable&) = delete;
+	TextureTable& operator=(const TextureTable&) = delete;
+
+	/// <summary> Gives out an index, freed indices are given out first, the most recently freed one first. </summary>
+	/// <exception cref="inl::gxapi::OutOfMemory"> If all indices are in use. </exception>
+	uint32_t Allocate();
+	/// <summary> Frees the index, the texture is not copied to scratch spaces anymore. </summary>
+	void Free(uint32_t index);
+	/// <summary> Sets the texture at the index. </summary>
+	/// <param name="source"> Descriptor in a heap that is not shader visible, it must stay valid until the index is set again or freed. </param>
+	void Set(uint32_t index, gxapi::DescriptorHandle source);
+
+	uint32_t GetCapacity() const { return m_capacity; }
+	uint32_t GetNumAllocated() const;
+	bool IsAllocated(uint32_t index) const;
+
+	/// <summary> Copies the descriptors that changed since the heap was last synced to its reserved range. </summary>
+	/// <exception cref="std::invalid_argument"> If the heap reserves fewer descriptors than the capacity of the table. </exception>
+	/// <returns> Number of descriptors copied. </returns>
+	size_t Sync(StackDescHeap& heap);
+private:
+	struct Slot {
+		gxapi::DescriptorHandle source; // no texture if cpuAddress is nullptr
+		uint64_t version = 0; // m_version when the slot last changed
+		bool allocated = false;
+	};
+
+	void CheckAllocated(uint32_t index) const;
+private:
+	gxapi::IGraphicsApi* m_graphicsApi;
+	uint32_t m_capacity;
+	std::vector<Slot> m_slots; // indices below the size have been given out at least once
+	std::vector<uint32_t> m_freeIndices;
+	uint32_t m_numAllocated = 0;
+	uint64_t m_version = 0;
+	std::unordered_map<const StackDescHeap*, uint64_t> m_syncedVersions; // heap -> m_version when last synced
+	mutable std::mutex m_mutex;
+
+	// reused between copies to avoid allocations
+	std::vector<gxapi::DescriptorHandle> m_srcRangeStarts;
+	std::vector<uint32_t> m_srcRangeLengths;
+	std::vector<gxapi::DescriptorHandle> m_dstRangeStarts;
+	std::vector<uint32_t> m_dstRangeLengths;
+};
+
+
+} // namespace gxeng
+} // namespace inl
@@ -0,0 +1,104 @@
+#include "TransformBatch.hpp"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define INL_TRANSFORM_BATCH_SSE
+#endif
+
+
+namespace inl {
+namespace gxeng {
+
+
+// Matrices are accessed as 16 floats in mathfu's column-major order.
+static_assert(sizeof(mathfu::Matrix<float, 4, 4>) == 16 * sizeof(float), "Matrix must be 16 tightly packed floats.");
+
+static const float* Elements(const mathfu::Matrix<float, 4, 4>& m) {
+	return reinterpret_cast<const float*>(&m);
+}
+
+static float* Elements(mathfu::Matrix<float, 4, 4>& m) {
+	return reinterpret_cast<float*>(&m);
+}
+
+
+void ComposeTransforms(const mathfu::Vector<float, 3>* positions,
+					   const mathfu::Quaternion<float>* rotations,
+					   const mathfu::Vector<float, 3>* scales,
+					   mathfu::Matrix<float, 4, 4>* result,
+					   size_t count)
+{
+	for (size_t i = 0; i < count; ++i) {
+		const float s = rotations[i].scalar();
+		const mathfu::Vector<float, 3>& v = rotations[i].vector();
+		const float x2 = v[0] * v[0], y2 = v[1] * v[1], z2 = v[2] * v[2];
+		const float sx = s * v[0], sy = s * v[1], sz = s * v[2];
+		const float xz = v[0] * v[2], yz = v[1] * v[2], xy = v[0] * v[1];
+		const mathfu::Vector<float, 3>& scale = scales[i];
+		const mathfu::Vector<float, 3>& position = positions[i];
+
+		// rotation columns scaled by the scale's components, translation in the last column
+		float* m = Elements(result[i]);
+		m[0] = (1 - 2 * (y2 + z2)) * scale[0];
+		m[1] = 2 * (xy + sz) * scale[0];
+		m[2] = 2 * (xz - sy) * scale[0];
+		m[3] = 0;
+		m[4] = 2 * (xy - sz) * scale[1];
+		m[5] = (1 - 2 * (x2 + z2)) * scale[1];
+		m[6] = 2 * (sx + yz) * scale[1];
+		m[7] = 0;
+		m[8] = 2 * (sy + xz) * scale[2];
+		m[9] = 2 * (yz - sx) * scale[2];
+		m[10] = (1 - 2 * (x2 + y2)) * scale[2];
+		m[11] = 0;
+		m[12] = position[0];
+		m[13] = position[1];
+		m[14] = position[2];
+		m[15] = 1;
+	}
+}
+
+
+void MultiplyTransforms(const mathfu::Matrix<float, 4, 4>& lhs,
+						const mathfu::Matrix<float, 4, 4>* rhs,
+						mathfu::Matrix<float, 4, 4>* result,
+						size_t count)
+{
+	const float* a = Elements(lhs);
+
+#ifdef INL_TRANSFORM_BATCH_SSE
+	// Columns of lhs stay in registers, each result column is a linear combination of them.
+	const __m128 a0 = _mm_loadu_ps(a + 0);
+	const __m128 a1 = _mm_loadu_ps(a + 4);
+	const __m128 a2 = _mm_loadu_ps(a + 8);
+	const __m128 a3 = _mm_loadu_ps(a + 12);
+	for (size_t i = 0; i < count; ++i) {
+		const float* b = Elements(rhs[i]);
+		float* c = Elements(result[i]);
+		for (int col = 0; col < 4; ++col) {
+			__m128 sum = _mm_mul_ps(a0, _mm_set1_ps(b[col * 4 + 0]));
+			sum = _mm_add_ps(sum, _mm_mul_ps(a1, _mm_set1_ps(b[col * 4 + 1])));
+			sum = _mm_add_ps(sum, _mm_mul_ps(a2, _mm_set1_ps(b[col * 4 + 2])));
+			sum = _mm_add_ps(sum, _mm_mul_ps(a3, _mm_set1_ps(b[col * 4 + 3])));
+			_mm_storeu_ps(c + col * 4, sum);
+		}
+	}
+#else
+	for (size_t i = 0; i < count; ++i) {
+		const float* b = Elements(rhs[i]);
+		float* c = Elements(result[i]);
+		for (int col = 0; col < 4; ++col) {
+			for (int row = 0; row < 4; ++row) {
+				c[col * 4 + row] = a[0 * 4 + row] * b[col * 4 + 0]
+					+ a[1 * 4 + row] * b[col * 4 + 1]
+					+ a[2 * 4 + row] * b[col * 4 + 2]
+					+ a[3 * 4 + row] * b[col * 4 + 3];
+			}
+		}
+	}
+#endif
+}
+
+
+} // namespace gxeng
+} // namespace inl
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <mathfu/vector_3.h>
+#include <mathfu/quaternion.h>
+#include <mathfu/matrix_4x4.h>
+
+#include <cstddef>
+
+
+namespace inl {
+namespace gxeng {
+
+
+/// <summary> Computes world matrices, result[i] = translate(positions[i]) * rotate(rotations[i]) * scale(scales[i]). </summary>
+void ComposeTransforms(const mathfu::Vector<float, 3>* positions,
+					   const mathfu::Quaternion<float>* rotations,
+					   const mathfu::Vector<float, 3>* scales,
+					   mathfu::Matrix<float, 4, 4>* result,
+					   size_t count);
+
+/// <summary> Multiplies many matrices by the same matrix from the left, result[i] = lhs * rhs[i]. </summary>
+/// <remarks> Uses SSE where available. result must not overlap rhs. </remarks>
+void MultiplyTransforms(const mathfu::Matrix<float, 4, 4>& lhs,
+						const mathfu::Matrix<float, 4, 4>* rhs,
+						mathfu::Matrix<float, 4, 4>* result,
+						size_t count);
+
+
+} // namespace gxeng
+} // namespace inl
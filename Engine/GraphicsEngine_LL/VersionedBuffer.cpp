@@ -0,0 +1,71 @@
+#include "VersionedBuffer.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+
+
+namespace inl {
+namespace gxeng {
+
+
+VersionedBuffer::VersionedBuffer(unsigned numVersions, size_t size) {
+	Reset(numVersions, size);
+}
+
+
+void VersionedBuffer::Reset(unsigned numVersions, size_t size) {
+	if (numVersions == 0) {
+		throw std::invalid_argument("Buffer must have at least one version.");
+	}
+
+	m_data.assign(size, 0);
+	m_missing.assign(numVersions, ByteRange{ 0, size });
+	// The first flip brings up the first version
+	m_currentVersion = numVersions - 1;
+}
+
+
+void VersionedBuffer::Write(size_t offset, const void* data, size_t size) {
+	std::memcpy(Map(offset, size), data, size);
+}
+
+
+uint8_t* VersionedBuffer::Map(size_t offset, size_t size) {
+	if (offset > m_data.size() || size > m_data.size() - offset) {
+		throw std::out_of_range("Range does not fit in the buffer.");
+	}
+
+	MarkWritten(offset, size);
+	return m_data.data() + offset;
+}
+
+
+ByteRange VersionedBuffer::Flip() {
+	m_currentVersion = (m_currentVersion + 1) % GetNumVersions();
+	ByteRange missing = m_missing[m_currentVersion];
+	m_missing[m_currentVersion] = ByteRange{};
+	return missing;
+}
+
+
+void VersionedBuffer::MarkWritten(size_t offset, size_t size) {
+	if (size == 0) {
+		return;
+	}
+
+	// Versions miss a single range, bytes between separate writes are copied along
+	for (ByteRange& missing : m_missing) {
+		if (missing.IsEmpty()) {
+			missing = ByteRange{ offset, offset + size };
+		}
+		else {
+			missing.begin = std::min(missing.begin, offset);
+			missing.end = std::max(missing.end, offset + size);
+		}
+	}
+}
+
+
+} // namespace gxeng
+} // namespace inl
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace inl {
+namespace gxeng {
+
+
+/// <summary> Bytes [begin, end) of a buffer. </summary>
+struct ByteRange {
+	size_t begin = 0;
+	size_t end = 0;
+
+	bool IsEmpty() const { return begin >= end; }
+	size_t GetSize() const { return IsEmpty() ? 0 : end - begin; }
+};
+
+
+/// <summary>
+/// CPU copy of a buffer that the GPU reads in several versions, one for each frame in flight.
+/// <para />
+/// Writes go to the CPU copy, and every version remembers the range of bytes written since it was last brought up to date.
+/// When a version comes up for a frame, only that range has to be copied into it.
+/// </summary>
+class VersionedBuffer {
+public:
+	VersionedBuffer(unsigned numVersions = 1, size_t size = 0);
+
+	/// <summary> Resizes the buffer and zeroes it. All versions miss all of it. </summary>
+	/// <exception cref="std::invalid_argument"> If there are no versions. </exception>
+	void Reset(unsigned numVersions, size_t size);
+
+	/// <exception cref="std::out_of_range"> If the range does not fit in the buffer. </exception>
+	void Write(size_t offset, const void* data, size_t size);
+	/// <summary> Returns the CPU copy of the range to be written in place. The range is missed by all versions. </summary>
+	/// <exception cref="std::out_of_range"> If the range does not fit in the buffer. </exception>
+	uint8_t* Map(size_t offset, size_t size);
+
+	/// <summary> Moves to the next version and returns the bytes it misses.
+	///		The version is up to date once those bytes are copied into it from GetData. </summary>
+	ByteRange Flip();
+
+	unsigned GetCurrentVersion() const { return m_currentVersion; }
+	unsigned GetNumVersions() const { return (unsigned)m_missing.size(); }
+	size_t GetSize() const { return m_data.size(); }
+	const uint8_t* GetData() const { return m_data.data(); }
+private:
+	void MarkWritten(size_t offset, size_t size);
+private:
+	std::vector<uint8_t> m_data;
+	std::vector<ByteRange> m_missing;
+	unsigned m_currentVersion;
+};
+
+
+} // namespace gxeng
+} // namespace inl
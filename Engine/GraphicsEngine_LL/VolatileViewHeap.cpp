@@ -26,5 +26,14 @@ gxapi::DescriptorHandle VolatileViewHeap::Allocate() {
 }
 
 
+void VolatileViewHeap::Merge(VolatileViewHeap&& other) {
+	// the last heap is the one being allocated from, keep it last
+	m_heaps.insert(m_heaps.begin(), std::make_move_iterator(other.m_heaps.begin()), std::make_move_iterator(other.m_heaps.end()));
+	m_nextPos += other.m_heaps.size() * HEAP_SIZE;
+	other.m_heaps.clear();
+	other.m_nextPos = 0;
+}
+
+
 } // namespace gxeng
 } // namespace inl
@@ -22,6 +22,9 @@ public:
 
 	gxapi::DescriptorHandle Allocate();
 
+	/// <summary> Takes over the descriptors of the other heap, they stay valid as long as this heap lives. </summary>
+	void Merge(VolatileViewHeap&& other);
+
 private:
 	static constexpr size_t HEAP_SIZE = 128;
 
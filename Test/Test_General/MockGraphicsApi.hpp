@@ -0,0 +1,257 @@
+#pragma once
+
+#include <GraphicsApi_LL/IGraphicsApi.hpp>
+#include <GraphicsApi_LL/ICommandList.hpp>
+#include <GraphicsApi_LL/ICommandAllocator.hpp>
+#include <GraphicsApi_LL/IResource.hpp>
+#include <GraphicsApi_LL/IDescriptorHeap.hpp>
+#include <GraphicsApi_LL/IRootSignature.hpp>
+#include <GraphicsApi_LL/ICommandSignature.hpp>
+#include <GraphicsApi_LL/IPipelineState.hpp>
+#include <GraphicsApi_LL/IGxapiManager.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+
+
+//------------------------------------------------------------------------------
+// A graphics api that creates no GPU objects.
+// Command lists only record the name of every call they receive, so tests
+// can check what the engine submits without a device.
+//------------------------------------------------------------------------------
+
+
+class MockDescriptorHeap : public inl::gxapi::IDescriptorHeap {
+public:
+	MockDescriptorHeap(inl::gxapi::DescriptorHeapDesc desc) : m_desc(desc), m_memory(desc.numDescriptors) {}
+
+	inl::gxapi::DescriptorHandle At(size_t index) const override {
+		inl::gxapi::DescriptorHandle handle;
+		handle.cpuAddress = (void*)&m_memory[index];
+		handle.gpuAddress = m_desc.isShaderVisible ? (void*)&m_memory[index] : nullptr;
+		return handle;
+	}
+	inl::gxapi::DescriptorHeapDesc GetDesc() const override { return m_desc; }
+	uint32_t GetIncrementSize() const override { return 1; }
+private:
+	inl::gxapi::DescriptorHeapDesc m_desc;
+	std::vector<char> m_memory;
+};
+
+
+class MockCommandAllocator : public inl::gxapi::ICommandAllocator {
+public:
+	MockCommandAllocator(inl::gxapi::eCommandListType type) : m_type(type) {}
+	void Reset() override {}
+	inl::gxapi::eCommandListType GetType() const override { return m_type; }
+private:
+	inl::gxapi::eCommandListType m_type;
+};
+
+
+/// <summary> A resource with a made up GPU address and no memory, only for binding. </summary>
+class MockResource : public inl::gxapi::IResource {
+public:
+	MockResource(inl::gxapi::ResourceDesc desc, void* gpuAddress) : m_desc(desc), m_gpuAddress(gpuAddress) {}
+	inl::gxapi::ResourceDesc GetDesc() const override { return m_desc; }
+	void* Map(unsigned, const inl::gxapi::MemoryRange*) override { return nullptr; }
+	void Unmap(unsigned, const inl::gxapi::MemoryRange*) override {}
+	void* GetGPUAddress() const override { return m_gpuAddress; }
+	void SetName(const char*) override {}
+private:
+	inl::gxapi::ResourceDesc m_desc;
+	void* m_gpuAddress;
+};
+
+
+class MockRootSignature : public inl::gxapi::IRootSignature {};
+class MockCommandSignature : public inl::gxapi::ICommandSignature {
+public:
+	MockCommandSignature(inl::gxapi::CommandSignatureDesc desc) : desc(std::move(desc)) {}
+	inl::gxapi::CommandSignatureDesc desc;
+};
+class MockPipelineState : public inl::gxapi::IPipelineState {
+public:
+	std::vector<uint8_t> GetCachedBlob() const override { return { 'm', 'o', 'c', 'k' }; }
+};
+
+
+class MockCommandList : public inl::gxapi::IGraphicsCommandList {
+public:
+	MockCommandList(inl::gxapi::eCommandListType type = inl::gxapi::eCommandListType::GRAPHICS) : m_type(type) {}
+
+	/// <summary> Number of times the given method was called. </summary>
+	int Count(const std::string& method) const {
+		auto it = m_calls.find(method);
+		return it != m_calls.end() ? it->second : 0;
+	}
+	const std::vector<std::string>& History() const { return m_history; }
+	void ClearHistory() { m_calls.clear(); m_history.clear(); }
+
+	inl::gxapi::eCommandListType GetType() const override { return m_type; }
+
+	void Close() override { Record("Close"); }
+	void Reset(inl::gxapi::ICommandAllocator*, inl::gxapi::IPipelineState*) override { Record("Reset"); }
+
+	void CopyBuffer(inl::gxapi::IResource*, size_t, inl::gxapi::IResource*, size_t, size_t) override { Record("CopyBuffer"); }
+	void CopyResource(inl::gxapi::IResource*, inl::gxapi::IResource*) override { Record("CopyResource"); }
+	void CopyTexture(inl::gxapi::IResource*, unsigned, int, int, int, inl::gxapi::IResource*, unsigned, inl::gxapi::Cube) override { Record("CopyTexture"); }
+	void CopyTexture(inl::gxapi::IResource*, inl::gxapi::TextureCopyDesc, int, int, int, inl::gxapi::IResource*, inl::gxapi::TextureCopyDesc, inl::gxapi::Cube) override { Record("CopyTexture"); }
+	void CopyTexture(inl::gxapi::IResource*, inl::gxapi::TextureCopyDesc, int, int, int, inl::gxapi::IResource*, inl::gxapi::TextureCopyDesc) override { Record("CopyTexture"); }
+	void ResourceBarrier(unsigned, inl::gxapi::ResourceBarrier*) override { Record("ResourceBarrier"); }
+
+	void Dispatch(size_t, size_t, size_t) override { Record("Dispatch"); }
+	void SetComputeRootConstant(unsigned, unsigned, uint32_t) override { Record("SetComputeRootConstant"); }
+	void SetComputeRootConstants(unsigned, unsigned, unsigned, const uint32_t*) override { Record("SetComputeRootConstants"); }
+	void SetComputeRootConstantBuffer(unsigned, void*) override { Record("SetComputeRootConstantBuffer"); }
+	void SetComputeRootDescriptorTable(unsigned, inl::gxapi::DescriptorHandle) override { Record("SetComputeRootDescriptorTable"); }
+	void SetComputeRootShaderResource(unsigned, void*) override { Record("SetComputeRootShaderResource"); }
+	void SetComputeRootUnorderedResource(unsigned, void*) override { Record("SetComputeRootUnorderedResource"); }
+	void SetComputeRootSignature(inl::gxapi::IRootSignature*) override { Record("SetComputeRootSignature"); }
+	void SetPipelineState(inl::gxapi::IPipelineState*) override { Record("SetPipelineState"); }
+	void ResetState(inl::gxapi::IPipelineState*) override { Record("ResetState"); }
+	void SetDescriptorHeaps(inl::gxapi::IDescriptorHeap*const*, uint32_t) override { Record("SetDescriptorHeaps"); }
+
+	void ClearDepthStencil(inl::gxapi::DescriptorHandle, float, uint8_t, size_t, inl::gxapi::Rectangle*, bool, bool) override { Record("ClearDepthStencil"); }
+	void ClearRenderTarget(inl::gxapi::DescriptorHandle, inl::gxapi::ColorRGBA, size_t, inl::gxapi::Rectangle*) override { Record("ClearRenderTarget"); }
+	void DrawIndexedInstanced(unsigned, unsigned, int, unsigned, unsigned) override { Record("DrawIndexedInstanced"); }
+	void DrawInstanced(unsigned, unsigned, unsigned, unsigned) override { Record("DrawInstanced"); }
+	void ExecuteBundle(inl::gxapi::IGraphicsCommandList*) override { Record("ExecuteBundle"); }
+	void ExecuteIndirect(inl::gxapi::ICommandSignature*, unsigned, inl::gxapi::IResource*, size_t, inl::gxapi::IResource*, size_t) override { Record("ExecuteIndirect"); }
+	void SetIndexBuffer(void*, size_t, inl::gxapi::eFormat) override { Record("SetIndexBuffer"); }
+	void SetPrimitiveTopology(inl::gxapi::ePrimitiveTopology) override { Record("SetPrimitiveTopology"); }
+	void SetVertexBuffers(unsigned, unsigned, void**, unsigned*, unsigned*) override { Record("SetVertexBuffers"); }
+	void SetRenderTargets(unsigned, inl::gxapi::DescriptorHandle*, inl::gxapi::DescriptorHandle*) override { Record("SetRenderTargets"); }
+	void SetBlendFactor(float, float, float, float) override { Record("SetBlendFactor"); }
+	void SetStencilRef(unsigned) override { Record("SetStencilRef"); }
+	void SetScissorRects(unsigned, inl::gxapi::Rectangle*) override { Record("SetScissorRects"); }
+	void SetViewports(unsigned, inl::gxapi::Viewport*) override { Record("SetViewports"); }
+	void SetGraphicsRootConstant(unsigned, unsigned, uint32_t) override { Record("SetGraphicsRootConstant"); }
+	void SetGraphicsRootConstants(unsigned, unsigned, unsigned, const uint32_t*) override { Record("SetGraphicsRootConstants"); }
+	void SetGraphicsRootConstantBuffer(unsigned, void*) override { Record("SetGraphicsRootConstantBuffer"); }
+	void SetGraphicsRootDescriptorTable(unsigned, inl::gxapi::DescriptorHandle) override { Record("SetGraphicsRootDescriptorTable"); }
+	void SetGraphicsRootShaderResource(unsigned, void*) override { Record("SetGraphicsRootShaderResource"); }
+	void SetGraphicsRootSignature(inl::gxapi::IRootSignature*) override { Record("SetGraphicsRootSignature"); }
+protected:
+	void Record(const char* method) {
+		++m_calls[method];
+		m_history.push_back(method);
+	}
+private:
+	inl::gxapi::eCommandListType m_type;
+	std::map<std::string, int> m_calls;
+	std::vector<std::string> m_history;
+};
+
+
+class MockGraphicsApi : public inl::gxapi::IGraphicsApi {
+public:
+	int rootSignatureCount = 0;
+	int pipelineStateCount = 0;
+	int cachedPipelineStateCount = 0; // PSOs created with a cached blob
+	int descriptorCopyCount = 0;
+	int commandSignatureCount = 0;
+
+	inl::gxapi::ICommandQueue* CreateCommandQueue(inl::gxapi::CommandQueueDesc) override { return nullptr; }
+	inl::gxapi::ICommandAllocator* CreateCommandAllocator(inl::gxapi::eCommandListType type) override { return new MockCommandAllocator(type); }
+	inl::gxapi::IGraphicsCommandList* CreateGraphicsCommandList(inl::gxapi::CommandListDesc) override { return new MockCommandList(inl::gxapi::eCommandListType::GRAPHICS); }
+	inl::gxapi::IComputeCommandList* CreateComputeCommandList(inl::gxapi::CommandListDesc) override { return new MockCommandList(inl::gxapi::eCommandListType::COMPUTE); }
+	inl::gxapi::ICopyCommandList* CreateCopyCommandList(inl::gxapi::CommandListDesc) override { return new MockCommandList(inl::gxapi::eCommandListType::COPY); }
+
+	inl::gxapi::IResource* CreateCommittedResource(inl::gxapi::HeapProperties, inl::gxapi::eHeapFlags, inl::gxapi::ResourceDesc, inl::gxapi::eResourceState, inl::gxapi::ClearValue*) override { return nullptr; }
+
+	inl::gxapi::IRootSignature* CreateRootSignature(inl::gxapi::RootSignatureDesc) override { ++rootSignatureCount; return new MockRootSignature; }
+	inl::gxapi::ICommandSignature* CreateCommandSignature(const inl::gxapi::CommandSignatureDesc& desc, inl::gxapi::IRootSignature*) override { ++commandSignatureCount; return new MockCommandSignature(desc); }
+	inl::gxapi::IPipelineState* CreateGraphicsPipelineState(const inl::gxapi::GraphicsPipelineStateDesc& desc) override {
+		++pipelineStateCount;
+		cachedPipelineStateCount += desc.cachedState.cachedBlob != nullptr;
+		return new MockPipelineState;
+	}
+	inl::gxapi::IPipelineState* CreateComputePipelineState(const inl::gxapi::ComputePipelineStateDesc& desc) override {
+		++pipelineStateCount;
+		cachedPipelineStateCount += desc.cachedState.cachedBlob != nullptr;
+		return new MockPipelineState;
+	}
+	inl::gxapi::IDescriptorHeap* CreateDescriptorHeap(inl::gxapi::DescriptorHeapDesc desc) override { return new MockDescriptorHeap(desc); }
+
+	void CreateConstantBufferView(inl::gxapi::ConstantBufferViewDesc, inl::gxapi::DescriptorHandle) override {}
+	void CreateDepthStencilView(inl::gxapi::DepthStencilViewDesc, inl::gxapi::DescriptorHandle) override {}
+	void CreateDepthStencilView(const inl::gxapi::IResource*, inl::gxapi::DescriptorHandle) override {}
+	void CreateDepthStencilView(const inl::gxapi::IResource*, inl::gxapi::DepthStencilViewDesc, inl::gxapi::DescriptorHandle) override {}
+	void CreateRenderTargetView(const inl::gxapi::IResource*, inl::gxapi::DescriptorHandle) override {}
+	void CreateRenderTargetView(const inl::gxapi::IResource*, inl::gxapi::RenderTargetViewDesc, inl::gxapi::DescriptorHandle) override {}
+	void CreateShaderResourceView(inl::gxapi::ShaderResourceViewDesc, inl::gxapi::DescriptorHandle) override {}
+	void CreateShaderResourceView(const inl::gxapi::IResource*, inl::gxapi::DescriptorHandle) override {}
+	void CreateShaderResourceView(const inl::gxapi::IResource*, inl::gxapi::ShaderResourceViewDesc, inl::gxapi::DescriptorHandle) override {}
+	void CreateUnorderedAccessView(inl::gxapi::UnorderedAccessViewDesc, inl::gxapi::DescriptorHandle) override {}
+	void CreateUnorderedAccessView(const inl::gxapi::IResource*, inl::gxapi::DescriptorHandle) override {}
+	void CreateUnorderedAccessView(const inl::gxapi::IResource*, inl::gxapi::UnorderedAccessViewDesc, inl::gxapi::DescriptorHandle) override {}
+
+	void CopyDescriptors(size_t, inl::gxapi::DescriptorHandle*, size_t, inl::gxapi::DescriptorHandle*, uint32_t*, inl::gxapi::eDescriptorHeapType) override { ++descriptorCopyCount; }
+	// Mock descriptors are a single byte, see MockDescriptorHeap
+	void CopyDescriptors(size_t numSrcRanges, inl::gxapi::DescriptorHandle* srcStarts, uint32_t* srcLengths, size_t numDstRanges, inl::gxapi::DescriptorHandle* dstStarts, uint32_t* dstLengths, inl::gxapi::eDescriptorHeapType) override {
+		++descriptorCopyCount;
+		std::vector<char> values;
+		for (size_t i = 0; i < numSrcRanges; ++i) {
+			values.insert(values.end(), (char*)srcStarts[i].cpuAddress, (char*)srcStarts[i].cpuAddress + srcLengths[i]);
+		}
+		size_t next = 0;
+		for (size_t i = 0; i < numDstRanges; ++i) {
+			std::copy(values.begin() + next, values.begin() + next + dstLengths[i], (char*)dstStarts[i].cpuAddress);
+			next += dstLengths[i];
+		}
+	}
+	void CopyDescriptors(inl::gxapi::DescriptorHandle, inl::gxapi::DescriptorHandle, size_t, inl::gxapi::eDescriptorHeapType) override { ++descriptorCopyCount; }
+
+	inl::gxapi::IFence* CreateFence(uint64_t) override { return nullptr; }
+	void MakeResident(const std::vector<inl::gxapi::IResource*>&) override {}
+	void Evict(const std::vector<inl::gxapi::IResource*>&) override {}
+	void ReportLiveObjects() const override {}
+};
+
+
+//------------------------------------------------------------------------------
+// A shader compiler that outputs the entry point followed by the macros whose
+// name appears in the source, so macros a shader doesn't use don't change the
+// binary, just like with a real compiler.
+//------------------------------------------------------------------------------
+
+class MockGxapiManager : public inl::gxapi::IGxapiManager {
+public:
+	std::atomic_int compileCount{ 0 };
+
+	std::vector<inl::gxapi::AdapterInfo> EnumerateAdapters() override { return {}; }
+	inl::gxapi::ISwapChain* CreateSwapChain(inl::gxapi::SwapChainDesc, inl::gxapi::ICommandQueue*) override { return nullptr; }
+	inl::gxapi::IGraphicsApi* CreateGraphicsApi(unsigned) override { return nullptr; }
+
+	inl::gxapi::ShaderProgramBinary CompileShader(const char* source,
+												  const char* mainFunction,
+												  inl::gxapi::eShaderType,
+												  inl::gxapi::eShaderCompileFlags,
+												  inl::gxapi::IShaderIncludeProvider*,
+												  const char* macroDefinitions) override
+	{
+		++compileCount;
+		std::string output = mainFunction;
+		std::string sourceCode = source;
+		std::string macros = macroDefinitions ? macroDefinitions : "";
+		size_t begin = 0;
+		while (begin < macros.size()) {
+			size_t end = std::min(macros.find(' ', begin), macros.size());
+			std::string definition = macros.substr(begin, end - begin);
+			if (sourceCode.find(definition.substr(0, definition.find('='))) != sourceCode.npos) {
+				output += " " + definition;
+			}
+			begin = end + 1;
+		}
+		return { std::vector<uint8_t>(output.begin(), output.end()) };
+	}
+
+	inl::gxapi::ShaderProgramBinary CompileShaderFromFile(const std::string&, const std::string&, inl::gxapi::eShaderType, inl::gxapi::eShaderCompileFlags, const std::vector<inl::gxapi::ShaderMacroDefinition>&) override {
+		return {};
+	}
+};
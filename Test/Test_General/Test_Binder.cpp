@@ -1,6 +1,7 @@
 #include "Test.hpp"
 #include <iostream>
 #include "GraphicsEngine_LL/Binder.hpp"
+#include "MockGraphicsApi.hpp"
 
 using std::cout;
 using std::endl;
@@ -110,11 +111,17 @@ int TestBinder::Run() {
 	p.constantSize = 53;
 	parameters.push_back(p);
 
-	throw std::invalid_argument("Binder requires a graphics api, so it's no longer testable this way. Create a mock graphics api.");
-	//Binder binder(parameters);
+	MockGraphicsApi gxApi;
 
-	//cout << binder;
+	Binder binder(&gxApi, parameters);
+	cout << binder;
 
+	// Root signatures are shared between binders with the same layout.
+	Binder sameBinder(&gxApi, parameters);
+	if (sameBinder.GetRootSignature() != binder.GetRootSignature() || gxApi.rootSignatureCount != 1) {
+		cout << "Identical binders did not share their root signature." << endl;
+		return 1;
+	}
 
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,179 @@
+#include "Test.hpp"
+
+#include <GraphicsEngine_LL/BoundingVolumeHierarchy.hpp>
+
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <cmath>
+
+using std::cout;
+using std::endl;
+
+using namespace inl;
+using namespace inl::gxeng;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestBoundingVolumeHierarchy : public AutoRegisterTest<TestBoundingVolumeHierarchy> {
+public:
+	static std::string Name() {
+		return "BoundingVolumeHierarchy";
+	}
+	virtual int Run() override;
+private:
+	static bool Overlaps(const Aabb& lhs, const Aabb& rhs);
+	static bool SameItems(std::vector<uint32_t> actual, std::vector<uint32_t> expected);
+};
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+bool TestBoundingVolumeHierarchy::Overlaps(const Aabb& lhs, const Aabb& rhs) {
+	for (int axis = 0; axis < 3; ++axis) {
+		if (lhs.max[axis] < rhs.min[axis] || rhs.max[axis] < lhs.min[axis]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool TestBoundingVolumeHierarchy::SameItems(std::vector<uint32_t> actual, std::vector<uint32_t> expected) {
+	std::sort(actual.begin(), actual.end());
+	std::sort(expected.begin(), expected.end());
+	return actual == expected;
+}
+
+
+int TestBoundingVolumeHierarchy::Run() {
+	// enough boxes to build subtrees in parallel
+	std::mt19937 rne(11);
+	std::uniform_real_distribution<float> position(-1000.f, 1000.f);
+	std::uniform_real_distribution<float> size(0.f, 5.f);
+	const size_t count = 20000;
+	std::vector<Aabb> boxes(count);
+	for (auto& box : boxes) {
+		box.min = { position(rne), position(rne), position(rne) };
+		box.max = box.min + mathfu::Vector<float, 3>(size(rne), size(rne), size(rne));
+	}
+
+	BoundingVolumeHierarchy bvh;
+	bvh.Build(boxes.data(), boxes.size());
+	if (bvh.GetNumItems() != count || bvh.GetNumNodes() > 2 * count - 1 || bvh.NeedsRebuild()) {
+		cout << "Tree has wrong size." << endl;
+		return 1;
+	}
+
+	// box query finds the same items as testing every box
+	Aabb region;
+	region.min = { -200, -100, -300 };
+	region.max = { 100, 200, 50 };
+	std::vector<uint32_t> found, expected;
+	bvh.QueryAabb(region, found);
+	for (uint32_t i = 0; i < count; ++i) {
+		if (Overlaps(boxes[i], region)) {
+			expected.push_back(i);
+		}
+	}
+	if (expected.empty() || !SameItems(found, expected)) {
+		cout << "Box query is wrong." << endl;
+		return 1;
+	}
+
+	// frustum query agrees with testing every box
+	Frustum frustum(mathfu::Matrix<float, 4, 4>::Perspective(1.0f, 1.5f, 1.0f, 800.0f) * mathfu::Matrix<float, 4, 4>::LookAt({ 0, 0, 1 }, { 0, 0, 0 }, { 0, 1, 0 }));
+	found.clear();
+	expected.clear();
+	bvh.QueryFrustum(frustum, found);
+	for (uint32_t i = 0; i < count; ++i) {
+		if (frustum.IsVisible(boxes[i])) {
+			expected.push_back(i);
+		}
+	}
+	if (expected.empty() || !SameItems(found, expected)) {
+		cout << "Frustum query is wrong." << endl;
+		return 1;
+	}
+
+	// sphere and ray queries find an item placed for them
+	Aabb target;
+	target.min = { 5000, 5000, 5000 };
+	target.max = { 5001, 5001, 5001 };
+	boxes[123] = target;
+	if (!bvh.Refit(boxes.data()) || bvh.Refit(boxes.data())) {
+		cout << "Refit did not report changes correctly." << endl;
+		return 1;
+	}
+	BoundingSphere sphere;
+	sphere.center = { 5002, 5000.5f, 5000.5f };
+	sphere.radius = 1.5f;
+	found.clear();
+	bvh.QuerySphere(sphere, found);
+	if (!SameItems(found, { 123 })) {
+		cout << "Sphere query is wrong after refit." << endl;
+		return 1;
+	}
+	Ray ray;
+	ray.origin = { 0, 0, 0 };
+	ray.direction = { 1, 1, 1 };
+	found.clear();
+	bvh.QueryRay(ray, found);
+	if (std::find(found.begin(), found.end(), 123) == found.end()) {
+		cout << "Ray query missed the item." << endl;
+		return 1;
+	}
+	found.clear();
+	bvh.QueryRay(ray, found, 4000.f);
+	if (std::find(found.begin(), found.end(), 123) != found.end()) {
+		cout << "Ray query found an item past the maximum distance." << endl;
+		return 1;
+	}
+
+	// refitting only the moved items gives the same tree as refitting all of them
+	BoundingVolumeHierarchy partial = bvh;
+	std::vector<uint32_t> movedItems;
+	for (uint32_t i = 0; i < count; i += 101) {
+		boxes[i].min += mathfu::Vector<float, 3>(300, -200, 100);
+		boxes[i].max += mathfu::Vector<float, 3>(300, -200, 100);
+		movedItems.push_back(i);
+	}
+	movedItems.push_back(movedItems.front()); // reported twice
+	if (!partial.Refit(boxes.data(), movedItems) || !bvh.Refit(boxes.data())
+		|| std::abs(partial.GetCost() - bvh.GetCost()) > 1e-3f * bvh.GetCost()
+		|| partial.Refit(boxes.data(), movedItems))
+	{
+		cout << "Partial refit did not report changes correctly." << endl;
+		return 1;
+	}
+	found.clear();
+	expected.clear();
+	partial.QueryAabb(region, found);
+	bvh.QueryAabb(region, expected);
+	if (!SameItems(found, expected)) {
+		cout << "Query is wrong after partial refit." << endl;
+		return 1;
+	}
+
+	// scattering everything degrades the tree until it's rebuilt
+	std::shuffle(boxes.begin(), boxes.end(), rne);
+	bvh.Refit(boxes.data());
+	if (!bvh.NeedsRebuild()) {
+		cout << "Degraded tree does not ask for a rebuild." << endl;
+		return 1;
+	}
+	bvh.Build(boxes.data(), boxes.size());
+	if (bvh.NeedsRebuild()) {
+		cout << "Rebuilt tree asks for a rebuild." << endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,159 @@
+#include "Test.hpp"
+
+#include <GraphicsEngine_LL/CascadedShadows.hpp>
+
+#include <iostream>
+#include <cmath>
+
+using std::cout;
+using std::endl;
+
+using namespace inl;
+using namespace inl::gxeng;
+
+using Vec3 = mathfu::Vector<float, 3>;
+using Vec4 = mathfu::Vector<float, 4>;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestCascadedShadows : public AutoRegisterTest<TestCascadedShadows> {
+public:
+	static std::string Name() {
+		return "CascadedShadows";
+	}
+	virtual int Run() override;
+private:
+	static bool CoversSlice(const Camera& camera, const ShadowCascade& cascade);
+};
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+// All corners of the camera frustum's slice are inside the cascade's volume.
+bool TestCascadedShadows::CoversSlice(const Camera& camera, const ShadowCascade& cascade) {
+	auto projection = camera.GetPerspectiveMatrixRH();
+	Vec3 look = camera.GetLookDirection().Normalized();
+	Vec3 right = Vec3::CrossProduct(look, camera.GetUpVector()).Normalized();
+	Vec3 up = Vec3::CrossProduct(right, look);
+	for (float distance : { cascade.nearDistance, cascade.farDistance }) {
+		for (int corner = 0; corner < 4; ++corner) {
+			float sx = corner & 1 ? 1.0f : -1.0f;
+			float sy = corner & 2 ? 1.0f : -1.0f;
+			Vec3 point = camera.GetPosition() + distance * (look + sx / projection(0, 0) * right + sy / projection(1, 1) * up);
+			Vec4 clip = cascade.viewProjection * Vec4(point, 1.0f);
+			if (std::abs(clip.x()) > 1.0001f || std::abs(clip.y()) > 1.0001f || clip.z() < -0.0001f || clip.z() > 1.0001f) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+
+int TestCascadedShadows::Run() {
+	// splits cover the view range in increasing order, uniform without the logarithmic part
+	auto splits = ComputeCascadeSplits(0.5f, 500.0f, 4);
+	if (splits.size() != 5 || splits.front() != 0.5f || splits.back() != 500.0f) {
+		cout << "Splits do not span the view range." << endl;
+		return 1;
+	}
+	for (size_t i = 1; i < splits.size(); ++i) {
+		if (splits[i] <= splits[i - 1]) {
+			cout << "Splits are not increasing." << endl;
+			return 1;
+		}
+	}
+	auto uniformSplits = ComputeCascadeSplits(1.0f, 101.0f, 4, 0.0f);
+	if (std::abs(uniformSplits[1] - 26.0f) > 1e-3f || std::abs(uniformSplits[2] - 51.0f) > 1e-3f) {
+		cout << "Uniform splits are not evenly spaced." << endl;
+		return 1;
+	}
+	if (splits[1] >= 500.0f / 4) {
+		cout << "Logarithmic splits should favor the near range." << endl;
+		return 1;
+	}
+
+	Camera camera;
+	camera.SetPosition({ 10, 20, 5 });
+	camera.SetLookDirection({ 1, 0.5f, -0.2f });
+	camera.SetUpVector({ 0, 0, 1 });
+	camera.SetFOVAspect(1.2f, 16.0f / 9.0f);
+	camera.SetNearPlane(0.5f);
+	camera.SetFarPlane(500.0f);
+
+	Vec3 lightDirection = Vec3(0.3f, -0.2f, -1.0f).Normalized();
+	auto lightView = LightViewTransform(lightDirection);
+	const unsigned resolution = 1024;
+
+	// the light shines along -z in its own space
+	Vec4 lightDirInLightSpace = lightView * Vec4(lightDirection, 0.0f);
+	if (std::abs(lightDirInLightSpace.z() + 1.0f) > 1e-4f) {
+		cout << "Light view does not look along the light." << endl;
+		return 1;
+	}
+
+	// cascades contain their slice of the view frustum
+	std::vector<ShadowCascade> cascades;
+	for (size_t i = 0; i + 1 < splits.size(); ++i) {
+		cascades.push_back(FitShadowCascade(camera, lightView, splits[i], splits[i + 1], resolution, 50.0f));
+		if (!CoversSlice(camera, cascades.back())) {
+			cout << "Cascade does not cover its part of the view frustum." << endl;
+			return 1;
+		}
+	}
+
+	// turning the camera keeps the size, moving it keeps the texel grid
+	Camera turned = camera;
+	turned.SetLookDirection({ -0.3f, 1.0f, 0.4f });
+	Camera moved = camera;
+	moved.SetPosition({ 10.37f, 19.81f, 5.02f });
+	for (size_t i = 0; i < cascades.size(); ++i) {
+		ShadowCascade turnedCascade = FitShadowCascade(turned, lightView, splits[i], splits[i + 1], resolution, 50.0f);
+		ShadowCascade movedCascade = FitShadowCascade(moved, lightView, splits[i], splits[i + 1], resolution, 50.0f);
+		if (turnedCascade.viewProjection(0, 0) != cascades[i].viewProjection(0, 0)
+			|| turnedCascade.viewProjection(1, 1) != cascades[i].viewProjection(1, 1))
+		{
+			cout << "Cascade size changed as the camera turned." << endl;
+			return 1;
+		}
+		for (int row = 0; row < 2; ++row) {
+			float texels = (movedCascade.viewProjection(row, 3) - cascades[i].viewProjection(row, 3)) * resolution / 2;
+			if (std::abs(texels - std::round(texels)) > 1e-2f) {
+				cout << "Cascade moved by a fraction of a texel." << endl;
+				return 1;
+			}
+		}
+	}
+
+	// casters between the light and the slice cast shadows, casters behind it or to its side don't
+	Vec3 sliceCenter = camera.GetPosition() + camera.GetLookDirection().Normalized() * 0.5f * (splits[0] + splits[1]);
+	std::vector<Vec3> centers = {
+		sliceCenter,								// inside
+		sliceCenter - lightDirection * 40.0f,		// above the slice, towards the light
+		sliceCenter - lightDirection * 500.0f,		// too far towards the light
+		sliceCenter + lightDirection * 200.0f,		// below the slice, cannot shadow it
+		sliceCenter + Vec3::CrossProduct(lightDirection, Vec3(0, 0, 1)).Normalized() * 300.0f, // to the side
+	};
+	std::vector<float> xs, ys, zs, rs;
+	for (const auto& center : centers) {
+		xs.push_back(center.x());
+		ys.push_back(center.y());
+		zs.push_back(center.z());
+		rs.push_back(1.0f);
+	}
+	std::vector<std::vector<uint32_t>> casters;
+	CullShadowCasters(cascades, xs.data(), ys.data(), zs.data(), rs.data(), centers.size(), casters);
+	if (casters.size() != cascades.size() || casters[0] != std::vector<uint32_t>{ 0, 1 }) {
+		cout << "Wrong casters for the first cascade." << endl;
+		return 1;
+	}
+
+	return 0;
+}
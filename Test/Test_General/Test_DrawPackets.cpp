@@ -0,0 +1,135 @@
+#include "Test.hpp"
+
+#include <GraphicsEngine_LL/DrawPackets.hpp>
+
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <set>
+
+using std::cout;
+using std::endl;
+
+using namespace inl;
+using namespace inl::gxeng;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestDrawPackets : public AutoRegisterTest<TestDrawPackets> {
+public:
+	static std::string Name() {
+		return "DrawPackets";
+	}
+	virtual int Run() override;
+};
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestDrawPackets::Run() {
+	std::mt19937_64 rne(42);
+
+	// radix sort matches a stable sort, keys only differing in a few bytes too
+	for (uint64_t mask : { ~uint64_t(0), uint64_t(0x00FF0000000000FF), uint64_t(0) }) {
+		std::vector<DrawPacket> packets, scratch;
+		for (uint32_t i = 0; i < 5000; ++i) {
+			packets.push_back({ rne() & mask, i });
+		}
+		std::vector<DrawPacket> expected = packets;
+		std::stable_sort(expected.begin(), expected.end(), [](const DrawPacket& l, const DrawPacket& r) { return l.key < r.key; });
+		SortDrawPackets(packets, scratch);
+		for (size_t i = 0; i < packets.size(); ++i) {
+			if (packets[i].key != expected[i].key || packets[i].index != expected[i].index) {
+				cout << "Radix sort differs from stable sort." << endl;
+				return 1;
+			}
+		}
+	}
+
+	// pipeline takes precedence over mesh, mesh over texture, texture over depth
+	if (!(DrawPacketBuilder::MakeKey(0, 5, 5, 1.0f) < DrawPacketBuilder::MakeKey(1, 0, 0, 0.0f))
+		|| !(DrawPacketBuilder::MakeKey(0, 0, 5, 1.0f) < DrawPacketBuilder::MakeKey(0, 1, 0, 0.0f))
+		|| !(DrawPacketBuilder::MakeKey(0, 0, 0, 1.0f) < DrawPacketBuilder::MakeKey(0, 0, 1, 0.0f))
+		|| !(DrawPacketBuilder::MakeKey(0, 0, 0, 0.25f) < DrawPacketBuilder::MakeKey(0, 0, 0, 0.5f)))
+	{
+		cout << "Key fields are in the wrong order." << endl;
+		return 1;
+	}
+
+	// 3 meshes with 2 textures in 5 combinations, shuffled draws
+	int meshes[3], textures[2];
+	struct Draw { const void* mesh; const void* texture; float depth; };
+	std::vector<Draw> draws;
+	for (int i = 0; i < 1000; ++i) {
+		draws.push_back({ &meshes[i % 3], &textures[i % 3 == 2 ? 1 : (i / 3) % 2], std::uniform_real_distribution<float>(0, 1)(rne) });
+	}
+	std::shuffle(draws.begin(), draws.end(), rne);
+
+	DrawPacketBuilder builder;
+	for (int frame = 0; frame < 2; ++frame) {
+		builder.Clear();
+		for (uint32_t i = 0; i < draws.size(); ++i) {
+			builder.Add(i, 0, draws[i].mesh, draws[i].texture, draws[i].depth);
+		}
+		builder.Build(1000);
+
+		const auto& packets = builder.GetPackets();
+		const auto& batches = builder.GetBatches();
+		if (packets.size() != draws.size() || batches.size() != 5) {
+			cout << "Draws were not batched by mesh and texture." << endl;
+			return 1;
+		}
+
+		std::set<std::pair<const void*, const void*>> seen;
+		uint32_t covered = 0;
+		for (const auto& batch : batches) {
+			if (batch.first != covered) {
+				cout << "Batches do not cover the packets." << endl;
+				return 1;
+			}
+			covered += batch.count;
+
+			const Draw& first = draws[packets[batch.first].index];
+			if (!seen.insert({ first.mesh, first.texture }).second) {
+				cout << "Same state is split into several batches." << endl;
+				return 1;
+			}
+			for (uint32_t i = batch.first; i < batch.first + batch.count; ++i) {
+				const Draw& draw = draws[packets[i].index];
+				if (draw.mesh != first.mesh || draw.texture != first.texture) {
+					cout << "Batch mixes meshes or textures." << endl;
+					return 1;
+				}
+				if (i > batch.first && draw.depth < draws[packets[i - 1].index].depth - 1e-4f) {
+					cout << "Batch is not sorted front to back." << endl;
+					return 1;
+				}
+			}
+		}
+		if (covered != draws.size()) {
+			cout << "Batches do not cover the packets." << endl;
+			return 1;
+		}
+	}
+
+	// long runs are split at the instance limit
+	builder.Clear();
+	for (uint32_t i = 0; i < 10; ++i) {
+		builder.Add(i, 0, &meshes[0], &textures[0], 0.5f);
+	}
+	builder.Build(4);
+	const auto& batches = builder.GetBatches();
+	if (batches.size() != 3 || batches[0].count != 4 || batches[1].count != 4 || batches[2].count != 2) {
+		cout << "Batches exceed the instance limit." << endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,178 @@
+#include "Test.hpp"
+
+#include <GraphicsEngine_LL/MeshEntityStore.hpp>
+#include <GraphicsEngine_LL/MeshEntity.hpp>
+
+#include <iostream>
+#include <memory>
+#include <cmath>
+#include <stdexcept>
+#include <algorithm>
+
+using std::cout;
+using std::endl;
+
+using namespace inl;
+using namespace inl::gxeng;
+
+using Mat4 = mathfu::Matrix<float, 4, 4>;
+using Vec3 = mathfu::Vector<float, 3>;
+using Quat = mathfu::Quaternion<float>;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestEntityHierarchy : public AutoRegisterTest<TestEntityHierarchy> {
+public:
+	static std::string Name() {
+		return "EntityHierarchy";
+	}
+	virtual int Run() override;
+private:
+	static bool IsClose(const Mat4& lhs, const Mat4& rhs);
+	static Mat4 Local(const MeshEntity& entity);
+	static bool ParentsFirst(const MeshEntityStore& store);
+};
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+bool TestEntityHierarchy::IsClose(const Mat4& lhs, const Mat4& rhs) {
+	for (int i = 0; i < 16; ++i) {
+		if (std::abs(lhs[i] - rhs[i]) > 1e-4f * (1.0f + std::abs(rhs[i]))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+Mat4 TestEntityHierarchy::Local(const MeshEntity& entity) {
+	return Mat4::FromTranslationVector(entity.GetPosition()) * entity.GetRotation().ToMatrix4() * Mat4::FromScaleVector(entity.GetScale());
+}
+
+
+bool TestEntityHierarchy::ParentsFirst(const MeshEntityStore& store) {
+	for (size_t i = 0; i < store.Size(); ++i) {
+		MeshEntityHandle parent = store.Parent(i);
+		if (store.IsValid(parent) && store.IndexOf(parent) >= i) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+int TestEntityHierarchy::Run() {
+	auto store = std::make_shared<MeshEntityStore>();
+
+	// a drone with four rotors, the rotors are created before the body on purpose
+	std::vector<std::unique_ptr<MeshEntity>> rotors;
+	for (int i = 0; i < 4; ++i) {
+		rotors.push_back(std::make_unique<MeshEntity>(store));
+		rotors.back()->SetPosition({ i % 2 ? 0.3f : -0.3f, i / 2 ? 0.3f : -0.3f, 0.05f });
+	}
+	auto drone = std::make_unique<MeshEntity>(store);
+	auto tree = std::make_unique<MeshEntity>(store);
+	for (auto& rotor : rotors) {
+		rotor->SetParent(drone.get());
+	}
+	drone->SetPosition({ 10, 0, 3 });
+	drone->SetRotation(Quat::FromAngleAxis(0.5f, Vec3(0, 0, 1)));
+	tree->SetPosition({ -5, 5, 0 });
+
+	if (store->UpdateWorldMatrices() != 6 || !ParentsFirst(*store)) {
+		cout << "Hierarchy is not sorted with parents first." << endl;
+		return 1;
+	}
+	for (auto& rotor : rotors) {
+		Mat4 expected = Local(*drone) * Local(*rotor);
+		if (!IsClose(store->WorldMatrix(rotor->GetStoreIndex()), expected) || !IsClose(rotor->GetTransform(), expected)) {
+			cout << "Rotor is not transformed by the drone." << endl;
+			return 1;
+		}
+	}
+
+	// moving the drone moves the rotors, but not the tree
+	drone->SetPosition({ 11, 1, 4 });
+	rotors[2]->SetRotation(Quat::FromAngleAxis(2.0f, Vec3(0, 0, 1)));
+	Mat4 expectedRotor = Local(*drone) * Local(*rotors[2]);
+	if (!IsClose(rotors[2]->GetTransform(), expectedRotor)) {
+		cout << "Transform of an entity with a moved parent is out of date." << endl;
+		return 1;
+	}
+	if (store->UpdateWorldMatrices() != 5) {
+		cout << "Only the drone's subtree should be recomputed." << endl;
+		return 1;
+	}
+	if (!IsClose(store->WorldMatrix(rotors[2]->GetStoreIndex()), expectedRotor)) {
+		cout << "Rotor did not follow the drone." << endl;
+		return 1;
+	}
+	const std::vector<MeshEntityHandle>& moved = store->GetMovedEntities();
+	if (moved.size() != 5
+		|| std::find(moved.begin(), moved.end(), rotors[0]->GetStoreHandle()) == moved.end()
+		|| std::find(moved.begin(), moved.end(), tree->GetStoreHandle()) != moved.end())
+	{
+		cout << "Moved entities are not reported with their subtree." << endl;
+		return 1;
+	}
+	rotors[1]->SetRotation(Quat::FromAngleAxis(1.0f, Vec3(0, 0, 1)));
+	if (store->UpdateWorldMatrices() != 1) {
+		cout << "Spinning a rotor should only update the rotor." << endl;
+		return 1;
+	}
+
+	// no cycles
+	try {
+		drone->SetParent(rotors[0].get());
+		cout << "Entity was attached to its own child." << endl;
+		return 1;
+	}
+	catch (std::invalid_argument&) {
+		// expected
+	}
+
+	// children of a destroyed entity become roots
+	drone.reset();
+	if (store->UpdateWorldMatrices() != 4 || store->IsValid(store->Parent(rotors[0]->GetStoreIndex()))) {
+		cout << "Orphans were not detached." << endl;
+		return 1;
+	}
+	if (!IsClose(rotors[0]->GetTransform(), Local(*rotors[0]))) {
+		cout << "Orphan is still transformed by its destroyed parent." << endl;
+		return 1;
+	}
+
+	// large levels split across threads give the same result
+	std::vector<std::unique_ptr<MeshEntity>> parents;
+	std::vector<std::unique_ptr<MeshEntity>> children;
+	for (int i = 0; i < 20000; ++i) {
+		parents.push_back(std::make_unique<MeshEntity>(store));
+		parents.back()->SetPosition({ (float)i, 0, 0 });
+		parents.back()->SetRotation(Quat::FromAngleAxis(0.001f * i, Vec3(0, 0, 1)));
+		children.push_back(std::make_unique<MeshEntity>(store));
+		children.back()->SetParent(parents.back().get());
+		children.back()->SetPosition({ 0, 1, 0 });
+		children.back()->SetScale({ 2, 2, 2 });
+	}
+	store->UpdateWorldMatrices();
+	if (!ParentsFirst(*store)) {
+		cout << "Large hierarchy is not sorted with parents first." << endl;
+		return 1;
+	}
+	for (size_t i = 0; i < children.size(); i += 97) {
+		if (!IsClose(store->WorldMatrix(children[i]->GetStoreIndex()), Local(*parents[i]) * Local(*children[i]))) {
+			cout << "Parallel update gave a wrong world matrix." << endl;
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,118 @@
+#include "Test.hpp"
+
+#include <GraphicsEngine_LL/FrustumCulling.hpp>
+#include <GraphicsEngine_LL/BoundingVolume.hpp>
+#include <GraphicsEngine_LL/Camera.hpp>
+
+#include <iostream>
+#include <random>
+#include <cmath>
+
+using std::cout;
+using std::endl;
+
+using namespace inl;
+using namespace inl::gxeng;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestFrustumCulling : public AutoRegisterTest<TestFrustumCulling> {
+public:
+	static std::string Name() {
+		return "FrustumCulling";
+	}
+	virtual int Run() override;
+};
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestFrustumCulling::Run() {
+	// bounds of a mesh
+	std::vector<mathfu::Vector<float, 3>> points = { { -1, 0, 0 },{ 3, 2, 0 },{ 1, -2, 4 } };
+	Aabb aabb = ComputeAabb(points.data(), points.size());
+	BoundingSphere sphere = ComputeBoundingSphere(points.data(), points.size());
+	if (aabb.min != mathfu::Vector<float, 3>(-1, -2, 0) || aabb.max != mathfu::Vector<float, 3>(3, 2, 4)) {
+		cout << "Wrong bounding box." << endl;
+		return 1;
+	}
+	for (auto& point : points) {
+		if ((point - sphere.center).Length() > sphere.radius + 1e-4f) {
+			cout << "Bounding sphere does not contain the points." << endl;
+			return 1;
+		}
+	}
+
+	// scaling grows the sphere by the largest scale
+	BoundingSphere unit;
+	unit.radius = 1;
+	BoundingSphere transformed = TransformSphere(unit, mathfu::Matrix<float, 4, 4>::FromTranslationVector(mathfu::Vector<float, 3>(5, 0, 0)) * mathfu::Matrix<float, 4, 4>::FromScaleVector(mathfu::Vector<float, 3>(1, 3, 2)));
+	if (transformed.center != mathfu::Vector<float, 3>(5, 0, 0) || std::abs(transformed.radius - 3) > 1e-5f) {
+		cout << "Wrong transformed sphere." << endl;
+		return 1;
+	}
+
+	// camera at the origin looking down +Y
+	Camera camera;
+	camera.SetPosition({ 0, 0, 0 });
+	camera.SetTarget({ 0, 1, 0 });
+	camera.SetUpVector({ 0, 0, 1 });
+	camera.SetFOVAspect(1.5f, 16.f / 9.f);
+	camera.SetNearPlane(0.1f);
+	camera.SetFarPlane(100.f);
+	Frustum frustum(camera.GetPerspectiveMatrixRH() * camera.GetViewMatrixRH());
+
+	auto visible = [&](mathfu::Vector<float, 3> center, float radius) {
+		BoundingSphere s;
+		s.center = center;
+		s.radius = radius;
+		return frustum.IsVisible(s);
+	};
+	if (!visible({ 0, 10, 0 }, 1) || visible({ 0, -10, 0 }, 1) || visible({ 0, 200, 0 }, 1) || visible({ 100, 10, 0 }, 1)) {
+		cout << "Frustum classifies spheres wrong." << endl;
+		return 1;
+	}
+	if (!visible({ 0, -1, 0 }, 1.5f) || !visible({ 0, 101, 0 }, 2)) {
+		cout << "Spheres crossing the frustum's planes must be visible." << endl;
+		return 1;
+	}
+
+	// batched culling agrees with the single sphere test, including the remainder not filling a batch
+	std::mt19937 rne(7);
+	std::uniform_real_distribution<float> position(-120.f, 120.f);
+	std::uniform_real_distribution<float> radius(0.f, 10.f);
+	const size_t count = 1003;
+	std::vector<float> xs(count), ys(count), zs(count), rs(count);
+	for (size_t i = 0; i < count; ++i) {
+		xs[i] = position(rne);
+		ys[i] = position(rne);
+		zs[i] = position(rne);
+		rs[i] = radius(rne);
+	}
+	std::vector<uint32_t> visibleIndices(count);
+	size_t numVisible = CullSpheres(frustum, xs.data(), ys.data(), zs.data(), rs.data(), count, visibleIndices.data());
+
+	size_t next = 0;
+	for (size_t i = 0; i < count; ++i) {
+		bool expected = visible({ xs[i], ys[i], zs[i] }, rs[i]);
+		bool actual = next < numVisible && visibleIndices[next] == i;
+		if (expected != actual) {
+			cout << "Batched culling differs for sphere " << i << "." << endl;
+			return 1;
+		}
+		next += actual;
+	}
+	if (next != numVisible || numVisible == 0 || numVisible == count) {
+		cout << "Batched culling gave wrong number of spheres." << endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,109 @@
+#include "Test.hpp"
+#include "MockGraphicsApi.hpp"
+
+#include <GraphicsEngine_LL/Nodes/Node_GenCSM.hpp>
+#include <GraphicsEngine_LL/ExecutionContext.hpp>
+
+#include <iostream>
+#include <cmath>
+
+using std::cout;
+using std::endl;
+
+using namespace inl;
+using namespace inl::gxeng;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestGenCSM : public AutoRegisterTest<TestGenCSM> {
+public:
+	static std::string Name() {
+		return "GenCSM";
+	}
+	virtual int Run() override;
+};
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestGenCSM::Run() {
+	MockGraphicsApi graphicsApi;
+	nodes::GenCSM node(&graphicsApi, 1024, 3);
+
+	exc::InputPort<const nodes::ShadowCascades*> shadowCascades;
+	shadowCascades.Link(node.GetOutput(0));
+
+	// one culling subtask, followed by one subtask recording all cascades in parallel
+	Task task = node.GetTask();
+	if (lemon::countNodes(task.m_nodes) != 2 || lemon::countArcs(task.m_nodes) != 1) {
+		cout << "Task should cull, then record the cascades." << endl;
+		return 1;
+	}
+	lemon::ListDigraph::Node cullNode = lemon::INVALID;
+	for (lemon::ListDigraph::NodeIt taskNode(task.m_nodes); taskNode != lemon::INVALID; ++taskNode) {
+		if (lemon::countInArcs(task.m_nodes, taskNode) == 0) {
+			cullNode = taskNode;
+		}
+	}
+	if (cullNode == lemon::INVALID || lemon::countOutArcs(task.m_nodes, cullNode) != 1) {
+		cout << "Recording should depend on culling." << endl;
+		return 1;
+	}
+
+	Camera camera;
+	camera.SetPosition({ 0, 0, 10 });
+	camera.SetLookDirection({ 0, 1, 0 });
+	camera.SetUpVector({ 0, 0, 1 });
+	camera.SetFOVAspect(1.2f, 16.0f / 9.0f);
+	camera.SetNearPlane(0.5f);
+	camera.SetFarPlane(300.0f);
+	DirectionalLight sun({ 0.2f, 0.3f, -1.0f }, { 1, 1, 1 });
+	EntityCollection<MeshEntity> entities;
+
+	// culling fits the cascades on the camera's frustum, the culling subtask records nothing
+	FrameContext frameContext;
+	ExecutionContext context(&frameContext);
+	node.GetInput<0>().Set(&camera);
+	node.GetInput<1>().Set(&sun);
+	node.GetInput<2>().Set(&entities);
+	task.m_subtasks[cullNode](context);
+	if (!shadowCascades.IsSet() || shadowCascades.Get() == nullptr) {
+		cout << "Shadow cascades were not output." << endl;
+		return 1;
+	}
+	const std::vector<ShadowCascade>& cascades = shadowCascades.Get()->cascades;
+	if (cascades.size() != 3 || cascades.front().nearDistance != 0.5f || cascades.back().farDistance != 300.0f) {
+		cout << "Cascades do not cover the camera's view range." << endl;
+		return 1;
+	}
+	for (size_t i = 1; i < cascades.size(); ++i) {
+		if (cascades[i].nearDistance != cascades[i - 1].farDistance) {
+			cout << "Cascades are not adjacent." << endl;
+			return 1;
+		}
+	}
+
+	// without a sun there is nothing to draw
+	node.GetInput<0>().Set(&camera);
+	node.GetInput<1>().Set(nullptr);
+	node.GetInput<2>().Set(&entities);
+	task.m_subtasks[cullNode](context);
+	if (!shadowCascades.Get()->cascades.empty()) {
+		cout << "Cascades were fitted without a sun." << endl;
+		return 1;
+	}
+	lemon::ListDigraph::OutArcIt recordArc(task.m_nodes, cullNode);
+	if (task.m_subtasks[task.m_nodes.target(recordArc)](context).GetNumLists() != 0) {
+		cout << "Cascades were recorded without a sun." << endl;
+		return 1;
+	}
+
+	return 0;
+}
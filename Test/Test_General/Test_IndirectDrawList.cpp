@@ -0,0 +1,194 @@
+#include "Test.hpp"
+
+#include <GraphicsEngine_LL/IndirectDrawList.hpp>
+#include "MockGraphicsApi.hpp"
+
+#include <iostream>
+#include <random>
+#include <vector>
+#include <cstring>
+
+using std::cout;
+using std::endl;
+
+using namespace inl;
+using namespace inl::gxeng;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestIndirectDrawList : public AutoRegisterTest<TestIndirectDrawList> {
+public:
+	static std::string Name() {
+		return "IndirectDrawList";
+	}
+	virtual int Run() override;
+private:
+	struct Draw {
+		gxapi::DrawIndexedArguments arguments;
+		std::vector<uint32_t> constants;
+	};
+	/// <summary> Executes the argument buffer the way the GPU does, following the signature. </summary>
+	static std::vector<Draw> Replay(const gxapi::CommandSignatureDesc& signature, const uint8_t* data, size_t numCommands, MockCommandList& commandList);
+};
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestIndirectDrawList::Run() {
+	// layout
+	IndirectDrawList drawList;
+	if (drawList.GetStride() != sizeof(gxapi::DrawIndexedArguments) || sizeof(gxapi::DrawIndexedArguments) != 20) {
+		cout << "Draw arguments are not laid out as the GPU reads them." << endl;
+		return 1;
+	}
+	drawList.AddConstants(3, 2);
+	drawList.AddConstants(1, 1, 4);
+	if (drawList.GetStride() != 3 * sizeof(uint32_t) + 20 || !drawList.HasConstants()) {
+		cout << "Constants are not laid out before the draw arguments." << endl;
+		return 1;
+	}
+
+	gxapi::CommandSignatureDesc signature = drawList.GetSignatureDesc();
+	if (signature.byteStride != drawList.GetStride()
+		|| signature.arguments.size() != 3
+		|| signature.arguments[0].type != gxapi::eIndirectArgumentType::CONSTANT || signature.arguments[0].rootParameterIndex != 3 || signature.arguments[0].numValues != 2
+		|| signature.arguments[1].destOffset != 4
+		|| signature.arguments[2].type != gxapi::eIndirectArgumentType::DRAW_INDEXED)
+	{
+		cout << "Signature does not describe the layout." << endl;
+		return 1;
+	}
+	unsigned argumentsSize = 0;
+	for (const auto& argument : signature.arguments) {
+		argumentsSize += argument.Size();
+	}
+	if (argumentsSize != signature.byteStride) {
+		cout << "Signature arguments do not add up to the stride." << endl;
+		return 1;
+	}
+
+	// constants can't change the layout of packed draws
+	uint32_t values[3] = { 1, 2, 3 };
+	drawList.AddDraw({ 3, 1, 0, 0, 0 }, values);
+	try {
+		drawList.AddConstants(0, 1);
+		cout << "Constants were added after draws." << endl;
+		return 1;
+	}
+	catch (std::logic_error&) {}
+	drawList.Clear();
+	if (!drawList.IsEmpty() || drawList.GetDrawCount() != 0 || !drawList.HasConstants()) {
+		cout << "Clear does not remove only the draws." << endl;
+		return 1;
+	}
+
+	// constants from a binder, only inline ones can be set
+	MockGraphicsApi graphicsApi;
+	BindParameterDesc inlineDesc, bufferDesc;
+	inlineDesc.parameter = BindParameter(eBindParameterType::CONSTANT, 0);
+	inlineDesc.constantSize = 16;
+	bufferDesc.parameter = BindParameter(eBindParameterType::CONSTANT, 1);
+	bufferDesc.constantSize = 0;
+	Binder binder(&graphicsApi, { inlineDesc, bufferDesc });
+
+	IndirectDrawList binderDrawList;
+	binderDrawList.AddConstants(binder, inlineDesc.parameter);
+	int rootParamIndex, rootTableIndex;
+	binder.Translate(inlineDesc.parameter, rootParamIndex, rootTableIndex);
+	if (binderDrawList.GetStride() != 16 + 20 || binderDrawList.GetSignatureDesc().arguments[0].rootParameterIndex != (unsigned)rootParamIndex) {
+		cout << "Binder constant is not set by the draws." << endl;
+		return 1;
+	}
+	try {
+		binderDrawList.AddConstants(binder, bufferDesc.parameter);
+		cout << "Constant buffer view was accepted as draw constants." << endl;
+		return 1;
+	}
+	catch (std::invalid_argument&) {}
+
+	// the packed buffer replays to the same draws as direct calls
+	std::mt19937 rne(47);
+	std::uniform_int_distribution<unsigned> rng(0, 100000);
+	std::vector<Draw> draws;
+	MockCommandList directList;
+	for (int i = 0; i < 1000; ++i) {
+		Draw draw{ { rng(rne), rng(rne) % 8 + 1, rng(rne), int32_t(rng(rne)) - 50000, 0 }, { rng(rne), rng(rne), rng(rne) } };
+		drawList.AddDraw(draw.arguments, draw.constants.data());
+		draws.push_back(draw);
+
+		directList.SetGraphicsRootConstants(3, 0, 2, draw.constants.data());
+		directList.SetGraphicsRootConstants(1, 4, 1, draw.constants.data() + 2);
+		directList.DrawIndexedInstanced(draw.arguments.numIndices, draw.arguments.startIndex, draw.arguments.vertexOffset, draw.arguments.numInstances, draw.arguments.startInstance);
+	}
+	if (drawList.GetDrawCount() != draws.size() || drawList.GetSize() != draws.size() * drawList.GetStride()) {
+		cout << "Draw count is wrong." << endl;
+		return 1;
+	}
+
+	std::unique_ptr<gxapi::ICommandSignature> commandSignature(graphicsApi.CreateCommandSignature(drawList.GetSignatureDesc(), binder.GetRootSignature()));
+	MockCommandList indirectList;
+	indirectList.ExecuteIndirect(commandSignature.get(), (unsigned)drawList.GetDrawCount(), nullptr, 0, nullptr, 0);
+	if (graphicsApi.commandSignatureCount != 1 || indirectList.Count("ExecuteIndirect") != 1 || indirectList.History().size() != 1) {
+		cout << "Draws are not submitted with a single call." << endl;
+		return 1;
+	}
+
+	MockCommandList replayList;
+	const gxapi::CommandSignatureDesc& createdSignature = static_cast<MockCommandSignature*>(commandSignature.get())->desc;
+	std::vector<Draw> replayed = Replay(createdSignature, drawList.GetData(), drawList.GetDrawCount(), replayList);
+	if (replayList.History() != directList.History()) {
+		cout << "Replayed commands differ from direct calls." << endl;
+		return 1;
+	}
+	for (size_t i = 0; i < draws.size(); ++i) {
+		const gxapi::DrawIndexedArguments& a = draws[i].arguments;
+		const gxapi::DrawIndexedArguments& b = replayed[i].arguments;
+		if (a.numIndices != b.numIndices || a.numInstances != b.numInstances || a.startIndex != b.startIndex
+			|| a.vertexOffset != b.vertexOffset || a.startInstance != b.startInstance
+			|| draws[i].constants != replayed[i].constants)
+		{
+			cout << "Replayed draw " << i << " differs from the packed one." << endl;
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+
+auto TestIndirectDrawList::Replay(const gxapi::CommandSignatureDesc& signature, const uint8_t* data, size_t numCommands, MockCommandList& commandList) -> std::vector<Draw> {
+	std::vector<Draw> draws;
+	for (size_t command = 0; command < numCommands; ++command) {
+		const uint8_t* arguments = data + command * signature.byteStride;
+		Draw draw;
+		for (const gxapi::IndirectArgumentDesc& argument : signature.arguments) {
+			switch (argument.type) {
+				case gxapi::eIndirectArgumentType::CONSTANT: {
+					std::vector<uint32_t> values(argument.numValues);
+					std::memcpy(values.data(), arguments, argument.Size());
+					commandList.SetGraphicsRootConstants(argument.rootParameterIndex, argument.destOffset, argument.numValues, values.data());
+					draw.constants.insert(draw.constants.end(), values.begin(), values.end());
+					break;
+				}
+				case gxapi::eIndirectArgumentType::DRAW_INDEXED: {
+					std::memcpy(&draw.arguments, arguments, argument.Size());
+					const gxapi::DrawIndexedArguments& a = draw.arguments;
+					commandList.DrawIndexedInstanced(a.numIndices, a.startIndex, a.vertexOffset, a.numInstances, a.startInstance);
+					break;
+				}
+				default:
+					break;
+			}
+			arguments += argument.Size();
+		}
+		draws.push_back(draw);
+	}
+	return draws;
+}
@@ -0,0 +1,182 @@
+#include "Test.hpp"
+
+#include <GraphicsEngine_LL/LightClusters.hpp>
+#include <GraphicsEngine_LL/PointLight.hpp>
+#include <GraphicsEngine_LL/SpotLight.hpp>
+#include <GraphicsEngine_LL/Camera.hpp>
+
+#include <iostream>
+#include <random>
+#include <memory>
+#include <algorithm>
+#include <cmath>
+
+using std::cout;
+using std::endl;
+
+using namespace inl;
+using namespace inl::gxeng;
+
+using Vec3 = mathfu::Vector<float, 3>;
+using Vec4 = mathfu::Vector<float, 4>;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestLightClusters : public AutoRegisterTest<TestLightClusters> {
+public:
+	static std::string Name() {
+		return "LightClusters";
+	}
+	virtual int Run() override;
+private:
+	static bool IsListed(const LightClusters& clusters, size_t cluster, uint32_t light);
+	static bool IsCompact(const LightClusters& clusters);
+};
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+bool TestLightClusters::IsListed(const LightClusters& clusters, size_t cluster, uint32_t light) {
+	auto first = clusters.GetLightIndices().begin() + clusters.GetOffsets()[cluster];
+	auto last = first + clusters.GetCounts()[cluster];
+	return std::find(first, last, light) != last;
+}
+
+
+bool TestLightClusters::IsCompact(const LightClusters& clusters) {
+	size_t offset = 0;
+	for (size_t i = 0; i < clusters.GetNumClusters(); ++i) {
+		if (clusters.GetOffsets()[i] != offset) {
+			return false;
+		}
+		offset += clusters.GetCounts()[i];
+	}
+	return offset == clusters.GetLightIndices().size();
+}
+
+
+int TestLightClusters::Run() {
+	Camera camera;
+	camera.SetPosition({ 0, 0, 2 });
+	camera.SetLookDirection({ 0, 1, 0 });
+	camera.SetUpVector({ 0, 0, 1 });
+	camera.SetFOVAspect(1.4f, 16.0f / 9.0f);
+	camera.SetNearPlane(0.2f);
+	camera.SetFarPlane(200.0f);
+	mathfu::Matrix<float, 4, 4> view = camera.GetViewMatrixRH();
+	mathfu::Matrix<float, 4, 4> inverseView = view.Inverse();
+
+	LightClusters clusters(16, 8, 16);
+
+	// slices grow exponentially and cover the view range
+	clusters.Build(camera, {}, {});
+	if (clusters.SliceOf(0.2f) != 0 || clusters.SliceOf(199.0f) != 15 || clusters.SliceOf(1000.0f) != 15) {
+		cout << "Slices do not cover the view range." << endl;
+		return 1;
+	}
+	Aabb nearBox = clusters.ClusterBounds(clusters.ClusterIndex(0, 0, 1));
+	Aabb farBox = clusters.ClusterBounds(clusters.ClusterIndex(0, 0, 14));
+	if (nearBox.max.z() - nearBox.min.z() >= farBox.max.z() - farBox.min.z()
+		|| clusters.SliceOf(-nearBox.max.z() * 1.001f) != 1 || clusters.SliceOf(-nearBox.min.z() * 0.999f) != 1) {
+		cout << "Slices are not exponential." << endl;
+		return 1;
+	}
+	if (!clusters.GetLightIndices().empty() || !IsCompact(clusters)) {
+		cout << "Clusters without lights are not empty." << endl;
+		return 1;
+	}
+
+	// a small light lights up a few clusters, a light behind the camera none
+	PointLight smallLight({ 1, 20, 2 }, { 1, 1, 1 }, 1.0f);
+	PointLight behindLight({ 0, -10, 2 }, { 1, 1, 1 }, 5.0f);
+	clusters.Build(camera, { &smallLight, &behindLight }, {});
+	size_t smallLightClusters = std::count(clusters.GetLightIndices().begin(), clusters.GetLightIndices().end(), 0u);
+	if (smallLightClusters == 0 || smallLightClusters > 16 || std::count(clusters.GetLightIndices().begin(), clusters.GetLightIndices().end(), 1u) != 0) {
+		cout << "Lights are not binned into the clusters they reach." << endl;
+		return 1;
+	}
+
+	// a narrow spot light reaches fewer clusters than a point light of the same range
+	PointLight roundLight({ 0, 10, 2 }, { 1, 1, 1 }, 4.0f);
+	SpotLight narrowLight({ 0, 10, 2 }, { 1, 0, 0 }, { 1, 1, 1 }, 4.0f, 0.3f);
+	clusters.Build(camera, { &roundLight }, { &narrowLight });
+	size_t roundLightClusters = std::count(clusters.GetLightIndices().begin(), clusters.GetLightIndices().end(), 0u);
+	size_t narrowLightClusters = std::count(clusters.GetLightIndices().begin(), clusters.GetLightIndices().end(), 1u);
+	if (narrowLightClusters == 0 || narrowLightClusters * 2 >= roundLightClusters) {
+		cout << "Spot lights are not culled by their cone." << endl;
+		return 1;
+	}
+
+	// many lights: every point a light reaches must be in a cluster that lists the light
+	std::mt19937 rne(43);
+	std::uniform_real_distribution<float> rngX(-60.0f, 60.0f), rngY(-5.0f, 120.0f), rngZ(-5.0f, 15.0f);
+	std::uniform_real_distribution<float> rngRange(0.5f, 8.0f), rngAngle(0.1f, 1.5f), rngUnit(-1.0f, 1.0f);
+	std::vector<std::unique_ptr<PointLight>> pointLights;
+	std::vector<std::unique_ptr<SpotLight>> spotLights;
+	std::vector<const PointLight*> pointLightPtrs;
+	std::vector<const SpotLight*> spotLightPtrs;
+	for (int i = 0; i < 1500; ++i) {
+		pointLights.push_back(std::make_unique<PointLight>(Vec3{ rngX(rne), rngY(rne), rngZ(rne) }, Vec3{ 1, 1, 1 }, rngRange(rne)));
+		pointLightPtrs.push_back(pointLights.back().get());
+	}
+	for (int i = 0; i < 1500; ++i) {
+		Vec3 direction = { rngUnit(rne), rngUnit(rne), rngUnit(rne) + 0.01f };
+		spotLights.push_back(std::make_unique<SpotLight>(Vec3{ rngX(rne), rngY(rne), rngZ(rne) }, direction, Vec3{ 1, 1, 1 }, rngRange(rne), rngAngle(rne)));
+		spotLightPtrs.push_back(spotLights.back().get());
+	}
+	clusters.Build(camera, pointLightPtrs, spotLightPtrs);
+	if (!IsCompact(clusters)) {
+		cout << "Light lists are not compact." << endl;
+		return 1;
+	}
+	if (clusters.GetLightIndices().size() >= clusters.GetNumClusters() * 3000 / 10) {
+		cout << "Lights are listed in far too many clusters." << endl;
+		return 1;
+	}
+
+	const float tanHalfFovX = 1.0f / camera.GetPerspectiveMatrixRH()(0, 0);
+	const float tanHalfFovY = 1.0f / camera.GetPerspectiveMatrixRH()(1, 1);
+	std::uniform_real_distribution<float> rngNdc(-0.999f, 0.999f), rngLogDistance(std::log(0.2f), std::log(200.0f));
+	for (int sample = 0; sample < 20000; ++sample) {
+		float ndcX = rngNdc(rne), ndcY = rngNdc(rne), distance = std::exp(rngLogDistance(rne));
+		Vec4 viewPoint = { ndcX * distance * tanHalfFovX, ndcY * distance * tanHalfFovY, -distance, 1 };
+		Vec3 point = (inverseView * viewPoint).xyz();
+
+		unsigned tileX = std::min(15u, unsigned((ndcX + 1.0f) * 0.5f * 16));
+		unsigned tileY = std::min(7u, unsigned((1.0f - ndcY) * 0.5f * 8));
+		size_t cluster = clusters.ClusterIndex(tileX, tileY, clusters.SliceOf(distance));
+
+		for (uint32_t i = 0; i < pointLights.size(); ++i) {
+			if ((point - pointLights[i]->GetPosition()).Length() < pointLights[i]->GetRange() * 0.999f && !IsListed(clusters, cluster, i)) {
+				cout << "Point light is missing from a cluster it reaches." << endl;
+				return 1;
+			}
+		}
+		for (uint32_t i = 0; i < spotLights.size(); ++i) {
+			Vec3 toPoint = point - spotLights[i]->GetPosition();
+			float length = toPoint.Length();
+			bool inCone = Vec3::DotProduct(toPoint, spotLights[i]->GetDirection()) > length * std::cos(spotLights[i]->GetAngle() * 0.999f);
+			if (length < spotLights[i]->GetRange() * 0.999f && inCone && !IsListed(clusters, cluster, uint32_t(pointLights.size() + i))) {
+				cout << "Spot light is missing from a cluster it reaches." << endl;
+				return 1;
+			}
+		}
+	}
+
+	// the index list is cut short when it does not fit
+	size_t fullSize = clusters.GetLightIndices().size();
+	clusters.Build(camera, pointLightPtrs, spotLightPtrs, fullSize / 2);
+	if (clusters.GetLightIndices().size() != fullSize / 2 || !IsCompact(clusters)) {
+		cout << "Light lists were not cut to the capacity." << endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -70,6 +70,47 @@ int TestMaterialShader::Run() {
 	std::string shaderCode = graph.GetShaderCode(*(ShaderManager*)nullptr);
 	cout << shaderCode << endl;
 
+	// an identical graph must produce identical code, from the cache
+	std::vector<std::unique_ptr<MaterialShader>> sameNodes;
+	sameNodes.push_back(std::unique_ptr<MaterialShader>(new MaterialShaderEquation(mapNode)));
+	sameNodes.push_back(std::unique_ptr<MaterialShader>(new MaterialShaderEquation(darkenNode)));
+	sameNodes.push_back(std::unique_ptr<MaterialShader>(new MaterialShaderEquation(darkenNode)));
+	sameNodes.push_back(std::unique_ptr<MaterialShader>(new MaterialShaderEquation(shaderNode)));
+	MaterialShaderGraph sameGraph;
+	sameGraph.SetGraph(std::move(sameNodes), {
+		{ 0, 1, 0 },
+		{ 0, 2, 0 },
+		{ 1, 3, 0 },
+		{ 2, 3, 1 },
+	});
+	if (sameGraph.GetShaderCode(*(ShaderManager*)nullptr) != shaderCode) {
+		cout << "Identical graphs generated different code." << endl;
+		return 1;
+	}
+
+	// comments, modifiers, semantics and identifiers containing "main" must not confuse the parser
+	std::string trickyShader =
+		"// float main(float x) { \n"
+		"float domain_main; \n"
+		"/* float4 main() { */ \n"
+		"float4 main(in const float4 color : COLOR0, MapValue2D mask, float weights[2]) : SV_Target { \n"
+		"    return color * domain_main; \n"
+		"}";
+	eMaterialShaderParamType trickyReturn;
+	std::vector<eMaterialShaderParamType> trickyParams;
+	ExtractShaderParameters(trickyShader, trickyReturn, trickyParams);
+	if (trickyReturn != eMaterialShaderParamType::COLOR
+		|| trickyParams != std::vector<eMaterialShaderParamType>{ eMaterialShaderParamType::COLOR, eMaterialShaderParamType::MAP_VALUE_2D, eMaterialShaderParamType::VALUE })
+	{
+		cout << "Shader parameters were not extracted correctly." << endl;
+		return 1;
+	}
+	std::string renamed = RenameHlslIdentifier(trickyShader, TokenizeHlsl(trickyShader), "main", "mtl_shader");
+	if (renamed.find("float4 mtl_shader(") == renamed.npos || renamed.find("domain_main") == renamed.npos || renamed.find("// float main(") == renamed.npos) {
+		cout << "Renaming touched more than the function's name." << endl;
+		return 1;
+	}
+
 
 	std::string code = inl::gxeng::MaterialGenPixelShader(shaderCode);
 	cout << "---------------------------" << endl;
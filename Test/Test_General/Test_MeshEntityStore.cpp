@@ -0,0 +1,100 @@
+#include "Test.hpp"
+
+#include <GraphicsEngine_LL/MeshEntityStore.hpp>
+#include <GraphicsEngine_LL/MeshEntity.hpp>
+#include <GraphicsEngine_LL/EntityCollection.hpp>
+
+#include <iostream>
+#include <memory>
+
+using std::cout;
+using std::endl;
+
+using namespace inl;
+using namespace inl::gxeng;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestMeshEntityStore : public AutoRegisterTest<TestMeshEntityStore> {
+public:
+	static std::string Name() {
+		return "MeshEntityStore";
+	}
+	virtual int Run() override;
+};
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestMeshEntityStore::Run() {
+	auto store = std::make_shared<MeshEntityStore>();
+
+	// entity x is at position (x, 0, 0)
+	std::vector<std::unique_ptr<MeshEntity>> entities;
+	for (int i = 0; i < 1000; ++i) {
+		entities.push_back(std::make_unique<MeshEntity>(store));
+		entities.back()->SetPosition({ (float)i, 0, 0 });
+	}
+
+	// destroying from the middle keeps the others' data, and the array dense
+	MeshEntityHandle stale = store->HandleAt(entities[10]->GetStoreIndex());
+	entities.erase(entities.begin() + 10);
+	entities.erase(entities.begin() + 500);
+	if (store->Size() != 998 || store->IsValid(stale)) {
+		cout << "Destroyed entities are still in the store." << endl;
+		return 1;
+	}
+	for (auto& entity : entities) {
+		size_t index = entity->GetStoreIndex();
+		if (index >= store->Size() || store->Position(index) != entity->GetPosition()) {
+			cout << "Entity data got mixed up by removal." << endl;
+			return 1;
+		}
+	}
+
+	// a reused slot must not revive the old handle
+	entities.push_back(std::make_unique<MeshEntity>(store));
+	if (store->IsValid(stale) || store->Size() != 999) {
+		cout << "Stale handle refers to a new entity." << endl;
+		return 1;
+	}
+
+	// chunks cover every entity exactly once
+	size_t visited = 0;
+	float sum = 0;
+	store->ForEachChunk([&](const MeshEntityStore::Chunk& chunk) {
+		if (chunk.first != visited || chunk.count > MeshEntityStore::ChunkSize) {
+			return;
+		}
+		for (size_t i = 0; i < chunk.count; ++i) {
+			sum += chunk.positions[i].x();
+		}
+		visited += chunk.count;
+	});
+	float expectedSum = 999.f * 1000.f / 2.f - 10.f - 501.f;
+	if (visited != store->Size() || sum != expectedSum) {
+		cout << "Chunks did not cover the store." << endl;
+		return 1;
+	}
+
+	// collections stay consistent when removing from the middle
+	EntityCollection<MeshEntity> collection;
+	for (auto& entity : entities) {
+		collection.Add(entity.get());
+	}
+	collection.Remove(entities[3].get());
+	collection.Remove(entities[3].get());
+	if (collection.Size() != entities.size() - 1 || collection.Contains(entities[3].get()) || !collection.Contains(entities.back().get())) {
+		cout << "Entity collection is inconsistent after removal." << endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,224 @@
+#include "Test.hpp"
+
+#include <GraphicsEngine_LL/Meshlets.hpp>
+#include <GraphicsEngine_LL/Camera.hpp>
+
+#include <iostream>
+#include <random>
+#include <array>
+#include <algorithm>
+#include <cmath>
+
+using std::cout;
+using std::endl;
+
+using namespace inl;
+using namespace inl::gxeng;
+
+using Vec3 = mathfu::Vector<float, 3>;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestMeshlets : public AutoRegisterTest<TestMeshlets> {
+public:
+	static std::string Name() {
+		return "Meshlets";
+	}
+	virtual int Run() override;
+private:
+	static void MakeSphere(unsigned rings, unsigned segments, std::vector<Vec3>& positions, std::vector<unsigned>& indices);
+	static std::array<unsigned, 3> Canonical(unsigned a, unsigned b, unsigned c);
+};
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+void TestMeshlets::MakeSphere(unsigned rings, unsigned segments, std::vector<Vec3>& positions, std::vector<unsigned>& indices) {
+	const float pi = 3.14159265f;
+	for (unsigned i = 0; i <= rings; ++i) {
+		for (unsigned j = 0; j <= segments; ++j) {
+			float theta = pi * i / rings, phi = 2.0f * pi * j / segments;
+			positions.push_back({ std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta) });
+		}
+	}
+	// counter-clockwise seen from outside, the rings at the poles are degenerate
+	for (unsigned i = 0; i < rings; ++i) {
+		for (unsigned j = 0; j < segments; ++j) {
+			unsigned v = i * (segments + 1) + j;
+			unsigned below = v + segments + 1;
+			indices.insert(indices.end(), { v, below, v + 1, below, below + 1, v + 1 });
+		}
+	}
+}
+
+
+std::array<unsigned, 3> TestMeshlets::Canonical(unsigned a, unsigned b, unsigned c) {
+	// same triangle with the same winding, starting at the smallest index
+	if (b < a && b < c) {
+		return { b, c, a };
+	}
+	if (c < a && c < b) {
+		return { c, a, b };
+	}
+	return { a, b, c };
+}
+
+
+int TestMeshlets::Run() {
+	std::vector<Vec3> positions;
+	std::vector<unsigned> indices;
+	MakeSphere(200, 400, positions, indices);
+
+	Meshlets meshlets;
+	try {
+		meshlets.Build(positions.data(), positions.size(), indices.data(), indices.size() - 1);
+		cout << "Partial triangles were accepted." << endl;
+		return 1;
+	}
+	catch (std::invalid_argument&) {}
+	try {
+		meshlets.Build(positions.data(), positions.size(), indices.data(), indices.size(), 300, 124);
+		cout << "Too many vertices per meshlet were accepted." << endl;
+		return 1;
+	}
+	catch (std::invalid_argument&) {}
+
+	meshlets.Build(positions.data(), positions.size(), indices.data(), indices.size());
+	const std::vector<Meshlet>& list = meshlets.GetMeshlets();
+	const std::vector<uint32_t>& vertices = meshlets.GetVertices();
+	const std::vector<uint8_t>& triangles = meshlets.GetTriangles();
+	const std::vector<uint16_t>& drawIndices = meshlets.GetDrawIndices();
+
+	// every triangle ends up in exactly one meshlet, both as local and as draw indices
+	std::vector<std::array<unsigned, 3>> expected, local, drawn;
+	for (size_t i = 0; i < indices.size(); i += 3) {
+		expected.push_back(Canonical(indices[i], indices[i + 1], indices[i + 2]));
+	}
+	size_t meshletVertices = 0;
+	std::vector<uint32_t> bases;
+	for (const Meshlet& meshlet : list) {
+		if (meshlet.numVertices > 64 || meshlet.numTriangles > 124 || meshlet.numTriangles == 0) {
+			cout << "Meshlet is out of its limits." << endl;
+			return 1;
+		}
+		meshletVertices += meshlet.numVertices;
+		if (bases.empty() || bases.back() != meshlet.baseVertex) {
+			bases.push_back(meshlet.baseVertex);
+		}
+		for (uint32_t i = meshlet.firstVertex; i < meshlet.firstVertex + meshlet.numVertices; ++i) {
+			if ((positions[vertices[i]] - meshlet.bounds.center).Length() > meshlet.bounds.radius * 1.0001f) {
+				cout << "Meshlet bounds do not contain its vertices." << endl;
+				return 1;
+			}
+		}
+		for (uint32_t t = meshlet.firstTriangle; t < meshlet.firstTriangle + meshlet.numTriangles; ++t) {
+			std::array<unsigned, 3> fromLocal, fromDraw;
+			for (unsigned k = 0; k < 3; ++k) {
+				if (triangles[3 * t + k] >= meshlet.numVertices) {
+					cout << "Local index is outside its meshlet." << endl;
+					return 1;
+				}
+				fromLocal[k] = vertices[meshlet.firstVertex + triangles[3 * t + k]];
+				fromDraw[k] = vertices[meshlet.baseVertex + drawIndices[3 * t + k]];
+			}
+			local.push_back(Canonical(fromLocal[0], fromLocal[1], fromLocal[2]));
+			drawn.push_back(Canonical(fromDraw[0], fromDraw[1], fromDraw[2]));
+		}
+	}
+	std::sort(expected.begin(), expected.end());
+	std::sort(local.begin(), local.end());
+	std::sort(drawn.begin(), drawn.end());
+	if (local != expected || drawn != expected || meshletVertices != vertices.size()) {
+		cout << "Meshlets do not hold the mesh's triangles." << endl;
+		return 1;
+	}
+
+	// large meshes keep 16-bit indices by switching base vertices, meshlets are well filled
+	if (positions.size() <= 0xFFFF || bases.size() < 2 || meshlets.GetDraws().size() != bases.size()) {
+		cout << "Meshlets of a large mesh do not switch base vertices." << endl;
+		return 1;
+	}
+	if (vertices.size() > 2 * positions.size() || list.size() * 64 > indices.size() / 3) {
+		cout << "Meshlets are poorly filled: " << list.size() << " meshlets, " << vertices.size() << " vertices." << endl;
+		return 1;
+	}
+	std::vector<MeshletDraw> draws;
+	meshlets.Cull(Frustum{}, nullptr, draws);
+	size_t drawnIndices = 0;
+	for (const MeshletDraw& draw : draws) {
+		drawnIndices += draw.numIndices;
+	}
+	if (draws.size() != bases.size() || drawnIndices != drawIndices.size()) {
+		cout << "Visible meshlets are not merged into one draw per base vertex." << endl;
+		return 1;
+	}
+
+	// meshlets culled as facing away only have triangles that face away
+	std::mt19937 rne(45);
+	std::uniform_real_distribution<float> rngUnit(-1.0f, 1.0f), rngDistance(1.2f, 20.0f);
+	for (int sample = 0; sample < 50; ++sample) {
+		Vec3 eye = Vec3{ rngUnit(rne), rngUnit(rne), rngUnit(rne) }.Normalized() * rngDistance(rne);
+		meshlets.Cull(Frustum{}, &eye, draws);
+		std::vector<bool> kept(indices.size() / 3, false);
+		size_t keptTriangles = 0;
+		for (const MeshletDraw& draw : draws) {
+			std::fill(kept.begin() + draw.firstIndex / 3, kept.begin() + (draw.firstIndex + draw.numIndices) / 3, true);
+			keptTriangles += draw.numIndices / 3;
+		}
+		for (const Meshlet& meshlet : list) {
+			for (uint32_t t = meshlet.firstTriangle; t < meshlet.firstTriangle + meshlet.numTriangles && !kept[t]; ++t) {
+				Vec3 a = positions[vertices[meshlet.firstVertex + triangles[3 * t]]];
+				Vec3 b = positions[vertices[meshlet.firstVertex + triangles[3 * t + 1]]];
+				Vec3 c = positions[vertices[meshlet.firstVertex + triangles[3 * t + 2]]];
+				Vec3 normal = Vec3::CrossProduct(b - a, c - a);
+				if (Vec3::DotProduct(normal, a - eye) < -1e-7f) {
+					cout << "A culled meshlet has a triangle facing the eye." << endl;
+					return 1;
+				}
+			}
+		}
+		if (keptTriangles * 10 > kept.size() * 8) {
+			cout << "Too few meshlets facing away were culled." << endl;
+			return 1;
+		}
+	}
+
+	// meshlets outside the view are culled, mirrored instances do not cull by facing
+	Camera camera;
+	camera.SetPosition({ 0, -3, 0 });
+	camera.SetLookDirection({ 0, 1, 0 });
+	camera.SetUpVector({ 0, 0, 1 });
+	camera.SetFOVAspect(0.3f, 1.0f);
+	camera.SetNearPlane(0.1f);
+	camera.SetFarPlane(10.0f);
+	mathfu::Matrix<float, 4, 4> viewProjection = camera.GetPerspectiveMatrixRH() * camera.GetViewMatrixRH();
+	mathfu::Matrix<float, 4, 4> identity = mathfu::Matrix<float, 4, 4>::Identity();
+	Vec3 eye = camera.GetPosition();
+	std::vector<MeshletDraw> frustumDraws, mirroredDraws, mirroredFrustumDraws;
+	meshlets.Cull(viewProjection, identity, nullptr, frustumDraws);
+	meshlets.Cull(viewProjection, identity, &eye, draws);
+	mathfu::Matrix<float, 4, 4> mirror = mathfu::Matrix<float, 4, 4>::FromScaleVector({ 1, 1, -1 });
+	meshlets.Cull(viewProjection * mirror, mirror, &eye, mirroredDraws);
+	meshlets.Cull(viewProjection * mirror, mirror, nullptr, mirroredFrustumDraws);
+	auto countIndices = [](const std::vector<MeshletDraw>& draws) {
+		size_t count = 0;
+		for (const MeshletDraw& draw : draws) {
+			count += draw.numIndices;
+		}
+		return count;
+	};
+	if (countIndices(frustumDraws) * 2 > drawIndices.size() || countIndices(draws) >= countIndices(frustumDraws)
+		|| countIndices(mirroredDraws) != countIndices(mirroredFrustumDraws)) {
+		cout << "Meshlets are not culled by the instance's view." << endl;
+		return 1;
+	}
+
+	return 0;
+}
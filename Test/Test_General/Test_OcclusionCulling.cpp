@@ -0,0 +1,97 @@
+#include "Test.hpp"
+
+#include <GraphicsEngine_LL/OcclusionCulling.hpp>
+
+#include <iostream>
+#include <cmath>
+
+using std::cout;
+using std::endl;
+
+using namespace inl;
+using namespace inl::gxeng;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestOcclusionCulling : public AutoRegisterTest<TestOcclusionCulling> {
+public:
+	static std::string Name() {
+		return "OcclusionCulling";
+	}
+	virtual int Run() override;
+};
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestOcclusionCulling::Run() {
+	using Vec3 = mathfu::Vector<float, 3>;
+	using Mat4 = mathfu::Matrix<float, 4, 4>;
+
+	// camera at the origin looking down -Z, like a right handed view matrix does
+	Mat4 viewProjection = Mat4::Perspective(1.2f, 16.f / 9.f, 0.5f, 1000.f, 1.0f);
+
+	// a wall at z = -10, 8 wide and 4 high, facing away from the camera to check that back faces are drawn
+	Vec3 wall[4] = { { -4, -2, -10 },{ 4, -2, -10 },{ 4, 2, -10 },{ -4, 2, -10 } };
+	unsigned indices[6] = { 0, 2, 1, 0, 3, 2 };
+
+	OcclusionBuffer buffer(256, 140);
+	if (buffer.GetWidth() != 256 || buffer.GetHeight() != 144) {
+		cout << "Buffer is not rounded up to whole tiles." << endl;
+		return 1;
+	}
+	buffer.RasterizeOccluder(wall, 4, indices, 6, viewProjection);
+	buffer.UpdateHierarchy();
+
+	// the wall's depth is in the middle of the screen
+	mathfu::Vector<float, 4> wallClip = viewProjection * mathfu::Vector<float, 4>(0, 0, -10, 1);
+	float wallDepth = wallClip.z() / wallClip.w();
+	if (std::abs(buffer.GetDepth(128, 72) - wallDepth) > 1e-4f || buffer.GetDepth(0, 0) != 1.0f) {
+		cout << "Wall is not drawn at the right depth." << endl;
+		return 1;
+	}
+
+	auto box = [](Vec3 center, float halfSize) {
+		Aabb aabb;
+		aabb.min = center - Vec3(halfSize);
+		aabb.max = center + Vec3(halfSize);
+		return aabb;
+	};
+
+	if (!buffer.IsOccluded(box({ 0, 0, -50 }, 2), viewProjection)) {
+		cout << "Box behind the wall is not occluded." << endl;
+		return 1;
+	}
+	if (buffer.IsOccluded(box({ 0, 0, -5 }, 1), viewProjection)) {
+		cout << "Box in front of the wall is occluded." << endl;
+		return 1;
+	}
+	if (buffer.IsOccluded(box({ 30, 0, -50 }, 2), viewProjection)) {
+		cout << "Box beside the wall is occluded." << endl;
+		return 1;
+	}
+	if (buffer.IsOccluded(box({ 0, 0, -50 }, 12), viewProjection)) {
+		cout << "Box larger than the wall is occluded." << endl;
+		return 1;
+	}
+	if (buffer.IsOccluded(box({ 0, 0, 0 }, 1), viewProjection)) {
+		cout << "Box around the camera is occluded." << endl;
+		return 1;
+	}
+
+	buffer.Clear();
+	buffer.UpdateHierarchy();
+	if (buffer.IsOccluded(box({ 0, 0, -50 }, 2), viewProjection)) {
+		cout << "Box is occluded by a cleared buffer." << endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,70 @@
+#include "Test.hpp"
+
+#include <GraphicsEngine_LL/ParallelRecording.hpp>
+
+#include <iostream>
+
+using std::cout;
+using std::endl;
+
+using namespace inl;
+using namespace inl::gxeng;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestParallelRecording : public AutoRegisterTest<TestParallelRecording> {
+public:
+	static std::string Name() {
+		return "ParallelRecording";
+	}
+	virtual int Run() override;
+};
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestParallelRecording::Run() {
+	// nothing to record needs no lists
+	if (!SplitRecording(0, 256, 8).empty()) {
+		cout << "Empty range was split into chunks." << endl;
+		return 1;
+	}
+
+	// small ranges are recorded into one list
+	auto chunks = SplitRecording(300, 256, 8);
+	if (chunks.size() != 1 || chunks[0].first != 0 || chunks[0].end != 300) {
+		cout << "Small range was split." << endl;
+		return 1;
+	}
+
+	// chunks cover the range in order, are not too small, and there are not too many of them
+	for (size_t count : { 511, 512, 1000, 20000, 20001 }) {
+		chunks = SplitRecording(count, 256, 8);
+		size_t expectedChunks = std::min<size_t>(8, count / 256);
+		if (chunks.size() != expectedChunks) {
+			cout << "Wrong number of chunks." << endl;
+			return 1;
+		}
+		size_t covered = 0;
+		for (const auto& chunk : chunks) {
+			if (chunk.first != covered || chunk.end - chunk.first < 256 || chunk.end - chunk.first > count / chunks.size() + 1) {
+				cout << "Chunks are uneven or do not cover the range." << endl;
+				return 1;
+			}
+			covered = chunk.end;
+		}
+		if (covered != count) {
+			cout << "Chunks do not cover the range." << endl;
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,118 @@
+#include "Test.hpp"
+#include "MockGraphicsApi.hpp"
+
+#include <GraphicsEngine_LL/PipelineStateCache.hpp>
+#include <GraphicsEngine_LL/RootSignatureCache.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+
+using std::cout;
+using std::endl;
+
+using namespace inl;
+using namespace inl::gxeng;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestPipelineStateCache : public AutoRegisterTest<TestPipelineStateCache> {
+public:
+	static std::string Name() {
+		return "PipelineStateCache";
+	}
+	virtual int Run() override;
+};
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestPipelineStateCache::Run() {
+	MockGraphicsApi gxApi;
+	auto rootSignature = RootSignatureCache::Get(&gxApi, gxapi::RootSignatureDesc{});
+
+	const uint8_t vsCode[] = { 1, 2, 3, 4 };
+	const uint8_t psCode[] = { 5, 6, 7, 8 };
+	const uint8_t otherPsCode[] = { 5, 6, 7, 9 };
+
+	gxapi::GraphicsPipelineStateDesc desc;
+	desc.rootSignature = rootSignature.get();
+	desc.vs = { vsCode, sizeof(vsCode) };
+	desc.ps = { psCode, sizeof(psCode) };
+	desc.primitiveTopologyType = gxapi::ePrimitiveTopologyType::TRIANGLE;
+
+	const std::string cacheFile = "Test_PipelineStateCache.bin";
+
+	{
+		PipelineStateCache cache(&gxApi);
+
+		auto pso1 = cache.Get(desc);
+		auto pso2 = cache.Get(desc);
+		if (pso1 != pso2 || gxApi.pipelineStateCount != 1) {
+			cout << "Identical descriptions did not share the PSO." << endl;
+			return 1;
+		}
+
+		// different bytecode must not hit
+		desc.ps = { otherPsCode, sizeof(otherPsCode) };
+		auto pso3 = cache.Get(desc);
+		desc.ps = { psCode, sizeof(psCode) };
+		if (pso3 == pso1 || gxApi.pipelineStateCount != 2) {
+			cout << "Different shaders resulted in the same PSO." << endl;
+			return 1;
+		}
+
+		cache.Save(cacheFile);
+	}
+
+	{
+		PipelineStateCache cache(&gxApi);
+		if (!cache.Load(cacheFile) || cache.GetNumBlobs() != 2) {
+			cout << "Cache file was not loaded back." << endl;
+			return 1;
+		}
+		cache.Get(desc);
+		if (cache.GetNumBlobs() != 2 || gxApi.cachedPipelineStateCount != 1) {
+			cout << "Loaded blob was not reused." << endl;
+			return 1;
+		}
+	}
+
+	// sizes in a damaged file must not be trusted
+	{
+		std::ofstream file(cacheFile, std::ios::binary | std::ios::trunc);
+		const uint32_t header[] = { 0x43535049, 1, 0xFFFFFFFFu };
+		file.write(reinterpret_cast<const char*>(header), sizeof(header));
+	}
+	{
+		PipelineStateCache cache(&gxApi);
+		if (cache.Load(cacheFile) || cache.GetNumBlobs() != 0) {
+			cout << "Damaged cache file was loaded." << endl;
+			return 1;
+		}
+	}
+	{
+		std::ofstream file(cacheFile, std::ios::binary | std::ios::trunc);
+		const uint32_t header[] = { 0x43535049, 1, 1, 0x7FFFFFFFu, 0, 0 };
+		file.write(reinterpret_cast<const char*>(header), sizeof(header));
+	}
+	{
+		PipelineStateCache cache(&gxApi);
+		if (cache.Load(cacheFile) || cache.GetNumBlobs() != 0) {
+			cout << "Cache file with a truncated key was loaded." << endl;
+			return 1;
+		}
+	}
+
+	std::remove(cacheFile.c_str());
+
+	cout << "PSOs created: " << gxApi.pipelineStateCount << endl;
+	return 0;
+}
@@ -0,0 +1,123 @@
+#include "Test.hpp"
+
+#include <GraphicsEngine_LL/Scene.hpp>
+#include <GraphicsEngine_LL/Mesh.hpp>
+#include <GraphicsEngine_LL/MeshEntity.hpp>
+#include <GraphicsEngine_LL/MeshEntityStore.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+
+using std::cout;
+using std::endl;
+
+using namespace inl;
+using namespace inl::gxeng;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestSceneSpatialIndex : public AutoRegisterTest<TestSceneSpatialIndex> {
+public:
+	static std::string Name() {
+		return "SceneSpatialIndex";
+	}
+	virtual int Run() override;
+};
+
+
+// Mesh whose vertices are replaced without uploading anything, like a dynamic mesh's.
+class DeformedMesh : public Mesh {
+public:
+	DeformedMesh() : Mesh(nullptr) {}
+	void SetVertices(std::vector<mathfu::Vector<float, 3>> positions) {
+		SetBounds(ComputeAabb(positions.data(), positions.size()), ComputeBoundingSphere(positions.data(), positions.size()));
+	}
+};
+
+
+static bool Contains(const std::vector<MeshEntity*>& entities, const MeshEntity* entity) {
+	return std::find(entities.begin(), entities.end(), entity) != entities.end();
+}
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestSceneSpatialIndex::Run() {
+	auto store = std::make_shared<MeshEntityStore>();
+	Scene scene;
+
+	DeformedMesh staticMesh, deformedMesh;
+	staticMesh.SetVertices({ { -1, -1, -1 }, { 1, 1, 1 } });
+	deformedMesh.SetVertices({ { -1, -1, -1 }, { 1, 1, 1 } });
+
+	// a row of entities along x, the last one uses the deformed mesh
+	std::vector<std::unique_ptr<MeshEntity>> entities;
+	for (int i = 0; i < 64; ++i) {
+		entities.push_back(std::make_unique<MeshEntity>(store));
+		entities.back()->SetPosition({ 10.f * i, 0, 0 });
+		entities.back()->SetMesh(&staticMesh);
+		scene.GetMeshEntities().Add(entities.back().get());
+	}
+	MeshEntity* deformed = entities.back().get();
+	deformed->SetMesh(&deformedMesh);
+	store->UpdateWorldMatrices();
+	scene.UpdateSpatialIndex(store->GetMovedEntities());
+
+	Aabb oldRegion, newRegion;
+	oldRegion.min = { 620, -5, -5 };
+	oldRegion.max = { 640, 5, 5 };
+	newRegion.min = { 725, -5, -5 };
+	newRegion.max = { 735, 5, 5 };
+	std::vector<MeshEntity*> found;
+	scene.QueryMeshEntities(oldRegion, found);
+	if (!Contains(found, deformed)) {
+		cout << "Entity is not found where its mesh is." << endl;
+		return 1;
+	}
+
+	// the vertices move outside the old bounds, the entity itself stays
+	deformedMesh.SetVertices({ { 99, -1, -1 }, { 101, 1, 1 } });
+	store->UpdateWorldMatrices();
+	if (!store->GetMovedEntities().empty()) {
+		cout << "Entity is reported as moved although only its mesh changed." << endl;
+		return 1;
+	}
+	scene.UpdateSpatialIndex(store->GetMovedEntities());
+
+	found.clear();
+	scene.QueryMeshEntities(newRegion, found);
+	if (!Contains(found, deformed)) {
+		cout << "Entity is culled after its mesh's vertices moved." << endl;
+		return 1;
+	}
+	found.clear();
+	scene.QueryMeshEntities(oldRegion, found);
+	if (Contains(found, deformed) || !Contains(found, entities[entities.size() - 2].get())) {
+		cout << "Index still uses the old bounds of the mesh." << endl;
+		return 1;
+	}
+
+	// switching meshes is tracked too, the old mesh changing must not matter anymore
+	deformed->SetMesh(&staticMesh);
+	store->UpdateWorldMatrices();
+	scene.UpdateSpatialIndex(store->GetMovedEntities());
+	deformedMesh.SetVertices({ { 199, -1, -1 }, { 201, 1, 1 } });
+	store->UpdateWorldMatrices();
+	scene.UpdateSpatialIndex(store->GetMovedEntities());
+	found.clear();
+	scene.QueryMeshEntities(oldRegion, found);
+	if (!Contains(found, deformed)) {
+		cout << "Entity is not found after its mesh was replaced." << endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,95 @@
+#include "Test.hpp"
+#include "MockGraphicsApi.hpp"
+
+#include <GraphicsEngine_LL/ShaderCache.hpp>
+#include <GraphicsEngine_LL/ShaderManager.hpp>
+
+#include <iostream>
+
+using std::cout;
+using std::endl;
+
+using namespace inl;
+using namespace inl::gxeng;
+
+namespace fs = std::experimental::filesystem;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestShaderCache : public AutoRegisterTest<TestShaderCache> {
+public:
+	static std::string Name() {
+		return "ShaderCache";
+	}
+	virtual int Run() override;
+};
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestShaderCache::Run() {
+	const fs::path cacheDirectory = "Test_ShaderCache";
+	fs::remove_all(cacheDirectory);
+
+	// binaries are read back as stored, also by another instance
+	const std::vector<uint8_t> stored = { 1, 2, 3, 4, 5 };
+	{
+		ShaderCache cache;
+		cache.SetDirectory(cacheDirectory);
+		cache.Store(42, stored);
+
+		std::vector<uint8_t> loaded;
+		if (!cache.Load(42, loaded) || loaded != stored) {
+			cout << "Stored binary was not loaded back." << endl;
+			return 1;
+		}
+		if (cache.Load(43, loaded)) {
+			cout << "Binary was loaded for a key that was never stored." << endl;
+			return 1;
+		}
+	}
+	{
+		ShaderCache cache;
+		cache.SetDirectory(cacheDirectory);
+		std::vector<uint8_t> loaded;
+		if (!cache.Load(42, loaded) || loaded != stored) {
+			cout << "Stored binary did not persist." << endl;
+			return 1;
+		}
+		cache.Clear();
+	}
+
+	// a shader is compiled again only when one of its includes changes
+	MockGxapiManager gxapiManager;
+	ShaderParts parts;
+	parts.ps = true;
+	auto createShader = [&](const std::string& includedCode) {
+		ShaderManager shaderManager(&gxapiManager);
+		shaderManager.SetCacheDirectory(cacheDirectory);
+		shaderManager.AddSourceCode("main", " #  include \"common.hlsl\"\n");
+		shaderManager.AddSourceCode("common", includedCode);
+		shaderManager.CreateShader("main", parts);
+	};
+
+	createShader("float4 color;");
+	createShader("float4 color;");
+	if (gxapiManager.compileCount != 1) {
+		cout << "Cached shader was compiled again." << endl;
+		return 1;
+	}
+	createShader("float3 color;");
+	if (gxapiManager.compileCount != 2) {
+		cout << "Changing an include did not invalidate the cached shader." << endl;
+		return 1;
+	}
+
+	fs::remove_all(cacheDirectory);
+	return 0;
+}
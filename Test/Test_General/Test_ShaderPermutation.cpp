@@ -0,0 +1,127 @@
+#include "Test.hpp"
+#include "MockGraphicsApi.hpp"
+
+#include <GraphicsEngine_LL/ShaderPermutationManager.hpp>
+
+#include <iostream>
+#include <future>
+#include <string>
+
+using std::cout;
+using std::endl;
+
+using namespace inl;
+using namespace inl::gxeng;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestShaderPermutation : public AutoRegisterTest<TestShaderPermutation> {
+public:
+	static std::string Name() {
+		return "ShaderPermutation";
+	}
+	virtual int Run() override;
+};
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestShaderPermutation::Run() {
+	MockGxapiManager gxapiManager;
+	ShaderManager shaderManager(&gxapiManager);
+	shaderManager.AddSourceCode("material",
+		"#ifdef NORMAL_MAP \n"
+		"#endif \n"
+		"#ifdef ALPHA_TEST \n"
+		"#endif \n");
+
+	ShaderPermutationManager permutations(&shaderManager);
+
+	// the order and the form of the definitions must not matter
+	if (permutations.GetMask("NORMAL_MAP;ALPHA_TEST") != permutations.GetMask("ALPHA_TEST=1 NORMAL_MAP")) {
+		cout << "Equivalent macro sets got different masks." << endl;
+		return 1;
+	}
+	if (permutations.GetMacros(permutations.GetMask("NORMAL_MAP ALPHA_TEST")) != "ALPHA_TEST=1 NORMAL_MAP=1") {
+		cout << "Macro string is not canonical." << endl;
+		return 1;
+	}
+
+	// hundred materials using three macro sets, two of which compile to the same code
+	const char* materialMacros[] = {
+		"NORMAL_MAP;ALPHA_TEST",
+		"ALPHA_TEST NORMAL_MAP",
+		"NORMAL_MAP",
+		"NORMAL_MAP UNUSED_FEATURE",
+	};
+	ShaderParts parts;
+	parts.vs = parts.ps = true;
+	for (int i = 0; i < 100; ++i) {
+		permutations.Request("material", parts, permutations.GetMask(materialMacros[i % 4]));
+	}
+
+	std::vector<std::string> errors;
+	if (!permutations.Precompile(errors)) {
+		cout << "Precompilation failed: " << errors[0] << endl;
+		return 1;
+	}
+	if (permutations.GetNumPermutations() != 3 || gxapiManager.compileCount != 6) {
+		cout << "Expected 3 permutations in 6 compilations, got " << permutations.GetNumPermutations()
+			<< " permutations in " << gxapiManager.compileCount << " compilations." << endl;
+		return 1;
+	}
+
+	// precompiled permutations must not be compiled again
+	const ShaderProgram& withUnused = permutations.GetProgram("material", parts, permutations.GetMask("UNUSED_FEATURE NORMAL_MAP"));
+	const ShaderProgram& withoutUnused = permutations.GetProgram("material", parts, permutations.GetMask("NORMAL_MAP"));
+	if (gxapiManager.compileCount != 6) {
+		cout << "Precompiled permutation was compiled again." << endl;
+		return 1;
+	}
+
+	// identical bytecode must be stored once
+	if (withUnused.ps.Data() != withoutUnused.ps.Data() || shaderManager.GetNumUniqueBinaries() != 4) {
+		cout << "Identical binaries were not shared." << endl;
+		return 1;
+	}
+
+	// invalidated permutations are fetched from the shader manager again, without compiling
+	const void* oldPs = withoutUnused.ps.Data();
+	permutations.InvalidatePrograms();
+	const ShaderProgram& refetched = permutations.GetProgram("material", parts, permutations.GetMask("NORMAL_MAP"));
+	if (refetched.ps.Data() != oldPs || permutations.GetNumPermutations() != 3 || gxapiManager.compileCount != 6) {
+		cout << "Invalidated permutation was not refetched from the shader manager." << endl;
+		return 1;
+	}
+
+	// requests still queued when the shader manager is destroyed fail with an error instead of a broken promise
+	std::vector<std::shared_future<ShaderProgram>> pending;
+	{
+		ShaderManager shortLived(&gxapiManager);
+		shortLived.AddSourceCode("material", "");
+		for (int i = 0; i < 64; ++i) {
+			pending.push_back(shortLived.CreateShaderAsync("material", parts, "VARIANT=" + std::to_string(i)));
+		}
+	}
+	for (auto& program : pending) {
+		try {
+			program.get();
+		}
+		catch (std::future_error&) {
+			cout << "Queued shader request ended in a broken promise." << endl;
+			return 1;
+		}
+		catch (std::exception&) {
+		}
+	}
+
+	cout << "Compilations: " << gxapiManager.compileCount << ", unique binaries: " << shaderManager.GetNumUniqueBinaries() << endl;
+	return 0;
+}
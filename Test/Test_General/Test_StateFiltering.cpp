@@ -0,0 +1,135 @@
+#include "Test.hpp"
+
+#include <GraphicsEngine_LL/GraphicsCommandList.hpp>
+#include <GraphicsEngine_LL/CommandAllocatorPool.hpp>
+#include <GraphicsEngine_LL/ScratchSpacePool.hpp>
+#include "MockGraphicsApi.hpp"
+
+#include <iostream>
+#include <memory>
+
+using std::cout;
+using std::endl;
+
+using namespace inl;
+using namespace inl::gxeng;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestStateFiltering : public AutoRegisterTest<TestStateFiltering> {
+public:
+	static std::string Name() {
+		return "StateFiltering";
+	}
+	virtual int Run() override;
+};
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestStateFiltering::Run() {
+	MockGraphicsApi graphicsApi;
+	CommandAllocatorPool commandAllocatorPool(&graphicsApi);
+	ScratchSpacePool scratchSpacePool(&graphicsApi, gxapi::eDescriptorHeapType::CBV_SRV_UAV);
+	GraphicsCommandList commandList(&graphicsApi, commandAllocatorPool, scratchSpacePool);
+
+	BindParameterDesc inlineDesc;
+	inlineDesc.parameter = BindParameter(eBindParameterType::CONSTANT, 0);
+	inlineDesc.constantSize = 16;
+	Binder binder(&graphicsApi, { inlineDesc });
+	Binder sameLayoutBinder(&graphicsApi, { inlineDesc });
+
+	MockPipelineState pipelineState;
+	VertexBuffer vertexBuffers[3] = {
+		VertexBuffer(MemoryObjDesc(new MockResource(gxapi::ResourceDesc::Buffer(256), (void*)0x10000))),
+		VertexBuffer(MemoryObjDesc(new MockResource(gxapi::ResourceDesc::Buffer(256), (void*)0x20000))),
+		VertexBuffer(MemoryObjDesc(new MockResource(gxapi::ResourceDesc::Buffer(256), (void*)0x30000))),
+	};
+	IndexBuffer indexBuffer(MemoryObjDesc(new MockResource(gxapi::ResourceDesc::Buffer(256), (void*)0x40000)), 128);
+	const VertexBuffer* buffers[2] = { &vertexBuffers[0], &vertexBuffers[1] };
+	const VertexBuffer* changedBuffers[2] = { &vertexBuffers[0], &vertexBuffers[2] };
+	unsigned sizes[2] = { 256, 256 };
+	unsigned strides[2] = { 16, 16 };
+	uint32_t constants[4] = { 1, 2, 3, 4 };
+	uint32_t changedConstants[4] = { 1, 2, 3, 5 };
+
+	// everything is set once, setting it again is dropped
+	commandList.SetPipelineState(&pipelineState);
+	commandList.SetPipelineState(&pipelineState);
+	commandList.SetGraphicsBinder(&binder);
+	commandList.SetGraphicsBinder(&binder);
+	commandList.SetGraphicsBinder(&sameLayoutBinder);
+	commandList.SetPrimitiveTopology(gxapi::ePrimitiveTopology::TRIANGLELIST);
+	commandList.SetPrimitiveTopology(gxapi::ePrimitiveTopology::TRIANGLELIST);
+	commandList.SetVertexBuffers(0, 2, buffers, sizes, strides);
+	commandList.SetVertexBuffers(0, 2, buffers, sizes, strides);
+	commandList.SetVertexBuffers(1, 1, buffers + 1, sizes, strides);
+	commandList.SetIndexBuffer(&indexBuffer, false);
+	commandList.SetIndexBuffer(&indexBuffer, false);
+	commandList.BindGraphics(inlineDesc.parameter, constants, sizeof(constants), 0);
+	commandList.BindGraphics(inlineDesc.parameter, constants, sizeof(constants), 0);
+	if (commandList.GetNumSubmittedStateCalls() != 6 || commandList.GetNumFilteredStateCalls() != 8) {
+		cout << "Redundant state calls were not filtered." << endl;
+		return 1;
+	}
+
+	// changed values are set
+	commandList.SetVertexBuffers(0, 2, changedBuffers, sizes, strides);
+	commandList.SetIndexBuffer(&indexBuffer, true);
+	commandList.BindGraphics(inlineDesc.parameter, changedConstants, sizeof(changedConstants), 0);
+	commandList.DrawIndexedInstanced(3);
+	if (commandList.GetNumSubmittedStateCalls() != 9 || commandList.GetNumFilteredStateCalls() != 8) {
+		cout << "Changed state was filtered." << endl;
+		return 1;
+	}
+
+	// bundles may change everything but the root signature and tables
+	auto bundle = std::make_shared<GraphicsBundle>(&graphicsApi);
+	bundle->Close();
+	commandList.ExecuteBundle(bundle);
+	commandList.SetPipelineState(&pipelineState);
+	commandList.SetGraphicsBinder(&binder);
+	commandList.SetPrimitiveTopology(gxapi::ePrimitiveTopology::TRIANGLELIST);
+	commandList.SetVertexBuffers(0, 2, changedBuffers, sizes, strides);
+	commandList.SetIndexBuffer(&indexBuffer, true);
+	commandList.BindGraphics(inlineDesc.parameter, changedConstants, sizeof(changedConstants), 0);
+	if (commandList.GetNumSubmittedStateCalls() != 14 || commandList.GetNumFilteredStateCalls() != 9) {
+		cout << "State was filtered after a bundle." << endl;
+		return 1;
+	}
+
+	// clearing the state forgets everything, the reset pipeline state is known
+	commandList.ResetState(&pipelineState);
+	commandList.SetPipelineState(&pipelineState);
+	commandList.SetGraphicsBinder(&binder);
+	commandList.BindGraphics(inlineDesc.parameter, changedConstants, sizeof(changedConstants), 0);
+	if (commandList.GetNumSubmittedStateCalls() != 16 || commandList.GetNumFilteredStateCalls() != 10) {
+		cout << "State was filtered after clearing it." << endl;
+		return 1;
+	}
+
+	// the API list received exactly the submitted calls
+	size_t numSubmitted = commandList.GetNumSubmittedStateCalls();
+	BasicCommandList::Decomposition decomposition = static_cast<BasicCommandList&>(commandList).Decompose();
+	const MockCommandList& mockList = dynamic_cast<const MockCommandList&>(*decomposition.commandList);
+	int numSetCalls = mockList.Count("SetPipelineState") + mockList.Count("SetGraphicsRootSignature") + mockList.Count("SetPrimitiveTopology")
+		+ mockList.Count("SetVertexBuffers") + mockList.Count("SetIndexBuffer") + mockList.Count("SetGraphicsRootConstants");
+	if (numSetCalls != (int)numSubmitted
+		|| mockList.Count("SetPipelineState") != 2
+		|| mockList.Count("SetGraphicsRootSignature") != 2
+		|| mockList.Count("SetVertexBuffers") != 3
+		|| mockList.Count("SetGraphicsRootConstants") != 4)
+	{
+		cout << "API command list did not receive the submitted calls." << endl;
+		return 1;
+	}
+
+	return 0;
+}
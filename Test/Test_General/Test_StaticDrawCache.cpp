@@ -0,0 +1,256 @@
+#include "Test.hpp"
+
+#include <GraphicsEngine_LL/StaticDrawCache.hpp>
+#include <GraphicsEngine_LL/GraphicsBundle.hpp>
+#include <GraphicsEngine_LL/MeshEntity.hpp>
+#include "MockGraphicsApi.hpp"
+
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <algorithm>
+
+using std::cout;
+using std::endl;
+
+using namespace inl;
+using namespace inl::gxeng;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestStaticDrawCache : public AutoRegisterTest<TestStaticDrawCache> {
+public:
+	static std::string Name() {
+		return "StaticDrawCache";
+	}
+	virtual int Run() override;
+private:
+	/// <summary> Renders a frame the way the nodes do: records the changed groups into bundles
+	///		and counts the commands recorded. </summary>
+	size_t Frame(const EntityCollection<MeshEntity>& visible);
+	/// <summary> Whether the visible entities are all drawn once, either by a group or directly. </summary>
+	bool DrawsEachOnce(const EntityCollection<MeshEntity>& visible) const;
+private:
+	MockGraphicsApi m_graphicsApi;
+	std::unique_ptr<Binder> m_binder;
+	MockPipelineState m_pipelineState;
+	std::shared_ptr<MeshEntityStore> m_store;
+	StaticDrawCache m_cache;
+	std::vector<std::shared_ptr<GraphicsBundle>> m_bundles;
+	size_t m_numGroupsRecorded = 0;
+};
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestStaticDrawCache::Run() {
+	// a bundle skips setting what it has already set and can't record once closed
+	BindParameterDesc inlineDesc, bufferDesc;
+	inlineDesc.parameter = BindParameter(eBindParameterType::CONSTANT, 0);
+	inlineDesc.constantSize = 16;
+	bufferDesc.parameter = BindParameter(eBindParameterType::CONSTANT, 1);
+	bufferDesc.constantSize = 0;
+	m_binder = std::make_unique<Binder>(&m_graphicsApi, std::vector<BindParameterDesc>{ inlineDesc, bufferDesc });
+
+	GraphicsBundle bundle(&m_graphicsApi);
+	float constants[4] = { 1, 2, 3, 4 };
+	try {
+		bundle.BindGraphics(inlineDesc.parameter, constants, sizeof(constants), 0);
+		cout << "Bundle bound a parameter without a binder." << endl;
+		return 1;
+	}
+	catch (std::logic_error&) {}
+	bundle.SetPipelineState(&m_pipelineState);
+	bundle.SetGraphicsBinder(m_binder.get());
+	bundle.SetPrimitiveTopology(gxapi::ePrimitiveTopology::TRIANGLELIST);
+	bundle.SetPipelineState(&m_pipelineState);
+	bundle.SetGraphicsBinder(m_binder.get());
+	bundle.SetPrimitiveTopology(gxapi::ePrimitiveTopology::TRIANGLELIST);
+	bundle.BindGraphics(inlineDesc.parameter, constants, sizeof(constants), 0);
+	bundle.DrawIndexedInstanced(3);
+	try {
+		bundle.BindGraphics(bufferDesc.parameter, constants, sizeof(constants), 0);
+		cout << "Bundle bound a constant buffer view as inline constants." << endl;
+		return 1;
+	}
+	catch (std::invalid_argument&) {}
+	bundle.Close();
+	const MockCommandList& bundleList = *static_cast<MockCommandList*>(bundle._GetCommandList());
+	std::vector<std::string> expected = { "SetPipelineState", "SetGraphicsRootSignature", "SetPrimitiveTopology", "SetGraphicsRootConstants", "DrawIndexedInstanced", "Close" };
+	if (bundleList.History() != expected || bundle.GetNumCommands() != 5 || bundle.GetNumSkippedCommands() != 3) {
+		cout << "Bundle did not skip redundant state." << endl;
+		return 1;
+	}
+	try {
+		bundle.DrawIndexedInstanced(3);
+		cout << "Closed bundle recorded a draw." << endl;
+		return 1;
+	}
+	catch (std::logic_error&) {}
+
+	// entities on a grid across several cells, with two textures
+	Image* textures[2] = { reinterpret_cast<Image*>(0x1000), reinterpret_cast<Image*>(0x2000) };
+	m_store = std::make_shared<MeshEntityStore>();
+	std::vector<std::unique_ptr<MeshEntity>> entities;
+	EntityCollection<MeshEntity> visible;
+	for (int i = 0; i < 1000; ++i) {
+		auto entity = std::make_unique<MeshEntity>(m_store);
+		entity->SetPosition({ float(i % 40) * 5.0f, float(i / 40) * 5.0f, 0.0f });
+		entity->SetTexture(textures[i % 2]);
+		visible.Add(entity.get());
+		entities.push_back(std::move(entity));
+	}
+
+	// entities are drawn directly until they settle, then by bundles that are recorded once
+	for (unsigned frame = 0; frame < StaticDrawCache::FramesToSettle; ++frame) {
+		Frame(visible);
+		if (m_cache.GetDynamicEntities().size() != entities.size() || !m_cache.GetVisibleGroups().empty()) {
+			cout << "Entities were grouped before settling." << endl;
+			return 1;
+		}
+	}
+	Frame(visible);
+	if (!m_cache.GetDynamicEntities().empty() || !DrawsEachOnce(visible)) {
+		cout << "Settled entities are not drawn by groups." << endl;
+		return 1;
+	}
+	size_t numGroups = m_cache.GetVisibleGroups().size();
+	for (size_t groupIndex : m_cache.GetVisibleGroups()) {
+		const StaticDrawCache::Group& group = m_cache.GetGroup(groupIndex);
+		if (group.entities.size() > StaticDrawCache::MaxGroupSize
+			|| std::any_of(group.entities.begin(), group.entities.end(), [&group](const MeshEntity* entity) { return entity->GetTexture() != group.texture; }))
+		{
+			cout << "Group mixes textures or is too large." << endl;
+			return 1;
+		}
+	}
+	for (int frame = 0; frame < 10; ++frame) {
+		if (Frame(visible) != 0 || m_cache.GetVisibleGroups().size() != numGroups) {
+			cout << "Commands were recorded for unchanged entities." << endl;
+			return 1;
+		}
+	}
+
+	// a moved entity leaves its group, only that group is recorded again, twice once it settles elsewhere
+	MeshEntity* moved = entities[123].get();
+	moved->SetPosition({ 1000.0f, 0.0f, 0.0f });
+	m_numGroupsRecorded = 0;
+	Frame(visible);
+	if (m_cache.GetDynamicEntities() != std::vector<const MeshEntity*>{ moved } || m_numGroupsRecorded != 1 || !DrawsEachOnce(visible)) {
+		cout << "Moving an entity did not invalidate only its group." << endl;
+		return 1;
+	}
+	for (unsigned frame = 0; frame < StaticDrawCache::FramesToSettle; ++frame) {
+		Frame(visible);
+	}
+	if (!m_cache.GetDynamicEntities().empty() || m_numGroupsRecorded != 2 || !DrawsEachOnce(visible)) {
+		cout << "Moved entity did not settle into a group of its own cell." << endl;
+		return 1;
+	}
+
+	// changing the texture counts as a change
+	entities[7]->SetTexture(textures[0]);
+	Frame(visible);
+	if (m_cache.GetDynamicEntities() != std::vector<const MeshEntity*>{ entities[7].get() }) {
+		cout << "Changing the texture did not take the entity out of its group." << endl;
+		return 1;
+	}
+	for (unsigned frame = 0; frame < StaticDrawCache::FramesToSettle; ++frame) {
+		Frame(visible);
+	}
+
+	// partly visible groups are drawn one by one, culled entities are never drawn
+	numGroups = m_cache.GetVisibleGroups().size();
+	MeshEntity* culled = entities[500].get();
+	visible.Remove(culled);
+	if (Frame(visible) != 0 || m_cache.GetVisibleGroups().size() != numGroups - 1 || !DrawsEachOnce(visible)) {
+		cout << "Group with a culled entity was drawn whole." << endl;
+		return 1;
+	}
+	visible.Add(culled);
+	if (Frame(visible) != 0 || m_cache.GetVisibleGroups().size() != numGroups || !m_cache.GetDynamicEntities().empty()) {
+		cout << "Group was not drawn whole again once visible." << endl;
+		return 1;
+	}
+
+	// destroyed entities are forgotten, their group is drawn whole again without them
+	visible.Remove(culled);
+	auto culledIt = std::find_if(entities.begin(), entities.end(), [culled](const auto& entity) { return entity.get() == culled; });
+	entities.erase(culledIt);
+	for (unsigned frame = 0; frame <= StaticDrawCache::FramesToForget; ++frame) {
+		Frame(visible);
+	}
+	if (m_cache.GetNumTrackedEntities() != entities.size() || !m_cache.GetDynamicEntities().empty() || !DrawsEachOnce(visible)) {
+		cout << "Destroyed entity was not forgotten." << endl;
+		return 1;
+	}
+
+	// caches given the same entities group them the same way, so depth prepass and forward rendering match
+	StaticDrawCache other;
+	StaticDrawCache again;
+	for (unsigned frame = 0; frame <= StaticDrawCache::FramesToSettle; ++frame) {
+		m_store->UpdateWorldMatrices();
+		other.Update(visible);
+		again.Update(visible);
+	}
+	if (other.GetVisibleGroups() != again.GetVisibleGroups() || other.GetDynamicEntities() != again.GetDynamicEntities()) {
+		cout << "Caches given the same entities differ." << endl;
+		return 1;
+	}
+	for (size_t groupIndex : other.GetVisibleGroups()) {
+		if (other.GetGroup(groupIndex).entities != again.GetGroup(groupIndex).entities) {
+			cout << "Caches given the same entities group them differently." << endl;
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+
+size_t TestStaticDrawCache::Frame(const EntityCollection<MeshEntity>& visible) {
+	m_store->UpdateWorldMatrices();
+	m_cache.Update(visible);
+
+	size_t numCommands = 0;
+	m_bundles.resize(m_cache.GetNumGroups());
+	for (size_t groupIndex : m_cache.GetVisibleGroups()) {
+		const StaticDrawCache::Group& group = m_cache.GetGroup(groupIndex);
+		if (!group.changed) {
+			continue;
+		}
+		auto bundle = std::make_shared<GraphicsBundle>(&m_graphicsApi);
+		bundle->SetPipelineState(&m_pipelineState);
+		bundle->SetGraphicsBinder(m_binder.get());
+		bundle->SetPrimitiveTopology(gxapi::ePrimitiveTopology::TRIANGLELIST);
+		for (size_t i = 0; i < group.entities.size(); ++i) {
+			bundle->DrawIndexedInstanced(3);
+		}
+		bundle->Close();
+		numCommands += bundle->GetNumCommands();
+		m_bundles[groupIndex] = bundle;
+		m_cache.MarkRecorded(groupIndex);
+		++m_numGroupsRecorded;
+	}
+	return numCommands;
+}
+
+
+bool TestStaticDrawCache::DrawsEachOnce(const EntityCollection<MeshEntity>& visible) const {
+	std::vector<const MeshEntity*> drawn = m_cache.GetDynamicEntities();
+	for (size_t groupIndex : m_cache.GetVisibleGroups()) {
+		const StaticDrawCache::Group& group = m_cache.GetGroup(groupIndex);
+		drawn.insert(drawn.end(), group.entities.begin(), group.entities.end());
+	}
+	std::vector<const MeshEntity*> expected(visible.begin(), visible.end());
+	std::sort(drawn.begin(), drawn.end());
+	std::sort(expected.begin(), expected.end());
+	return drawn == expected;
+}
@@ -0,0 +1,227 @@
+#include "Test.hpp"
+
+#include <GraphicsEngine_LL/TerrainQuadtree.hpp>
+#include <GraphicsEngine_LL/Camera.hpp>
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+using std::cout;
+using std::endl;
+
+using namespace inl;
+using namespace inl::gxeng;
+
+using Vec3 = mathfu::Vector<float, 3>;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestTerrainQuadtree : public AutoRegisterTest<TestTerrainQuadtree> {
+public:
+	static std::string Name() {
+		return "TerrainQuadtree";
+	}
+	virtual int Run() override;
+private:
+	static Heightfield MakeHills(unsigned size, float spacing);
+	static bool TilesTerrain(const TerrainQuadtree& quadtree, const std::vector<uint32_t>& selected, unsigned quads);
+};
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+Heightfield TestTerrainQuadtree::MakeHills(unsigned size, float spacing) {
+	std::vector<float> heights(size * size);
+	for (unsigned y = 0; y < size; ++y) {
+		for (unsigned x = 0; x < size; ++x) {
+			heights[y * size + x] = 8.0f * std::sin(x * 0.11f) * std::cos(y * 0.07f) + 0.15f * std::sin(x * 0.9f + y * 1.3f);
+		}
+	}
+	return Heightfield(std::move(heights), size, spacing);
+}
+
+
+bool TestTerrainQuadtree::TilesTerrain(const TerrainQuadtree& quadtree, const std::vector<uint32_t>& selected, unsigned quads) {
+	// every quad of the heightfield is covered by exactly one selected chunk
+	std::vector<int> coverage(quads * quads, 0);
+	for (uint32_t index : selected) {
+		const TerrainChunk& chunk = quadtree.GetChunks()[index];
+		unsigned span = chunk.stride * quadtree.GetChunkQuads();
+		for (unsigned y = chunk.firstY; y < chunk.firstY + span; ++y) {
+			for (unsigned x = chunk.firstX; x < chunk.firstX + span; ++x) {
+				++coverage[y * quads + x];
+			}
+		}
+	}
+	return std::all_of(coverage.begin(), coverage.end(), [](int count) { return count == 1; });
+}
+
+
+int TestTerrainQuadtree::Run() {
+	const unsigned chunkQuads = 16;
+	const unsigned quads = chunkQuads * 8;
+	const float spacing = 2.0f;
+	Heightfield heightfield = MakeHills(quads + 1, spacing);
+
+	// sizes that do not split into chunks are rejected
+	try {
+		TerrainQuadtree invalid(MakeHills(chunkQuads * 3 + 1, spacing), chunkQuads);
+		cout << "Heightfield of invalid size was accepted." << endl;
+		return 1;
+	}
+	catch (std::invalid_argument&) {}
+
+	TerrainQuadtree quadtree(heightfield, chunkQuads);
+	const std::vector<TerrainChunk>& chunks = quadtree.GetChunks();
+	if (chunks.size() != 1 + 4 + 16 + 64) {
+		cout << "Quadtree has the wrong number of chunks." << endl;
+		return 1;
+	}
+
+	// errors never shrink towards the root, and leaves are exact
+	for (const TerrainChunk& chunk : chunks) {
+		if (chunk.IsLeaf() ? chunk.geometricError != 0.0f || chunk.stride != 1 : chunk.geometricError <= 0.0f) {
+			cout << "Chunk error does not match its detail." << endl;
+			return 1;
+		}
+		if (chunk.parent != TerrainQuadtree::InvalidChunk && chunks[chunk.parent].geometricError < chunk.geometricError) {
+			cout << "Chunk error is larger than its parent's." << endl;
+			return 1;
+		}
+	}
+
+	// selection tiles the terrain, with finer chunks near the eye
+	Frustum everything;
+	Vec3 eye = { 10.0f, 10.0f, 15.0f };
+	float errorScale = TerrainQuadtree::ErrorScale(1.2f, 1080);
+	std::vector<uint32_t> selected;
+	quadtree.SelectLod(eye, everything, errorScale, 2.0f, selected);
+	if (!TilesTerrain(quadtree, selected, quads)) {
+		cout << "Selected chunks do not tile the terrain." << endl;
+		return 1;
+	}
+	auto levelAt = [&](float x, float y) {
+		for (uint32_t index : selected) {
+			const Aabb& bounds = chunks[index].bounds;
+			if (bounds.min.x() <= x && x < bounds.max.x() && bounds.min.y() <= y && y < bounds.max.y()) {
+				return chunks[index].level;
+			}
+		}
+		return ~0u;
+	};
+	if (levelAt(eye.x(), eye.y()) <= levelAt(quads * spacing - 1.0f, quads * spacing - 1.0f)) {
+		cout << "Chunks near the eye are not finer than far away." << endl;
+		return 1;
+	}
+	for (uint32_t index : selected) {
+		const TerrainChunk& chunk = chunks[index];
+		Vec3 nearest = Vec3::Max(chunk.bounds.min, Vec3::Min(eye, chunk.bounds.max));
+		if (!chunk.IsLeaf() && chunk.geometricError * errorScale > 2.0f * (nearest - eye).Length()) {
+			cout << "Selected chunk exceeds the pixel error." << endl;
+			return 1;
+		}
+	}
+
+	// a looser error bound draws fewer chunks
+	std::vector<uint32_t> coarse;
+	quadtree.SelectLod(eye, everything, errorScale, 50.0f, coarse);
+	if (coarse.size() >= selected.size() || !TilesTerrain(quadtree, coarse, quads)) {
+		cout << "Larger pixel error does not coarsen the selection." << endl;
+		return 1;
+	}
+
+	// chunks outside the frustum are skipped
+	Camera camera;
+	camera.SetPosition({ -20.0f, -20.0f, 15.0f });
+	camera.SetLookDirection({ -1.0f, -1.0f, 0.0f });
+	camera.SetUpVector({ 0, 0, 1 });
+	camera.SetFOVAspect(1.2f, 16.0f / 9.0f);
+	camera.SetNearPlane(0.5f);
+	camera.SetFarPlane(1000.0f);
+	Frustum away(camera.GetPerspectiveMatrixRH() * camera.GetViewMatrixRH());
+	quadtree.SelectLod(camera.GetPosition(), away, errorScale, 2.0f, selected);
+	if (!selected.empty()) {
+		cout << "Chunks behind the camera were selected." << endl;
+		return 1;
+	}
+
+	// meshes sample the heightfield, face up, and have skirts facing out
+	for (uint32_t index : { 0u, 1u, uint32_t(chunks.size() - 1) }) {
+		const TerrainChunk& chunk = chunks[index];
+		TerrainChunkMesh mesh;
+		TerrainQuadtree::GenerateChunkMesh(heightfield, chunk, chunkQuads, mesh);
+
+		const unsigned side = chunkQuads + 1;
+		const unsigned surfaceTriangles = 2 * chunkQuads * chunkQuads;
+		if (mesh.vertices.size() != side * side + 4 * chunkQuads || mesh.indices.size() != 3 * (surfaceTriangles + 8 * chunkQuads)) {
+			cout << "Chunk mesh has the wrong size." << endl;
+			return 1;
+		}
+		for (unsigned j = 0; j < side; ++j) {
+			for (unsigned i = 0; i < side; ++i) {
+				Vec3 position = mesh.vertices[j * side + i].position;
+				float height = heightfield.At(chunk.firstX + i * chunk.stride, chunk.firstY + j * chunk.stride);
+				if (position.z() != height || std::abs(position.x() - (chunk.firstX + i * chunk.stride) * spacing) > 1e-3f) {
+					cout << "Chunk vertex does not match the heightfield." << endl;
+					return 1;
+				}
+			}
+		}
+
+		Vec3 center = (chunk.bounds.min + chunk.bounds.max) * 0.5f;
+		for (size_t t = 0; t < mesh.indices.size() / 3; ++t) {
+			Vec3 a = mesh.vertices[mesh.indices[3 * t]].position;
+			Vec3 b = mesh.vertices[mesh.indices[3 * t + 1]].position;
+			Vec3 c = mesh.vertices[mesh.indices[3 * t + 2]].position;
+			Vec3 normal = Vec3::CrossProduct(b - a, c - a);
+			if (t < surfaceTriangles) {
+				if (normal.z() <= 0.0f) {
+					cout << "Chunk surface does not face up." << endl;
+					return 1;
+				}
+			}
+			else {
+				Vec3 outward = (a + b + c) / 3.0f - center;
+				outward.z() = 0;
+				if (Vec3::DotProduct(normal, outward) <= 0.0f || std::min({ a.z(), b.z(), c.z() }) < chunk.bounds.min.z() - 1e-3f) {
+					cout << "Chunk skirt does not face out of the chunk." << endl;
+					return 1;
+				}
+			}
+		}
+
+		// the occluder is coarser and stays below the mesh's surface
+		const unsigned occluderQuads = 4;
+		const unsigned cellQuads = chunkQuads / occluderQuads;
+		TerrainQuadtree::GenerateChunkOccluder(heightfield, chunk, chunkQuads, occluderQuads, mesh);
+		if (mesh.occluderPositions.size() != (occluderQuads + 1) * (occluderQuads + 1) || mesh.occluderIndices.size() != 6 * occluderQuads * occluderQuads) {
+			cout << "Chunk occluder has the wrong size." << endl;
+			return 1;
+		}
+		for (unsigned j = 0; j < side; ++j) {
+			for (unsigned i = 0; i < side; ++i) {
+				unsigned cellX = std::min(i / cellQuads, occluderQuads - 1), cellY = std::min(j / cellQuads, occluderQuads - 1);
+				float fx = float(i - cellX * cellQuads) / cellQuads;
+				float fy = float(j - cellY * cellQuads) / cellQuads;
+				auto corner = [&](unsigned x, unsigned y) { return mesh.occluderPositions[(cellY + y) * (occluderQuads + 1) + cellX + x].z(); };
+				float occluderHeight = fx >= fy
+					? corner(0, 0) + fx * (corner(1, 0) - corner(0, 0)) + fy * (corner(1, 1) - corner(1, 0))
+					: corner(0, 0) + fy * (corner(0, 1) - corner(0, 0)) + fx * (corner(1, 1) - corner(0, 1));
+				if (occluderHeight > mesh.vertices[j * side + i].position.z() + 1e-3f) {
+					cout << "Chunk occluder rises above the chunk's surface." << endl;
+					return 1;
+				}
+			}
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,220 @@
+#include "Test.hpp"
+
+#include <GraphicsEngine_LL/TextureTable.hpp>
+#include <GraphicsEngine_LL/GraphicsCommandList.hpp>
+#include <GraphicsEngine_LL/CommandAllocatorPool.hpp>
+#include <GraphicsEngine_LL/ScratchSpacePool.hpp>
+#include "MockGraphicsApi.hpp"
+
+#include <iostream>
+#include <vector>
+
+using std::cout;
+using std::endl;
+
+using namespace inl;
+using namespace inl::gxeng;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestTextureTable : public AutoRegisterTest<TestTextureTable> {
+public:
+	static std::string Name() {
+		return "TextureTable";
+	}
+	virtual int Run() override;
+private:
+	/// <summary> Whether the reserved range of the heap holds the expected descriptors, 0 where nothing was copied. </summary>
+	static bool Holds(StackDescHeap& heap, const std::vector<char>& expected);
+};
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestTextureTable::Run() {
+	MockGraphicsApi graphicsApi;
+
+	// staging descriptors are told apart by their only byte
+	MockDescriptorHeap staging(gxapi::DescriptorHeapDesc(gxapi::eDescriptorHeapType::CBV_SRV_UAV, 16, false));
+	for (size_t i = 0; i < 16; ++i) {
+		*static_cast<char*>(staging.At(i).cpuAddress) = char('a' + i);
+	}
+
+	// indices are handed out in order, freed ones are given out again, the last freed first
+	TextureTable table(&graphicsApi, 8);
+	uint32_t first = table.Allocate();
+	uint32_t second = table.Allocate();
+	uint32_t third = table.Allocate();
+	table.Free(second);
+	if (first != 0 || second != 1 || third != 2 || table.Allocate() != 1) {
+		cout << "Freed index was not recycled." << endl;
+		return 1;
+	}
+	table.Free(third);
+	table.Free(first);
+	if (table.Allocate() != 0 || table.Allocate() != 2 || table.GetNumAllocated() != 3 || !table.IsAllocated(1) || table.IsAllocated(3)) {
+		cout << "Indices were not recycled in order." << endl;
+		return 1;
+	}
+	try {
+		table.Free(5);
+		cout << "Freed an index that was not allocated." << endl;
+		return 1;
+	}
+	catch (std::invalid_argument&) {}
+
+	// a full table refuses more textures
+	TextureTable smallTable(&graphicsApi, 2);
+	smallTable.Allocate();
+	smallTable.Allocate();
+	try {
+		smallTable.Allocate();
+		cout << "Full table gave out an index." << endl;
+		return 1;
+	}
+	catch (gxapi::OutOfMemory&) {}
+
+	// the reserved range is never allocated
+	StackDescHeap heap(&graphicsApi, gxapi::eDescriptorHeapType::CBV_SRV_UAV, 16, 8);
+	if (heap.Allocate(1).Get(0).cpuAddress != heap.GetHeap()->At(8).cpuAddress) {
+		cout << "Allocation overlaps the reserved range." << endl;
+		return 1;
+	}
+	heap.Reset();
+	if (heap.Allocate(1).Get(0).cpuAddress != heap.GetHeap()->At(8).cpuAddress) {
+		cout << "Reset heap allocates from the reserved range." << endl;
+		return 1;
+	}
+
+	// syncing copies all set descriptors at once, adjacent ones in a single range
+	uint32_t fourth = table.Allocate();
+	table.Set(0, staging.At(0));
+	table.Set(1, staging.At(1));
+	table.Set(fourth, staging.At(7));
+	int copyCount = graphicsApi.descriptorCopyCount;
+	if (table.Sync(heap) != 3 || graphicsApi.descriptorCopyCount != copyCount + 1 || !Holds(heap, { 'a', 'b', 0, 'h', 0, 0, 0, 0 })) {
+		cout << "Set descriptors were not synced." << endl;
+		return 1;
+	}
+
+	// unchanged tables copy nothing, changed ones copy only what changed
+	if (table.Sync(heap) != 0 || graphicsApi.descriptorCopyCount != copyCount + 1) {
+		cout << "Unchanged table was copied again." << endl;
+		return 1;
+	}
+	table.Set(2, staging.At(2));
+	if (table.Sync(heap) != 1 || !Holds(heap, { 'a', 'b', 'c', 'h', 0, 0, 0, 0 })) {
+		cout << "Changed descriptor was not synced alone." << endl;
+		return 1;
+	}
+
+	// a recycled index keeps its place and gets the new texture
+	table.Free(0);
+	if (table.Sync(heap) != 0 || table.Allocate() != 0) {
+		cout << "Freed index was copied or not recycled." << endl;
+		return 1;
+	}
+	table.Set(0, staging.At(4));
+	if (table.Sync(heap) != 1 || !Holds(heap, { 'e', 'b', 'c', 'h', 0, 0, 0, 0 })) {
+		cout << "Recycled index was not synced." << endl;
+		return 1;
+	}
+
+	// other heaps get everything on their first sync, heaps without room are refused
+	StackDescHeap otherHeap(&graphicsApi, gxapi::eDescriptorHeapType::CBV_SRV_UAV, 16, 8);
+	if (table.Sync(otherHeap) != 4 || !Holds(otherHeap, { 'e', 'b', 'c', 'h', 0, 0, 0, 0 })) {
+		cout << "New heap was not synced fully." << endl;
+		return 1;
+	}
+	StackDescHeap unreservedHeap(&graphicsApi, gxapi::eDescriptorHeapType::CBV_SRV_UAV, 16);
+	try {
+		table.Sync(unreservedHeap);
+		cout << "Synced a heap without a reserved range." << endl;
+		return 1;
+	}
+	catch (std::invalid_argument&) {}
+
+	// scratch spaces are synced when requested
+	ScratchSpacePool scratchSpacePool(&graphicsApi, gxapi::eDescriptorHeapType::CBV_SRV_UAV, &table);
+	{
+		ScratchSpacePtr scratchSpace = scratchSpacePool.RequestScratchSpace();
+		if (scratchSpace->GetReservedSize() != table.GetCapacity() || !Holds(*scratchSpace, { 'e', 'b', 'c', 'h', 0, 0, 0, 0 })) {
+			cout << "Requested scratch space was not synced." << endl;
+			return 1;
+		}
+	}
+	table.Set(1, staging.At(5));
+	{
+		ScratchSpacePtr scratchSpace = scratchSpacePool.RequestScratchSpace();
+		if (!Holds(*scratchSpace, { 'e', 'f', 'c', 'h', 0, 0, 0, 0 })) {
+			cout << "Recycled scratch space was not synced." << endl;
+			return 1;
+		}
+	}
+
+	// texture arrays get a table of their own
+	BindParameterDesc texturesDesc, indexDesc, otherTextureDesc;
+	texturesDesc.parameter = BindParameter(eBindParameterType::TEXTURE, 0, 1);
+	texturesDesc.numDescriptors = table.GetCapacity();
+	indexDesc.parameter = BindParameter(eBindParameterType::CONSTANT, 0);
+	indexDesc.constantSize = sizeof(uint32_t);
+	otherTextureDesc.parameter = BindParameter(eBindParameterType::TEXTURE, 0);
+	Binder binder(&graphicsApi, { texturesDesc, indexDesc, otherTextureDesc });
+	int slot, tableIndex;
+	binder.Translate(texturesDesc.parameter, slot, tableIndex);
+	const auto& rootParam = binder.GetRootSignatureDesc().rootParameters[slot];
+	if (rootParam.type != gxapi::RootParameterDesc::DESCRIPTOR_TABLE
+		|| rootParam.As<gxapi::RootParameterDesc::DESCRIPTOR_TABLE>().ranges.size() != 1
+		|| rootParam.As<gxapi::RootParameterDesc::DESCRIPTOR_TABLE>().ranges[0].numDescriptors != table.GetCapacity())
+	{
+		cout << "Texture array does not have a table of its own." << endl;
+		return 1;
+	}
+
+	// binding the table points the root table to the reserved range, textures set since are synced
+	CommandAllocatorPool commandAllocatorPool(&graphicsApi);
+	GraphicsCommandList commandList(&graphicsApi, commandAllocatorPool, scratchSpacePool);
+	table.Set(2, staging.At(6));
+	commandList.SetGraphicsBinder(&binder);
+	try {
+		commandList.BindGraphics(otherTextureDesc.parameter, table);
+		cout << "Texture table was bound to a single texture." << endl;
+		return 1;
+	}
+	catch (std::invalid_argument&) {}
+	commandList.BindGraphics(texturesDesc.parameter, table);
+	for (uint32_t textureIndex = 0; textureIndex < 3; ++textureIndex) {
+		commandList.BindGraphics(indexDesc.parameter, &textureIndex, sizeof(textureIndex), 0);
+		commandList.DrawIndexedInstanced(3);
+		commandList.BindGraphics(texturesDesc.parameter, table);
+	}
+	BasicCommandList::Decomposition decomposition = static_cast<BasicCommandList&>(commandList).Decompose();
+	const MockCommandList& mockList = dynamic_cast<const MockCommandList&>(*decomposition.commandList);
+	if (decomposition.scratchSpaces.size() != 1
+		|| !Holds(*decomposition.scratchSpaces[0], { 'e', 'f', 'g', 'h', 0, 0, 0, 0 })
+		|| mockList.Count("SetGraphicsRootDescriptorTable") != 2 // the texture array and the single texture
+		|| mockList.Count("SetGraphicsRootConstants") != 3)
+	{
+		cout << "Texture table was not bound once with an index per draw." << endl;
+		return 1;
+	}
+
+	return 0;
+}
+
+
+bool TestTextureTable::Holds(StackDescHeap& heap, const std::vector<char>& expected) {
+	for (size_t i = 0; i < expected.size(); ++i) {
+		if (*static_cast<char*>(heap.GetHeap()->At(i).cpuAddress) != expected[i]) {
+			return false;
+		}
+	}
+	return true;
+}
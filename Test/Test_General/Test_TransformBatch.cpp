@@ -0,0 +1,110 @@
+#include "Test.hpp"
+
+#include <GraphicsEngine_LL/TransformBatch.hpp>
+#include <GraphicsEngine_LL/MeshEntityStore.hpp>
+#include <GraphicsEngine_LL/MeshEntity.hpp>
+
+#include <iostream>
+#include <memory>
+#include <cmath>
+
+using std::cout;
+using std::endl;
+
+using namespace inl;
+using namespace inl::gxeng;
+
+using Mat4 = mathfu::Matrix<float, 4, 4>;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestTransformBatch : public AutoRegisterTest<TestTransformBatch> {
+public:
+	static std::string Name() {
+		return "TransformBatch";
+	}
+	virtual int Run() override;
+private:
+	static bool IsClose(const Mat4& lhs, const Mat4& rhs);
+};
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+bool TestTransformBatch::IsClose(const Mat4& lhs, const Mat4& rhs) {
+	for (int i = 0; i < 16; ++i) {
+		if (std::abs(lhs[i] - rhs[i]) > 1e-4f * (1.0f + std::abs(rhs[i]))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+int TestTransformBatch::Run() {
+	auto store = std::make_shared<MeshEntityStore>();
+
+	std::vector<std::unique_ptr<MeshEntity>> entities;
+	for (int i = 0; i < 100; ++i) {
+		entities.push_back(std::make_unique<MeshEntity>(store));
+		entities.back()->SetPosition({ (float)i, 2.0f, -3.0f * i });
+		entities.back()->SetRotation(mathfu::Quaternion<float>::FromAngleAxis(0.1f * i, mathfu::Vector<float, 3>(1, 2, 3).Normalized()));
+		entities.back()->SetScale({ 1.0f + i, 2.0f, 0.5f });
+	}
+
+	// cached matrices match the matrices computed by mathfu
+	if (store->UpdateWorldMatrices() != 100) {
+		cout << "Not all moved entities were updated." << endl;
+		return 1;
+	}
+	for (auto& entity : entities) {
+		size_t index = entity->GetStoreIndex();
+		Mat4 expected = Mat4::FromTranslationVector(entity->GetPosition()) * entity->GetRotation().ToMatrix4() * Mat4::FromScaleVector(entity->GetScale());
+		if (!IsClose(store->WorldMatrix(index), expected) || !IsClose(store->NormalMatrix(index), expected.Inverse().Transpose())) {
+			cout << "Batched world matrix differs from mathfu's." << endl;
+			return 1;
+		}
+	}
+
+	// static scenes cost nothing, moved entities are updated alone
+	if (store->UpdateWorldMatrices() != 0) {
+		cout << "Static entities were recomputed." << endl;
+		return 1;
+	}
+	mathfu::Vector<float, 3> position = { 7, 7, 7 }, scale = { 3, 3, 3 };
+	entities[42]->SetPosition(position);
+	entities[42]->SetScale(scale);
+	if (!IsClose(entities[42]->GetTransform(), Mat4::FromTranslationVector(position) * entities[42]->GetRotation().ToMatrix4() * Mat4::FromScaleVector(scale))) {
+		cout << "Transform of a dirty entity is out of date." << endl;
+		return 1;
+	}
+	if (store->UpdateWorldMatrices() != 1) {
+		cout << "Wrong number of entities updated." << endl;
+		return 1;
+	}
+
+	// batched MVPs match mathfu's product
+	Mat4 viewProjection = Mat4::Perspective(1.0f, 1.5f, 0.1f, 100.0f) * Mat4::LookAt({ 0, 0, 0 }, { 10, 20, 30 }, { 0, 0, 1 });
+	std::vector<Mat4> mvps;
+	store->ComputeMvps(viewProjection, mvps);
+	if (mvps.size() != store->Size()) {
+		cout << "Wrong number of MVPs." << endl;
+		return 1;
+	}
+	for (auto& entity : entities) {
+		size_t index = entity->GetStoreIndex();
+		if (!IsClose(mvps[index], viewProjection * entity->GetTransform())) {
+			cout << "Batched MVP differs from mathfu's." << endl;
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,108 @@
+#include "Test.hpp"
+
+#include <GraphicsEngine_LL/VersionedBuffer.hpp>
+
+#include <iostream>
+#include <random>
+#include <vector>
+#include <cstring>
+
+using std::cout;
+using std::endl;
+
+using namespace inl;
+using namespace inl::gxeng;
+
+
+//------------------------------------------------------------------------------
+// Test class
+//------------------------------------------------------------------------------
+
+
+class TestVersionedBuffer : public AutoRegisterTest<TestVersionedBuffer> {
+public:
+	static std::string Name() {
+		return "VersionedBuffer";
+	}
+	virtual int Run() override;
+};
+
+
+//------------------------------------------------------------------------------
+// Test definition
+//------------------------------------------------------------------------------
+
+
+int TestVersionedBuffer::Run() {
+	const unsigned numVersions = 3;
+	const size_t size = 4096;
+
+	try {
+		VersionedBuffer invalid(0, size);
+		cout << "Buffer without versions was accepted." << endl;
+		return 1;
+	}
+	catch (std::invalid_argument&) {}
+
+	VersionedBuffer buffer(numVersions, size);
+	try {
+		buffer.Map(size - 8, 16);
+		cout << "Range past the end of the buffer was accepted." << endl;
+		return 1;
+	}
+	catch (std::out_of_range&) {}
+
+	// the GPU's copies, filled with garbage until their first flip
+	std::vector<std::vector<uint8_t>> versions(numVersions, std::vector<uint8_t>(size, 0xCD));
+
+	// each version comes up in turn and is complete after copying only what it missed
+	std::mt19937 rne(46);
+	std::uniform_int_distribution<size_t> rngOffset(0, size - 64), rngSize(1, 64);
+	std::uniform_int_distribution<int> rngWrites(0, 3);
+	for (int frame = 0; frame < 300; ++frame) {
+		for (int write = rngWrites(rne); write > 0; --write) {
+			size_t offset = rngOffset(rne), length = rngSize(rne);
+			uint8_t* target = buffer.Map(offset, length);
+			for (size_t i = 0; i < length; ++i) {
+				target[i] = uint8_t(rne());
+			}
+		}
+
+		ByteRange missing = buffer.Flip();
+		if (buffer.GetCurrentVersion() != frame % numVersions) {
+			cout << "Versions do not come up in turn." << endl;
+			return 1;
+		}
+		std::vector<uint8_t>& version = versions[buffer.GetCurrentVersion()];
+		std::memcpy(version.data() + missing.begin, buffer.GetData() + missing.begin, missing.GetSize());
+		if (std::memcmp(version.data(), buffer.GetData(), size) != 0) {
+			cout << "Version is not up to date after copying what it missed." << endl;
+			return 1;
+		}
+	}
+
+	// versions miss exactly what was written since their last flip, nothing once they have seen it
+	for (unsigned i = 0; i < numVersions; ++i) {
+		buffer.Flip();
+	}
+	buffer.Write(10, "abc", 3);
+	for (unsigned i = 0; i < numVersions; ++i) {
+		if (buffer.Flip().GetSize() != 3) {
+			cout << "A version does not miss exactly the bytes written." << endl;
+			return 1;
+		}
+	}
+	if (!buffer.Flip().IsEmpty()) {
+		cout << "Up to date version misses bytes." << endl;
+		return 1;
+	}
+
+	// resetting makes every version miss everything
+	buffer.Reset(2, 100);
+	if (buffer.Flip().GetSize() != 100 || buffer.Flip().GetSize() != 100 || !buffer.Flip().IsEmpty()) {
+		cout << "Reset buffer is not copied whole into every version." << endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -52,7 +52,7 @@ MiniWorld::MiniWorld(inl::gxeng::GraphicsEngine * graphicsEngine) {
 	const float extent = 5;
 	const int count = 6;
 	for (int i = 0; i < count; i++) {
-		std::unique_ptr<inl::gxeng::MeshEntity> entity(new inl::gxeng::MeshEntity());
+		std::unique_ptr<inl::gxeng::MeshEntity> entity(m_graphicsEngine->CreateMeshEntity());
 		entity->SetMesh(m_cubeMesh.get());
 		entity->SetTexture(m_texture.get());
 		mathfu::Vector<float, 3> pos;